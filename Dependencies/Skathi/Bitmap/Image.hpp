@@ -2,6 +2,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <yaul.h>
 
 namespace Skathi::Bitmap
@@ -44,9 +45,9 @@ namespace Skathi::Bitmap
          */
         ImageFormat Format;
 
-        /** @brief Number of color entries in the palette
+        /** @brief Number of color entries in the palette (up to 256)
          */
-        uint8_t PaletteSize;
+        uint16_t PaletteSize;
     } ImageInfo_t;
 
     /** @brief Color data
@@ -148,9 +149,9 @@ namespace Skathi::Bitmap
          */
         Color_t * paletteData = NULL;
 
-        /** @brief Number of colors in palette
+        /** @brief Number of colors in palette (up to 256)
          */
-        uint8_t paletteSize = 0;
+        uint16_t paletteSize = 0;
 
         /** @brief Default image contructor, will create an empty image
          */
@@ -179,8 +180,8 @@ namespace Skathi::Bitmap
 
             if (format == Bitmap::ImageFormat::Indexed)
             {
-                this->paletteData = (Color_t*)malloc(sizeof(Color_t) * 255);
-                this->paletteSize = 255;
+                this->paletteData = (Color_t*)malloc(sizeof(Color_t) * 256);
+                this->paletteSize = 256;
             }
 
             this->data = (uint8_t*)malloc((height * width) << (uint8_t)format);
@@ -246,7 +247,7 @@ namespace Skathi::Bitmap
         void SetPixel(uint32_t x, uint32_t y, uint8_t colorIndex)
         {
             assert(this->paletteData != NULL);
-            this->data[(this->bitmapSize.Height * y) + x] = colorIndex;
+            this->data[(this->bitmapSize.Width * y) + x] = colorIndex;
         }
 
         /** @brief Set the RGB pixel
@@ -260,8 +261,7 @@ namespace Skathi::Bitmap
         void SetPixel(uint32_t x, uint32_t y, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
         {
             assert(this->paletteData == NULL);
-            uint32_t pixel = ((this->bitmapSize.Height * y) + x) << 1;
-            ((Color_t*)this->data)[pixel] = Color_t(r, g, b, a);
+            ((Color_t*)this->data)[(this->bitmapSize.Width * y) + x] = Color_t(r, g, b, a);
         }
 
         /** @brief Set the RGB pixel
@@ -286,11 +286,520 @@ namespace Skathi::Bitmap
             if (this->bitmapFormat == Bitmap::ImageFormat::Indexed)
             {
                 assert(this->paletteData != NULL);
-                return this->paletteData[this->data[(this->bitmapSize.Height * y) + x]];
+                return this->paletteData[this->data[(this->bitmapSize.Width * y) + x]];
             }
             else
             {
-                return ((Color_t*)this->data)[(this->bitmapSize.Height * y) + x];
+                return ((Color_t*)this->data)[(this->bitmapSize.Width * y) + x];
+            }
+        }
+
+        /** @brief Fill rectangle with a single value (clipped to the image)
+         * @param x Left edge
+         * @param y Top edge
+         * @param width Rectangle width
+         * @param height Rectangle height
+         * @param value Color index of indexed image or RGB1555 color
+         */
+        void FillRect(int32_t x, int32_t y, int32_t width, int32_t height, uint16_t value)
+        {
+            assert(this->data != NULL);
+            Rect_t rect = { x, y, width, height };
+
+            if (!this->Clip(&rect))
+            {
+                return;
+            }
+
+            const uint8_t pixelSize = this->GetPixelSize();
+            const uint32_t word = pixelSize == 1 ? (value & 0xff) * 0x01010101 : (value * 0x00010001);
+
+            for (int32_t row = 0; row < rect.Height; row++)
+            {
+                Image::FillRow(this->GetPixelData(rect.X, rect.Y + row), rect.Width * pixelSize, pixelSize, word);
+            }
+        }
+
+        /** @brief Copy rectangle from another image of the same format (clipped to both images)
+         * @param source Source image
+         * @param sourceX Left edge in source image
+         * @param sourceY Top edge in source image
+         * @param width Rectangle width
+         * @param height Rectangle height
+         * @param x Left edge in this image
+         * @param y Top edge in this image
+         */
+        void Blit(const Image * source, int32_t sourceX, int32_t sourceY, int32_t width, int32_t height, int32_t x, int32_t y)
+        {
+            Rect_t from;
+            Rect_t to;
+
+            if (!this->ClipBlit(source, sourceX, sourceY, width, height, x, y, &from, &to))
+            {
+                return;
+            }
+
+            const uint32_t bytes = to.Width * this->GetPixelSize();
+
+            for (int32_t row = 0; row < to.Height; row++)
+            {
+                Image::CopyRow(this->GetPixelData(to.X, to.Y + row), source->GetPixelData(from.X, from.Y + row), bytes);
+            }
+        }
+
+        /** @brief Copy rectangle from another image of the same format, pixels equal to the key are skipped
+         * @param source Source image
+         * @param sourceX Left edge in source image
+         * @param sourceY Top edge in source image
+         * @param width Rectangle width
+         * @param height Rectangle height
+         * @param x Left edge in this image
+         * @param y Top edge in this image
+         * @param key Transparent color index or RGB1555 color
+         */
+        void BlitKeyed(const Image * source, int32_t sourceX, int32_t sourceY, int32_t width, int32_t height, int32_t x, int32_t y, uint16_t key)
+        {
+            Rect_t from;
+            Rect_t to;
+
+            if (!this->ClipBlit(source, sourceX, sourceY, width, height, x, y, &from, &to))
+            {
+                return;
+            }
+
+            const uint8_t pixelSize = this->GetPixelSize();
+
+            for (int32_t row = 0; row < to.Height; row++)
+            {
+                Image::CopyRowKeyed(this->GetPixelData(to.X, to.Y + row), source->GetPixelData(from.X, from.Y + row), to.Width, pixelSize, key);
+            }
+        }
+
+        /** @brief Convert indexed image to RGB1555 image of the same size
+         * @param target RGB image
+         */
+        void ConvertToRGB(Image * target) const
+        {
+            assert(this->bitmapFormat == Bitmap::ImageFormat::Indexed && this->paletteData != NULL);
+            assert(target->bitmapFormat == Bitmap::ImageFormat::RGB);
+            assert(target->bitmapSize.Width == this->bitmapSize.Width && target->bitmapSize.Height == this->bitmapSize.Height);
+
+            const uint8_t * from = this->data;
+            uint16_t * to = (uint16_t*)target->data;
+            const uint16_t * palette = (const uint16_t*)this->paletteData;
+
+            for (uint32_t row = 0; row < this->bitmapSize.Height; row++)
+            {
+                uint32_t left = this->bitmapSize.Width;
+
+                // Rows of odd width do not start at word boundary
+                if (((uintptr_t)to & 3) != 0)
+                {
+                    *to++ = palette[*from++];
+                    left--;
+                }
+
+                for (; left >= 2; left -= 2, from += 2, to += 2)
+                {
+                    *(uint32_t*)to = Image::PackHalfWords(palette[from[0]], palette[from[1]]);
+                }
+
+                if (left != 0)
+                {
+                    *to++ = palette[*from++];
+                }
+            }
+        }
+
+        /** @brief Convert RGB1555 image to indexed image of the same size using palette of the target image
+         * @details Transparent pixels become color 0, other pixels get the nearest color of the rest of the palette.
+         * @param target Indexed image with palette
+         */
+        void ConvertToIndexed(Image * target) const
+        {
+            assert(this->bitmapFormat == Bitmap::ImageFormat::RGB);
+            assert(target->bitmapFormat == Bitmap::ImageFormat::Indexed && target->paletteData != NULL && target->paletteSize > 1);
+            assert(target->bitmapSize.Width == this->bitmapSize.Width && target->bitmapSize.Height == this->bitmapSize.Height);
+
+            const Color_t * from = (const Color_t*)this->data;
+            uint8_t * to = target->data;
+            const uint32_t count = this->bitmapSize.Width * this->bitmapSize.Height;
+
+            // Neighbouring pixels are mostly the same, remember last match
+            uint16_t lastColor = from[0].Data;
+            uint8_t lastIndex = target->FindColor(from[0]);
+            uint32_t pixel = 0;
+
+            while (pixel < count)
+            {
+                uint8_t indices[4];
+                const uint8_t packed = ((uintptr_t)(to + pixel) & 3) == 0 && count - pixel >= 4 ? 4 : 1;
+
+                for (uint8_t index = 0; index < packed; index++)
+                {
+                    if (from[pixel + index].Data != lastColor)
+                    {
+                        lastColor = from[pixel + index].Data;
+                        lastIndex = target->FindColor(from[pixel + index]);
+                    }
+
+                    indices[index] = lastIndex;
+                }
+
+                if (packed == 4)
+                {
+                    *(uint32_t*)(to + pixel) = Image::PackBytes(indices);
+                }
+                else
+                {
+                    to[pixel] = indices[0];
+                }
+
+                pixel += packed;
+            }
+        }
+
+    private:
+        /** @brief Rectangle
+         */
+        typedef struct
+        {
+            /** @brief Left edge
+             */
+            int32_t X;
+
+            /** @brief Top edge
+             */
+            int32_t Y;
+
+            /** @brief Width
+             */
+            int32_t Width;
+
+            /** @brief Height
+             */
+            int32_t Height;
+        } Rect_t;
+
+        /** @brief Get size of a single pixel
+         * @return Number of bytes per pixel
+         */
+        uint8_t GetPixelSize() const
+        {
+            return this->bitmapFormat == Bitmap::ImageFormat::Indexed ? 1 : 2;
+        }
+
+        /** @brief Get pixel address
+         * @param x X coordinate
+         * @param y Y coordinate
+         * @return Pixel data
+         */
+        uint8_t * GetPixelData(int32_t x, int32_t y) const
+        {
+            return this->data + (((this->bitmapSize.Width * y) + x) * this->GetPixelSize());
+        }
+
+        /** @brief Clip rectangle to the image
+         * @param rect Rectangle to clip
+         * @return true Part of the rectangle is inside of the image
+         * @return false Rectangle is outside of the image
+         */
+        bool Clip(Rect_t * rect) const
+        {
+            if (rect->X < 0)
+            {
+                rect->Width += rect->X;
+                rect->X = 0;
+            }
+
+            if (rect->Y < 0)
+            {
+                rect->Height += rect->Y;
+                rect->Y = 0;
+            }
+
+            if (rect->X + rect->Width > (int32_t)this->bitmapSize.Width)
+            {
+                rect->Width = this->bitmapSize.Width - rect->X;
+            }
+
+            if (rect->Y + rect->Height > (int32_t)this->bitmapSize.Height)
+            {
+                rect->Height = this->bitmapSize.Height - rect->Y;
+            }
+
+            return rect->Width > 0 && rect->Height > 0;
+        }
+
+        /** @brief Clip copied rectangle to both images
+         * @param source Source image
+         * @param sourceX Left edge in source image
+         * @param sourceY Top edge in source image
+         * @param width Rectangle width
+         * @param height Rectangle height
+         * @param x Left edge in this image
+         * @param y Top edge in this image
+         * @param from Clipped source rectangle
+         * @param to Clipped target rectangle
+         * @return true Something is left to copy
+         * @return false Nothing to copy
+         */
+        bool ClipBlit(const Image * source, int32_t sourceX, int32_t sourceY, int32_t width, int32_t height, int32_t x, int32_t y, Rect_t * from, Rect_t * to) const
+        {
+            assert(source != NULL && source->data != NULL && this->data != NULL);
+            assert(source->bitmapFormat == this->bitmapFormat);
+
+            *from = { sourceX, sourceY, width, height };
+
+            if (!source->Clip(from))
+            {
+                return false;
+            }
+
+            // Move target by what was cut from the source, then clip target and shrink source to match
+            *to = { x + (from->X - sourceX), y + (from->Y - sourceY), from->Width, from->Height };
+            const int32_t left = to->X;
+            const int32_t top = to->Y;
+
+            if (!this->Clip(to))
+            {
+                return false;
+            }
+
+            from->X += to->X - left;
+            from->Y += to->Y - top;
+            from->Width = to->Width;
+            from->Height = to->Height;
+            return true;
+        }
+
+        /** @brief Find palette entry nearest to the color
+         * @param color Color to look for
+         * @return Palette index (0 for transparent color)
+         */
+        uint8_t FindColor(Color_t color) const
+        {
+            if (color.Components.Alpha == 0)
+            {
+                return 0;
+            }
+
+            uint8_t nearest = 1;
+            int32_t nearestDistance = INT32_MAX;
+
+            for (uint16_t index = 1; index < this->paletteSize; index++)
+            {
+                const Color_t entry = this->paletteData[index];
+                const int32_t r = (int32_t)entry.Components.R - color.Components.R;
+                const int32_t g = (int32_t)entry.Components.G - color.Components.G;
+                const int32_t b = (int32_t)entry.Components.B - color.Components.B;
+                const int32_t distance = (r * r) + (g * g) + (b * b);
+
+                if (distance < nearestDistance)
+                {
+                    nearest = index;
+                    nearestDistance = distance;
+
+                    if (distance == 0)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            return nearest;
+        }
+
+        /** @brief Pack two pixels into a word, first pixel goes to the lower address
+         * @param first First pixel
+         * @param second Second pixel
+         * @return Packed pixels
+         */
+        static uint32_t PackHalfWords(uint16_t first, uint16_t second)
+        {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return ((uint32_t)second << 16) | first;
+#else
+            return ((uint32_t)first << 16) | second;
+#endif
+        }
+
+        /** @brief Pack four pixels into a word, first pixel goes to the lowest address
+         * @param pixels Pixels
+         * @return Packed pixels
+         */
+        static uint32_t PackBytes(const uint8_t * pixels)
+        {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return ((uint32_t)pixels[3] << 24) | ((uint32_t)pixels[2] << 16) | ((uint32_t)pixels[1] << 8) | pixels[0];
+#else
+            return ((uint32_t)pixels[0] << 24) | ((uint32_t)pixels[1] << 16) | ((uint32_t)pixels[2] << 8) | pixels[3];
+#endif
+        }
+
+        /** @brief Store single pixel
+         * @param pixel Pixel address
+         * @param pixelSize Number of bytes per pixel
+         * @param value Pixel value
+         */
+        static void StorePixel(uint8_t * pixel, uint8_t pixelSize, uint16_t value)
+        {
+            if (pixelSize == 1)
+            {
+                *pixel = (uint8_t)value;
+            }
+            else
+            {
+                *(uint16_t*)pixel = value;
+            }
+        }
+
+        /** @brief Load single pixel
+         * @param pixel Pixel address
+         * @param pixelSize Number of bytes per pixel
+         * @return Pixel value
+         */
+        static uint16_t LoadPixel(const uint8_t * pixel, uint8_t pixelSize)
+        {
+            return pixelSize == 1 ? *pixel : *(const uint16_t*)pixel;
+        }
+
+        /** @brief Fill row with word stores
+         * @param row First pixel
+         * @param bytes Row length in bytes
+         * @param pixelSize Number of bytes per pixel
+         * @param word Pixel value repeated over the whole word
+         */
+        static void FillRow(uint8_t * row, uint32_t bytes, uint8_t pixelSize, uint32_t word)
+        {
+            for (; bytes > 0 && ((uintptr_t)row & 3) != 0; bytes -= pixelSize, row += pixelSize)
+            {
+                Image::StorePixel(row, pixelSize, (uint16_t)word);
+            }
+
+            uint32_t * words = (uint32_t*)row;
+
+            for (; bytes >= 16; bytes -= 16, words += 4)
+            {
+                words[0] = word;
+                words[1] = word;
+                words[2] = word;
+                words[3] = word;
+            }
+
+            for (; bytes >= 4; bytes -= 4)
+            {
+                *words++ = word;
+            }
+
+            for (row = (uint8_t*)words; bytes > 0; bytes -= pixelSize, row += pixelSize)
+            {
+                Image::StorePixel(row, pixelSize, (uint16_t)word);
+            }
+        }
+
+        /** @brief Copy row with word loads and stores when both rows have the same alignment
+         * @param to Target row
+         * @param from Source row
+         * @param bytes Row length in bytes
+         */
+        static void CopyRow(uint8_t * to, const uint8_t * from, uint32_t bytes)
+        {
+            if ((((uintptr_t)to ^ (uintptr_t)from) & 3) != 0)
+            {
+                memcpy(to, from, bytes);
+                return;
+            }
+
+            for (; bytes > 0 && ((uintptr_t)to & 3) != 0; bytes--)
+            {
+                *to++ = *from++;
+            }
+
+            uint32_t * targetWords = (uint32_t*)to;
+            const uint32_t * sourceWords = (const uint32_t*)from;
+
+            for (; bytes >= 16; bytes -= 16, targetWords += 4, sourceWords += 4)
+            {
+                targetWords[0] = sourceWords[0];
+                targetWords[1] = sourceWords[1];
+                targetWords[2] = sourceWords[2];
+                targetWords[3] = sourceWords[3];
+            }
+
+            for (; bytes >= 4; bytes -= 4)
+            {
+                *targetWords++ = *sourceWords++;
+            }
+
+            to = (uint8_t*)targetWords;
+            from = (const uint8_t*)sourceWords;
+
+            for (; bytes > 0; bytes--)
+            {
+                *to++ = *from++;
+            }
+        }
+
+        /** @brief Copy row skipping key pixels, words without key pixels are copied in one store
+         * @param to Target row
+         * @param from Source row
+         * @param pixels Row length in pixels
+         * @param pixelSize Number of bytes per pixel
+         * @param key Skipped pixel value
+         */
+        static void CopyRowKeyed(uint8_t * to, const uint8_t * from, uint32_t pixels, uint8_t pixelSize, uint16_t key)
+        {
+            const uint32_t perWord = 4 / pixelSize;
+
+            // Word has a key pixel when XOR with the key leaves a zero pixel in it
+            const uint32_t keyWord = pixelSize == 1 ? (key & 0xff) * 0x01010101 : (key * 0x00010001);
+            const uint32_t low = pixelSize == 1 ? 0x01010101 : 0x00010001;
+            const uint32_t high = low << ((pixelSize << 3) - 1);
+
+            if ((((uintptr_t)to ^ (uintptr_t)from) & 3) == 0)
+            {
+                for (; pixels > 0 && ((uintptr_t)to & 3) != 0; pixels--, to += pixelSize, from += pixelSize)
+                {
+                    const uint16_t value = Image::LoadPixel(from, pixelSize);
+
+                    if (value != key)
+                    {
+                        Image::StorePixel(to, pixelSize, value);
+                    }
+                }
+
+                for (; pixels >= perWord; pixels -= perWord, to += 4, from += 4)
+                {
+                    const uint32_t word = *(const uint32_t*)from;
+                    const uint32_t difference = word ^ keyWord;
+
+                    if (((difference - low) & ~difference & high) == 0)
+                    {
+                        *(uint32_t*)to = word;
+                        continue;
+                    }
+
+                    for (uint8_t pixel = 0; pixel < 4; pixel += pixelSize)
+                    {
+                        const uint16_t value = Image::LoadPixel(from + pixel, pixelSize);
+
+                        if (value != key)
+                        {
+                            Image::StorePixel(to + pixel, pixelSize, value);
+                        }
+                    }
+                }
+            }
+
+            for (; pixels > 0; pixels--, to += pixelSize, from += pixelSize)
+            {
+                const uint16_t value = Image::LoadPixel(from, pixelSize);
+
+                if (value != key)
+                {
+                    Image::StorePixel(to, pixelSize, value);
+                }
             }
         }
     };
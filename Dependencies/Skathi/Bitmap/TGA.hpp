@@ -6,12 +6,13 @@
 #include <tga.h>
 #include "Image.hpp"
 #include "../Cd.hpp"
+#include "../Compression/Packed.hpp"
 
 namespace Skathi::Bitmap
 {
     /** @brief Image loaded from TGA file
      */
-    class TGAImage : Image
+    class TGAImage : public Image
     {
     private:
         /** @brief Load image
@@ -31,6 +32,7 @@ namespace Skathi::Bitmap
             if (image.tga_bpp == 8)
             {
                 this->bitmapFormat = Skathi::Bitmap::ImageFormat::Indexed;
+                assert(image.tga_cmap_len > 0 && image.tga_cmap_len <= 256);
                 this->paletteSize = image.tga_cmap_len;
 
                 // Load palette
@@ -68,9 +70,10 @@ namespace Skathi::Bitmap
          */
         TGAImage(const cdfs_filelist_entry_t * file)
         {
-            // Read file into a buffer
-            uint8_t * buffer = (uint8_t*)malloc(file->size);
-            assert(Cd::ReadFile(file, buffer));
+            // Read file into a buffer, packed files are decompressed
+            uint32_t size;
+            uint8_t * buffer = Compression::Packed::ReadFile(file, &size);
+            assert(buffer != NULL);
 
             // Load image
             this->LoadImage(buffer);
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace Skathi
+{
+    /** @brief Least recently used cache of disc reads kept in extra memory (does not depend on yaul, so host tools can back it with plain buffer)
+     * @details Each entry holds data read from a disc sector address (FAD) onwards. Read of the same address that is not longer
+     * than the stored data is served from the cache. Entries are placed into the first gap large enough, least recently used
+     * entries are evicted until such gap exists. Data larger than the whole cache is never stored.
+     */
+    class Cache
+    {
+    public:
+        /** @brief Largest number of cached reads
+         */
+        static constexpr uint16_t MaxEntries = 256;
+
+    private:
+        /** @brief Cached read
+         */
+        struct Entry
+        {
+            /** @brief Sector address the read started at
+             */
+            uint32_t Fad;
+
+            /** @brief Size of cached data
+             */
+            uint32_t Size;
+
+            /** @brief Offset of cached data from the start of the cache memory
+             */
+            uint32_t Offset;
+
+            /** @brief Access counter value at the last use
+             */
+            uint32_t Used;
+        };
+
+        /** @brief Cache memory
+         */
+        inline static uint8_t * area = NULL;
+
+        /** @brief Size of cache memory
+         */
+        inline static uint32_t capacity = 0;
+
+        /** @brief Cached reads ordered by offset
+         */
+        inline static Entry entries[Cache::MaxEntries];
+
+        /** @brief Number of cached reads
+         */
+        inline static uint16_t count = 0;
+
+        /** @brief Access counter
+         */
+        inline static uint32_t clock = 0;
+
+        /** @brief Number of reads served from the cache
+         */
+        inline static uint32_t hits = 0;
+
+        /** @brief Number of reads not found in the cache
+         */
+        inline static uint32_t misses = 0;
+
+        /** @brief Round size up to whole words
+         * @param size Size in bytes
+         * @return Aligned size
+         */
+        static uint32_t Align(uint32_t size)
+        {
+            return (size + 3) & ~3;
+        }
+
+        /** @brief Remove entry
+         * @param index Entry index
+         */
+        static void Remove(uint16_t index)
+        {
+            memmove(&Cache::entries[index], &Cache::entries[index + 1], (Cache::count - index - 1) * sizeof(Entry));
+            Cache::count--;
+        }
+
+        /** @brief Find first gap large enough
+         * @param size Aligned size
+         * @param offset Offset of the gap
+         * @return Index the new entry is inserted at or -1 if there is no such gap
+         */
+        static int32_t FindGap(uint32_t size, uint32_t * offset)
+        {
+            uint32_t start = 0;
+
+            for (uint16_t index = 0; index <= Cache::count; index++)
+            {
+                const uint32_t end = index < Cache::count ? Cache::entries[index].Offset : Cache::capacity;
+
+                if (end - start >= size)
+                {
+                    *offset = start;
+                    return index;
+                }
+
+                if (index < Cache::count)
+                {
+                    start = Cache::entries[index].Offset + Cache::Align(Cache::entries[index].Size);
+                }
+            }
+
+            return -1;
+        }
+
+        /** @brief Remove least recently used entry
+         */
+        static void Evict()
+        {
+            uint16_t oldest = 0;
+
+            for (uint16_t index = 1; index < Cache::count; index++)
+            {
+                if (Cache::entries[index].Used < Cache::entries[oldest].Used)
+                {
+                    oldest = index;
+                }
+            }
+
+            Cache::Remove(oldest);
+        }
+
+    public:
+        /** @brief Start using cache memory, all cached data is dropped
+         * @param memory Cache memory (NULL disables cache)
+         * @param size Size of cache memory
+         */
+        static void Initialize(void * memory, uint32_t size)
+        {
+            Cache::area = (uint8_t*)memory;
+            Cache::capacity = memory != NULL ? size & ~3 : 0;
+            Cache::count = 0;
+            Cache::clock = 0;
+            Cache::hits = 0;
+            Cache::misses = 0;
+        }
+
+        /** @brief Check whether cache has memory
+         * @return true Reads are cached
+         * @return false Cache is disabled
+         */
+        static bool IsEnabled()
+        {
+            return Cache::area != NULL;
+        }
+
+        /** @brief Find cached read
+         * @param fad Sector address the read starts at
+         * @param size Number of bytes read
+         * @return Cached data or NULL if read is not cached
+         */
+        static const uint8_t * Find(uint32_t fad, uint32_t size)
+        {
+            if (Cache::area == NULL)
+            {
+                return NULL;
+            }
+
+            for (uint16_t index = 0; index < Cache::count; index++)
+            {
+                Entry * entry = &Cache::entries[index];
+
+                if (entry->Fad == fad && entry->Size >= size)
+                {
+                    entry->Used = ++Cache::clock;
+                    Cache::hits++;
+                    return Cache::area + entry->Offset;
+                }
+            }
+
+            Cache::misses++;
+            return NULL;
+        }
+
+        /** @brief Store read data, shorter reads from the same address are replaced
+         * @param fad Sector address the read started at
+         * @param data Read data
+         * @param size Number of bytes read
+         */
+        static void Store(uint32_t fad, const void * data, uint32_t size)
+        {
+            if (Cache::area == NULL || size == 0 || size > Cache::capacity)
+            {
+                return;
+            }
+
+            for (uint16_t index = 0; index < Cache::count;)
+            {
+                if (Cache::entries[index].Fad == fad)
+                {
+                    Cache::Remove(index);
+                }
+                else
+                {
+                    index++;
+                }
+            }
+
+            if (Cache::count == Cache::MaxEntries)
+            {
+                Cache::Evict();
+            }
+
+            uint32_t offset = 0;
+            int32_t index;
+
+            while ((index = Cache::FindGap(Cache::Align(size), &offset)) < 0)
+            {
+                Cache::Evict();
+            }
+
+            memmove(&Cache::entries[index + 1], &Cache::entries[index], (Cache::count - index) * sizeof(Entry));
+            Cache::entries[index] = { Fad : fad, Size : size, Offset : offset, Used : ++Cache::clock };
+            Cache::count++;
+            memcpy(Cache::area + offset, data, size);
+        }
+
+        /** @brief Drop all cached data
+         */
+        static void Clear()
+        {
+            Cache::count = 0;
+        }
+
+        /** @brief Get number of reads served from the cache
+         * @return Hit count
+         */
+        static uint32_t GetHits()
+        {
+            return Cache::hits;
+        }
+
+        /** @brief Get number of reads not found in the cache
+         * @return Miss count
+         */
+        static uint32_t GetMisses()
+        {
+            return Cache::misses;
+        }
+
+        /** @brief Get size of cached data
+         * @return Used bytes
+         */
+        static uint32_t GetUsed()
+        {
+            uint32_t used = 0;
+
+            for (uint16_t index = 0; index < Cache::count; index++)
+            {
+                used += Cache::Align(Cache::entries[index].Size);
+            }
+
+            return used;
+        }
+    };
+}
@@ -1,30 +1,266 @@
 #pragma once
 
 #include <yaul.h>
+#include "Cache.hpp"
+#include "CdScheduler.hpp"
 
 namespace Skathi
 {
     /** @brief File and CD access wrapper
+     * @details When 1MB or 4MB DRAM cartridge is inserted, disc reads are kept in it (see Cache), so files loaded again are copied from the cartridge instead of the disc.
+     * Directory listings are read on first access into a fixed entry pool and kept there, least recently used listings are dropped when the pool is full.
+     * Entries of the root directory stay valid forever, entries of other directories only until the next ChangeDir.
+     * Listing that does not fit into the pool even with all other listings dropped is kept cut to the pool size, so files past
+     * the limit are not found (see GetTruncatedListings). Raise MaxEntries for discs with larger directories.
+     * Data reads go through CdScheduler, so they can share the drive with CD-DA music. Loading uses the waiting reads, code running
+     * during the game queues reads with QueueFileRange and Prefetch and polls their status.
      */
     class Cd
     {
+    public:
+        /** @brief Size of a disc sector
+         */
+        static constexpr uint32_t SectorSize = 2048;
+
+        /** @brief Number of directory entries all cached listings share (also the largest directory that can be listed whole)
+         */
+        static constexpr uint16_t MaxEntries = 128;
+
+        /** @brief Largest number of cached directory listings
+         */
+        static constexpr uint8_t MaxDirectories = 8;
+
     private:
+        /** @brief Cached directory listing
+         */
+        struct Directory
+        {
+            /** @brief Sector address of the directory (0 for root directory)
+             */
+            uint32_t Fad;
+
+            /** @brief Index of the first entry in the pool
+             */
+            uint16_t First;
+
+            /** @brief Number of entries
+             */
+            uint16_t Count;
+
+            /** @brief Access counter value at the last use
+             */
+            uint32_t Used;
+        };
+
         /** @brief Current directory listing
          */
         inline static cdfs_filelist_t files;
 
+        /** @brief Drive functions used by the scheduler
+         */
+        inline static CdScheduler::Backend drive;
+
+        /** @brief Entries of all cached listings, listings are stored one after another in the order of the directories array
+         */
+        inline static cdfs_filelist_entry_t entries[Cd::MaxEntries];
+
+        /** @brief Cached listings, root directory is always first
+         */
+        inline static Directory directories[Cd::MaxDirectories];
+
+        /** @brief Number of cached listings
+         */
+        inline static uint8_t directoryCount = 0;
+
+        /** @brief Access counter
+         */
+        inline static uint32_t clock = 0;
+
+        /** @brief Number of listings read from the disc
+         */
+        inline static uint32_t directoryReads = 0;
+
+        /** @brief Number of listings that filled the whole free pool and might have been cut short
+         */
+        inline static uint32_t truncatedListings = 0;
+
+        /** @brief Get number of used pool entries
+         * @return Entry count
+         */
+        static uint16_t GetUsedEntries()
+        {
+            if (Cd::directoryCount == 0)
+            {
+                return 0;
+            }
+
+            const Directory * last = &Cd::directories[Cd::directoryCount - 1];
+            return last->First + last->Count;
+        }
+
+        /** @brief Drop cached listing and move later listings in its place
+         * @param index Listing index (root directory cannot be dropped)
+         */
+        static void Drop(uint8_t index)
+        {
+            assert(index > 0 && index < Cd::directoryCount);
+            const Directory dropped = Cd::directories[index];
+            const uint16_t used = Cd::GetUsedEntries();
+
+            memmove(&Cd::entries[dropped.First], &Cd::entries[dropped.First + dropped.Count], (used - dropped.First - dropped.Count) * sizeof(cdfs_filelist_entry_t));
+            memmove(&Cd::directories[index], &Cd::directories[index + 1], (Cd::directoryCount - index - 1) * sizeof(Directory));
+            Cd::directoryCount--;
+
+            for (uint8_t later = index; later < Cd::directoryCount; later++)
+            {
+                Cd::directories[later].First -= dropped.Count;
+            }
+        }
+
+        /** @brief Drop least recently used listing
+         * @return true Listing was dropped
+         * @return false Only root directory is cached
+         */
+        static bool DropOldest()
+        {
+            if (Cd::directoryCount < 2)
+            {
+                return false;
+            }
+
+            uint8_t oldest = 1;
+
+            for (uint8_t index = 2; index < Cd::directoryCount; index++)
+            {
+                if (Cd::directories[index].Used < Cd::directories[oldest].Used)
+                {
+                    oldest = index;
+                }
+            }
+
+            Cd::Drop(oldest);
+            return true;
+        }
+
+        /** @brief Read listing into the free end of the pool
+         * @param directory Directory entry (NULL for root directory)
+         * @return Number of read entries, equals free entry count when listing might not fit
+         */
+        static uint16_t ReadListing(const cdfs_filelist_entry_t * directory)
+        {
+            const uint16_t used = Cd::GetUsedEntries();
+            const bool resume = CdScheduler::BeginDirect();
+            cdfs_filelist_t listing;
+            cdfs_filelist_default_init(&listing, &Cd::entries[used], Cd::MaxEntries - used);
+
+            if (directory == NULL)
+            {
+                cdfs_filelist_root_read(&listing);
+            }
+            else
+            {
+                cdfs_filelist_read(&listing, *directory);
+            }
+
+            CdScheduler::EndDirect(resume);
+            Cd::directoryReads++;
+            return listing.entries_count;
+        }
+
+        /** @brief Make cached listing current, listing is read from the disc if it is not cached
+         * @param directory Directory entry (NULL for root directory)
+         */
+        static void Open(const cdfs_filelist_entry_t * directory)
+        {
+            const uint32_t fad = directory != NULL ? directory->starting_fad : 0;
+            int16_t index = -1;
+
+            for (uint8_t cached = 0; cached < Cd::directoryCount; cached++)
+            {
+                if (Cd::directories[cached].Fad == fad)
+                {
+                    index = cached;
+                    break;
+                }
+            }
+
+            if (index < 0)
+            {
+                if (Cd::directoryCount == Cd::MaxDirectories)
+                {
+                    Cd::DropOldest();
+                }
+
+                uint16_t count = Cd::ReadListing(directory);
+
+                // Full pool might have cut the listing short, read it again with all other listings dropped
+                while (count == Cd::MaxEntries - Cd::GetUsedEntries() && Cd::DropOldest())
+                {
+                    count = Cd::ReadListing(directory);
+                }
+
+                const uint16_t first = Cd::GetUsedEntries();
+
+                // Nothing else can be dropped, listing is kept as it is and files past the pool are not found
+                if (count == Cd::MaxEntries - first)
+                {
+                    Cd::truncatedListings++;
+                }
+
+                index = Cd::directoryCount++;
+                Cd::directories[index] = { Fad : fad, First : first, Count : count, Used : 0 };
+            }
+
+            Directory * current = &Cd::directories[index];
+            current->Used = ++Cd::clock;
+            Cd::files.entries = &Cd::entries[current->First];
+            Cd::files.entries_pooled_count = current->Count;
+            Cd::files.entries_count = current->Count;
+        }
+
+        /** @brief Read sectors directly from the drive
+         * @param fad Sector address to start at
+         * @param buffer Target buffer
+         * @param size Number of bytes to read
+         * @return true Data was read
+         * @return false Reading ended with error
+         */
+        static bool ReadSectors(uint32_t fad, void * buffer, uint32_t size)
+        {
+            return cd_block_sectors_read(fad, buffer, size) == 0;
+        }
+
+        /** @brief Use DRAM cartridge as read cache if there is one
+         */
+        static void InitializeCart()
+        {
+            dram_cart_init();
+            const dram_cart_id_t id = dram_cart_id_get();
+
+            if (id == DRAM_CART_ID_1MIB || id == DRAM_CART_ID_4MIB)
+            {
+                Cache::Initialize(dram_cart_area_get(), dram_cart_size_get());
+            }
+            else
+            {
+                Cache::Initialize(NULL, 0);
+            }
+        }
+
     public:
         /** @brief Initialize file handling stuff
          */
         static void Initialize()
         {
-            /* Load the maximum number. We have to free the allocated filelist
-             * entries, but since we never exit, we don't have to */
-            cdfs_filelist_entry_t * const filelist_entries = cdfs_entries_alloc(-1);
-            assert(filelist_entries != NULL);
+            Cd::InitializeCart();
 
-            cdfs_filelist_default_init(&Cd::files, filelist_entries, -1);
-            cdfs_filelist_root_read(&Cd::files);
+            // There is no music until SetMusic is called
+            Cd::drive = { Read : Cd::ReadSectors, Play : NULL, Stop : NULL };
+            CdScheduler::Initialize(&Cd::drive);
+
+            // Only root directory is read now, other directories are read on first ChangeDir
+            Cd::directoryCount = 0;
+            Cd::Open(NULL);
         }
 
         /** @brief Get the All files
@@ -61,16 +297,63 @@ namespace Skathi
         {
             if (name == NULL)
             {
-                cdfs_filelist_root_read(&Cd::files);
+                Cd::Open(NULL);
             }
             else
             {
-                cdfs_filelist_entry_t * directory = Cd::FindFileByName(name);
-                assert(directory->type == CDFS_ENTRY_TYPE_DIRECTORY);
-                cdfs_filelist_read(&Cd::files, *directory);
+                // Entry is copied, reading the listing can move entries of the current directory
+                cdfs_filelist_entry_t * found = Cd::FindFileByName(name);
+                assert(found != NULL && found->type == CDFS_ENTRY_TYPE_DIRECTORY);
+                const cdfs_filelist_entry_t directory = *found;
+                Cd::Open(&directory);
             }
         }
 
+        /** @brief Queue part of a file to be read into the DRAM cartridge while the drive is idle, later ReadFileRange of the same range does not touch the drive
+         * @param file File to read
+         * @param offset Offset from the start of the file
+         * @param length Number of bytes to read
+         * @return true Range was queued or there is no cartridge to read into
+         * @return false Queue is full
+         */
+        static bool Prefetch(const cdfs_filelist_entry_t * file, uint32_t offset, uint32_t length)
+        {
+            if (!Cache::IsEnabled())
+            {
+                return true;
+            }
+
+            const uint32_t skip = offset % Cd::SectorSize;
+            const CdScheduler::Request request = { Fad : file->starting_fad + (offset / Cd::SectorSize), Size : skip + length, Buffer : NULL, Done : NULL, Served : 0 };
+            return CdScheduler::Queue(&request);
+        }
+
+        /** @brief Set CD-DA playback functions, data reads then stop the music only for as long as they need the drive
+         * @param play Start playback at sector address and stop or loop at end address
+         * @param stop Stop playback and return sector address it stopped at
+         */
+        static void SetMusic(void (*play)(uint32_t fad, uint32_t end), uint32_t (*stop)())
+        {
+            Cd::drive.Play = play;
+            Cd::drive.Stop = stop;
+        }
+
+        /** @brief Get number of directory listings read from the disc
+         * @return Listing read count
+         */
+        static uint32_t GetDirectoryReads()
+        {
+            return Cd::directoryReads;
+        }
+
+        /** @brief Get number of directory listings that filled the whole free pool (listing might be missing entries past MaxEntries)
+         * @return Truncated listing count
+         */
+        static uint32_t GetTruncatedListings()
+        {
+            return Cd::truncatedListings;
+        }
+
         /** @brief Read whole file into a buffer
          * @param file File to read
          * @param buffer Target buffer
@@ -80,7 +363,64 @@ namespace Skathi
          */
         static bool ReadFileBytes(const cdfs_filelist_entry_t * file, void * buffer, uint32_t length)
         {
-            return cd_block_sectors_read(file->starting_fad, buffer, length) == 0;
+            const uint8_t * cached = Cache::Find(file->starting_fad, length);
+
+            if (cached != NULL)
+            {
+                memcpy(buffer, cached, length);
+                return true;
+            }
+
+            return CdScheduler::Read(file->starting_fad, buffer, length);
+        }
+
+        /** @brief Read part of a file, reads always start at sector boundary
+         * @param file File to read
+         * @param offset Offset from the start of the file
+         * @param length Number of bytes to read
+         * @param buffer Target buffer (at least offset % SectorSize + length bytes large)
+         * @return Requested data in the buffer or NULL if reading ended with error
+         */
+        static const uint8_t * ReadFileRange(const cdfs_filelist_entry_t * file, uint32_t offset, uint32_t length, uint8_t * buffer)
+        {
+            const uint32_t skip = offset % Cd::SectorSize;
+            const uint32_t fad = file->starting_fad + (offset / Cd::SectorSize);
+            const uint8_t * cached = Cache::Find(fad, skip + length);
+
+            if (cached != NULL)
+            {
+                memcpy(buffer + skip, cached + skip, length);
+                return buffer + skip;
+            }
+
+            return CdScheduler::Read(fad, buffer, skip + length) ? buffer + skip : NULL;
+        }
+
+        /** @brief Queue read of part of a file without waiting for it, data is read by following CdScheduler::Update calls
+         * @details Range found in the DRAM cartridge is copied at once and status is set to done before this returns.
+         * @param file File to read
+         * @param offset Offset from the start of the file
+         * @param length Number of bytes to read
+         * @param buffer Target buffer (at least offset % SectorSize + length bytes large, has to stay valid until the read is served)
+         * @param status Set to CdScheduler::Status::Done or CdScheduler::Status::Failed once the read is served
+         * @return Position of requested data in the buffer (valid once status is done) or NULL if queue is full
+         */
+        static const uint8_t * QueueFileRange(const cdfs_filelist_entry_t * file, uint32_t offset, uint32_t length, uint8_t * buffer, CdScheduler::Status * status)
+        {
+            assert(status != NULL);
+            const uint32_t skip = offset % Cd::SectorSize;
+            const uint32_t fad = file->starting_fad + (offset / Cd::SectorSize);
+            const uint8_t * cached = Cache::Find(fad, skip + length);
+
+            if (cached != NULL)
+            {
+                memcpy(buffer + skip, cached + skip, length);
+                *status = CdScheduler::Status::Done;
+                return buffer + skip;
+            }
+
+            const CdScheduler::Request request = { Fad : fad, Size : skip + length, Buffer : buffer, Done : status, Served : 0 };
+            return CdScheduler::Queue(&request) ? buffer + skip : NULL;
         }
 
         /** @brief Read whole file into a buffer
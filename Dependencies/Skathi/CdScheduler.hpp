@@ -0,0 +1,575 @@
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "Cache.hpp"
+
+namespace Skathi
+{
+    /** @brief Shares the drive between CD-DA music and data reads (does not depend on yaul, so host tools can drive it with simulated backend)
+     * @details Data reads are queued and served by Update in ascending sector address (FAD) order starting at the drive head, wrapping around
+     * once the highest address is reached, so a batch of reads crosses the disc only once. Update reads only a limited number of sectors each
+     * frame, larger reads are finished over several frames and the caller polls the request status. Music is stopped when a batch starts,
+     * stays stopped while reads queued meanwhile join the batch and is resumed where it stopped once the queue has no data reads left.
+     * Drive backend blocks until its sectors arrive, so a frame serving reads still waits for its sectors and at most one seek.
+     * Finished data reads and prefetch requests are stored in Cache, later reads of the same range are then served from memory and do not
+     * stop the music at all. Prefetch requests are read only while the drive is idle (no music and no data reads).
+     */
+    class CdScheduler
+    {
+    public:
+        /** @brief Largest number of queued requests
+         */
+        static constexpr uint8_t MaxRequests = 32;
+
+        /** @brief Size of a disc sector
+         */
+        static constexpr uint32_t SectorSize = 2048;
+
+        /** @brief Read speed at 2x in sectors per second
+         */
+        static constexpr uint32_t SectorsPerSecond = 150;
+
+        /** @brief Gap in sectors the drive reads through instead of seeking
+         */
+        static constexpr uint32_t ReadThroughSectors = 16;
+
+        /** @brief Time of the shortest seek in microseconds
+         */
+        static constexpr uint32_t SeekBaseMicroseconds = 50000;
+
+        /** @brief Time of a seek across the whole disc in microseconds
+         */
+        static constexpr uint32_t SeekFullMicroseconds = 400000;
+
+        /** @brief Number of sectors on a full disc (74 minutes)
+         */
+        static constexpr uint32_t DiscSectors = 333000;
+
+        /** @brief Drive functions
+         */
+        struct Backend
+        {
+            /** @brief Read sectors
+             * @param fad Sector address to start at
+             * @param buffer Target buffer
+             * @param size Number of bytes to read
+             * @return true Data was read
+             * @return false Reading ended with error
+             */
+            bool (*Read)(uint32_t fad, void * buffer, uint32_t size);
+
+            /** @brief Start CD-DA playback (NULL when there is no music)
+             * @param fad Sector address to start at
+             * @param end Sector address to stop or loop at
+             */
+            void (*Play)(uint32_t fad, uint32_t end);
+
+            /** @brief Stop CD-DA playback (NULL when there is no music)
+             * @return Sector address playback stopped at
+             */
+            uint32_t (*Stop)();
+        };
+
+        /** @brief State of a queued request
+         */
+        enum class Status : uint8_t
+        {
+            /** @brief Request is waiting or partially read
+             */
+            Queued,
+
+            /** @brief All data was read
+             */
+            Done,
+
+            /** @brief Reading ended with error
+             */
+            Failed
+        };
+
+        /** @brief Queued request
+         */
+        struct Request
+        {
+            /** @brief Sector address to start at
+             */
+            uint32_t Fad;
+
+            /** @brief Number of bytes to read
+             */
+            uint32_t Size;
+
+            /** @brief Target buffer (NULL for prefetch into Cache)
+             */
+            void * Buffer;
+
+            /** @brief Set to Status::Queued when queued and to Status::Done or Status::Failed once served (can be NULL)
+             */
+            Status * Done;
+
+            /** @brief Number of bytes already read (reset when queued)
+             */
+            uint32_t Served;
+        };
+
+    private:
+        /** @brief Drive functions
+         */
+        inline static const Backend * backend = NULL;
+
+        /** @brief Queued requests
+         */
+        inline static Request requests[CdScheduler::MaxRequests];
+
+        /** @brief Number of queued requests
+         */
+        inline static uint8_t count = 0;
+
+        /** @brief Index of the data read being served over several updates (-1 when there is none)
+         */
+        inline static int16_t active = -1;
+
+        /** @brief Data reads are being served, music stays stopped until the batch ends
+         */
+        inline static bool batch = false;
+
+        /** @brief Music was interrupted by the current batch
+         */
+        inline static bool resumeMusic = false;
+
+        /** @brief Sector address under the drive head
+         */
+        inline static uint32_t head = 0;
+
+        /** @brief Music is playing
+         */
+        inline static bool playing = false;
+
+        /** @brief Sector address music stops or loops at
+         */
+        inline static uint32_t musicEnd = 0;
+
+        /** @brief Sector address music was interrupted at
+         */
+        inline static uint32_t musicPosition = 0;
+
+        /** @brief Total distance of all seeks in sectors
+         */
+        inline static uint32_t seekDistance = 0;
+
+        /** @brief Estimated drive time in microseconds
+         */
+        inline static uint32_t driveTime = 0;
+
+        /** @brief Number of times music was stopped by data reads
+         */
+        inline static uint32_t interruptions = 0;
+
+        /** @brief Get number of sectors of a read
+         * @param size Number of bytes
+         * @return Sector count
+         */
+        static uint32_t GetSectors(uint32_t size)
+        {
+            return (size + CdScheduler::SectorSize - 1) / CdScheduler::SectorSize;
+        }
+
+        /** @brief Move drive head, seek distance and time are recorded
+         * @param fad Sector address to move to
+         */
+        static void Seek(uint32_t fad)
+        {
+            CdScheduler::seekDistance += fad > CdScheduler::head ? fad - CdScheduler::head : CdScheduler::head - fad;
+            CdScheduler::driveTime += CdScheduler::GetSeekCost(CdScheduler::head, fad);
+            CdScheduler::head = fad;
+        }
+
+        /** @brief Find next data read, nearest address at or after the head first
+         * @param prefetch Look for prefetch requests instead of data reads
+         * @return Request index or -1 if there is no such request
+         */
+        static int16_t FindNext(bool prefetch)
+        {
+            int16_t ahead = -1;
+            int16_t lowest = -1;
+
+            for (uint8_t index = 0; index < CdScheduler::count; index++)
+            {
+                const Request * request = &CdScheduler::requests[index];
+
+                if ((request->Buffer == NULL) != prefetch)
+                {
+                    continue;
+                }
+
+                if (request->Fad >= CdScheduler::head && (ahead < 0 || request->Fad < CdScheduler::requests[ahead].Fad))
+                {
+                    ahead = index;
+                }
+
+                if (lowest < 0 || request->Fad < CdScheduler::requests[lowest].Fad)
+                {
+                    lowest = index;
+                }
+            }
+
+            return ahead >= 0 ? ahead : lowest;
+        }
+
+        /** @brief Remove request from the queue and report its result
+         * @param index Request index
+         * @param done Request was served without errors
+         */
+        static void Finish(uint8_t index, bool done)
+        {
+            const Request request = CdScheduler::requests[index];
+            CdScheduler::requests[index] = CdScheduler::requests[--CdScheduler::count];
+
+            if (request.Done != NULL)
+            {
+                *request.Done = done ? Status::Done : Status::Failed;
+            }
+        }
+
+        /** @brief Record time of read sectors and move the head past them
+         * @param sectors Number of read sectors
+         */
+        static void Advance(uint32_t sectors)
+        {
+            CdScheduler::driveTime += (uint32_t)(((uint64_t)sectors * 1000000) / CdScheduler::SectorsPerSecond);
+            CdScheduler::head += sectors;
+        }
+
+        /** @brief Read next part of a data read, finished read is stored in Cache and removed from the queue
+         * @param index Request index
+         * @param budget Largest number of sectors to read
+         * @return Number of read sectors
+         */
+        static uint32_t ServeRead(uint8_t index, uint32_t budget)
+        {
+            Request * request = &CdScheduler::requests[index];
+            uint8_t * buffer = (uint8_t*)request->Buffer;
+            const uint32_t remaining = request->Size - request->Served;
+            const uint32_t size = remaining < budget * CdScheduler::SectorSize ? remaining : budget * CdScheduler::SectorSize;
+
+            // Parts other than the last one are whole sectors, so each part starts at sector boundary
+            const bool read = CdScheduler::backend->Read(request->Fad + (request->Served / CdScheduler::SectorSize), buffer + request->Served, size);
+            const uint32_t sectors = CdScheduler::GetSectors(size);
+            CdScheduler::Advance(sectors);
+            request->Served += size;
+
+            if (!read || request->Served == request->Size)
+            {
+                if (read)
+                {
+                    Cache::Store(request->Fad, buffer, request->Size);
+                }
+
+                CdScheduler::Finish(index, read);
+                CdScheduler::active = -1;
+            }
+
+            return sectors;
+        }
+
+        /** @brief Read prefetch request whole into Cache and remove it from the queue
+         * @param index Request index
+         * @return Number of read sectors
+         */
+        static uint32_t ServePrefetch(uint8_t index)
+        {
+            const Request request = CdScheduler::requests[index];
+
+            // Prefetch of already cached range does not move the head
+            if (Cache::Find(request.Fad, request.Size) != NULL)
+            {
+                CdScheduler::Finish(index, true);
+                return 0;
+            }
+
+            void * buffer = malloc(request.Size);
+            assert(buffer != NULL);
+            CdScheduler::Seek(request.Fad);
+            const bool read = CdScheduler::backend->Read(request.Fad, buffer, request.Size);
+            const uint32_t sectors = CdScheduler::GetSectors(request.Size);
+            CdScheduler::Advance(sectors);
+
+            if (read)
+            {
+                Cache::Store(request.Fad, buffer, request.Size);
+            }
+
+            free(buffer);
+            CdScheduler::Finish(index, read);
+            return sectors;
+        }
+
+    public:
+        /** @brief Start scheduling, queue is emptied and statistics are reset
+         * @param drive Drive functions
+         */
+        static void Initialize(const Backend * drive)
+        {
+            assert(drive != NULL && drive->Read != NULL);
+            CdScheduler::backend = drive;
+            CdScheduler::count = 0;
+            CdScheduler::active = -1;
+            CdScheduler::batch = false;
+            CdScheduler::head = 0;
+            CdScheduler::playing = false;
+            CdScheduler::ResetStatistics();
+        }
+
+        /** @brief Check whether scheduler has a drive
+         * @return true Scheduler was initialized
+         * @return false Reads go directly to the drive
+         */
+        static bool IsInitialized()
+        {
+            return CdScheduler::backend != NULL;
+        }
+
+        /** @brief Estimate time of moving the drive head
+         * @param from Sector address of the head
+         * @param to Sector address to move to
+         * @return Time in microseconds
+         */
+        static uint32_t GetSeekCost(uint32_t from, uint32_t to)
+        {
+            // Short gaps forward are read through, anything else is a seek growing with the distance
+            if (to >= from && to - from <= CdScheduler::ReadThroughSectors)
+            {
+                return ((to - from) * 1000000) / CdScheduler::SectorsPerSecond;
+            }
+
+            const uint32_t distance = to > from ? to - from : from - to;
+            const uint32_t range = CdScheduler::SeekFullMicroseconds - CdScheduler::SeekBaseMicroseconds;
+            return CdScheduler::SeekBaseMicroseconds + (uint32_t)(((uint64_t)range * (distance < CdScheduler::DiscSectors ? distance : CdScheduler::DiscSectors)) / CdScheduler::DiscSectors);
+        }
+
+        /** @brief Start music
+         * @param fad Sector address of the track start
+         * @param end Sector address to stop or loop at
+         */
+        static void PlayMusic(uint32_t fad, uint32_t end)
+        {
+            if (CdScheduler::backend->Play == NULL)
+            {
+                return;
+            }
+
+            CdScheduler::Seek(fad);
+            CdScheduler::backend->Play(fad, end);
+            CdScheduler::musicEnd = end;
+            CdScheduler::playing = true;
+        }
+
+        /** @brief Stop music
+         */
+        static void StopMusic()
+        {
+            if (CdScheduler::playing)
+            {
+                CdScheduler::head = CdScheduler::backend->Stop();
+                CdScheduler::playing = false;
+            }
+        }
+
+        /** @brief Check whether music is playing
+         * @return true Music is playing
+         * @return false Drive is free
+         */
+        static bool IsPlaying()
+        {
+            return CdScheduler::playing;
+        }
+
+        /** @brief Queue request, last slot is kept for data reads (request is served by following Update calls)
+         * @param request Request (copied, target buffer has to stay valid until the request is served)
+         * @return true Request was queued or the same prefetch is already queued
+         * @return false Queue is full
+         */
+        static bool Queue(const Request * request)
+        {
+            if (request->Buffer == NULL)
+            {
+                for (uint8_t index = 0; index < CdScheduler::count; index++)
+                {
+                    const Request * queued = &CdScheduler::requests[index];
+
+                    if (queued->Buffer == NULL && queued->Fad == request->Fad && queued->Size == request->Size)
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            const uint8_t limit = request->Buffer != NULL ? CdScheduler::MaxRequests : CdScheduler::MaxRequests - 1;
+
+            if (CdScheduler::count >= limit)
+            {
+                return false;
+            }
+
+            Request * queued = &CdScheduler::requests[CdScheduler::count++];
+            *queued = *request;
+            queued->Served = 0;
+
+            if (queued->Done != NULL)
+            {
+                *queued->Done = Status::Queued;
+            }
+
+            return true;
+        }
+
+        /** @brief Serve queued data reads up to a number of sectors (should be called once per frame), music is stopped for the whole batch
+         * @param sectors Largest number of sectors read by this update
+         * @param prefetches Largest number of prefetch requests served when the drive is idle
+         */
+        static void Update(uint32_t sectors, uint8_t prefetches)
+        {
+            const uint32_t budget = sectors;
+
+            while (sectors > 0)
+            {
+                if (CdScheduler::active < 0)
+                {
+                    CdScheduler::active = CdScheduler::FindNext(false);
+
+                    if (CdScheduler::active < 0)
+                    {
+                        break;
+                    }
+
+                    if (!CdScheduler::batch)
+                    {
+                        CdScheduler::resumeMusic = CdScheduler::BeginDirect();
+                        CdScheduler::batch = true;
+                    }
+
+                    CdScheduler::Seek(CdScheduler::requests[CdScheduler::active].Fad);
+                }
+
+                sectors -= CdScheduler::ServeRead(CdScheduler::active, sectors);
+            }
+
+            if (CdScheduler::batch && CdScheduler::active < 0 && CdScheduler::FindNext(false) < 0)
+            {
+                CdScheduler::EndDirect(CdScheduler::resumeMusic);
+                CdScheduler::batch = false;
+            }
+
+            // Prefetching would stop the music, so it waits for idle drive, prefetch larger than the budget is read only by an otherwise idle update
+            for (int16_t next; !CdScheduler::playing && !CdScheduler::batch && prefetches > 0 && (next = CdScheduler::FindNext(true)) >= 0; prefetches--)
+            {
+                if (CdScheduler::GetSectors(CdScheduler::requests[next].Size) > sectors && sectors != budget)
+                {
+                    break;
+                }
+
+                const uint32_t read = CdScheduler::ServePrefetch(next);
+                sectors -= read < sectors ? read : sectors;
+            }
+        }
+
+        /** @brief Stop music before the drive is used, reads outside of the scheduler have to be enclosed by BeginDirect and EndDirect
+         * @return true Music was interrupted
+         * @return false Music was not playing
+         */
+        static bool BeginDirect()
+        {
+            if (!CdScheduler::playing)
+            {
+                return false;
+            }
+
+            CdScheduler::StopMusic();
+            CdScheduler::musicPosition = CdScheduler::head;
+            CdScheduler::interruptions++;
+            return true;
+        }
+
+        /** @brief Resume music interrupted by BeginDirect
+         * @param resume Value returned by BeginDirect
+         */
+        static void EndDirect(bool resume)
+        {
+            if (resume)
+            {
+                CdScheduler::PlayMusic(CdScheduler::musicPosition, CdScheduler::musicEnd);
+            }
+        }
+
+        /** @brief Read data through the queue and wait for it (for loading, other queued data reads are served meanwhile)
+         * @param fad Sector address to start at
+         * @param buffer Target buffer
+         * @param size Number of bytes to read
+         * @return true Data was read
+         * @return false Reading ended with error
+         */
+        static bool Read(uint32_t fad, void * buffer, uint32_t size)
+        {
+            Status status = Status::Queued;
+            const Request request = { Fad : fad, Size : size, Buffer : buffer, Done : &status, Served : 0 };
+
+            // Queued data reads are served first, last slot is then always free
+            if (!CdScheduler::Queue(&request))
+            {
+                CdScheduler::Update(CdScheduler::DiscSectors, 0);
+                CdScheduler::Queue(&request);
+            }
+
+            while (status == Status::Queued)
+            {
+                CdScheduler::Update(CdScheduler::DiscSectors, 0);
+            }
+
+            return status == Status::Done;
+        }
+
+        /** @brief Get number of queued requests
+         * @return Request count
+         */
+        static uint8_t GetPending()
+        {
+            return CdScheduler::count;
+        }
+
+        /** @brief Get total seek distance since last reset
+         * @return Distance in sectors
+         */
+        static uint32_t GetSeekDistance()
+        {
+            return CdScheduler::seekDistance;
+        }
+
+        /** @brief Get estimated drive time of seeks and reads since last reset
+         * @return Time in microseconds
+         */
+        static uint32_t GetDriveTime()
+        {
+            return CdScheduler::driveTime;
+        }
+
+        /** @brief Get number of times data reads stopped the music since last reset
+         * @return Interruption count
+         */
+        static uint32_t GetInterruptions()
+        {
+            return CdScheduler::interruptions;
+        }
+
+        /** @brief Reset seek distance, drive time and interruption count
+         */
+        static void ResetStatistics()
+        {
+            CdScheduler::seekDistance = 0;
+            CdScheduler::driveTime = 0;
+            CdScheduler::interruptions = 0;
+        }
+    };
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+/** @brief Compressed asset handling
+ */
+namespace Skathi::Compression { }
+
+#include "Lz.hpp"
+#include "Packed.hpp"
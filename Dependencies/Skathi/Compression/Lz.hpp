@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace Skathi::Compression
+{
+    /** @brief LZ block decoder (does not depend on yaul, so host tools can use it too)
+     * @details Block is a list of sequences. Each sequence starts with a token byte, high nibble is number of literals
+     * and low nibble is match length minus 4. Value of 15 is followed by extra length bytes, which are added together
+     * until byte other than 255 is found. Literals follow, then 16 bit big endian match offset and extra match length bytes.
+     * Last sequence has only literals.
+     */
+    class Lz
+    {
+    public:
+        /** @brief Shortest match
+         */
+        static constexpr size_t MinMatch = 4;
+
+        /** @brief Largest match offset
+         */
+        static constexpr size_t MaxOffset = 65535;
+
+    private:
+        /** @brief Read extra length bytes
+         * @param source Current read position
+         * @param end End of block
+         * @param length Length to add to
+         * @return true Length was read
+         * @return false Block ended in the middle of length
+         */
+        static bool ReadLength(const uint8_t ** source, const uint8_t * end, size_t * length)
+        {
+            uint8_t value;
+
+            do
+            {
+                if (*source >= end)
+                {
+                    return false;
+                }
+
+                value = *(*source)++;
+                *length += value;
+            } while (value == 255);
+
+            return true;
+        }
+
+    public:
+        /** @brief Decompress single block
+         * @param source Compressed block
+         * @param sourceSize Compressed block size
+         * @param target Decompressed data
+         * @param targetSize Size of the target buffer
+         * @return Decompressed size, 0 if block is corrupted
+         */
+        static size_t Decompress(const uint8_t * source, size_t sourceSize, uint8_t * target, size_t targetSize)
+        {
+            const uint8_t * end = source + sourceSize;
+            uint8_t * output = target;
+            uint8_t * outputEnd = target + targetSize;
+
+            while (source < end)
+            {
+                const uint8_t token = *source++;
+                size_t literals = token >> 4;
+
+                if (literals == 15 && !Lz::ReadLength(&source, end, &literals))
+                {
+                    return 0;
+                }
+
+                if (literals > (size_t)(end - source) || literals > (size_t)(outputEnd - output))
+                {
+                    return 0;
+                }
+
+                memcpy(output, source, literals);
+                output += literals;
+                source += literals;
+
+                if (source == end)
+                {
+                    break;
+                }
+
+                if (end - source < 2)
+                {
+                    return 0;
+                }
+
+                const size_t offset = ((size_t)source[0] << 8) | source[1];
+                source += 2;
+
+                size_t match = (token & 0x0f) + Lz::MinMatch;
+
+                if ((token & 0x0f) == 15 && !Lz::ReadLength(&source, end, &match))
+                {
+                    return 0;
+                }
+
+                if (offset == 0 || offset > (size_t)(output - target) || match > (size_t)(outputEnd - output))
+                {
+                    return 0;
+                }
+
+                // Match can overlap with its own output, so it is copied byte by byte
+                const uint8_t * from = output - offset;
+
+                for (const uint8_t * matchEnd = output + match; output < matchEnd;)
+                {
+                    *output++ = *from++;
+                }
+            }
+
+            return output - target;
+        }
+    };
+}
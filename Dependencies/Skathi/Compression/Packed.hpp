@@ -0,0 +1,217 @@
+#pragma once
+
+#include <yaul.h>
+#include "../Cd.hpp"
+#include "../Slave.hpp"
+#include "Lz.hpp"
+
+namespace Skathi::Compression
+{
+    /** @brief Compressed file container (created by Tools/AssetPacker)
+     * @details File layout (big endian): header, offset of each block from the start of the file and end offset of the last block,
+     * then independently compressed blocks. Block is stored uncompressed when its stored size equals its decompressed size.
+     * While master reads next block from the disc, slave CPU decompresses the previous one. Only two block buffers are needed.
+     */
+    class Packed
+    {
+    public:
+        /** @brief File identifier ("UPAK")
+         */
+        static constexpr uint32_t Magic = 0x5550414b;
+
+        /** @brief Largest supported block size
+         */
+        static constexpr uint32_t MaxBlockSize = 16384;
+
+        /** @brief File header
+         */
+        struct Header
+        {
+            /** @brief File identifier ("UPAK")
+             */
+            uint32_t Magic;
+
+            /** @brief Decompressed size
+             */
+            uint32_t Size;
+
+            /** @brief Decompressed size of a block (last block can be smaller)
+             */
+            uint32_t BlockSize;
+
+            /** @brief Number of blocks
+             */
+            uint32_t BlockCount;
+        };
+
+    private:
+        /** @brief Block waiting for decompression
+         */
+        struct Job
+        {
+            /** @brief Compressed data
+             */
+            const uint8_t * Source;
+
+            /** @brief Compressed size
+             */
+            uint32_t SourceSize;
+
+            /** @brief Decompressed data
+             */
+            uint8_t * Target;
+
+            /** @brief Decompressed size
+             */
+            uint32_t TargetSize;
+
+            /** @brief Block was decompressed without errors
+             */
+            bool Done;
+        };
+
+        /** @brief Round size up to whole words
+         * @param size Size in bytes
+         * @return Aligned size
+         */
+        static uint32_t Align(uint32_t size)
+        {
+            return (size + 3) & ~3;
+        }
+
+        /** @brief Decompress block
+         * @param work Block job
+         */
+        static void Decompress(void * work)
+        {
+            Job * job = (Job*)work;
+
+            if (job->SourceSize == job->TargetSize)
+            {
+                memcpy(job->Target, job->Source, job->TargetSize);
+                job->Done = true;
+            }
+            else
+            {
+                job->Done = Lz::Decompress(job->Source, job->SourceSize, job->Target, job->TargetSize) == job->TargetSize;
+            }
+        }
+
+        /** @brief Read and decompress all blocks
+         * @param file File entry
+         * @param header File header
+         * @param offsets Block offsets
+         * @param target Decompressed data
+         * @return true File was read successfully
+         * @return false Reading or decompression failed
+         */
+        static bool ReadBlocks(const cdfs_filelist_entry_t * file, const Header * header, const uint32_t * offsets, uint8_t * target)
+        {
+            // Block can start anywhere in a sector, so buffers hold one extra sector
+            const uint32_t bufferSize = header->BlockSize + Cd::SectorSize;
+            uint8_t * buffers[2] = { (uint8_t*)malloc(bufferSize), (uint8_t*)malloc(bufferSize) };
+            assert(buffers[0] != NULL && buffers[1] != NULL);
+
+            const bool slave = Slave::IsInitialized();
+            Job job = { Source : NULL, SourceSize : 0, Target : NULL, TargetSize : 0, Done : true };
+            bool result = true;
+
+            for (uint32_t block = 0; block < header->BlockCount && result; block++)
+            {
+                const uint32_t size = offsets[block + 1] - offsets[block];
+                const uint32_t blockStart = block * header->BlockSize;
+                const uint32_t blockSize = header->Size - blockStart < header->BlockSize ? header->Size - blockStart : header->BlockSize;
+
+                // Previous block is decompressed meanwhile, buffer used by the block before it is free again
+                const uint8_t * source = size <= header->BlockSize ? Cd::ReadFileRange(file, offsets[block], size, buffers[block & 1]) : NULL;
+
+                if (slave)
+                {
+                    Slave::Wait();
+                }
+
+                if (source == NULL || !job.Done)
+                {
+                    result = false;
+                    break;
+                }
+
+                job = { Source : source, SourceSize : size, Target : target + blockStart, TargetSize : blockSize, Done : false };
+
+                if (slave)
+                {
+                    Slave::Start(Packed::Decompress, &job);
+                }
+                else
+                {
+                    Packed::Decompress(&job);
+                }
+            }
+
+            if (slave)
+            {
+                Slave::Wait();
+            }
+
+            free(buffers[0]);
+            free(buffers[1]);
+            return result && job.Done;
+        }
+
+    public:
+        /** @brief Read whole file, packed files are decompressed and other files are read as they are
+         * @param file File entry
+         * @param size Size of the returned data
+         * @return File data (allocated with malloc) or NULL on error
+         */
+        static uint8_t * ReadFile(const cdfs_filelist_entry_t * file, uint32_t * size)
+        {
+            assert(file != NULL);
+
+            // First sector tells whether the file is packed
+            Header header;
+            uint8_t * sector = (uint8_t*)malloc(Cd::SectorSize);
+            assert(sector != NULL);
+            const bool packed = file->size >= sizeof(Header) && Cd::ReadFileRange(file, 0, sizeof(Header), sector) != NULL && ((Header*)sector)->Magic == Packed::Magic;
+            memcpy(&header, sector, sizeof(Header));
+            free(sector);
+
+            if (!packed)
+            {
+                uint8_t * data = (uint8_t*)malloc(Packed::Align(file->size));
+                assert(data != NULL);
+
+                if (!Cd::ReadFile(file, data))
+                {
+                    free(data);
+                    return NULL;
+                }
+
+                *size = file->size;
+                return data;
+            }
+
+            assert(header.BlockSize <= Packed::MaxBlockSize);
+
+            // Block offsets follow the header
+            const uint32_t tableSize = (header.BlockCount + 1) * sizeof(uint32_t);
+            uint8_t * table = (uint8_t*)malloc(sizeof(Header) + tableSize);
+            uint8_t * data = (uint8_t*)malloc(Packed::Align(header.Size));
+            assert(table != NULL && data != NULL);
+
+            const bool loaded = Cd::ReadFileRange(file, 0, sizeof(Header) + tableSize, table) != NULL &&
+                Packed::ReadBlocks(file, &header, (const uint32_t*)(table + sizeof(Header)), data);
+
+            free(table);
+
+            if (!loaded)
+            {
+                free(data);
+                return NULL;
+            }
+
+            *size = header.Size;
+            return data;
+        }
+    };
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+/** @brief SCU DSP programs
+ */
+namespace Skathi::Dsp { }
+
+#include "Instruction.hpp"
+#include "TransformProgram.hpp"
+#include "Transform.hpp"
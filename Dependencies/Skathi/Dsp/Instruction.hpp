@@ -0,0 +1,180 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace Skathi::Dsp
+{
+    /** @brief SCU DSP instruction encoding (does not depend on yaul, so host tools can assemble and simulate programs too)
+     * @details Operation command is made of ALU operation and X-bus, Y-bus and D1-bus moves combined with bitwise or.
+     * All parts of an operation command read registers as they were before the instruction, product register (MUL) holds
+     * product of RX and RY written by the previous instruction. Jump and loop bottom commands have one delay slot.
+     */
+    class Instruction
+    {
+    public:
+        /** @brief ALU operations
+         */
+        enum Alu : uint32_t
+        {
+            Nop = 0x0,
+            And = 0x1,
+            Or = 0x2,
+            Xor = 0x3,
+            Add = 0x4,
+            Sub = 0x5,
+            Ad2 = 0x6,
+            Sr = 0x8,
+            Rr = 0x9,
+            Sl = 0xa,
+            Rl = 0xb,
+            Rl8 = 0xf
+        };
+
+        /** @brief Bus sources, MC reads increment the counter of the data RAM bank
+         */
+        enum Source : uint32_t
+        {
+            M0 = 0x0,
+            M1 = 0x1,
+            M2 = 0x2,
+            M3 = 0x3,
+            MC0 = 0x4,
+            MC1 = 0x5,
+            MC2 = 0x6,
+            MC3 = 0x7,
+
+            /** @brief Low 32 bits of ALU result (D1-bus only)
+             */
+            All = 0x9,
+
+            /** @brief Bits 47 to 16 of ALU result (D1-bus only)
+             */
+            Alh = 0xa
+        };
+
+        /** @brief D1-bus destinations, MC writes increment the counter of the data RAM bank
+         */
+        enum Destination : uint32_t
+        {
+            ToMC0 = 0x0,
+            ToMC1 = 0x1,
+            ToMC2 = 0x2,
+            ToMC3 = 0x3,
+            ToRX = 0x4,
+            ToPL = 0x5,
+            ToRA0 = 0x6,
+            ToWA0 = 0x7,
+            ToLOP = 0xa,
+            ToTOP = 0xb,
+            ToCT0 = 0xc,
+            ToCT1 = 0xd,
+            ToCT2 = 0xe,
+            ToCT3 = 0xf
+        };
+
+        /** @brief ALU operation
+         * @param operation Operation
+         * @return Instruction part
+         */
+        static constexpr uint32_t Operation(Alu operation)
+        {
+            return operation << 26;
+        }
+
+        /** @brief X-bus MOV [s],X
+         * @param source Source
+         * @return Instruction part
+         */
+        static constexpr uint32_t MovX(Source source)
+        {
+            return (1 << 25) | (source << 20);
+        }
+
+        /** @brief X-bus MOV MUL,P
+         * @return Instruction part
+         */
+        static constexpr uint32_t MovMulP()
+        {
+            return 2 << 23;
+        }
+
+        /** @brief X-bus MOV [s],P (source must match MovX source when both are used)
+         * @param source Source
+         * @return Instruction part
+         */
+        static constexpr uint32_t MovP(Source source)
+        {
+            return (3 << 23) | (source << 20);
+        }
+
+        /** @brief Y-bus MOV [s],Y
+         * @param source Source
+         * @return Instruction part
+         */
+        static constexpr uint32_t MovY(Source source)
+        {
+            return (1 << 19) | (source << 14);
+        }
+
+        /** @brief Y-bus CLR A
+         * @return Instruction part
+         */
+        static constexpr uint32_t ClrA()
+        {
+            return 1 << 17;
+        }
+
+        /** @brief Y-bus MOV ALU,A
+         * @return Instruction part
+         */
+        static constexpr uint32_t MovAluA()
+        {
+            return 2 << 17;
+        }
+
+        /** @brief Y-bus MOV [s],A (source must match MovY source when both are used)
+         * @param source Source
+         * @return Instruction part
+         */
+        static constexpr uint32_t MovA(Source source)
+        {
+            return (3 << 17) | (source << 14);
+        }
+
+        /** @brief D1-bus MOV SImm,[d]
+         * @param value Signed 8 bit value
+         * @param destination Destination
+         * @return Instruction part
+         */
+        static constexpr uint32_t MovImmediate(int8_t value, Destination destination)
+        {
+            return (1 << 12) | (destination << 8) | (uint8_t)value;
+        }
+
+        /** @brief D1-bus MOV [s],[d]
+         * @param source Source
+         * @param destination Destination
+         * @return Instruction part
+         */
+        static constexpr uint32_t Mov(Source source, Destination destination)
+        {
+            return (3 << 12) | (destination << 8) | source;
+        }
+
+        /** @brief Loop bottom, jumps to TOP after the delay slot while LOP is not 0, LOP is decremented
+         * @return Instruction
+         */
+        static constexpr uint32_t Btm()
+        {
+            return 0xe0000000;
+        }
+
+        /** @brief End program
+         * @return Instruction
+         */
+        static constexpr uint32_t End()
+        {
+            return 0xf0000000;
+        }
+    };
+}
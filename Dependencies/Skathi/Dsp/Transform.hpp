@@ -0,0 +1,158 @@
+#pragma once
+
+#include <yaul.h>
+#include "TransformProgram.hpp"
+
+namespace Skathi::Dsp
+{
+    /** @brief Batched point transforms on the SCU DSP with CPU fallback
+     * @details Points are sent to the DSP data RAM in batches of TransformProgram::BatchSize. While the DSP works on a batch,
+     * the CPU unpacks results of the previous one. Results are the same as of the CPU path within the range described in TransformProgram.
+     */
+    class Transform
+    {
+    private:
+        /** @brief Batches smaller than this are transformed on the CPU, data port transfers would cost more than they save
+         */
+        static constexpr uint16_t MinDspPoints = 4;
+
+        /** @brief Program was loaded into the DSP
+         */
+        inline static bool loaded = false;
+
+        /** @brief Results of the batch being unpacked
+         */
+        inline static fix16_t results[TransformProgram::BatchSize * 3];
+
+        /** @brief Transform single point on the CPU
+         * @param matrix Transformation matrix
+         * @param point Point
+         * @param result Transformed point
+         */
+        static void TransformPoint(const fix16_mat43_t * matrix, const fix16_vec3_t * point, fix16_vec3_t * result)
+        {
+            fix16_t coordinates[3];
+
+            for (uint8_t row = 0; row < 3; row++)
+            {
+                const fix16_vec3_t axis = { matrix->frow[row][0], matrix->frow[row][1], matrix->frow[row][2] };
+                coordinates[row] = fix16_vec3_dot(&axis, point) + matrix->frow[row][3];
+            }
+
+            result->x = coordinates[0];
+            result->y = coordinates[1];
+            result->z = coordinates[2];
+        }
+
+        /** @brief Send batch to the DSP and start the program
+         * @param points Points
+         * @param count Number of points
+         */
+        static void StartBatch(const fix16_vec3_t * points, uint16_t count)
+        {
+            fix16_t input[TransformProgram::BatchSize * TransformProgram::InputStride];
+
+            for (uint16_t point = 0; point < count; point++)
+            {
+                input[(point * TransformProgram::InputStride) + 0] = points[point].x;
+                input[(point * TransformProgram::InputStride) + 1] = points[point].y;
+                input[(point * TransformProgram::InputStride) + 2] = points[point].z;
+                input[(point * TransformProgram::InputStride) + 3] = FIX16_ONE;
+            }
+
+            uint32_t last = count - 1;
+            scu_dsp_data_write((scu_dsp_ram_t)TransformProgram::InputBank, 0, input, count * TransformProgram::InputStride);
+            scu_dsp_data_write((scu_dsp_ram_t)TransformProgram::CountBank, 0, &last, 1);
+            scu_dsp_program_pc_set(0);
+            scu_dsp_program_start();
+        }
+
+        /** @brief Wait for the DSP and copy raw results out of its data RAM
+         * @param count Number of points
+         */
+        static void FinishBatch(uint16_t count)
+        {
+            scu_dsp_program_end_wait();
+            scu_dsp_data_read((scu_dsp_ram_t)TransformProgram::OutputBank, 0, Transform::results, count * 3);
+        }
+
+        /** @brief Unpack raw results, results are stored as all x values, then all y values, then all z values
+         * @param results Transformed points
+         * @param count Number of points
+         */
+        static void UnpackBatch(fix16_vec3_t * results, uint16_t count)
+        {
+            for (uint16_t point = 0; point < count; point++)
+            {
+                results[point].x = Transform::results[point];
+                results[point].y = Transform::results[count + point];
+                results[point].z = Transform::results[(count << 1) + point];
+            }
+        }
+
+    public:
+        /** @brief Load transform program into the DSP
+         */
+        static void Initialize()
+        {
+            uint32_t program[TransformProgram::MaxSize];
+            const uint8_t size = TransformProgram::Build(program);
+
+            scu_dsp_init();
+            scu_dsp_program_load(program, size);
+            Transform::loaded = true;
+        }
+
+        /** @brief Check whether points are transformed by the DSP
+         * @return true DSP program is loaded
+         * @return false Points are transformed by the CPU
+         */
+        static bool IsLoaded()
+        {
+            return Transform::loaded;
+        }
+
+        /** @brief Transform points by a matrix
+         * @param matrix Transformation matrix
+         * @param in Points
+         * @param out Transformed points (can be the same as input)
+         * @param count Number of points
+         */
+        static void TransformVertices(const fix16_mat43_t * matrix, const fix16_vec3_t * in, fix16_vec3_t * out, uint16_t count)
+        {
+            if (!Transform::loaded || count < Transform::MinDspPoints)
+            {
+                for (uint16_t point = 0; point < count; point++)
+                {
+                    Transform::TransformPoint(matrix, &in[point], &out[point]);
+                }
+
+                return;
+            }
+
+            // Matrix stays in data RAM for all batches
+            scu_dsp_data_write((scu_dsp_ram_t)TransformProgram::MatrixBank, 0, (void*)matrix->arr, 12);
+
+            uint16_t previous = 0;
+            uint16_t previousCount = 0;
+
+            for (uint16_t first = 0; first < count; first += TransformProgram::BatchSize)
+            {
+                const uint16_t batch = count - first < TransformProgram::BatchSize ? count - first : TransformProgram::BatchSize;
+                Transform::StartBatch(&in[first], batch);
+
+                // Previous results are unpacked while the DSP runs, output can overlap only with already sent input
+                if (previousCount != 0)
+                {
+                    Transform::UnpackBatch(&out[previous], previousCount);
+                }
+
+                Transform::FinishBatch(batch);
+                previous = first;
+                previousCount = batch;
+            }
+
+            Transform::UnpackBatch(&out[previous], previousCount);
+        }
+    };
+}
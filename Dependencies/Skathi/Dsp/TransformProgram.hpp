@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include "Instruction.hpp"
+
+namespace Skathi::Dsp
+{
+    /** @brief SCU DSP program transforming batch of points by 4x3 fix16 matrix (does not depend on yaul)
+     * @details Data RAM layout:
+     *   bank 0  matrix rows (3 rows of 4 values)
+     *   bank 1  points, each as x, y, z and 1.0 (so translation is just fourth product)
+     *   bank 2  results, all x values first, then all y values, then all z values
+     *   bank 3  word 0 is number of points minus 1
+     *
+     * Each result row is sum of 48 bit products taken from bits 47 to 16, which matches fix16 dot product done by the CPU
+     * as long as the sum of absolute products of a row stays below 2^47 (e.g. matrix values up to 2.0 with coordinates
+     * and translation up to 4096.0). Every point costs 6 instructions per row.
+     */
+    class TransformProgram
+    {
+    public:
+        /** @brief Data RAM bank of the matrix
+         */
+        static constexpr uint8_t MatrixBank = 0;
+
+        /** @brief Data RAM bank of the points
+         */
+        static constexpr uint8_t InputBank = 1;
+
+        /** @brief Data RAM bank of the results
+         */
+        static constexpr uint8_t OutputBank = 2;
+
+        /** @brief Data RAM bank of the point count
+         */
+        static constexpr uint8_t CountBank = 3;
+
+        /** @brief Number of words of a single point in the input bank
+         */
+        static constexpr uint8_t InputStride = 4;
+
+        /** @brief Largest number of points in a single run (input bank holds 64 words)
+         */
+        static constexpr uint8_t BatchSize = 16;
+
+        /** @brief Largest program size
+         */
+        static constexpr uint8_t MaxSize = 64;
+
+        /** @brief Write program
+         * @param program Program words (at least MaxSize)
+         * @return Number of program words
+         */
+        static uint8_t Build(uint32_t * program)
+        {
+            typedef Skathi::Dsp::Instruction I;
+            uint8_t size = 0;
+
+            program[size++] = I::MovImmediate(0, I::ToCT2);
+            program[size++] = I::MovImmediate(0, I::ToCT3);
+
+            for (int8_t row = 0; row < 3; row++)
+            {
+                const int8_t matrixRow = row * 4;
+
+                // Loop starts after the TOP setup and the first load
+                const int8_t top = size + 5;
+
+                program[size++] = I::MovImmediate(matrixRow, I::ToCT0);
+                program[size++] = I::MovImmediate(0, I::ToCT1);
+                program[size++] = I::Mov(I::M3, I::ToLOP);
+                program[size++] = I::MovImmediate(top, I::ToTOP);
+
+                // RX and RY are loaded one instruction before their product is needed, next point is loaded in the delay slot
+                program[size++] = I::MovX(I::MC0) | I::MovY(I::MC1);
+                program[size++] = I::MovX(I::MC0) | I::MovMulP() | I::MovY(I::MC1) | I::ClrA();
+                program[size++] = I::Operation(I::Ad2) | I::MovX(I::MC0) | I::MovMulP() | I::MovY(I::MC1) | I::MovAluA();
+                program[size++] = I::Operation(I::Ad2) | I::MovX(I::MC0) | I::MovMulP() | I::MovY(I::MC1) | I::MovAluA();
+                program[size++] = I::Operation(I::Ad2) | I::MovMulP() | I::MovAluA() | I::MovImmediate(matrixRow, I::ToCT0);
+                program[size++] = I::Btm();
+                program[size++] = I::Operation(I::Ad2) | I::MovX(I::MC0) | I::MovY(I::MC1) | I::Mov(I::Alh, I::ToMC2);
+            }
+
+            program[size++] = I::End();
+            return size;
+        }
+    };
+}
@@ -2,6 +2,7 @@
 
 #include "Peripherals.hpp"
 #include "Digital.hpp"
+#include "ResponseCurve.hpp"
 
 /** @brief Special handling for controllers
  */
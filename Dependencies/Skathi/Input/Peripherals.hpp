@@ -99,15 +99,141 @@ namespace Skathi::Input
             NotConnected = 0xff
         };
 
+        /** @brief Peripheral change event type
+         */
+        enum class EventType
+        {
+            /** @brief Peripheral was connected to a port
+             */
+            Connected = 0,
+
+            /** @brief Peripheral was disconnected from a port
+             */
+            Disconnected = 1,
+
+            /** @brief Different peripheral type is connected to a port
+             */
+            TypeChanged = 2,
+        };
+
+        /** @brief Peripheral change event
+         */
+        struct Event
+        {
+            /** @brief Event type
+             */
+            EventType Type;
+
+            /** @brief Peripheral port
+             */
+            uint8_t Port;
+
+            /** @brief Peripheral type connected to the port after the change
+             */
+            PeripheralType Peripheral;
+        };
+
+    private:
+        /** @brief Peripheral data latched during vertical blank
+         */
+        struct Sample
+        {
+            /** @brief Peripheral data of each port
+             */
+            smpc_peripheral_t Ports[12];
+
+            /** @brief Vertical blank the data was latched at
+             */
+            uint32_t Vblank;
+        };
+
+        /** @brief Latched samples, interrupt writes one while the other holds the newest complete sample
+         */
+        static Sample samples[];
+
+        /** @brief Index of the newest complete sample
+         */
+        static volatile uint8_t latest;
+
+        /** @brief Number of latched vertical blanks
+         */
+        static volatile uint32_t vblanks;
+
+        /** @brief Peripheral data used by the current frame
+         */
+        static smpc_peripheral_t current[];
+
+        /** @brief Vertical blank the current frame data was latched at
+         */
+        static uint32_t currentVblank;
+
+        /** @brief Frames between input latch and display of the last frame
+         */
+        static uint8_t latency;
+
+        /** @brief Most frames between input latch and display
+         */
+        static uint8_t worstLatency;
+
+        /** @brief Ports with connected peripheral, sorted by port index
+         */
+        static uint8_t connected[];
+
+        /** @brief Number of ports with connected peripheral
+         */
+        static uint8_t connectedCount;
+
+        /** @brief Peripheral types seen during the previous fetch
+         */
+        static PeripheralType lastTypes[];
+
+        /** @brief Events raised by the last fetch
+         */
+        static Event events[];
+
+        /** @brief Number of events raised by the last fetch
+         */
+        static uint8_t eventCount;
+
+    public:
+
         /** @brief Get count of the peripheral input
          *  @return uint8_t Peripheral input count
          */
         static uint8_t GetCount();
 
-        /** @brief Fetch controller input (should be called at start of each game loop)
+        /** @brief Latch controller input (should be called from vertical blank-in interrupt)
+         */
+        static void Latch();
+
+        /** @brief Fetch newest latched controller input (should be called as late as possible before the frame is rendered)
          */
         static void FetchAll();
 
+        /** @brief Update input latency counter (should be called once the frame is displayed)
+         */
+        static void FrameDisplayed();
+
+        /** @brief Update input latency counter of a frame built from earlier fetch (should be called once the frame is displayed)
+         *  @param latched Vertical blank input of the displayed frame was latched at
+         */
+        static void FrameDisplayed(uint32_t latched);
+
+        /** @brief Get vertical blank the input of the last fetch was latched at
+         *  @return Vertical blank count
+         */
+        static uint32_t GetLatchedVblank();
+
+        /** @brief Get frames between input latch and display of the last frame
+         *  @return Latency in frames
+         */
+        static uint8_t GetLatency();
+
+        /** @brief Get most frames between input latch and display
+         *  @return Latency in frames
+         */
+        static uint8_t GetWorstLatency();
+
         /** @brief Gets connected peripheral type
          *  @param peripheral Peripheral data
          *  @return Peripheral type
@@ -143,6 +269,28 @@ namespace Skathi::Input
          *  @return smpc_peripheral_t* nullptr if not found
          */
         static smpc_peripheral_t * GetNthConnectedPeripheral(uint8_t peripheral);
+
+        /** @brief Get number of connected peripherals
+         *  @return Connected peripheral count
+         */
+        static uint8_t GetConnectedCount();
+
+        /** @brief Get port of the Nth connected peripheral
+         *  @param peripheral Index of the peripheral
+         *  @return Peripheral port
+         */
+        static uint8_t GetNthConnectedPort(uint8_t peripheral);
+
+        /** @brief Get number of events raised by the last fetch
+         *  @return Event count
+         */
+        static uint8_t GetEventCount();
+
+        /** @brief Get event raised by the last fetch
+         *  @param event Event index
+         *  @return Event data
+         */
+        static const Event * GetEvent(uint8_t event);
     };
 
     /** @brief Number of controller ports
@@ -153,6 +301,61 @@ namespace Skathi::Input
      */
     smpc_peripheral_t *Peripherals::inputs[12];
 
+    /** @brief Latched samples, interrupt writes one while the other holds the newest complete sample
+     */
+    Peripherals::Sample Peripherals::samples[2];
+
+    /** @brief Index of the newest complete sample
+     */
+    volatile uint8_t Peripherals::latest = 0;
+
+    /** @brief Number of latched vertical blanks
+     */
+    volatile uint32_t Peripherals::vblanks = 0;
+
+    /** @brief Peripheral data used by the current frame
+     */
+    smpc_peripheral_t Peripherals::current[12];
+
+    /** @brief Vertical blank the current frame data was latched at
+     */
+    uint32_t Peripherals::currentVblank = 0;
+
+    /** @brief Frames between input latch and display of the last frame
+     */
+    uint8_t Peripherals::latency = 0;
+
+    /** @brief Most frames between input latch and display
+     */
+    uint8_t Peripherals::worstLatency = 0;
+
+    /** @brief Ports with connected peripheral, sorted by port index
+     */
+    uint8_t Peripherals::connected[12];
+
+    /** @brief Number of ports with connected peripheral
+     */
+    uint8_t Peripherals::connectedCount = 0;
+
+    /** @brief Peripheral types seen during the previous fetch
+     */
+    Peripherals::PeripheralType Peripherals::lastTypes[12] = {
+        Peripherals::PeripheralType::NotConnected, Peripherals::PeripheralType::NotConnected,
+        Peripherals::PeripheralType::NotConnected, Peripherals::PeripheralType::NotConnected,
+        Peripherals::PeripheralType::NotConnected, Peripherals::PeripheralType::NotConnected,
+        Peripherals::PeripheralType::NotConnected, Peripherals::PeripheralType::NotConnected,
+        Peripherals::PeripheralType::NotConnected, Peripherals::PeripheralType::NotConnected,
+        Peripherals::PeripheralType::NotConnected, Peripherals::PeripheralType::NotConnected
+    };
+
+    /** @brief Events raised by the last fetch
+     */
+    Peripherals::Event Peripherals::events[12];
+
+    /** @brief Number of events raised by the last fetch
+     */
+    uint8_t Peripherals::eventCount = 0;
+
     /** @brief Get count of the peripheral input
      *  @return uint8_t Peripheral input count
      */
@@ -161,27 +364,31 @@ namespace Skathi::Input
         return Peripherals::Count;
     }
 
-    /** @brief Fetch controller input (should be called at start of each game loop)
+    /** @brief Latch controller input (should be called from vertical blank-in interrupt)
      */
-    void Peripherals::FetchAll()
+    void Peripherals::Latch()
     {
-        int virtualInput = 0;
+        Peripherals::vblanks = Peripherals::vblanks + 1;
 
         // Get input data
         smpc_peripheral_process();
 
-        // Parse input data
+        // Write into the sample that is not the newest one
+        Sample * sample = &Peripherals::samples[Peripherals::latest ^ 1];
+        memset(sample->Ports, 0, sizeof(sample->Ports));
+
+        // Parse input data, each real port owns 6 virtual ports
         for (int port = 1; port <= 2; port++)
         {
             const smpc_peripheral_port_t * realPort = smpc_peripheral_raw_port(port);
             const smpc_peripherals_t * subPorts = &realPort->peripherals;
+            int virtualInput = (port - 1) * 6;
 
             if (realPort->peripheral != NULL)
             {
                 if (realPort->peripheral->connected)
                 {
-                    Peripherals::inputs[virtualInput] = realPort->peripheral;
-                    virtualInput += 6;
+                    sample->Ports[virtualInput] = *realPort->peripheral;
                 }
                 else
                 {
@@ -189,9 +396,9 @@ namespace Skathi::Input
 
                     TAILQ_FOREACH(peripheral, subPorts, peripherals)
                     {
-                        if (peripheral->connected)
+                        if (peripheral->connected && virtualInput < port * 6)
                         {
-                            Peripherals::inputs[virtualInput] = peripheral;
+                            sample->Ports[virtualInput] = *peripheral;
                         }
 
                         virtualInput++;
@@ -199,6 +406,118 @@ namespace Skathi::Input
                 }
             }
         }
+
+        sample->Vblank = Peripherals::vblanks;
+        Peripherals::latest = Peripherals::latest ^ 1;
+    }
+
+    /** @brief Fetch newest latched controller input (should be called as late as possible before the frame is rendered)
+     */
+    void Peripherals::FetchAll()
+    {
+        uint16_t held[12];
+        uint32_t start;
+
+        // Button edges are reported against the previous fetch, latches in between would otherwise hide them
+        for (uint8_t port = 0; port < Peripherals::Count; port++)
+        {
+            held[port] = *(uint16_t*)Peripherals::current[port].data;
+        }
+
+        // Copy out the newest sample, retry if the interrupt started writing into it meanwhile (two latches during the copy)
+        do
+        {
+            start = Peripherals::vblanks;
+            const Sample * sample = &Peripherals::samples[Peripherals::latest];
+            memcpy(Peripherals::current, sample->Ports, sizeof(Peripherals::current));
+            Peripherals::currentVblank = sample->Vblank;
+        }
+        while (Peripherals::vblanks - start > 1);
+
+        // Drop peripherals from previous fetch, so disconnected ports do not keep stale pointers
+        for (uint8_t port = 0; port < Peripherals::Count; port++)
+        {
+            *(uint16_t*)Peripherals::current[port].previous_data = held[port];
+            Peripherals::inputs[port] = Peripherals::current[port].connected ? &Peripherals::current[port] : NULL;
+        }
+
+        // Rebuild connected port list and raise events for ports that changed
+        Peripherals::connectedCount = 0;
+        Peripherals::eventCount = 0;
+
+        for (uint8_t port = 0; port < Peripherals::Count; port++)
+        {
+            const PeripheralType type = Peripherals::GetType(Peripherals::inputs[port]);
+            const PeripheralType lastType = Peripherals::lastTypes[port];
+
+            if (type != PeripheralType::NotConnected)
+            {
+                Peripherals::connected[Peripherals::connectedCount++] = port;
+            }
+
+            if (type != lastType)
+            {
+                Event * event = &Peripherals::events[Peripherals::eventCount++];
+                event->Port = port;
+                event->Peripheral = type;
+
+                if (lastType == PeripheralType::NotConnected)
+                {
+                    event->Type = EventType::Connected;
+                }
+                else if (type == PeripheralType::NotConnected)
+                {
+                    event->Type = EventType::Disconnected;
+                }
+                else
+                {
+                    event->Type = EventType::TypeChanged;
+                }
+
+                Peripherals::lastTypes[port] = type;
+            }
+        }
+    }
+
+    /** @brief Update input latency counter (should be called once the frame is displayed)
+     */
+    void Peripherals::FrameDisplayed()
+    {
+        Peripherals::FrameDisplayed(Peripherals::currentVblank);
+    }
+
+    /** @brief Update input latency counter of a frame built from earlier fetch (should be called once the frame is displayed)
+     *  @param latched Vertical blank input of the displayed frame was latched at
+     */
+    void Peripherals::FrameDisplayed(uint32_t latched)
+    {
+        const uint32_t frames = Peripherals::vblanks - latched;
+        Peripherals::latency = frames > 0xff ? 0xff : frames;
+        Peripherals::worstLatency = Peripherals::latency > Peripherals::worstLatency ? Peripherals::latency : Peripherals::worstLatency;
+    }
+
+    /** @brief Get vertical blank the input of the last fetch was latched at
+     *  @return Vertical blank count
+     */
+    uint32_t Peripherals::GetLatchedVblank()
+    {
+        return Peripherals::currentVblank;
+    }
+
+    /** @brief Get frames between input latch and display of the last frame
+     *  @return Latency in frames
+     */
+    uint8_t Peripherals::GetLatency()
+    {
+        return Peripherals::latency;
+    }
+
+    /** @brief Get most frames between input latch and display
+     *  @return Latency in frames
+     */
+    uint8_t Peripherals::GetWorstLatency()
+    {
+        return Peripherals::worstLatency;
     }
 
     /** @brief Gets connected peripheral type
@@ -271,25 +590,49 @@ namespace Skathi::Input
      */
     smpc_peripheral_t * Peripherals::GetNthConnectedPeripheral(uint8_t peripheral)
     {
-        int count = 0;
-        int searched = 0;
-
         assert(peripheral < Peripherals::Count);
 
-        do
+        if (peripheral < Peripherals::connectedCount)
         {
-            if (Peripherals::inputs[searched] != NULL && Peripherals::inputs[searched]->connected)
-            {
-                if (peripheral == count)
-                {
-                    return Peripherals::inputs[searched];
-                }
-                
-                count++;
-            }
+            return Peripherals::inputs[Peripherals::connected[peripheral]];
+        }
 
-        } while (++searched < Peripherals::Count);
-        
         return nullptr;
     }
+
+    /** @brief Get number of connected peripherals
+     *  @return Connected peripheral count
+     */
+    uint8_t Peripherals::GetConnectedCount()
+    {
+        return Peripherals::connectedCount;
+    }
+
+    /** @brief Get port of the Nth connected peripheral
+     *  @param peripheral Index of the peripheral
+     *  @return Peripheral port
+     */
+    uint8_t Peripherals::GetNthConnectedPort(uint8_t peripheral)
+    {
+        assert(peripheral < Peripherals::connectedCount);
+        return Peripherals::connected[peripheral];
+    }
+
+    /** @brief Get number of events raised by the last fetch
+     *  @return Event count
+     */
+    uint8_t Peripherals::GetEventCount()
+    {
+        return Peripherals::eventCount;
+    }
+
+    /** @brief Get event raised by the last fetch
+     *  @param event Event index
+     *  @return Event data
+     */
+    const Peripherals::Event * Peripherals::GetEvent(uint8_t event)
+    {
+        assert(event < Peripherals::eventCount);
+        return &Peripherals::events[event];
+    }
 }
\ No newline at end of file
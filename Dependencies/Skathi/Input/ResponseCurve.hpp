@@ -0,0 +1,119 @@
+#pragma once
+
+#include <yaul.h>
+
+namespace Skathi::Input
+{
+    /** @brief Precomputed deadzone and response curve for analog axes
+     * @details Raw axis byte is converted to fix16 value with a single table lookup.
+     */
+    class ResponseCurve
+    {
+    public:
+        /** @brief Response curve shape
+         */
+        enum class Shape
+        {
+            /** @brief Output is proportional to the stick deflection
+             */
+            Linear = 0,
+
+            /** @brief Finer control near the center
+             */
+            Quadratic = 1,
+
+            /** @brief Even finer control near the center
+             */
+            Cubic = 2,
+        };
+
+    private:
+        /** @brief Raw value of centered stick
+         */
+        static constexpr int32_t Center = 0x80;
+
+        /** @brief Stick axis values (-1 to 1)
+         */
+        fix16_t stick[256];
+
+        /** @brief Trigger axis values (0 to 1)
+         */
+        fix16_t trigger[256];
+
+        /** @brief Map normalized deflection through the curve
+         * @param value Deflection in range of 0 to 1
+         * @param shape Curve shape
+         * @return Curve value in range of 0 to 1
+         */
+        static fix16_t Apply(fix16_t value, ResponseCurve::Shape shape)
+        {
+            switch (shape)
+            {
+            case ResponseCurve::Shape::Quadratic:
+                return fix16_mul(value, value);
+
+            case ResponseCurve::Shape::Cubic:
+                return fix16_mul(fix16_mul(value, value), value);
+
+            default:
+                return value;
+            }
+        }
+
+        /** @brief Normalize magnitude past the deadzone
+         * @param magnitude Raw magnitude
+         * @param deadzone Raw deadzone
+         * @param range Raw magnitude at full deflection
+         * @return Deflection in range of 0 to 1
+         */
+        static fix16_t Normalize(int32_t magnitude, int32_t deadzone, int32_t range)
+        {
+            if (magnitude <= deadzone)
+            {
+                return FIX16_ZERO;
+            }
+            else if (magnitude >= range)
+            {
+                return FIX16_ONE;
+            }
+
+            return fix16_int32_from(magnitude - deadzone) / (range - deadzone);
+        }
+
+    public:
+        /** @brief Build lookup tables (not meant to be called every frame)
+         * @param deadzone Raw stick and trigger deflection that is still reported as zero
+         * @param shape Curve shape
+         */
+        void Build(uint8_t deadzone, ResponseCurve::Shape shape)
+        {
+            for (int32_t raw = 0; raw < 256; raw++)
+            {
+                const int32_t centered = raw - ResponseCurve::Center;
+                const int32_t magnitude = centered < 0 ? -centered : centered;
+                const fix16_t value = ResponseCurve::Apply(ResponseCurve::Normalize(magnitude, deadzone, ResponseCurve::Center - 1), shape);
+
+                this->stick[raw] = centered < 0 ? -value : value;
+                this->trigger[raw] = ResponseCurve::Apply(ResponseCurve::Normalize(raw, deadzone, 0xff), shape);
+            }
+        }
+
+        /** @brief Get stick axis value
+         * @param raw Raw axis byte
+         * @return Axis value in range of -1 to 1
+         */
+        fix16_t GetStick(uint8_t raw) const
+        {
+            return this->stick[raw];
+        }
+
+        /** @brief Get trigger axis value
+         * @param raw Raw axis byte
+         * @return Axis value in range of 0 to 1
+         */
+        fix16_t GetTrigger(uint8_t raw) const
+        {
+            return this->trigger[raw];
+        }
+    };
+}
@@ -5,5 +5,11 @@
 namespace Skathi { }
 
 #include "Input/Input.hpp"
+#include "Cache.hpp"
+#include "CdScheduler.hpp"
 #include "Cd.hpp"
+#include "Timer.hpp"
+#include "Slave.hpp"
+#include "Compression/Compression.hpp"
+#include "Dsp/Dsp.hpp"
 #include "Bitmap/Bitmap.hpp"
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <yaul.h>
+
+namespace Skathi
+{
+    /** @brief Runs single job at a time on the slave CPU
+     * @details Slave cache is purged before the job starts and master cache is purged once the job is done,
+     * so both CPUs see data written by the other one. Job data must not be touched by master until Wait returns.
+     */
+    class Slave
+    {
+    public:
+        /** @brief Job function
+         */
+        typedef void (*Job)(void * work);
+
+    private:
+        /** @brief Current job
+         */
+        inline static Job job = NULL;
+
+        /** @brief Current job data
+         */
+        inline static void * work = NULL;
+
+        /** @brief Slave CPU is running a job (accessed through cache-through address)
+         */
+        inline static uint32_t busy = 0;
+
+        /** @brief Slave entry was installed
+         */
+        inline static bool initialized = false;
+
+        /** @brief Get cache-through view of the busy flag
+         * @return Busy flag
+         */
+        static volatile uint32_t * GetBusy()
+        {
+            return (volatile uint32_t*)((uintptr_t)&Slave::busy | CPU_CACHE_THROUGH);
+        }
+
+        /** @brief Slave CPU entry
+         */
+        static void Entry()
+        {
+            // Master wrote job data through its write-through cache, drop stale lines of slave cache
+            cpu_cache_purge();
+            Slave::job(Slave::work);
+            *Slave::GetBusy() = 0;
+        }
+
+    public:
+        /** @brief Install slave CPU entry (can be called more than once)
+         */
+        static void Initialize()
+        {
+            if (!Slave::initialized)
+            {
+                *Slave::GetBusy() = 0;
+                cpu_dual_comm_mode_set(CPU_DUAL_ENTRY_ICI);
+                cpu_dual_slave_set(Slave::Entry);
+                Slave::initialized = true;
+            }
+        }
+
+        /** @brief Check whether jobs can run on the slave CPU
+         * @return true Slave entry is installed
+         * @return false Slave CPU is not used
+         */
+        static bool IsInitialized()
+        {
+            return Slave::initialized;
+        }
+
+        /** @brief Start job on the slave CPU
+         * @param function Job function
+         * @param data Job data
+         */
+        static void Start(Job function, void * data)
+        {
+            assert(Slave::initialized);
+            assert(*Slave::GetBusy() == 0);
+            Slave::job = function;
+            Slave::work = data;
+            *Slave::GetBusy() = 1;
+            cpu_dual_slave_notify();
+        }
+
+        /** @brief Check whether slave CPU is still running a job
+         * @return true Job is running
+         * @return false Slave CPU is idle
+         */
+        static bool IsBusy()
+        {
+            return *Slave::GetBusy() != 0;
+        }
+
+        /** @brief Wait until current job is done
+         */
+        static void Wait()
+        {
+            while (*Slave::GetBusy() != 0);
+
+            // Slave wrote job results to memory, drop stale lines of master cache
+            cpu_cache_purge();
+        }
+    };
+}
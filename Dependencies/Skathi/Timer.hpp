@@ -0,0 +1,58 @@
+#pragma once
+
+#include <yaul.h>
+
+namespace Skathi
+{
+    /** @brief Free running timer (FRT) wrapper for measuring short time spans
+     */
+    class Timer
+    {
+    public:
+        /** @brief Number of timer ticks per millisecond (system clock of 26.8465MHz divided by 32)
+         */
+        static constexpr uint32_t TicksPerMillisecond = 839;
+
+        /** @brief Initialize timer
+         */
+        static void Initialize()
+        {
+            cpu_frt_init(CPU_FRT_CLOCK_DIV_32);
+        }
+
+        /** @brief Get current timer value (wraps around every ~78ms)
+         * @return Timer ticks
+         */
+        static uint16_t GetTicks()
+        {
+            return cpu_frt_count_get();
+        }
+
+        /** @brief Get number of ticks elapsed since earlier timer value
+         * @param start Earlier timer value
+         * @return Elapsed ticks
+         */
+        static uint16_t GetElapsed(uint16_t start)
+        {
+            return (uint16_t)(cpu_frt_count_get() - start);
+        }
+
+        /** @brief Convert microseconds to timer ticks
+         * @param microseconds Time span
+         * @return Timer ticks
+         */
+        static constexpr uint32_t FromMicroseconds(uint32_t microseconds)
+        {
+            return (microseconds * Timer::TicksPerMillisecond) / 1000;
+        }
+
+        /** @brief Convert timer ticks to microseconds
+         * @param ticks Timer ticks
+         * @return Time span
+         */
+        static constexpr uint32_t ToMicroseconds(uint32_t ticks)
+        {
+            return (ticks * 1000) / Timer::TicksPerMillisecond;
+        }
+    };
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <yaul.h>
+
+namespace Skathi::Vdp1
+{
+    /** @brief Ordering table (bucket sort) for VDP1 command tables
+     * @details Commands are inserted into buckets by quantised depth in O(1) and are then chained
+     * far to near by rewriting their jump links, so the command list itself is never moved or compared.
+     * @tparam BucketCount Number of depth buckets
+     * @tparam MaxCommands Maximum number of commands that can be inserted per frame
+     */
+    template<uint16_t BucketCount, uint16_t MaxCommands>
+    class OrderingTable
+    {
+    private:
+        /** @brief Marks empty bucket or end of bucket chain
+         */
+        static constexpr uint16_t Empty = 0xffff;
+
+        /** @brief First command in each bucket
+         */
+        uint16_t heads[BucketCount];
+
+        /** @brief Next command in the same bucket
+         */
+        uint16_t next[MaxCommands];
+
+        /** @brief Nearest depth that maps to the first bucket
+         */
+        fix16_t nearDepth;
+
+        /** @brief Farthest depth that maps to the last bucket
+         */
+        fix16_t farDepth;
+
+        /** @brief Depth to bucket index scale
+         */
+        fix16_t depthScale;
+
+        /** @brief Number of inserted commands
+         */
+        uint16_t count;
+
+    public:
+        /** @brief Construct a new ordering table
+         * @param nearDepth Nearest depth (maps to first bucket)
+         * @param farDepth Farthest depth (maps to last bucket)
+         */
+        OrderingTable(fix16_t nearDepth, fix16_t farDepth)
+        {
+            this->SetDepthRange(nearDepth, farDepth);
+            this->Clear();
+        }
+
+        /** @brief Set depth range that is spread over the buckets
+         * @param nearDepth Nearest depth (maps to first bucket)
+         * @param farDepth Farthest depth (maps to last bucket)
+         */
+        void SetDepthRange(fix16_t nearDepth, fix16_t farDepth)
+        {
+            assert(farDepth > nearDepth);
+            this->nearDepth = nearDepth;
+            this->farDepth = farDepth;
+            this->depthScale = fix16_div(fix16_int32_from(BucketCount), farDepth - nearDepth);
+        }
+
+        /** @brief Remove all inserted commands (should be called at start of each frame)
+         */
+        void Clear()
+        {
+            memset(this->heads, 0xff, sizeof(this->heads));
+            this->count = 0;
+        }
+
+        /** @brief Get number of inserted commands
+         * @return Inserted command count
+         */
+        uint16_t GetCount() const
+        {
+            return this->count;
+        }
+
+        /** @brief Get bucket index for depth
+         * @param depth Depth value
+         * @return Bucket index clamped to table size
+         */
+        uint16_t GetBucket(fix16_t depth) const
+        {
+            // Depth is clamped before scaling, depths far outside of the range would overflow the multiplication
+            if (depth <= this->nearDepth)
+            {
+                return 0;
+            }
+            else if (depth >= this->farDepth)
+            {
+                return BucketCount - 1;
+            }
+
+            const int32_t bucket = fix16_int32_to(fix16_mul(depth - this->nearDepth, this->depthScale));
+            return bucket < BucketCount ? (uint16_t)bucket : BucketCount - 1;
+        }
+
+        /** @brief Insert command into table
+         * @param command Index of the command in the command list
+         * @param depth Command depth
+         */
+        void Insert(uint16_t command, fix16_t depth)
+        {
+            assert(command < MaxCommands);
+            assert(this->count < MaxCommands);
+
+            uint16_t bucket = this->GetBucket(depth);
+            this->next[command] = this->heads[bucket];
+            this->heads[bucket] = command;
+            this->count++;
+        }
+
+        /** @brief Chain inserted commands from farthest to nearest by rewriting their jump links
+         * @param commands Command list the inserted indexes point to
+         * @param head Index of command that should jump to the farthest command
+         * @param tail Index of command the nearest command should jump to
+         * @param vramIndex Index of the first command of the list in VDP1 VRAM
+         */
+        void Link(vdp1_cmdt_t * commands, uint16_t head, uint16_t tail, uint16_t vramIndex) const
+        {
+            assert(commands != NULL);
+
+            vdp1_cmdt_t * previous = &commands[head];
+
+            for (int32_t bucket = BucketCount - 1; bucket >= 0; bucket--)
+            {
+                for (uint16_t command = this->heads[bucket]; command != OrderingTable::Empty; command = this->next[command])
+                {
+                    vdp1_cmdt_link_type_set(previous, VDP1_CMDT_LINK_TYPE_JUMP_ASSIGN);
+                    vdp1_cmdt_link_set(previous, vramIndex + command);
+                    previous = &commands[command];
+                }
+            }
+
+            vdp1_cmdt_link_type_set(previous, VDP1_CMDT_LINK_TYPE_JUMP_ASSIGN);
+            vdp1_cmdt_link_set(previous, vramIndex + tail);
+        }
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <yaul.h>
-#include "../Bitmap/Bitmap.hpp"
+#include "../Bitmap/Image.hpp"
+#include "OrderingTable.hpp"
 
 extern "C"
 {
@@ -11,19 +12,350 @@ extern "C"
  */
 namespace Skathi::Vdp1
 {
-    /** @brief Sprite functions
+    /** @brief Sprite batcher, collects sprites during the frame and writes them into command tables in one go
+     * @details Sprites are grouped by layer, then by texture and palette. All buffers are allocated when the batch is created,
+     * nothing is allocated per frame.
      */
     class Sprite
     {
     public:
-        // TODO
+        /** @brief Sprite type
+         */
+        enum class Type : uint8_t
+        {
+            /** @brief Unscaled sprite, only first vertex (top left corner) is used
+             */
+            Normal = 0,
+
+            /** @brief Scaled sprite, first and second vertex are top left and bottom right corners
+             */
+            Scaled = 1,
+
+            /** @brief Distorted sprite, all four vertices are used (clockwise from top left)
+             */
+            Distorted = 2
+        };
+
+        /** @brief Single sprite
+         */
+        struct Instance
+        {
+            /** @brief Sprite type
+             */
+            Type Kind;
+
+            /** @brief Draw order, lower layers are drawn first
+             */
+            uint8_t Layer;
+
+            /** @brief Draw mode (command table cmd_pmod)
+             */
+            uint16_t DrawMode;
+
+            /** @brief Color bank or lookup table address (command table cmd_colr)
+             */
+            uint16_t Color;
+
+            /** @brief Texture address (command table cmd_srca)
+             */
+            uint16_t Character;
+
+            /** @brief Texture size (command table cmd_size)
+             */
+            uint16_t Size;
+
+            /** @brief Screen vertices
+             */
+            int16_vec2_t Vertices[4];
+        };
+
+    private:
+        /** @brief Command type bits of the control word (cmd_ctrl)
+         */
+        static constexpr uint16_t ControlCommand = 0x000f;
+
+        /** @brief Texture flip bits of the control word
+         */
+        static constexpr uint16_t ControlDirection = 0x0030;
+
+        /** @brief Reserved bits of the control word (have to be zero)
+         */
+        static constexpr uint16_t ControlReserved = 0x00c0;
+
+        /** @brief Zoom point bits of the control word
+         */
+        static constexpr uint16_t ControlZoomPoint = 0x0f00;
+
+        /** @brief Link type bits of the control word
+         */
+        static constexpr uint16_t ControlLinkType = 0x7000;
+
+        /** @brief End bit of the control word
+         */
+        static constexpr uint16_t ControlEnd = 0x8000;
+
+        /** @brief Added sprites
+         */
+        Instance * sprites;
+
+        /** @brief Sort keys of added sprites
+         */
+        uint32_t * keys;
+
+        /** @brief Sprite indices in draw order
+         */
+        uint16_t * order;
+
+        /** @brief Scratch buffer for sorting
+         */
+        uint16_t * scratch;
+
+        /** @brief Maximum number of sprites
+         */
+        uint16_t capacity;
+
+        /** @brief Number of added sprites
+         */
+        uint16_t count;
+
+        /** @brief Get sort key of a sprite
+         * @details Key collisions of texture and palette only make grouping worse, layer order is always kept.
+         * @param sprite Sprite instance
+         * @return Sort key
+         */
+        static uint32_t GetKey(const Instance * sprite)
+        {
+            return ((uint32_t)sprite->Layer << 24) | ((uint32_t)sprite->Character << 8) | (((sprite->Color & 0xff) ^ (sprite->Color >> 8)) & 0xff);
+        }
+
+        /** @brief Sort sprites by key (stable radix sort, 8 bits per pass)
+         */
+        void Sort()
+        {
+            uint16_t * from = this->order;
+            uint16_t * to = this->scratch;
+
+            for (uint16_t sprite = 0; sprite < this->count; sprite++)
+            {
+                from[sprite] = sprite;
+            }
+
+            for (uint8_t shift = 0; shift < 32; shift += 8)
+            {
+                uint16_t offsets[256];
+                memset(offsets, 0, sizeof(offsets));
+
+                for (uint16_t sprite = 0; sprite < this->count; sprite++)
+                {
+                    offsets[(this->keys[sprite] >> shift) & 0xff]++;
+                }
+
+                // Skip passes where all keys have the same digit
+                if (offsets[(this->keys[0] >> shift) & 0xff] == this->count)
+                {
+                    continue;
+                }
+
+                uint16_t total = 0;
+
+                for (uint16_t digit = 0; digit < 256; digit++)
+                {
+                    const uint16_t size = offsets[digit];
+                    offsets[digit] = total;
+                    total += size;
+                }
+
+                for (uint16_t sprite = 0; sprite < this->count; sprite++)
+                {
+                    to[offsets[(this->keys[from[sprite]] >> shift) & 0xff]++] = from[sprite];
+                }
+
+                uint16_t * swap = from;
+                from = to;
+                to = swap;
+            }
+
+            if (from != this->order)
+            {
+                memcpy(this->order, from, this->count * sizeof(uint16_t));
+            }
+        }
+
+    public:
+        /** @brief Construct a new sprite batch
+         * @param capacity Maximum number of sprites per frame
+         */
+        Sprite(uint16_t capacity)
+        {
+            assert(capacity > 0);
+            this->capacity = capacity;
+            this->count = 0;
+            this->sprites = (Instance*)malloc(sizeof(Instance) * capacity);
+            this->keys = (uint32_t*)malloc(sizeof(uint32_t) * capacity);
+            this->order = (uint16_t*)malloc(sizeof(uint16_t) * capacity);
+            this->scratch = (uint16_t*)malloc(sizeof(uint16_t) * capacity);
+            assert(this->sprites != NULL && this->keys != NULL && this->order != NULL && this->scratch != NULL);
+        }
+
+        /** @brief Destroy the sprite batch
+         */
+        ~Sprite()
+        {
+            free(this->sprites);
+            free(this->keys);
+            free(this->order);
+            free(this->scratch);
+        }
+
+        /** @brief Set texture of a sprite
+         * @param sprite Sprite instance
+         * @param texture Texture
+         */
+        static void SetTexture(Instance * sprite, const texture_t * texture)
+        {
+            sprite->Character = texture->vram_index;
+            sprite->Size = texture->size;
+        }
+
+        /** @brief Write single sprite into command table
+         * @details Command jumps to the next command in the list, links can be rewritten later (e.g. by OrderingTable::Link).
+         * @param sprite Sprite instance
+         * @param command Command table
+         */
+        static void WriteCommand(const Instance * sprite, vdp1_cmdt_t * command)
+        {
+            // Command is not the end of the list, texture is not flipped, scaled sprite uses vertex C as opposite corner (no zoom point)
+            // and zero link type is jump next
+            const uint16_t cleared = Sprite::ControlCommand | Sprite::ControlDirection | Sprite::ControlReserved | Sprite::ControlZoomPoint | Sprite::ControlLinkType | Sprite::ControlEnd;
+            command->cmd_ctrl = (command->cmd_ctrl & ~cleared) | ((uint16_t)sprite->Kind & Sprite::ControlCommand);
+            command->cmd_link = 0;
+            command->cmd_pmod = sprite->DrawMode;
+            command->cmd_colr = sprite->Color;
+            command->cmd_srca = sprite->Character;
+            command->cmd_size = sprite->Size;
+
+            switch (sprite->Kind)
+            {
+            case Type::Distorted:
+                command->cmd_xd = sprite->Vertices[3].x;
+                command->cmd_yd = sprite->Vertices[3].y;
+                command->cmd_xc = sprite->Vertices[2].x;
+                command->cmd_yc = sprite->Vertices[2].y;
+                command->cmd_xb = sprite->Vertices[1].x;
+                command->cmd_yb = sprite->Vertices[1].y;
+                break;
+
+            case Type::Scaled:
+                // Two point scaled sprite reads opposite corner from vertex C
+                command->cmd_xc = sprite->Vertices[1].x;
+                command->cmd_yc = sprite->Vertices[1].y;
+                break;
+
+            default:
+                break;
+            }
+
+            command->cmd_xa = sprite->Vertices[0].x;
+            command->cmd_ya = sprite->Vertices[0].y;
+        }
+
+        /** @brief Remove all sprites (should be called at start of each frame)
+         */
+        void Clear()
+        {
+            this->count = 0;
+        }
+
+        /** @brief Get number of added sprites
+         * @return Sprite count
+         */
+        uint16_t GetCount() const
+        {
+            return this->count;
+        }
+
+        /** @brief Add sprite
+         * @param sprite Sprite instance
+         * @return true Sprite was added
+         * @return false Batch is full
+         */
+        bool Add(const Instance * sprite)
+        {
+            return this->Add(sprite, 1) == 1;
+        }
+
+        /** @brief Add many sprites
+         * @param sprites Sprite instances
+         * @param count Number of sprites
+         * @return Number of sprites that fit into the batch
+         */
+        uint16_t Add(const Instance * sprites, uint16_t count)
+        {
+            const uint16_t space = this->capacity - this->count;
+            const uint16_t added = count < space ? count : space;
+            memcpy(&this->sprites[this->count], sprites, added * sizeof(Instance));
+
+            for (uint16_t sprite = 0; sprite < added; sprite++)
+            {
+                this->keys[this->count + sprite] = Sprite::GetKey(&sprites[sprite]);
+            }
+
+            this->count += added;
+            return added;
+        }
+
+        /** @brief Sort sprites and write them into command tables
+         * @details Commands are written one after another with jump next links, end of the list is left to the caller.
+         * @param commands Command table buffer
+         * @param capacity Number of command tables in the buffer
+         * @return Number of written command tables
+         */
+        uint16_t Write(vdp1_cmdt_t * commands, uint16_t capacity)
+        {
+            assert(commands != NULL);
+
+            if (this->count == 0)
+            {
+                return 0;
+            }
+
+            this->Sort();
+
+            const uint16_t written = this->count < capacity ? this->count : capacity;
+
+            for (uint16_t index = 0; index < written; index++)
+            {
+                Sprite::WriteCommand(&this->sprites[this->order[index]], &commands[index]);
+            }
+
+            return written;
+        }
     };
     
     /** @brief Texture utility functions
+     * @details Indexed images with at most 16 colors are stored as 4bpp color bank textures, other indexed images as 8bpp.
      */
     class TextureUtils
     {
     public:
+        /** @brief Get VDP1 color mode the image is loaded in
+         * @details Mode is picked by number of palette entries, 256 entry palette is always loaded as 8bpp.
+         * @param image Loaded image
+         * @return Color mode (command table cmd_pmod bits 3 to 5)
+         */
+        static uint16_t GetColorMode(Skathi::Bitmap::Image * image)
+        {
+            Skathi::Bitmap::ImageInfo_t info;
+            image->GetInfo(&info);
+
+            if (info.Format == Skathi::Bitmap::ImageFormat::RGB)
+            {
+                return VDP1_CMDT_CM_RGB_32768;
+            }
+
+            return info.PaletteSize <= 16 ? VDP1_CMDT_CM_CB_16 : VDP1_CMDT_CM_CB_256;
+        }
+
         /** @brief Loads RGB image as texture
          * @param image Image to load
          * @param texture Loaded texture
@@ -36,7 +368,7 @@ namespace Skathi::Vdp1
             Skathi::Bitmap::ImageInfo_t info;
             image->GetInfo(&info);
 
-            assert(info.Size.Width % 8 == 0)
+            assert(info.Size.Width % 8 == 0);
 
             texture->size = TEXTURE_SIZE(info.Size.Width, info.Size.Height);
             texture->vram_index = TEXTURE_VRAM_INDEX(textureBase);
@@ -44,16 +376,71 @@ namespace Skathi::Vdp1
             uint8_t * data = image->GetImageData();
             assert(data != NULL);
 
-            int dataSize = (info.Size.Height * info.Size.Width) * (info.PaletteSize > 0 ? 1 : 2);
+            const uint32_t pixels = info.Size.Height * info.Size.Width;
+
+            if (TextureUtils::GetColorMode(image) == VDP1_CMDT_CM_CB_16)
+            {
+                // Two pixels per byte, left pixel in the high nibble
+                const size_t packedSize = pixels >> 1;
+                uint8_t * packed = (uint8_t*)malloc(packedSize);
+                assert(packed != NULL);
+
+                for (uint32_t pixel = 0; pixel < packedSize; pixel++)
+                {
+                    // Palette has at most 16 entries, so any larger index is a broken image
+                    assert(((data[pixel << 1] | data[(pixel << 1) + 1]) & 0xf0) == 0);
+                    packed[pixel] = (data[pixel << 1] << 4) | data[(pixel << 1) + 1];
+                }
+
+                scu_dma_transfer(0, (void *)textureBase, packed, packedSize);
+                scu_dma_transfer_wait(0);
+                free(packed);
+                return packedSize;
+            }
+
+            int dataSize = pixels * (info.Format == Skathi::Bitmap::ImageFormat::Indexed ? 1 : 2);
             scu_dma_transfer(0, (void *)textureBase, data, dataSize);
             scu_dma_transfer_wait(0);
 
             return dataSize;
         }
 
+        /** @brief Get texture of a band of rows of a loaded texture
+         * @details VDP1 reads texture from its start address on, so the band keeps the full width and has to start at a multiple of 8 bytes.
+         * @param texture Loaded texture
+         * @param colorMode Color mode the texture was loaded in
+         * @param firstRow First row of the band
+         * @param rows Number of rows in the band
+         * @param region Texture of the band
+         */
+        static void GetRows(const texture_t * texture, uint16_t colorMode, uint16_t firstRow, uint16_t rows, texture_t * region)
+        {
+            assert(texture != NULL);
+            assert(region != NULL);
+
+            const uint16_t width = (texture->size >> 8) << 3;
+            assert(firstRow + rows <= (texture->size & 0xff));
+
+            // 16 color modes store two pixels per byte, RGB mode one pixel per word
+            uint32_t offset = firstRow * width;
+
+            if (colorMode == VDP1_CMDT_CM_CB_16 || colorMode == VDP1_CMDT_CM_CLUT_16)
+            {
+                offset >>= 1;
+            }
+            else if (colorMode == VDP1_CMDT_CM_RGB_32768)
+            {
+                offset <<= 1;
+            }
+
+            assert((offset & 7) == 0);
+            region->vram_index = texture->vram_index + (offset >> 3);
+            region->size = TEXTURE_SIZE(width, rows);
+        }
+
         /** @brief Loads paletted image as texture
          * @param image Image to load
-         * @param startPaletteColorIndex Index of first color in CRAM to load palette to
+         * @param startPaletteColorIndex Index of first color in CRAM to load palette to (color bank used by the texture)
          * @param texture Loaded texture
          * @param textureBase Where to load texture to in VRAM
          * @return Size of loaded image data
@@ -66,8 +453,11 @@ namespace Skathi::Vdp1
             // Load palette data
             Skathi::Bitmap::ImageInfo_t info;
             image->GetInfo(&info);
-            
-            scu_dma_transfer(0, (void *)VDP2_CRAM_ADDR(startPaletteColorIndex), image->GetPalette(), info.PaletteSize);
+
+            // Color bank has to start at a multiple of its size
+            assert((startPaletteColorIndex & ((TextureUtils::GetColorMode(image) == VDP1_CMDT_CM_CB_16 ? 16 : 256) - 1)) == 0);
+
+            scu_dma_transfer(0, (void *)VDP2_CRAM_ADDR(startPaletteColorIndex), image->GetPalette(), info.PaletteSize * sizeof(Skathi::Bitmap::Color_t));
             scu_dma_transfer_wait(0);
 
             return imageDataSize;
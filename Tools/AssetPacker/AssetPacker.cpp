@@ -0,0 +1,335 @@
+/** @brief Packs files into compressed container read by Skathi::Compression::Packed
+ * @details Build: g++ -std=c++17 -O2 -o AssetPacker AssetPacker.cpp
+ * Usage: AssetPacker <output directory> <input> [input ...]
+ *
+ * Outputs keep the names of the inputs, packed and plain files are read by the same Packed::ReadFile call.
+ * Every packed file is decompressed again and compared with the input before it is written.
+ * Report shows compression ratio and load throughput at 2x CD speed when decompression keeps up with the drive.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../../Dependencies/Skathi/Compression/Lz.hpp"
+
+/** @brief File identifier ("UPAK")
+ */
+static constexpr uint32_t Magic = 0x5550414b;
+
+/** @brief Decompressed size of a block (Skathi::Compression::Packed::MaxBlockSize at most)
+ */
+static constexpr size_t BlockSize = 16384;
+
+/** @brief Number of earlier positions tried for each match
+ */
+static constexpr int SearchDepth = 64;
+
+/** @brief Number of bits of match search hash
+ */
+static constexpr int HashBits = 14;
+
+/** @brief Read speed of 2x CD drive in bytes per second
+ */
+static constexpr double CdSpeed = 300.0 * 1024.0;
+
+/** @brief Append length bytes over 15
+ * @param output Compressed data
+ * @param length Length minus the part stored in the token
+ */
+static void WriteLength(std::vector<uint8_t> & output, size_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        output.push_back(255);
+    }
+
+    output.push_back((uint8_t)length);
+}
+
+/** @brief Append single sequence
+ * @param output Compressed data
+ * @param literals First literal
+ * @param literalCount Number of literals
+ * @param offset Match offset (0 for last sequence without match)
+ * @param match Match length
+ */
+static void WriteSequence(std::vector<uint8_t> & output, const uint8_t * literals, size_t literalCount, size_t offset, size_t match)
+{
+    const size_t matchCode = offset != 0 ? match - Skathi::Compression::Lz::MinMatch : 0;
+    output.push_back((uint8_t)(((literalCount < 15 ? literalCount : 15) << 4) | (matchCode < 15 ? matchCode : 15)));
+
+    if (literalCount >= 15)
+    {
+        WriteLength(output, literalCount - 15);
+    }
+
+    output.insert(output.end(), literals, literals + literalCount);
+
+    if (offset != 0)
+    {
+        output.push_back((uint8_t)(offset >> 8));
+        output.push_back((uint8_t)(offset & 0xff));
+
+        if (matchCode >= 15)
+        {
+            WriteLength(output, matchCode - 15);
+        }
+    }
+}
+
+/** @brief Hash of 4 bytes
+ * @param data Data
+ * @return Hash table index
+ */
+static size_t Hash(const uint8_t * data)
+{
+    const uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+    return (value * 2654435761u) >> (32 - HashBits);
+}
+
+/** @brief Compress single block (greedy parse with hash chains)
+ * @param data Block data
+ * @param size Block size
+ * @return Compressed block
+ */
+static std::vector<uint8_t> Compress(const uint8_t * data, size_t size)
+{
+    std::vector<uint8_t> output;
+    std::vector<int> head((size_t)1 << HashBits, -1);
+    std::vector<int> previous(size, -1);
+    size_t anchor = 0;
+    size_t position = 0;
+
+    auto insert = [&](size_t at)
+    {
+        if (at + Skathi::Compression::Lz::MinMatch <= size)
+        {
+            const size_t hash = Hash(data + at);
+            previous[at] = head[hash];
+            head[hash] = (int)at;
+        }
+    };
+
+    while (position + Skathi::Compression::Lz::MinMatch <= size)
+    {
+        size_t bestLength = 0;
+        size_t bestOffset = 0;
+        int candidate = head[Hash(data + position)];
+
+        for (int depth = 0; depth < SearchDepth && candidate >= 0; depth++, candidate = previous[candidate])
+        {
+            const size_t offset = position - candidate;
+
+            if (offset > Skathi::Compression::Lz::MaxOffset)
+            {
+                break;
+            }
+
+            size_t length = 0;
+
+            while (position + length < size && data[candidate + length] == data[position + length])
+            {
+                length++;
+            }
+
+            if (length > bestLength)
+            {
+                bestLength = length;
+                bestOffset = offset;
+            }
+        }
+
+        if (bestLength < Skathi::Compression::Lz::MinMatch)
+        {
+            insert(position++);
+            continue;
+        }
+
+        WriteSequence(output, data + anchor, position - anchor, bestOffset, bestLength);
+
+        for (size_t at = position; at < position + bestLength; at++)
+        {
+            insert(at);
+        }
+
+        position += bestLength;
+        anchor = position;
+    }
+
+    if (anchor < size)
+    {
+        WriteSequence(output, data + anchor, size - anchor, 0, 0);
+    }
+
+    return output;
+}
+
+/** @brief Packed file writer (big endian)
+ */
+class Writer
+{
+private:
+    /** @brief Output data
+     */
+    std::vector<uint8_t> data;
+
+public:
+    /** @brief Write 32bit word
+     * @param value Value
+     */
+    void Long(uint32_t value)
+    {
+        this->data.push_back(value >> 24);
+        this->data.push_back((value >> 16) & 0xff);
+        this->data.push_back((value >> 8) & 0xff);
+        this->data.push_back(value & 0xff);
+    }
+
+    /** @brief Write bytes
+     * @param bytes Bytes to write
+     */
+    void Bytes(const std::vector<uint8_t> & bytes)
+    {
+        this->data.insert(this->data.end(), bytes.begin(), bytes.end());
+    }
+
+    /** @brief Get output size
+     * @return Number of written bytes
+     */
+    size_t GetSize() const
+    {
+        return this->data.size();
+    }
+
+    /** @brief Save output
+     * @param path File path
+     * @return true File was written
+     * @return false File could not be written
+     */
+    bool Save(const std::string & path) const
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream.write((const char*)this->data.data(), this->data.size());
+        return (bool)stream;
+    }
+};
+
+int main(int argc, char ** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <output directory> <input> [input ...]\n", argv[0]);
+        return 1;
+    }
+
+    size_t totalInput = 0;
+    size_t totalOutput = 0;
+    double totalSeconds = 0.0;
+
+    for (int argument = 2; argument < argc; argument++)
+    {
+        const std::string input = argv[argument];
+        std::ifstream stream(input, std::ios::binary);
+
+        if (!stream)
+        {
+            fprintf(stderr, "Cannot open %s\n", input.c_str());
+            return 1;
+        }
+
+        const std::vector<uint8_t> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        const size_t blocks = (file.size() + BlockSize - 1) / BlockSize;
+        std::vector<std::vector<uint8_t>> packed(blocks);
+
+        // Blocks that do not get smaller are stored as they are
+        for (size_t block = 0; block < blocks; block++)
+        {
+            const size_t start = block * BlockSize;
+            const size_t size = file.size() - start < BlockSize ? file.size() - start : BlockSize;
+            packed[block] = Compress(file.data() + start, size);
+
+            if (packed[block].size() >= size)
+            {
+                packed[block].assign(file.begin() + start, file.begin() + start + size);
+            }
+        }
+
+        Writer writer;
+        writer.Long(Magic);
+        writer.Long((uint32_t)file.size());
+        writer.Long((uint32_t)BlockSize);
+        writer.Long((uint32_t)blocks);
+
+        size_t offset = 16 + ((blocks + 1) * 4);
+
+        for (size_t block = 0; block <= blocks; block++)
+        {
+            writer.Long((uint32_t)offset);
+            offset += block < blocks ? packed[block].size() : 0;
+        }
+
+        for (const std::vector<uint8_t> & block : packed)
+        {
+            writer.Bytes(block);
+        }
+
+        // Decompress everything again before the file is written
+        std::vector<uint8_t> check(file.size());
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t block = 0; block < blocks; block++)
+        {
+            const size_t size = file.size() - (block * BlockSize) < BlockSize ? file.size() - (block * BlockSize) : BlockSize;
+            uint8_t * target = check.data() + (block * BlockSize);
+
+            if (packed[block].size() == size)
+            {
+                std::copy(packed[block].begin(), packed[block].end(), target);
+            }
+            else if (Skathi::Compression::Lz::Decompress(packed[block].data(), packed[block].size(), target, size) != size)
+            {
+                fprintf(stderr, "%s: block %zu does not decompress\n", input.c_str(), block);
+                return 1;
+            }
+        }
+
+        totalSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (check != file)
+        {
+            fprintf(stderr, "%s: decompressed data differs from the input\n", input.c_str());
+            return 1;
+        }
+
+        const size_t slash = input.find_last_of("/\\");
+        const std::string output = std::string(argv[1]) + "/" + (slash == std::string::npos ? input : input.substr(slash + 1));
+
+        if (!writer.Save(output))
+        {
+            fprintf(stderr, "Cannot write %s\n", output.c_str());
+            return 1;
+        }
+
+        totalInput += file.size();
+        totalOutput += writer.GetSize();
+        printf("%s: %zu -> %zu bytes (%.1f%%)\n", output.c_str(), file.size(), writer.GetSize(), file.size() > 0 ? (100.0 * writer.GetSize()) / file.size() : 100.0);
+    }
+
+    if (totalOutput > 0)
+    {
+        printf("Total: %zu -> %zu bytes, ratio %.2f:1\n", totalInput, totalOutput, (double)totalInput / totalOutput);
+        printf("Load throughput at 2x CD speed: %.0f KB/s (plain %.0f KB/s)\n", (CdSpeed * totalInput / totalOutput) / 1024.0, CdSpeed / 1024.0);
+    }
+
+    if (totalSeconds > 0.0)
+    {
+        printf("Host decompression: %.1f MB/s\n", totalInput / totalSeconds / (1024.0 * 1024.0));
+    }
+
+    return 0;
+}
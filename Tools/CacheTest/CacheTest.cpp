@@ -0,0 +1,260 @@
+/** @brief Tests Skathi::Cache backed by a plain memory buffer in place of the DRAM cartridge
+ * @details Build: g++ -std=c++17 -O2 -o CacheTest CacheTest.cpp
+ * Usage: CacheTest [number of random operations]
+ *
+ * Covers least recently used eviction, first-fit placement, repeated stores to the same sector address, data larger than
+ * the cache and the entry count limit, then runs random stores and finds against a reference map of the latest data
+ * stored for each address. Exits with non-zero code when any check fails.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+#include "../../Dependencies/Skathi/Cache.hpp"
+
+/** @brief Number of failed checks
+ */
+static uint32_t failures = 0;
+
+/** @brief Number of passed checks
+ */
+static uint32_t passes = 0;
+
+/** @brief Record check result
+ * @param condition Checked condition
+ * @param name Check description
+ */
+static void Check(bool condition, const char * name)
+{
+    if (condition)
+    {
+        passes++;
+        return;
+    }
+
+    failures++;
+    fprintf(stderr, "FAILED: %s\n", name);
+}
+
+/** @brief Make data filled with a pattern
+ * @param seed Pattern seed
+ * @param size Number of bytes
+ * @return Data
+ */
+static std::vector<uint8_t> Pattern(uint32_t seed, uint32_t size)
+{
+    std::vector<uint8_t> data(size);
+
+    for (uint32_t byte = 0; byte < size; byte++)
+    {
+        data[byte] = (uint8_t)((seed * 31) + (byte * 7) + (byte >> 8));
+    }
+
+    return data;
+}
+
+/** @brief Store pattern data
+ * @param fad Sector address
+ * @param size Number of bytes
+ */
+static void Store(uint32_t fad, uint32_t size)
+{
+    const std::vector<uint8_t> data = Pattern(fad, size);
+    Skathi::Cache::Store(fad, data.data(), size);
+}
+
+/** @brief Check cached data is the pattern of its address
+ * @param fad Sector address
+ * @param size Number of bytes
+ * @return Cached data or NULL if it was not found or does not match
+ */
+static const uint8_t * Verify(uint32_t fad, uint32_t size)
+{
+    const uint8_t * cached = Skathi::Cache::Find(fad, size);
+
+    if (cached == NULL)
+    {
+        return NULL;
+    }
+
+    const std::vector<uint8_t> data = Pattern(fad, size);
+    return memcmp(cached, data.data(), size) == 0 ? cached : NULL;
+}
+
+/** @brief Least recently used entry is evicted first
+ * @param memory Cache memory
+ */
+static void TestEviction(std::vector<uint8_t> & memory)
+{
+    Skathi::Cache::Initialize(memory.data(), 4096);
+
+    for (uint32_t fad = 1; fad <= 4; fad++)
+    {
+        Store(fad, 1024);
+    }
+
+    Check(Skathi::Cache::GetUsed() == 4096, "eviction: four entries fill the cache");
+
+    // Touch first entry, so the second one is the oldest
+    Check(Verify(1, 1024) != NULL, "eviction: first entry is found");
+    Store(5, 1024);
+
+    Check(Verify(1, 1024) != NULL, "eviction: recently used entry is kept");
+    Check(Skathi::Cache::Find(2, 1024) == NULL, "eviction: least recently used entry is evicted");
+    Check(Verify(3, 1024) != NULL && Verify(4, 1024) != NULL, "eviction: other entries are kept");
+    Check(Verify(5, 1024) != NULL, "eviction: new entry is found");
+
+    // Larger entry evicts as many old entries as it needs
+    Store(6, 3072);
+    Check(Verify(6, 3072) != NULL, "eviction: large entry is stored");
+    Check(Skathi::Cache::GetUsed() <= 4096, "eviction: used size stays within capacity");
+}
+
+/** @brief New entry goes into the first gap large enough
+ * @param memory Cache memory
+ */
+static void TestPlacement(std::vector<uint8_t> & memory)
+{
+    Skathi::Cache::Initialize(memory.data(), 4096);
+    Store(1, 1024);
+    Store(2, 1024);
+    Store(3, 1024);
+
+    Check(Skathi::Cache::Find(1, 1024) == memory.data(), "placement: first entry is at the start");
+    Check(Skathi::Cache::Find(3, 1024) == memory.data() + 2048, "placement: entries are packed");
+
+    // Replacing the second entry by a smaller one leaves a gap behind it
+    Store(2, 256);
+    Check(Skathi::Cache::Find(2, 256) == memory.data() + 1024, "placement: replaced entry takes the gap it left");
+
+    // Small entry goes into the first gap, not to the free end
+    Store(4, 512);
+    Check(Skathi::Cache::Find(4, 512) == memory.data() + 1280, "placement: first gap is used");
+
+    // Unaligned sizes are rounded up to words
+    Store(5, 3);
+    Check(Skathi::Cache::Find(5, 3) == memory.data() + 1792, "placement: entries start at word boundary");
+    Store(6, 4);
+    Check(Skathi::Cache::Find(6, 4) == memory.data() + 1796, "placement: size is rounded up to whole word");
+
+    // Entry that fits nowhere evicts the oldest entries and takes the first gap that opens
+    Store(7, 2048);
+    Check(Verify(7, 2048) != NULL, "placement: entry is stored after eviction");
+    Check(Skathi::Cache::Find(1, 1024) == NULL, "placement: oldest entry made room");
+}
+
+/** @brief Stores to the same address replace older data
+ * @param memory Cache memory
+ */
+static void TestRepeatedStores(std::vector<uint8_t> & memory)
+{
+    Skathi::Cache::Initialize(memory.data(), 4096);
+    Store(10, 100);
+    Store(10, 200);
+
+    Check(Skathi::Cache::GetUsed() == 200, "repeated: only the latest store is kept");
+    Check(Verify(10, 200) != NULL, "repeated: longer read is served");
+    Check(Verify(10, 50) != NULL, "repeated: shorter read of the same address is served");
+
+    // Different data at the same address replaces the old data
+    const std::vector<uint8_t> other = Pattern(99, 64);
+    Skathi::Cache::Store(10, other.data(), 64);
+    const uint8_t * cached = Skathi::Cache::Find(10, 64);
+    Check(cached != NULL && memcmp(cached, other.data(), 64) == 0, "repeated: new data replaces old data");
+    Check(Skathi::Cache::Find(10, 200) == NULL, "repeated: read longer than the latest store misses");
+
+    for (uint32_t repeat = 0; repeat < 1000; repeat++)
+    {
+        Store(11, 16 + (repeat % 512));
+    }
+
+    Check(Skathi::Cache::GetUsed() == 64 + ((16 + (999 % 512) + 3) & ~3), "repeated: many stores do not leak space");
+}
+
+/** @brief Data larger than the cache and entry count limit
+ * @param memory Cache memory
+ */
+static void TestLimits(std::vector<uint8_t> & memory)
+{
+    Skathi::Cache::Initialize(memory.data(), 4096);
+    Store(1, 5000);
+    Check(Skathi::Cache::Find(1, 5000) == NULL && Skathi::Cache::GetUsed() == 0, "limits: data larger than the cache is not stored");
+
+    Skathi::Cache::Initialize(memory.data(), (uint32_t)memory.size());
+
+    for (uint32_t fad = 0; fad < Skathi::Cache::MaxEntries + 10; fad++)
+    {
+        Store(fad, 4);
+    }
+
+    Check(Skathi::Cache::GetUsed() == Skathi::Cache::MaxEntries * 4, "limits: entry count stays at the limit");
+    Check(Skathi::Cache::Find(0, 4) == NULL, "limits: oldest entry is evicted at the entry limit");
+    Check(Verify(Skathi::Cache::MaxEntries + 9, 4) != NULL, "limits: newest entry is kept");
+
+    Skathi::Cache::Initialize(NULL, 0);
+    Store(1, 16);
+    Check(!Skathi::Cache::IsEnabled() && Skathi::Cache::Find(1, 16) == NULL, "limits: disabled cache stores nothing");
+}
+
+/** @brief Random stores and finds against reference of the latest data of each address
+ * @param memory Cache memory
+ * @param operations Number of operations
+ */
+static void TestRandom(std::vector<uint8_t> & memory, uint32_t operations)
+{
+    Skathi::Cache::Initialize(memory.data(), 64 * 1024);
+    std::map<uint32_t, std::vector<uint8_t>> latest;
+    std::mt19937 random(1);
+    uint32_t corrupted = 0;
+    uint32_t hits = 0;
+
+    for (uint32_t operation = 0; operation < operations; operation++)
+    {
+        const uint32_t fad = random() % 128;
+
+        if (random() % 3 == 0)
+        {
+            std::vector<uint8_t> data = Pattern(random(), 1 + (random() % 8192));
+            Skathi::Cache::Store(fad, data.data(), (uint32_t)data.size());
+            latest[fad] = data;
+        }
+        else if (latest.count(fad) != 0)
+        {
+            const std::vector<uint8_t> & expected = latest[fad];
+            const uint32_t size = 1 + (random() % expected.size());
+            const uint8_t * cached = Skathi::Cache::Find(fad, size);
+
+            if (cached != NULL)
+            {
+                hits++;
+                corrupted += memcmp(cached, expected.data(), size) != 0 ? 1 : 0;
+            }
+        }
+
+        if (Skathi::Cache::GetUsed() > 64 * 1024)
+        {
+            corrupted++;
+        }
+    }
+
+    Check(corrupted == 0, "random: hits return the latest stored data and capacity is kept");
+    Check(hits > 0, "random: some reads are served from the cache");
+    printf("Random: %u operations, %u hits, %u misses\n", operations, Skathi::Cache::GetHits(), Skathi::Cache::GetMisses());
+}
+
+int main(int argc, char ** argv)
+{
+    const uint32_t operations = argc > 1 ? (uint32_t)atoi(argv[1]) : 100000;
+    std::vector<uint8_t> memory(256 * 1024);
+
+    TestEviction(memory);
+    TestPlacement(memory);
+    TestRepeatedStores(memory);
+    TestLimits(memory);
+    TestRandom(memory, operations);
+
+    printf("%u checks passed, %u failed\n", passes, failures);
+    return failures == 0 ? 0 : 1;
+}
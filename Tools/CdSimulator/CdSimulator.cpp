@@ -0,0 +1,549 @@
+/** @brief Replays load sequences through the same Skathi::CdScheduler calls the game makes with simulated drive and compares them with
+ * reads served in issue order
+ * @details Build: g++ -std=c++17 -O2 -o CdSimulator CdSimulator.cpp
+ * Usage: CdSimulator [-c <cartridge size in KB>] [-b <sectors per frame>] [-p <prefetches per frame>] <sequences.txt>
+ * Example: CdSimulator -c 1024 sequences.txt (boot, level load and in-game streaming with music of a match)
+ *
+ * Sequence file has one command per line, '#' starts a comment:
+ *   sequence <name>              start new sequence (statistics are reported per sequence)
+ *   music <start fad> <end fad>  start CD-DA playback
+ *   stop                         stop CD-DA playback
+ *   read <fad> <sectors>         read queued in the current frame (Cd::QueueFileRange, polled by the caller)
+ *   load <fad> <sectors>         read waited for (Cd::ReadFileRange, used while loading)
+ *   prefetch <fad> <sectors>     prefetch into the DRAM cartridge issued in the current frame (Cd::Prefetch)
+ *   frame [count]                end current frame (CdScheduler::Update is called once per frame like the game loop does)
+ *
+ * Scheduled run serves queued reads a limited number of sectors per frame (-b, CD_READ_SECTORS of the game), so reads that are still
+ * queued when the sequence ends are served by extra frames. In order run serves every read when it is issued and waits for it.
+ * Cartridge contents are kept between sequences, so a sequence loading the same data again shows the effect of the cache.
+ * Report shows seek distance in sectors, estimated drive time, number of times the music was stopped, longest time a single frame
+ * waited for the drive and average number of frames between queueing a read and its data being ready.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../../Dependencies/Skathi/CdScheduler.hpp"
+
+/** @brief Time of a single frame in microseconds
+ */
+static constexpr uint64_t FrameMicroseconds = 16667;
+
+/** @brief CD-DA playback speed in sectors per second
+ */
+static constexpr uint64_t MusicSectorsPerSecond = 75;
+
+/** @brief Simulated drive used by the scheduler
+ */
+struct SimulatedDrive
+{
+    /** @brief Number of finished frames
+     */
+    uint64_t Frames = 0;
+
+    /** @brief Sector address playback started at
+     */
+    uint32_t PlayFad = 0;
+
+    /** @brief First sector address of the track
+     */
+    uint32_t TrackStart = 0;
+
+    /** @brief Sector address playback loops at
+     */
+    uint32_t TrackEnd = 0;
+
+    /** @brief Simulated time playback started at
+     */
+    uint64_t PlayTime = 0;
+
+    /** @brief Get simulated time
+     * @return Time in microseconds
+     */
+    uint64_t Now() const
+    {
+        return (this->Frames * FrameMicroseconds) + Skathi::CdScheduler::GetDriveTime();
+    }
+};
+
+/** @brief Drive state of the current run
+ */
+static SimulatedDrive drive;
+
+/** @brief Data of the largest read (content does not matter)
+ */
+static std::vector<uint8_t> scratch;
+
+/** @brief Simulated sector read
+ * @param fad Sector address
+ * @param buffer Target buffer
+ * @param size Number of bytes
+ * @return Always true
+ */
+static bool Read(uint32_t fad, void * buffer, uint32_t size)
+{
+    (void)fad;
+    (void)buffer;
+    (void)size;
+    return true;
+}
+
+/** @brief Simulated playback start
+ * @param fad Sector address to start at
+ * @param end Sector address to loop at
+ */
+static void Play(uint32_t fad, uint32_t end)
+{
+    drive.PlayFad = fad;
+    drive.TrackEnd = end;
+    drive.PlayTime = drive.Now();
+}
+
+/** @brief Simulated playback stop
+ * @return Sector address playback stopped at
+ */
+static uint32_t Stop()
+{
+    const uint64_t played = ((drive.Now() - drive.PlayTime) * MusicSectorsPerSecond) / 1000000;
+    const uint64_t length = drive.TrackEnd > drive.TrackStart ? drive.TrackEnd - drive.TrackStart : 1;
+    return drive.TrackStart + (uint32_t)(((drive.PlayFad - drive.TrackStart) + played) % length);
+}
+
+/** @brief Simulated drive functions
+ */
+static const Skathi::CdScheduler::Backend backend = { Read : Read, Play : Play, Stop : Stop };
+
+/** @brief Single command of a sequence
+ */
+struct Command
+{
+    /** @brief Command name
+     */
+    std::string Name;
+
+    /** @brief First argument
+     */
+    uint32_t First;
+
+    /** @brief Second argument
+     */
+    uint32_t Second;
+};
+
+/** @brief Load sequence
+ */
+struct Sequence
+{
+    /** @brief Sequence name
+     */
+    std::string Name;
+
+    /** @brief Commands in order
+     */
+    std::vector<Command> Commands;
+};
+
+/** @brief Statistics of a single run
+ */
+struct Result
+{
+    /** @brief Total seek distance in sectors
+     */
+    uint64_t Distance = 0;
+
+    /** @brief Estimated drive time in microseconds
+     */
+    uint64_t Time = 0;
+
+    /** @brief Number of times music was stopped
+     */
+    uint64_t Interruptions = 0;
+
+    /** @brief Longest drive time of a single frame in microseconds
+     */
+    uint64_t Stall = 0;
+
+    /** @brief Sum of frames queued reads waited for their data
+     */
+    uint64_t Latency = 0;
+
+    /** @brief Number of queued reads
+     */
+    uint64_t Reads = 0;
+};
+
+/** @brief Read queued by the scheduled run
+ */
+struct Queued
+{
+    /** @brief Read status updated by the scheduler
+     */
+    Skathi::CdScheduler::Status Status;
+
+    /** @brief Frame the read was issued in
+     */
+    uint64_t Frame;
+
+    /** @brief Read is in the scheduler queue (false while waiting for free slot)
+     */
+    bool InQueue;
+
+    /** @brief Latency of the finished read was recorded
+     */
+    bool Counted;
+
+    /** @brief Sector address
+     */
+    uint32_t Fad;
+
+    /** @brief Number of bytes
+     */
+    uint32_t Size;
+};
+
+/** @brief Largest number of sectors read by a single scheduler update
+ */
+static uint32_t frameSectors = 2;
+
+/** @brief Largest number of prefetch requests served by a single scheduler update
+ */
+static uint8_t framePrefetches = 1;
+
+/** @brief Serve reads in issue order and wait for each of them, every read while music plays stops it and seeks back afterwards
+ * @param sequence Load sequence
+ * @return Statistics
+ */
+static Result RunInOrder(const Sequence & sequence)
+{
+    Result result;
+    uint32_t head = 0;
+    bool playing = false;
+    uint32_t trackStart = 0;
+    uint32_t trackEnd = 0;
+    uint32_t playFad = 0;
+    uint64_t frames = 0;
+    uint64_t playTime = 0;
+
+    auto seek = [&](uint32_t fad)
+    {
+        result.Distance += fad > head ? fad - head : head - fad;
+        result.Time += Skathi::CdScheduler::GetSeekCost(head, fad);
+        head = fad;
+    };
+
+    uint64_t frameStart = 0;
+
+    auto position = [&]()
+    {
+        const uint64_t played = ((((frames * FrameMicroseconds) + result.Time) - playTime) * MusicSectorsPerSecond) / 1000000;
+        const uint64_t length = trackEnd > trackStart ? trackEnd - trackStart : 1;
+        return trackStart + (uint32_t)(((playFad - trackStart) + played) % length);
+    };
+
+    for (const Command & command : sequence.Commands)
+    {
+        if (command.Name == "music")
+        {
+            seek(command.First);
+            playing = true;
+            trackStart = playFad = command.First;
+            trackEnd = command.Second;
+            playTime = (frames * FrameMicroseconds) + result.Time;
+        }
+        else if (command.Name == "stop")
+        {
+            playing = false;
+        }
+        else if (command.Name == "read" || command.Name == "load")
+        {
+            const uint32_t resume = playing ? position() : 0;
+
+            if (playing)
+            {
+                head = resume;
+                result.Interruptions++;
+            }
+
+            seek(command.First);
+            result.Time += ((uint64_t)command.Second * 1000000) / Skathi::CdScheduler::SectorsPerSecond;
+            head += command.Second;
+
+            if (playing)
+            {
+                seek(resume);
+                playFad = resume;
+                playTime = (frames * FrameMicroseconds) + result.Time;
+            }
+        }
+        else if (command.Name == "frame")
+        {
+            result.Stall = std::max(result.Stall, result.Time - frameStart);
+            frameStart = result.Time;
+            frames += command.First;
+        }
+    }
+
+    result.Stall = std::max(result.Stall, result.Time - frameStart);
+    return result;
+}
+
+/** @brief Run sequence through the scheduler the way the game does, data found in the cartridge does not use the drive
+ * @param sequence Load sequence
+ * @return Statistics
+ */
+static Result RunScheduled(const Sequence & sequence)
+{
+    // Both runs start with the head at the start of the disc
+    Skathi::CdScheduler::Initialize(&backend);
+    drive.Frames = 0;
+
+    Result result;
+    std::deque<Queued> reads;
+    uint64_t frameStart = 0;
+
+    // Queue reads the caller could not queue yet (Cd::QueueFileRange returned NULL), then the per-frame update of the game loop
+    auto frame = [&]()
+    {
+        for (Queued & read : reads)
+        {
+            if (!read.InQueue)
+            {
+                const Skathi::CdScheduler::Request request = { Fad : read.Fad, Size : read.Size, Buffer : scratch.data(), Done : &read.Status, Served : 0 };
+                read.InQueue = Skathi::CdScheduler::Queue(&request);
+            }
+        }
+
+        Skathi::CdScheduler::Update(frameSectors, framePrefetches);
+        drive.Frames++;
+
+        // Scheduler holds status pointers, so only the oldest finished reads are removed
+        for (Queued & read : reads)
+        {
+            if (read.InQueue && !read.Counted && read.Status != Skathi::CdScheduler::Status::Queued)
+            {
+                result.Latency += drive.Frames - read.Frame;
+                read.Counted = true;
+            }
+        }
+
+        while (!reads.empty() && reads.front().Counted)
+        {
+            reads.pop_front();
+        }
+
+        result.Stall = std::max(result.Stall, (uint64_t)Skathi::CdScheduler::GetDriveTime() - frameStart);
+        frameStart = Skathi::CdScheduler::GetDriveTime();
+    };
+
+    for (const Command & command : sequence.Commands)
+    {
+        const uint32_t size = command.Second * Skathi::CdScheduler::SectorSize;
+
+        if (command.Name == "music")
+        {
+            drive.TrackStart = command.First;
+            Skathi::CdScheduler::PlayMusic(command.First, command.Second);
+        }
+        else if (command.Name == "stop")
+        {
+            Skathi::CdScheduler::StopMusic();
+        }
+        else if (command.Name == "read" && Skathi::Cache::Find(command.First, size) == NULL)
+        {
+            reads.push_back({ Skathi::CdScheduler::Status::Queued, drive.Frames, false, false, command.First, size });
+            Queued * read = &reads.back();
+            const Skathi::CdScheduler::Request request = { Fad : read->Fad, Size : size, Buffer : scratch.data(), Done : &read->Status, Served : 0 };
+            read->InQueue = Skathi::CdScheduler::Queue(&request);
+            result.Reads++;
+        }
+        else if (command.Name == "read")
+        {
+            // Found in the cartridge, data is ready in the same frame
+            result.Reads++;
+        }
+        else if (command.Name == "load" && Skathi::Cache::Find(command.First, size) == NULL)
+        {
+            Skathi::CdScheduler::Read(command.First, scratch.data(), size);
+        }
+        else if (command.Name == "prefetch" && Skathi::Cache::IsEnabled())
+        {
+            const Skathi::CdScheduler::Request request = { Fad : command.First, Size : size, Buffer : NULL, Done : NULL, Served : 0 };
+            Skathi::CdScheduler::Queue(&request);
+        }
+        else if (command.Name == "frame")
+        {
+            for (uint32_t count = 0; count < command.First; count++)
+            {
+                frame();
+            }
+        }
+    }
+
+    // Queued reads the sequence did not wait for are finished by extra frames
+    while (!reads.empty())
+    {
+        frame();
+    }
+
+    result.Distance = Skathi::CdScheduler::GetSeekDistance();
+    result.Time = Skathi::CdScheduler::GetDriveTime();
+    result.Interruptions = Skathi::CdScheduler::GetInterruptions();
+    return result;
+}
+
+/** @brief Load sequence file
+ * @param path File path
+ * @param sequences Loaded sequences
+ * @return true File was loaded
+ * @return false File is missing or malformed
+ */
+static bool LoadSequences(const std::string & path, std::vector<Sequence> & sequences)
+{
+    std::ifstream stream(path);
+
+    if (!stream)
+    {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    size_t number = 0;
+
+    while (std::getline(stream, line))
+    {
+        number++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        Command command = { "", 0, 0 };
+
+        if (!(words >> command.Name))
+        {
+            continue;
+        }
+
+        if (command.Name == "sequence")
+        {
+            std::string name;
+            words >> name;
+            sequences.push_back({ name, {} });
+            continue;
+        }
+
+        if (sequences.empty())
+        {
+            sequences.push_back({ "default", {} });
+        }
+
+        bool valid = true;
+
+        if (command.Name == "music" || command.Name == "read" || command.Name == "load" || command.Name == "prefetch")
+        {
+            valid = (bool)(words >> command.First >> command.Second) && command.Second > 0;
+        }
+        else if (command.Name == "frame")
+        {
+            command.First = (words >> command.First) ? command.First : 1;
+        }
+        else
+        {
+            valid = command.Name == "stop";
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "%s:%zu: invalid command\n", path.c_str(), number);
+            return false;
+        }
+
+        if (command.Name == "read" || command.Name == "load" || command.Name == "prefetch")
+        {
+            const size_t size = (size_t)command.Second * Skathi::CdScheduler::SectorSize;
+            scratch.resize(size > scratch.size() ? size : scratch.size());
+        }
+
+        sequences.back().Commands.push_back(command);
+    }
+
+    return true;
+}
+
+int main(int argc, char ** argv)
+{
+    size_t cartridge = 0;
+    int argument = 1;
+
+    for (; argument + 1 < argc && argv[argument][0] == '-'; argument += 2)
+    {
+        const std::string option = argv[argument];
+
+        if (option == "-c")
+        {
+            cartridge = (size_t)atoi(argv[argument + 1]) * 1024;
+        }
+        else if (option == "-b" && atoi(argv[argument + 1]) > 0)
+        {
+            frameSectors = (uint32_t)atoi(argv[argument + 1]);
+        }
+        else if (option == "-p")
+        {
+            framePrefetches = (uint8_t)atoi(argv[argument + 1]);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argument + 1 != argc)
+    {
+        fprintf(stderr, "Usage: %s [-c <cartridge size in KB>] [-b <sectors per frame>] [-p <prefetches per frame>] <sequences.txt>\n", argv[0]);
+        fprintf(stderr, "Example: %s -c 1024 sequences.txt\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Sequence> sequences;
+
+    if (!LoadSequences(argv[argument], sequences))
+    {
+        return 1;
+    }
+
+    std::vector<uint8_t> cartridgeMemory(cartridge);
+    Skathi::Cache::Initialize(cartridge > 0 ? cartridgeMemory.data() : NULL, (uint32_t)cartridge);
+
+    printf("%-16s %10s %9s %5s %9s   %10s %9s %5s %9s %8s\n",
+        "sequence", "in order", "ms", "stops", "worst ms", "scheduled", "ms", "stops", "worst ms", "frames");
+
+    for (const Sequence & sequence : sequences)
+    {
+        const Result inOrder = RunInOrder(sequence);
+        const Result scheduled = RunScheduled(sequence);
+
+        printf("%-16s %10llu %9.1f %5llu %9.1f   %10llu %9.1f %5llu %9.1f %8.1f\n",
+            sequence.Name.c_str(),
+            (unsigned long long)inOrder.Distance,
+            inOrder.Time / 1000.0,
+            (unsigned long long)inOrder.Interruptions,
+            inOrder.Stall / 1000.0,
+            (unsigned long long)scheduled.Distance,
+            scheduled.Time / 1000.0,
+            (unsigned long long)scheduled.Interruptions,
+            scheduled.Stall / 1000.0,
+            scheduled.Reads > 0 ? (double)scheduled.Latency / scheduled.Reads : 0.0);
+    }
+
+    printf("Worst ms is the longest drive time of a single frame, frames is the average wait of a queued read for its data\n");
+
+    if (Skathi::Cache::IsEnabled())
+    {
+        printf("Cartridge: %u hits, %u misses, %u bytes used\n", Skathi::Cache::GetHits(), Skathi::Cache::GetMisses(), Skathi::Cache::GetUsed());
+    }
+
+    return 0;
+}
@@ -0,0 +1,499 @@
+/** @brief Runs Skathi::Dsp::TransformProgram on simulated SCU DSP and compares results with the CPU path bit by bit
+ * @details Build: g++ -std=c++17 -O2 -o DspSimulator DspSimulator.cpp
+ * Usage: DspSimulator [number of points]
+ *
+ * Points are transformed in batches the same way Skathi::Dsp::Transform does it, by random matrices with values up to 2.0
+ * and points with coordinates up to 4096.0. CPU path is fix16 dot product with 64 bit accumulation (as done by MAC.L) plus translation.
+ * Simulator executes operation, loop bottom and end commands one instruction per cycle, DMA, jumps and flags are not simulated.
+ * Report shows mismatches, DSP cycles per point and time per point at DSP clock, and host time of both paths.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "../../Dependencies/Skathi/Dsp/TransformProgram.hpp"
+
+/** @brief DSP clock in Hz
+ */
+static constexpr double DspClock = 14318180.0;
+
+/** @brief Simulated SCU DSP
+ */
+class Simulator
+{
+private:
+    /** @brief Program RAM
+     */
+    uint32_t program[256] = { };
+
+    /** @brief Data RAM banks
+     */
+    uint32_t data[4][64] = { };
+
+    /** @brief Data RAM counters (6 bit)
+     */
+    uint8_t counters[4] = { };
+
+    /** @brief Multiplier inputs
+     */
+    int32_t rx = 0;
+    int32_t ry = 0;
+
+    /** @brief 48 bit registers kept sign extended
+     */
+    int64_t mul = 0;
+    int64_t p = 0;
+    int64_t a = 0;
+    int64_t alu = 0;
+
+    /** @brief Loop counter (12 bit) and loop top
+     */
+    uint16_t lop = 0;
+    uint8_t top = 0;
+
+    /** @brief Counters that have to be incremented after the current instruction
+     */
+    bool increment[4] = { };
+
+    /** @brief Sign extend 48 bit value
+     * @param value Value
+     * @return Sign extended value
+     */
+    static int64_t Extend48(int64_t value)
+    {
+        return (int64_t)((uint64_t)value << 16) >> 16;
+    }
+
+    /** @brief Replace low 32 bits of accumulator
+     * @param low New low bits
+     * @return 48 bit value
+     */
+    int64_t WithLow(uint32_t low) const
+    {
+        return Simulator::Extend48((this->a & ~(int64_t)0xffffffff) | low);
+    }
+
+    /** @brief Read bus source
+     * @param source Source code
+     * @return Value
+     */
+    uint32_t ReadSource(uint32_t source)
+    {
+        if (source < 8)
+        {
+            const uint8_t bank = source & 3;
+
+            if (source >= 4)
+            {
+                this->increment[bank] = true;
+            }
+
+            return this->data[bank][this->counters[bank]];
+        }
+
+        if (source == Skathi::Dsp::Instruction::All)
+        {
+            return (uint32_t)this->alu;
+        }
+
+        if (source == Skathi::Dsp::Instruction::Alh)
+        {
+            return (uint32_t)(this->alu >> 16);
+        }
+
+        fprintf(stderr, "Unsupported source %u\n", source);
+        exit(1);
+    }
+
+    /** @brief Write D1-bus destination
+     * @param destination Destination code
+     * @param value Value
+     * @param counterWritten Counters written by this instruction
+     */
+    void WriteDestination(uint32_t destination, uint32_t value, bool * counterWritten)
+    {
+        switch (destination)
+        {
+        case Skathi::Dsp::Instruction::ToMC0:
+        case Skathi::Dsp::Instruction::ToMC1:
+        case Skathi::Dsp::Instruction::ToMC2:
+        case Skathi::Dsp::Instruction::ToMC3:
+            this->data[destination][this->counters[destination]] = value;
+            this->increment[destination] = true;
+            break;
+
+        case Skathi::Dsp::Instruction::ToRX:
+            this->rx = (int32_t)value;
+            break;
+
+        case Skathi::Dsp::Instruction::ToPL:
+            this->p = (int32_t)value;
+            break;
+
+        case Skathi::Dsp::Instruction::ToLOP:
+            this->lop = value & 0xfff;
+            break;
+
+        case Skathi::Dsp::Instruction::ToTOP:
+            this->top = value & 0xff;
+            break;
+
+        case Skathi::Dsp::Instruction::ToCT0:
+        case Skathi::Dsp::Instruction::ToCT1:
+        case Skathi::Dsp::Instruction::ToCT2:
+        case Skathi::Dsp::Instruction::ToCT3:
+            this->counters[destination & 3] = value & 0x3f;
+            counterWritten[destination & 3] = true;
+            break;
+
+        default:
+            fprintf(stderr, "Unsupported destination %u\n", destination);
+            exit(1);
+        }
+    }
+
+    /** @brief Compute ALU result from accumulator and P as they were before the instruction
+     * @param operation ALU operation
+     */
+    void ExecuteAlu(uint32_t operation)
+    {
+        const uint32_t low = (uint32_t)this->a;
+
+        switch (operation)
+        {
+        case Skathi::Dsp::Instruction::Nop: break;
+        case Skathi::Dsp::Instruction::And: this->alu = this->WithLow(low & (uint32_t)this->p); break;
+        case Skathi::Dsp::Instruction::Or: this->alu = this->WithLow(low | (uint32_t)this->p); break;
+        case Skathi::Dsp::Instruction::Xor: this->alu = this->WithLow(low ^ (uint32_t)this->p); break;
+        case Skathi::Dsp::Instruction::Add: this->alu = this->WithLow(low + (uint32_t)this->p); break;
+        case Skathi::Dsp::Instruction::Sub: this->alu = this->WithLow(low - (uint32_t)this->p); break;
+        case Skathi::Dsp::Instruction::Ad2: this->alu = Simulator::Extend48(this->a + this->p); break;
+        case Skathi::Dsp::Instruction::Sr: this->alu = this->WithLow((uint32_t)((int32_t)low >> 1)); break;
+        case Skathi::Dsp::Instruction::Rr: this->alu = this->WithLow((low >> 1) | (low << 31)); break;
+        case Skathi::Dsp::Instruction::Sl: this->alu = this->WithLow(low << 1); break;
+        case Skathi::Dsp::Instruction::Rl: this->alu = this->WithLow((low << 1) | (low >> 31)); break;
+        case Skathi::Dsp::Instruction::Rl8: this->alu = this->WithLow((low << 8) | (low >> 24)); break;
+        default:
+            fprintf(stderr, "Unsupported ALU operation %u\n", operation);
+            exit(1);
+        }
+    }
+
+    /** @brief Execute operation command
+     * @param instruction Instruction
+     */
+    void ExecuteOperation(uint32_t instruction)
+    {
+        bool counterWritten[4] = { };
+        const int64_t product = this->mul;
+        this->ExecuteAlu((instruction >> 26) & 0xf);
+
+        // X-bus, source is read once even when both RX and P use it
+        const uint32_t xSource = (instruction >> 20) & 7;
+        const uint32_t xOperation = (instruction >> 23) & 3;
+        const bool xRead = (instruction & (1 << 25)) != 0 || xOperation == 3;
+        const uint32_t xValue = xRead ? this->ReadSource(xSource) : 0;
+
+        if ((instruction & (1 << 25)) != 0)
+        {
+            this->rx = (int32_t)xValue;
+        }
+
+        if (xOperation == 2)
+        {
+            this->p = product;
+        }
+        else if (xOperation == 3)
+        {
+            this->p = (int32_t)xValue;
+        }
+
+        // Y-bus
+        const uint32_t ySource = (instruction >> 14) & 7;
+        const uint32_t yOperation = (instruction >> 17) & 3;
+        const bool yRead = (instruction & (1 << 19)) != 0 || yOperation == 3;
+        const uint32_t yValue = yRead ? this->ReadSource(ySource) : 0;
+
+        if ((instruction & (1 << 19)) != 0)
+        {
+            this->ry = (int32_t)yValue;
+        }
+
+        if (yOperation == 1)
+        {
+            this->a = 0;
+        }
+        else if (yOperation == 2)
+        {
+            this->a = this->alu;
+        }
+        else if (yOperation == 3)
+        {
+            this->a = (int32_t)yValue;
+        }
+
+        // D1-bus
+        const uint32_t d1Operation = (instruction >> 12) & 3;
+        const uint32_t destination = (instruction >> 8) & 0xf;
+
+        if (d1Operation == 1)
+        {
+            this->WriteDestination(destination, (uint32_t)(int32_t)(int8_t)(instruction & 0xff), counterWritten);
+        }
+        else if (d1Operation == 3)
+        {
+            this->WriteDestination(destination, this->ReadSource(instruction & 0xf), counterWritten);
+        }
+
+        for (uint8_t bank = 0; bank < 4; bank++)
+        {
+            if (this->increment[bank] && !counterWritten[bank])
+            {
+                this->counters[bank] = (this->counters[bank] + 1) & 0x3f;
+            }
+
+            this->increment[bank] = false;
+        }
+
+        // Product of registers written by this instruction is available to the next one
+        this->mul = Simulator::Extend48((int64_t)this->rx * this->ry);
+    }
+
+public:
+    /** @brief Load program
+     * @param words Program words
+     * @param count Number of words
+     */
+    void Load(const uint32_t * words, size_t count)
+    {
+        std::copy(words, words + count, this->program);
+    }
+
+    /** @brief Write data RAM
+     * @param bank Bank index
+     * @param offset First word
+     * @param words Data
+     * @param count Number of words
+     */
+    void Write(uint8_t bank, uint8_t offset, const uint32_t * words, size_t count)
+    {
+        std::copy(words, words + count, &this->data[bank][offset]);
+    }
+
+    /** @brief Read data RAM
+     * @param bank Bank index
+     * @param offset First word
+     * @param words Data
+     * @param count Number of words
+     */
+    void Read(uint8_t bank, uint8_t offset, uint32_t * words, size_t count) const
+    {
+        std::copy(&this->data[bank][offset], &this->data[bank][offset] + count, words);
+    }
+
+    /** @brief Run program from address 0 until END
+     * @return Number of executed instructions
+     */
+    uint64_t Run()
+    {
+        uint32_t pc = 0;
+        int32_t jump = -1;
+        uint64_t cycles = 0;
+
+        while (true)
+        {
+            const uint32_t instruction = this->program[pc & 0xff];
+            const int32_t pending = jump;
+            jump = -1;
+            cycles++;
+
+            switch (instruction >> 28)
+            {
+            case 0x0:
+            case 0x1:
+            case 0x2:
+            case 0x3:
+                this->ExecuteOperation(instruction);
+                break;
+
+            case 0xe:
+                if ((instruction & (1 << 27)) != 0)
+                {
+                    fprintf(stderr, "LPS is not supported\n");
+                    exit(1);
+                }
+
+                if (this->lop != 0)
+                {
+                    jump = this->top;
+                }
+
+                this->lop = (this->lop - 1) & 0xfff;
+                break;
+
+            case 0xf:
+                return cycles;
+
+            default:
+                fprintf(stderr, "Unsupported instruction %08x at %u\n", instruction, pc);
+                exit(1);
+            }
+
+            // Jump happens after the delay slot
+            pc = pending >= 0 ? (uint32_t)pending : pc + 1;
+        }
+    }
+};
+
+/** @brief Point
+ */
+struct Point
+{
+    int32_t X;
+    int32_t Y;
+    int32_t Z;
+};
+
+/** @brief Transform point the way the CPU does it (MAC.L accumulation, middle 32 bits of the sum)
+ * @param matrix Matrix rows
+ * @param point Point
+ * @return Transformed point
+ */
+static Point TransformCpu(const int32_t * matrix, const Point & point)
+{
+    int32_t result[3];
+
+    for (int row = 0; row < 3; row++)
+    {
+        const int64_t sum = ((int64_t)matrix[row * 4] * point.X) + ((int64_t)matrix[(row * 4) + 1] * point.Y) + ((int64_t)matrix[(row * 4) + 2] * point.Z);
+        result[row] = (int32_t)(uint32_t)((uint64_t)(sum >> 16)) + matrix[(row * 4) + 3];
+    }
+
+    return { result[0], result[1], result[2] };
+}
+
+/** @brief Transform points on the simulated DSP in batches
+ * @param dsp Simulator with loaded program
+ * @param matrix Matrix rows
+ * @param points Points
+ * @param results Transformed points
+ * @param cycles Executed DSP instructions
+ */
+static void TransformDsp(Simulator & dsp, const int32_t * matrix, const std::vector<Point> & points, std::vector<Point> & results, uint64_t & cycles)
+{
+    constexpr size_t BatchSize = Skathi::Dsp::TransformProgram::BatchSize;
+    dsp.Write(Skathi::Dsp::TransformProgram::MatrixBank, 0, (const uint32_t*)matrix, 12);
+
+    for (size_t first = 0; first < points.size(); first += BatchSize)
+    {
+        const size_t batch = points.size() - first < BatchSize ? points.size() - first : BatchSize;
+        uint32_t input[BatchSize * Skathi::Dsp::TransformProgram::InputStride];
+        uint32_t output[BatchSize * 3];
+
+        for (size_t point = 0; point < batch; point++)
+        {
+            input[(point * 4) + 0] = (uint32_t)points[first + point].X;
+            input[(point * 4) + 1] = (uint32_t)points[first + point].Y;
+            input[(point * 4) + 2] = (uint32_t)points[first + point].Z;
+            input[(point * 4) + 3] = 0x10000;
+        }
+
+        const uint32_t last = (uint32_t)batch - 1;
+        dsp.Write(Skathi::Dsp::TransformProgram::InputBank, 0, input, batch * Skathi::Dsp::TransformProgram::InputStride);
+        dsp.Write(Skathi::Dsp::TransformProgram::CountBank, 0, &last, 1);
+        cycles += dsp.Run();
+        dsp.Read(Skathi::Dsp::TransformProgram::OutputBank, 0, output, batch * 3);
+
+        for (size_t point = 0; point < batch; point++)
+        {
+            results[first + point] = { (int32_t)output[point], (int32_t)output[batch + point], (int32_t)output[(batch * 2) + point] };
+        }
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const size_t count = argc > 1 ? (size_t)atol(argv[1]) : 10000;
+
+    if (count == 0)
+    {
+        fprintf(stderr, "Usage: %s [number of points]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t program[Skathi::Dsp::TransformProgram::MaxSize];
+    const uint8_t size = Skathi::Dsp::TransformProgram::Build(program);
+    Simulator dsp;
+    dsp.Load(program, size);
+
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int32_t> matrixValue(-0x20000, 0x20000);
+    std::uniform_int_distribution<int32_t> coordinate(-0x10000000, 0x10000000);
+    std::uniform_int_distribution<int32_t> translation(-0x10000000, 0x10000000);
+
+    size_t mismatches = 0;
+    uint64_t cycles = 0;
+    double cpuSeconds = 0.0;
+    double dspSeconds = 0.0;
+
+    // Every batch size is covered, including partial last batch
+    for (size_t run = 0; run < 8; run++)
+    {
+        int32_t matrix[12];
+
+        for (int value = 0; value < 12; value++)
+        {
+            matrix[value] = (value & 3) == 3 ? translation(random) : matrixValue(random);
+        }
+
+        const size_t points = run == 0 ? count : 1 + (run * 3);
+        std::vector<Point> input(points);
+        std::vector<Point> cpu(points);
+        std::vector<Point> simulated(points);
+
+        for (Point & point : input)
+        {
+            point = { coordinate(random), coordinate(random), coordinate(random) };
+        }
+
+        const auto cpuStart = std::chrono::steady_clock::now();
+
+        for (size_t point = 0; point < points; point++)
+        {
+            cpu[point] = TransformCpu(matrix, input[point]);
+        }
+
+        const auto dspStart = std::chrono::steady_clock::now();
+        uint64_t runCycles = 0;
+        TransformDsp(dsp, matrix, input, simulated, runCycles);
+        const auto end = std::chrono::steady_clock::now();
+
+        for (size_t point = 0; point < points; point++)
+        {
+            if (cpu[point].X != simulated[point].X || cpu[point].Y != simulated[point].Y || cpu[point].Z != simulated[point].Z)
+            {
+                if (mismatches++ < 8)
+                {
+                    fprintf(stderr, "Point %zu of run %zu: CPU %08x %08x %08x, DSP %08x %08x %08x\n", point, run,
+                        cpu[point].X, cpu[point].Y, cpu[point].Z, simulated[point].X, simulated[point].Y, simulated[point].Z);
+                }
+            }
+        }
+
+        if (run == 0)
+        {
+            cycles = runCycles;
+            cpuSeconds = std::chrono::duration<double>(dspStart - cpuStart).count();
+            dspSeconds = std::chrono::duration<double>(end - dspStart).count();
+        }
+    }
+
+    printf("Program: %u words\n", size);
+    printf("Points: %zu, mismatches: %zu\n", count, mismatches);
+    printf("DSP: %.2f cycles per point, %.2f us per point at %.2f MHz\n", (double)cycles / count, (cycles * 1000000.0 / DspClock) / count, DspClock / 1000000.0);
+    printf("Host: CPU path %.1f ns per point, simulator %.1f ns per point\n", cpuSeconds * 1e9 / count, dspSeconds * 1e9 / count);
+    return mismatches == 0 ? 0 : 1;
+}
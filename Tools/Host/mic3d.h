@@ -0,0 +1,26 @@
+/** @brief Host replacement of the parts of mic3d used by game headers tools test and benchmark
+ * @details Cameras only keep their values, camera_lookat does not compute a view matrix. Textures only keep their address and size.
+ */
+#pragma once
+
+#include <yaul.h>
+
+typedef struct camera
+{
+    fix16_vec3_t position;
+    fix16_vec3_t target;
+    fix16_vec3_t up;
+} camera_t;
+
+static inline void camera_lookat(const camera_t * camera __unused)
+{
+}
+
+typedef struct texture
+{
+    uint16_t vram_index;
+    uint16_t size;
+} texture_t;
+
+#define TEXTURE_SIZE(w, h) ((uint16_t)((((w) >> 3) << 8) | ((h) & 255)))
+#define TEXTURE_VRAM_INDEX(address) ((uint16_t)((uintptr_t)(address) >> 3))
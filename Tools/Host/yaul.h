@@ -0,0 +1,196 @@
+/** @brief Host replacement of the parts of yaul used by game headers tools test and benchmark
+ * @details Tools including game headers are built with -I../Host, so #include <yaul.h> picks this file instead of the real library.
+ * Fixed point math gives the same results as yaul, hardware functions do nothing.
+ * Times measured on the host compare algorithms with each other, they are not Saturn times.
+ */
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define __unused __attribute__((unused))
+#define __aligned(x) __attribute__((aligned(x)))
+#define __packed __attribute__((packed))
+
+/* Fixed point math */
+
+typedef int32_t fix16_t;
+
+#define FIX16(x) ((fix16_t)((x) * 65536.0f))
+#define FIX16_ONE ((fix16_t)0x00010000)
+#define FIX16_ZERO ((fix16_t)0x00000000)
+
+typedef struct fix16_vec2
+{
+    fix16_t x;
+    fix16_t y;
+} fix16_vec2_t;
+
+typedef struct fix16_vec3
+{
+    fix16_t x;
+    fix16_t y;
+    fix16_t z;
+} fix16_vec3_t;
+
+static inline fix16_t fix16_mul(fix16_t a, fix16_t b)
+{
+    return (fix16_t)(((int64_t)a * b) >> 16);
+}
+
+static inline fix16_t fix16_div(fix16_t dividend, fix16_t divisor)
+{
+    return (fix16_t)(((int64_t)dividend * 65536) / divisor);
+}
+
+static inline int32_t fix16_int32_to(fix16_t value)
+{
+    return value >> 16;
+}
+
+static inline fix16_t fix16_int32_from(int32_t value)
+{
+    return value << 16;
+}
+
+typedef union fix16_mat43
+{
+    fix16_t arr[12];
+    fix16_t frow[3][4];
+} fix16_mat43_t;
+
+static inline void fix16_mat43_identity(fix16_mat43_t * matrix)
+{
+    memset(matrix, 0, sizeof(fix16_mat43_t));
+    matrix->frow[0][0] = FIX16_ONE;
+    matrix->frow[1][1] = FIX16_ONE;
+    matrix->frow[2][2] = FIX16_ONE;
+}
+
+static inline void fix16_mat43_mul(const fix16_mat43_t * a, const fix16_mat43_t * b, fix16_mat43_t * result)
+{
+    fix16_mat43_t product;
+
+    for (int row = 0; row < 3; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            int64_t sum = 0;
+
+            for (int index = 0; index < 3; index++)
+            {
+                sum += (int64_t)a->frow[row][index] * b->frow[index][column];
+            }
+
+            product.frow[row][column] = (fix16_t)(sum >> 16) + (column == 3 ? a->frow[row][3] : 0);
+        }
+    }
+
+    *result = product;
+}
+
+/* Vectors */
+
+typedef struct int16_vec2
+{
+    int16_t x;
+    int16_t y;
+} int16_vec2_t;
+
+/* Colors */
+
+#define RGB1555(msb, r, g, b) ((uint16_t)((((msb) & 0x01) << 15) | (((b) & 0x1f) << 10) | (((g) & 0x1f) << 5) | ((r) & 0x1f)))
+
+/* VDP1 command tables */
+
+typedef struct vdp1_cmdt
+{
+    uint16_t cmd_ctrl;
+    uint16_t cmd_link;
+    uint16_t cmd_pmod;
+    uint16_t cmd_colr;
+    uint16_t cmd_srca;
+    uint16_t cmd_size;
+    int16_t cmd_xa;
+    int16_t cmd_ya;
+    int16_t cmd_xb;
+    int16_t cmd_yb;
+    int16_t cmd_xc;
+    int16_t cmd_yc;
+    int16_t cmd_xd;
+    int16_t cmd_yd;
+    uint16_t cmd_grda;
+    uint16_t reserved;
+} __aligned(32) vdp1_cmdt_t;
+
+#define VDP1_CMDT_LINK_TYPE_JUMP_NEXT (0x0000)
+#define VDP1_CMDT_LINK_TYPE_JUMP_ASSIGN (0x1000)
+
+static inline void vdp1_cmdt_link_type_set(vdp1_cmdt_t * cmdt, uint16_t link_type)
+{
+    cmdt->cmd_ctrl = (cmdt->cmd_ctrl & ~0x7000) | link_type;
+}
+
+static inline void vdp1_cmdt_link_set(vdp1_cmdt_t * cmdt, uint16_t index)
+{
+    cmdt->cmd_link = index << 2;
+}
+
+static inline void vdp1_cmdt_user_clip_coord_set(vdp1_cmdt_t * cmdt)
+{
+    cmdt->cmd_ctrl = (cmdt->cmd_ctrl & 0x7000) | 0x0008;
+}
+
+static inline void vdp1_cmdt_local_coord_set(vdp1_cmdt_t * cmdt)
+{
+    cmdt->cmd_ctrl = (cmdt->cmd_ctrl & 0x7000) | 0x000a;
+}
+
+#define VDP1_CMDT_CM_CB_16 (0)
+#define VDP1_CMDT_CM_CLUT_16 (1)
+#define VDP1_CMDT_CM_CB_64 (2)
+#define VDP1_CMDT_CM_CB_256 (4)
+#define VDP1_CMDT_CM_RGB_32768 (5)
+
+/* Video memory and DMA, nothing is transferred */
+
+typedef uintptr_t vdp1_vram_t;
+
+#define VDP2_CRAM_ADDR(x) ((uintptr_t)0x25f00000 + ((x) << 1))
+
+static inline void scu_dma_transfer(int channel __unused, void * destination __unused, const void * source __unused, size_t length __unused)
+{
+}
+
+static inline void scu_dma_transfer_wait(int channel __unused)
+{
+}
+
+/* Slave CPU, jobs run right away on the calling thread */
+
+#define CPU_CACHE_THROUGH (0)
+#define CPU_DUAL_ENTRY_ICI (0)
+
+static void (*host_slave_entry)(void) = NULL;
+
+static inline void cpu_cache_purge(void)
+{
+}
+
+static inline void cpu_dual_comm_mode_set(int mode __unused)
+{
+}
+
+static inline void cpu_dual_slave_set(void (*entry)(void))
+{
+    host_slave_entry = entry;
+}
+
+static inline void cpu_dual_slave_notify(void)
+{
+    host_slave_entry();
+}
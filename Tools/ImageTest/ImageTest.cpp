@@ -0,0 +1,554 @@
+/** @brief Tests Skathi::Bitmap::Image pixel kernels against per-pixel reference loops and measures their speed in megapixels per second
+ * @details Build: g++ -std=c++20 -O2 -I../Host -o ImageTest ImageTest.cpp
+ * Usage: ImageTest [number of random operations]
+ *
+ * Each random operation runs FillRect, Blit or BlitKeyed on indexed or RGB images of odd sizes with rectangles partly or
+ * fully outside of either image, so rows start and end at every alignment and clipping is exercised on all edges. The same
+ * operation is applied by a plain per-pixel loop to a copy of the image data and both results have to match byte for byte.
+ * ConvertToRGB and ConvertToIndexed are checked against a palette lookup and a nearest color search of every pixel.
+ * Speed of every kernel is then compared to its reference loop on a 320x224 screen. Exits with non-zero code when any check fails.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <yaul.h>
+#include "../../Dependencies/Skathi/Bitmap/Image.hpp"
+
+/** @brief Number of failed checks
+ */
+static uint32_t failures = 0;
+
+/** @brief Number of passed checks
+ */
+static uint32_t passes = 0;
+
+/** @brief Record check result
+ * @param condition Checked condition
+ * @param name Check description
+ */
+static void Check(bool condition, const char * name)
+{
+    if (condition)
+    {
+        passes++;
+        return;
+    }
+
+    failures++;
+    fprintf(stderr, "FAILED: %s\n", name);
+}
+
+/** @brief Milliseconds elapsed since a time point
+ * @param start Start time
+ * @return Elapsed time
+ */
+static double Elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** @brief Image with its size kept for the reference loops
+ */
+struct TestImage
+{
+    /** @brief Tested image
+     */
+    Skathi::Bitmap::Image * Image;
+
+    /** @brief Image width
+     */
+    int32_t Width;
+
+    /** @brief Image height
+     */
+    int32_t Height;
+
+    /** @brief Number of bytes per pixel
+     */
+    uint8_t PixelSize;
+};
+
+/** @brief Create image filled with random pixels drawn from a small set of values, so keyed copies meet the key often
+ * @param random Random generator
+ * @param width Image width
+ * @param height Image height
+ * @param format Image format
+ * @return Created image
+ */
+static TestImage Create(std::mt19937 & random, int32_t width, int32_t height, Skathi::Bitmap::ImageFormat format)
+{
+    TestImage result = { new Skathi::Bitmap::Image(width, height, format), width, height, (uint8_t)(format == Skathi::Bitmap::ImageFormat::Indexed ? 1 : 2) };
+    uint8_t * data = result.Image->GetImageData();
+
+    for (int32_t pixel = 0; pixel < width * height; pixel++)
+    {
+        const uint16_t value = (uint16_t)(random() % 8) * 0x1111;
+
+        if (result.PixelSize == 1)
+        {
+            data[pixel] = (uint8_t)value;
+        }
+        else
+        {
+            ((uint16_t*)data)[pixel] = value;
+        }
+    }
+
+    return result;
+}
+
+/** @brief Read pixel from raw image data
+ * @param data Image data
+ * @param image Image layout
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @return Pixel value
+ */
+static uint16_t Load(const uint8_t * data, const TestImage & image, int32_t x, int32_t y)
+{
+    const int32_t pixel = (y * image.Width) + x;
+    return image.PixelSize == 1 ? data[pixel] : ((const uint16_t*)data)[pixel];
+}
+
+/** @brief Write pixel to raw image data
+ * @param data Image data
+ * @param image Image layout
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @param value Pixel value
+ */
+static void Store(uint8_t * data, const TestImage & image, int32_t x, int32_t y, uint16_t value)
+{
+    const int32_t pixel = (y * image.Width) + x;
+
+    if (image.PixelSize == 1)
+    {
+        data[pixel] = (uint8_t)value;
+    }
+    else
+    {
+        ((uint16_t*)data)[pixel] = value;
+    }
+}
+
+/** @brief Check pixel is inside of the image
+ * @param image Image layout
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @return true Pixel is inside
+ * @return false Pixel is outside
+ */
+static bool Inside(const TestImage & image, int32_t x, int32_t y)
+{
+    return x >= 0 && y >= 0 && x < image.Width && y < image.Height;
+}
+
+/** @brief Reference fill, every pixel of the rectangle inside of the image is set
+ * @param data Image data
+ * @param image Image layout
+ * @param x Left edge
+ * @param y Top edge
+ * @param width Rectangle width
+ * @param height Rectangle height
+ * @param value Pixel value
+ */
+static void ReferenceFill(uint8_t * data, const TestImage & image, int32_t x, int32_t y, int32_t width, int32_t height, uint16_t value)
+{
+    for (int32_t row = y; row < y + height; row++)
+    {
+        for (int32_t column = x; column < x + width; column++)
+        {
+            if (Inside(image, column, row))
+            {
+                Store(data, image, column, row, image.PixelSize == 1 ? value & 0xff : value);
+            }
+        }
+    }
+}
+
+/** @brief Reference copy, pixel is copied when both its source and target are inside of their images
+ * @param data Target image data
+ * @param image Target image layout
+ * @param source Source image
+ * @param sourceX Left edge in source image
+ * @param sourceY Top edge in source image
+ * @param width Rectangle width
+ * @param height Rectangle height
+ * @param x Left edge in target image
+ * @param y Top edge in target image
+ * @param keyed Skip pixels equal to the key
+ * @param key Skipped pixel value
+ */
+static void ReferenceBlit(uint8_t * data, const TestImage & image, const TestImage & source, int32_t sourceX, int32_t sourceY, int32_t width, int32_t height, int32_t x, int32_t y, bool keyed, uint16_t key)
+{
+    const uint8_t * from = source.Image->GetImageData();
+
+    for (int32_t row = 0; row < height; row++)
+    {
+        for (int32_t column = 0; column < width; column++)
+        {
+            if (!Inside(source, sourceX + column, sourceY + row) || !Inside(image, x + column, y + row))
+            {
+                continue;
+            }
+
+            const uint16_t value = Load(from, source, sourceX + column, sourceY + row);
+
+            if (!keyed || value != key)
+            {
+                Store(data, image, x + column, y + row, value);
+            }
+        }
+    }
+}
+
+/** @brief Reference nearest color search over the whole palette except the transparent color 0
+ * @param palette Palette
+ * @param size Number of palette entries
+ * @param color Searched color
+ * @return Palette index
+ */
+static uint8_t ReferenceFind(const Skathi::Bitmap::Color_t * palette, uint16_t size, Skathi::Bitmap::Color_t color)
+{
+    if (color.Components.Alpha == 0)
+    {
+        return 0;
+    }
+
+    uint8_t nearest = 1;
+    int32_t nearestDistance = INT32_MAX;
+
+    for (uint16_t index = 1; index < size; index++)
+    {
+        const int32_t r = (int32_t)palette[index].Components.R - color.Components.R;
+        const int32_t g = (int32_t)palette[index].Components.G - color.Components.G;
+        const int32_t b = (int32_t)palette[index].Components.B - color.Components.B;
+        const int32_t distance = (r * r) + (g * g) + (b * b);
+
+        if (distance < nearestDistance)
+        {
+            nearest = (uint8_t)index;
+            nearestDistance = distance;
+        }
+    }
+
+    return nearest;
+}
+
+/** @brief Fill palette with random opaque colors
+ * @param random Random generator
+ * @param image Indexed image
+ */
+static void RandomPalette(std::mt19937 & random, Skathi::Bitmap::Image * image)
+{
+    Skathi::Bitmap::Color_t * palette = image->GetPalette();
+
+    for (uint16_t index = 0; index < 256; index++)
+    {
+        palette[index] = (uint16_t)(0x8000 | (random() & 0x7fff));
+    }
+}
+
+/** @brief Random rectangle coordinate around an image edge
+ * @param random Random generator
+ * @param size Image size along the axis
+ * @return Coordinate from a little before the image start to a little after its end
+ */
+static int32_t RandomEdge(std::mt19937 & random, int32_t size)
+{
+    return (int32_t)(random() % (size + 16)) - 8;
+}
+
+/** @brief Random fills, copies and keyed copies against the reference loops
+ * @param operations Number of operations
+ */
+static void TestRandom(uint32_t operations)
+{
+    std::mt19937 random(1);
+    uint32_t mismatches[3] = { 0, 0, 0 };
+
+    for (uint32_t operation = 0; operation < operations; operation++)
+    {
+        const Skathi::Bitmap::ImageFormat format = random() % 2 == 0 ? Skathi::Bitmap::ImageFormat::Indexed : Skathi::Bitmap::ImageFormat::RGB;
+        TestImage target = Create(random, 1 + (random() % 67), 1 + (random() % 23), format);
+        TestImage source = Create(random, 1 + (random() % 67), 1 + (random() % 23), format);
+        const uint32_t bytes = target.Width * target.Height * target.PixelSize;
+        std::vector<uint8_t> expected(target.Image->GetImageData(), target.Image->GetImageData() + bytes);
+
+        const uint32_t kind = random() % 3;
+        const int32_t width = (int32_t)(random() % 80) - 4;
+        const int32_t height = (int32_t)(random() % 30) - 4;
+        const int32_t x = RandomEdge(random, target.Width);
+        const int32_t y = RandomEdge(random, target.Height);
+        const int32_t sourceX = RandomEdge(random, source.Width);
+        const int32_t sourceY = RandomEdge(random, source.Height);
+        const uint16_t value = (uint16_t)(random() % 8) * 0x1111;
+
+        if (kind == 0)
+        {
+            target.Image->FillRect(x, y, width, height, value);
+            ReferenceFill(expected.data(), target, x, y, width, height, value);
+        }
+        else if (kind == 1)
+        {
+            target.Image->Blit(source.Image, sourceX, sourceY, width, height, x, y);
+            ReferenceBlit(expected.data(), target, source, sourceX, sourceY, width, height, x, y, false, 0);
+        }
+        else
+        {
+            target.Image->BlitKeyed(source.Image, sourceX, sourceY, width, height, x, y, value);
+            ReferenceBlit(expected.data(), target, source, sourceX, sourceY, width, height, x, y, true, value);
+        }
+
+        mismatches[kind] += memcmp(target.Image->GetImageData(), expected.data(), bytes) != 0 ? 1 : 0;
+        delete target.Image;
+        delete source.Image;
+    }
+
+    Check(mismatches[0] == 0, "random: FillRect matches reference");
+    Check(mismatches[1] == 0, "random: Blit matches reference");
+    Check(mismatches[2] == 0, "random: BlitKeyed matches reference");
+    printf("Random: %u operations, %u fill, %u copy and %u keyed copy mismatches\n", operations, mismatches[0], mismatches[1], mismatches[2]);
+}
+
+/** @brief Conversions of odd sized images against palette lookup and nearest color search
+ */
+static void TestConversions()
+{
+    std::mt19937 random(2);
+    uint32_t rgbMismatches = 0;
+    uint32_t indexedMismatches = 0;
+
+    for (uint32_t test = 0; test < 200; test++)
+    {
+        const int32_t width = 1 + (random() % 67);
+        const int32_t height = 1 + (random() % 23);
+        TestImage indexed = Create(random, width, height, Skathi::Bitmap::ImageFormat::Indexed);
+        TestImage rgb = Create(random, width, height, Skathi::Bitmap::ImageFormat::RGB);
+        RandomPalette(random, indexed.Image);
+
+        uint8_t * indices = indexed.Image->GetImageData();
+
+        for (int32_t pixel = 0; pixel < width * height; pixel++)
+        {
+            indices[pixel] = (uint8_t)random();
+        }
+
+        const Skathi::Bitmap::Color_t * palette = indexed.Image->GetPalette();
+        indexed.Image->ConvertToRGB(rgb.Image);
+        const uint16_t * colors = (const uint16_t*)rgb.Image->GetImageData();
+
+        for (int32_t pixel = 0; pixel < width * height; pixel++)
+        {
+            rgbMismatches += colors[pixel] != palette[indices[pixel]].Data ? 1 : 0;
+        }
+
+        // Runs of the same color, exact palette colors, transparent pixels and colors not in the palette
+        uint16_t * pixels = (uint16_t*)rgb.Image->GetImageData();
+
+        for (int32_t pixel = 0; pixel < width * height; pixel++)
+        {
+            const uint32_t choice = random() % 4;
+
+            if (pixel > 0 && choice == 0)
+            {
+                pixels[pixel] = pixels[pixel - 1];
+            }
+            else if (choice == 1)
+            {
+                pixels[pixel] = palette[random() % 256].Data;
+            }
+            else
+            {
+                pixels[pixel] = (uint16_t)random();
+            }
+        }
+
+        rgb.Image->ConvertToIndexed(indexed.Image);
+
+        for (int32_t pixel = 0; pixel < width * height; pixel++)
+        {
+            indexedMismatches += indices[pixel] != ReferenceFind(palette, 256, Skathi::Bitmap::Color_t(pixels[pixel])) ? 1 : 0;
+        }
+
+        delete indexed.Image;
+        delete rgb.Image;
+    }
+
+    Check(rgbMismatches == 0, "conversions: ConvertToRGB matches palette lookup");
+    Check(indexedMismatches == 0, "conversions: ConvertToIndexed matches nearest color search");
+}
+
+/** @brief Print speed of a kernel and its reference loop
+ * @param name Kernel name
+ * @param pixels Number of pixels processed
+ * @param kernelTime Kernel time in milliseconds
+ * @param referenceTime Reference time in milliseconds
+ */
+static void Report(const char * name, double pixels, double kernelTime, double referenceTime)
+{
+    printf("%-24s %10.1f %12.1f %8.2f\n", name, pixels / (kernelTime * 1000.0), pixels / (referenceTime * 1000.0), referenceTime / kernelTime);
+}
+
+/** @brief Measure kernels and reference loops on full screen images
+ * @param format Image format
+ * @param name Format name
+ */
+static void Benchmark(Skathi::Bitmap::ImageFormat format, const char * name)
+{
+    const int32_t width = 320;
+    const int32_t height = 224;
+    const uint32_t repeats = 200;
+    const double pixels = (double)width * height * repeats;
+    std::mt19937 random(3);
+    TestImage target = Create(random, width, height, format);
+    TestImage source = Create(random, width, height, format);
+    uint8_t * data = target.Image->GetImageData();
+    char label[32];
+
+    // Odd offset makes rows start at every alignment
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat++)
+    {
+        target.Image->FillRect(repeat & 1, 0, width - 1, height, (uint16_t)repeat);
+    }
+
+    double kernelTime = Elapsed(start);
+    start = std::chrono::steady_clock::now();
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat++)
+    {
+        ReferenceFill(data, target, repeat & 1, 0, width - 1, height, (uint16_t)repeat);
+    }
+
+    snprintf(label, sizeof(label), "FillRect %s", name);
+    Report(label, pixels, kernelTime, Elapsed(start));
+
+    start = std::chrono::steady_clock::now();
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat++)
+    {
+        target.Image->Blit(source.Image, repeat & 1, 0, width - 1, height, repeat & 1, 0);
+    }
+
+    kernelTime = Elapsed(start);
+    start = std::chrono::steady_clock::now();
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat++)
+    {
+        ReferenceBlit(data, target, source, repeat & 1, 0, width - 1, height, repeat & 1, 0, false, 0);
+    }
+
+    snprintf(label, sizeof(label), "Blit %s", name);
+    Report(label, pixels, kernelTime, Elapsed(start));
+
+    start = std::chrono::steady_clock::now();
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat++)
+    {
+        target.Image->BlitKeyed(source.Image, repeat & 1, 0, width - 1, height, repeat & 1, 0, 0);
+    }
+
+    kernelTime = Elapsed(start);
+    start = std::chrono::steady_clock::now();
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat++)
+    {
+        ReferenceBlit(data, target, source, repeat & 1, 0, width - 1, height, repeat & 1, 0, true, 0);
+    }
+
+    snprintf(label, sizeof(label), "BlitKeyed %s", name);
+    Report(label, pixels, kernelTime, Elapsed(start));
+
+    delete target.Image;
+    delete source.Image;
+}
+
+/** @brief Measure conversions and reference loops on full screen images
+ */
+static void BenchmarkConversions()
+{
+    const int32_t width = 320;
+    const int32_t height = 224;
+    const uint32_t repeats = 50;
+    const double pixels = (double)width * height * repeats;
+    std::mt19937 random(4);
+    TestImage indexed = Create(random, width, height, Skathi::Bitmap::ImageFormat::Indexed);
+    TestImage rgb = Create(random, width, height, Skathi::Bitmap::ImageFormat::RGB);
+    RandomPalette(random, indexed.Image);
+
+    const uint8_t * indices = indexed.Image->GetImageData();
+    uint16_t * colors = (uint16_t*)rgb.Image->GetImageData();
+    const Skathi::Bitmap::Color_t * palette = indexed.Image->GetPalette();
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat++)
+    {
+        indexed.Image->ConvertToRGB(rgb.Image);
+    }
+
+    double kernelTime = Elapsed(start);
+    start = std::chrono::steady_clock::now();
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat++)
+    {
+        for (int32_t pixel = 0; pixel < width * height; pixel++)
+        {
+            colors[pixel] = palette[indices[pixel]].Data;
+        }
+    }
+
+    Report("ConvertToRGB", pixels, kernelTime, Elapsed(start));
+
+    // Texture like image with runs of the same color
+    for (int32_t pixel = 0; pixel < width * height; pixel++)
+    {
+        colors[pixel] = palette[1 + ((pixel / 5) % 255)].Data;
+    }
+
+    start = std::chrono::steady_clock::now();
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat++)
+    {
+        rgb.Image->ConvertToIndexed(indexed.Image);
+    }
+
+    kernelTime = Elapsed(start);
+    start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> expected(width * height);
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat++)
+    {
+        for (int32_t pixel = 0; pixel < width * height; pixel++)
+        {
+            expected[pixel] = ReferenceFind(palette, 256, Skathi::Bitmap::Color_t(colors[pixel]));
+        }
+    }
+
+    Report("ConvertToIndexed", pixels, kernelTime, Elapsed(start));
+    Check(memcmp(expected.data(), indices, expected.size()) == 0, "benchmark: ConvertToIndexed matches nearest color search");
+
+    delete indexed.Image;
+    delete rgb.Image;
+}
+
+int main(int argc, char ** argv)
+{
+    const uint32_t operations = argc > 1 ? (uint32_t)atoi(argv[1]) : 100000;
+
+    TestRandom(operations);
+    TestConversions();
+
+    printf("%-24s %10s %12s %8s\n", "kernel", "MP/s", "reference", "ratio");
+    Benchmark(Skathi::Bitmap::ImageFormat::Indexed, "indexed");
+    Benchmark(Skathi::Bitmap::ImageFormat::RGB, "RGB");
+    BenchmarkConversions();
+
+    printf("%u checks passed, %u failed\n", passes, failures);
+    return failures == 0 ? 0 : 1;
+}
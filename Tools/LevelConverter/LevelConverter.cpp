@@ -0,0 +1,632 @@
+/** @brief Converts level layout and floor tile set into level file read by Utenyaa::Level::LevelFile
+ * @details Build: g++ -std=c++17 -O2 -o LevelConverter LevelConverter.cpp
+ * Usage: LevelConverter [-s] <layout.txt> <tileset.tga> <output.LVL> [tile size in world units]
+ *
+ *   -s  write streamed level read by Utenyaa::Level::Streamer (put it on disc as ARENA.LVC), level is split into
+ *       16x16 tile chunks and can be up to 255x255 tiles large
+ *
+ * Layout is a text file with one character per tile, all lines must have the same length:
+ *   '#'        solid wall (floor under it uses tile set tile 0)
+ *   '.'        floor, tile set tile 0
+ *   '1' - '9'  floor, tile set tile 1 - 9
+ *   'a' - 'z'  floor, tile set tile 10 - 35
+ *
+ * Tile set is an uncompressed or RLE TGA (color mapped or true color) made of 16x16 pixel tiles
+ * read left to right, top to bottom. Floor uses single 16 color palette, color 0 is transparent,
+ * so tile set can have at most 15 distinct colors (RGB555). Identical 8x8 cells are stored only once.
+ */
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+/** @brief File identifier ("ULVL")
+ */
+static constexpr uint32_t Magic = 0x554c564c;
+
+/** @brief Streamed level file identifier ("ULVC")
+ */
+static constexpr uint32_t StreamedMagic = 0x554c5643;
+
+/** @brief Chunk size of streamed level in tiles as power of two
+ */
+static constexpr int ChunkShift = 4;
+
+/** @brief Size of a disc sector
+ */
+static constexpr size_t SectorSize = 2048;
+
+/** @brief Size of a tile set tile in pixels
+ */
+static constexpr int TilePixels = 16;
+
+/** @brief Number of cells along one side of a tile
+ */
+static constexpr int CellsPerTile = TilePixels / 8;
+
+/** @brief Largest level size in tiles (2x2 planes of 64x64 cells)
+ */
+static constexpr int MaxTiles = 64;
+
+/** @brief Largest streamed level size in tiles (AI flow fields index tiles with 16 bits)
+ */
+static constexpr int MaxStreamedTiles = 255;
+
+/** @brief Largest number of cells (10 bit character number)
+ */
+static constexpr size_t MaxCells = 1024;
+
+/** @brief Tile flag of a solid tile (Utenyaa::Level::TileFlags::Solid)
+ */
+static constexpr uint8_t SolidFlag = 1;
+
+/** @brief Decoded tile set image
+ */
+struct Image
+{
+    /** @brief Image width
+     */
+    int Width = 0;
+
+    /** @brief Image height
+     */
+    int Height = 0;
+
+    /** @brief Pixels as RGB555 with bit 15 set for opaque pixels (row major, top to bottom)
+     */
+    std::vector<uint16_t> Pixels;
+};
+
+/** @brief Convert 8 bit per channel color to RGB555
+ * @param r Red
+ * @param g Green
+ * @param b Blue
+ * @param a Alpha
+ * @return Saturn color with bit 15 set when opaque
+ */
+static uint16_t ToRgb555(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+    if (a < 0x80)
+    {
+        return 0;
+    }
+
+    return 0x8000 | ((b >> 3) << 10) | ((g >> 3) << 5) | (r >> 3);
+}
+
+/** @brief Decode single TGA color value
+ * @param data Color data
+ * @param bits Bits per color
+ * @return Saturn color
+ */
+static uint16_t DecodeColor(const uint8_t * data, int bits)
+{
+    switch (bits)
+    {
+    case 15:
+    case 16:
+    {
+        // Attribute bit is often left clear by paint programs, so 16 bit colors are always opaque
+        const uint16_t value = data[0] | (data[1] << 8);
+        return ToRgb555(((value >> 10) & 0x1f) << 3, ((value >> 5) & 0x1f) << 3, (value & 0x1f) << 3, 0xff);
+    }
+
+    case 24:
+        return ToRgb555(data[2], data[1], data[0], 0xff);
+
+    case 32:
+        return ToRgb555(data[2], data[1], data[0], data[3]);
+
+    default:
+        return 0;
+    }
+}
+
+/** @brief Load TGA image
+ * @param path File path
+ * @param image Decoded image
+ * @return true Image was loaded
+ * @return false File is missing or in unsupported format
+ */
+static bool LoadTga(const std::string & path, Image & image)
+{
+    std::ifstream stream(path, std::ios::binary);
+
+    if (!stream)
+    {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    if (file.size() < 18)
+    {
+        fprintf(stderr, "%s is not a TGA file\n", path.c_str());
+        return false;
+    }
+
+    const uint8_t idLength = file[0];
+    const uint8_t type = file[2];
+    const int mapFirst = file[3] | (file[4] << 8);
+    const int mapLength = file[5] | (file[6] << 8);
+    const int mapBits = file[7];
+    const int bits = file[16];
+    const bool topDown = (file[17] & 0x20) != 0;
+    image.Width = file[12] | (file[13] << 8);
+    image.Height = file[14] | (file[15] << 8);
+
+    const bool mapped = type == 1 || type == 9;
+    const bool rle = type == 9 || type == 10;
+
+    if ((!mapped && type != 2 && type != 10) || (mapped && bits != 8) || (!mapped && bits != 16 && bits != 24 && bits != 32))
+    {
+        fprintf(stderr, "%s: unsupported TGA type %d with %d bits per pixel\n", path.c_str(), type, bits);
+        return false;
+    }
+
+    size_t offset = 18 + idLength;
+    std::vector<uint16_t> palette;
+
+    if (file[1] != 0)
+    {
+        const int mapBytes = (mapBits + 7) / 8;
+        palette.resize(mapFirst + mapLength, 0);
+
+        if (offset + ((size_t)mapLength * mapBytes) > file.size())
+        {
+            fprintf(stderr, "%s: unexpected end of file\n", path.c_str());
+            return false;
+        }
+
+        for (int entry = 0; entry < mapLength; entry++, offset += mapBytes)
+        {
+            palette[mapFirst + entry] = DecodeColor(&file[offset], mapBits);
+        }
+    }
+
+    const int pixelBytes = bits / 8;
+    const size_t count = (size_t)image.Width * image.Height;
+    std::vector<uint16_t> pixels;
+    pixels.reserve(count);
+
+    auto decode = [&](size_t at) -> uint16_t
+    {
+        if (mapped)
+        {
+            return file[at] < palette.size() ? palette[file[at]] : 0;
+        }
+
+        return DecodeColor(&file[at], bits);
+    };
+
+    while (pixels.size() < count)
+    {
+        if (offset >= file.size())
+        {
+            fprintf(stderr, "%s: unexpected end of file\n", path.c_str());
+            return false;
+        }
+
+        if (!rle)
+        {
+            if (offset + pixelBytes > file.size())
+            {
+                fprintf(stderr, "%s: unexpected end of file\n", path.c_str());
+                return false;
+            }
+
+            pixels.push_back(decode(offset));
+            offset += pixelBytes;
+            continue;
+        }
+
+        const uint8_t packet = file[offset++];
+        const size_t length = (packet & 0x7f) + 1;
+
+        if (offset + (pixelBytes * ((packet & 0x80) != 0 ? 1 : length)) > file.size())
+        {
+            fprintf(stderr, "%s: unexpected end of file\n", path.c_str());
+            return false;
+        }
+
+        if ((packet & 0x80) != 0)
+        {
+            const uint16_t color = decode(offset);
+            offset += pixelBytes;
+            pixels.insert(pixels.end(), length, color);
+        }
+        else
+        {
+            for (size_t pixel = 0; pixel < length; pixel++, offset += pixelBytes)
+            {
+                pixels.push_back(decode(offset));
+            }
+        }
+    }
+
+    pixels.resize(count);
+    image.Pixels.resize(count);
+
+    for (int y = 0; y < image.Height; y++)
+    {
+        const int source = topDown ? y : image.Height - 1 - y;
+        std::copy(pixels.begin() + ((size_t)source * image.Width), pixels.begin() + ((size_t)(source + 1) * image.Width), image.Pixels.begin() + ((size_t)y * image.Width));
+    }
+
+    return true;
+}
+
+/** @brief Load level layout
+ * @param path File path
+ * @param rows Layout rows
+ * @param maxTiles Largest level size in tiles
+ * @return true Layout was loaded
+ * @return false File is missing or malformed
+ */
+static bool LoadLayout(const std::string & path, std::vector<std::string> & rows, int maxTiles)
+{
+    std::ifstream stream(path);
+
+    if (!stream)
+    {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+
+    while (std::getline(stream, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+
+        if (!line.empty())
+        {
+            rows.push_back(line);
+        }
+    }
+
+    if (rows.empty() || rows.size() > (size_t)maxTiles || rows[0].size() > (size_t)maxTiles)
+    {
+        fprintf(stderr, "%s: level has to be between 1x1 and %dx%d tiles\n", path.c_str(), maxTiles, maxTiles);
+        return false;
+    }
+
+    for (size_t row = 0; row < rows.size(); row++)
+    {
+        if (rows[row].size() != rows[0].size())
+        {
+            fprintf(stderr, "%s: line %zu has different length\n", path.c_str(), row + 1);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/** @brief Get tile set tile index of a layout character
+ * @param tile Layout character
+ * @return Tile index or -1 if character is not valid
+ */
+static int GetTileIndex(char tile)
+{
+    if (tile == '#' || tile == '.')
+    {
+        return 0;
+    }
+    else if (tile >= '1' && tile <= '9')
+    {
+        return tile - '0';
+    }
+    else if (tile >= 'a' && tile <= 'z')
+    {
+        return 10 + (tile - 'a');
+    }
+
+    return -1;
+}
+
+/** @brief Level file writer (big endian)
+ */
+class Writer
+{
+private:
+    /** @brief Output data
+     */
+    std::vector<uint8_t> data;
+
+public:
+    /** @brief Write byte
+     * @param value Value
+     */
+    void Byte(uint8_t value)
+    {
+        this->data.push_back(value);
+    }
+
+    /** @brief Write 16bit word
+     * @param value Value
+     */
+    void Word(uint16_t value)
+    {
+        this->Byte(value >> 8);
+        this->Byte(value & 0xff);
+    }
+
+    /** @brief Write 32bit word
+     * @param value Value
+     */
+    void Long(uint32_t value)
+    {
+        this->Word(value >> 16);
+        this->Word(value & 0xffff);
+    }
+
+    /** @brief Pad output to 4 byte boundary
+     * @param boundary Boundary to pad to (power of two)
+     */
+    void Align(size_t boundary = 4)
+    {
+        while ((this->data.size() & (boundary - 1)) != 0)
+        {
+            this->Byte(0);
+        }
+    }
+
+    /** @brief Get output size
+     * @return Number of written bytes
+     */
+    size_t GetSize() const
+    {
+        return this->data.size();
+    }
+
+    /** @brief Save output
+     * @param path File path
+     * @return true File was written
+     * @return false File could not be written
+     */
+    bool Save(const std::string & path) const
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream.write((const char*)this->data.data(), this->data.size());
+        return (bool)stream;
+    }
+};
+
+int main(int argc, char ** argv)
+{
+    const bool streamed = argc > 1 && std::string(argv[1]) == "-s";
+
+    if (streamed)
+    {
+        argc--;
+        argv++;
+    }
+
+    if (argc < 4)
+    {
+        fprintf(stderr, "Usage: %s [-s] <layout.txt> <tileset.tga> <output.LVL> [tile size]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> rows;
+    Image tileset;
+
+    if (!LoadLayout(argv[1], rows, streamed ? MaxStreamedTiles : MaxTiles) || !LoadTga(argv[2], tileset))
+    {
+        return 1;
+    }
+
+    const double tileSize = argc > 4 ? atof(argv[4]) : 2.0;
+    const int width = (int)rows[0].size();
+    const int height = (int)rows.size();
+    const int tilesetColumns = tileset.Width / TilePixels;
+    const int tilesetTiles = tilesetColumns * (tileset.Height / TilePixels);
+
+    if (tileSize <= 0.0 || tileSize >= 32768.0)
+    {
+        fprintf(stderr, "Invalid tile size %f\n", tileSize);
+        return 1;
+    }
+
+    // Color 0 is transparent, opaque colors get the rest of the palette in order of appearance
+    std::map<uint16_t, uint8_t> colors;
+    std::vector<uint16_t> palette(16, 0);
+    colors[0] = 0;
+
+    // Cell 0 is always empty, it fills the map outside of the level
+    std::map<std::array<uint8_t, 32>, uint16_t> cellIndex;
+    std::vector<std::array<uint8_t, 32>> cells(1);
+    cells[0].fill(0);
+    cellIndex[cells[0]] = 0;
+
+    std::vector<uint8_t> flags((size_t)width * height, 0);
+    std::vector<uint16_t> patterns((size_t)width * CellsPerTile * height * CellsPerTile, 0);
+    const int columns = width * CellsPerTile;
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const char tile = rows[y][x];
+            const int index = GetTileIndex(tile);
+
+            if (index < 0 || index >= tilesetTiles)
+            {
+                fprintf(stderr, "Tile '%c' at %d,%d is not in the tile set (%d tiles)\n", tile, x + 1, y + 1, tilesetTiles);
+                return 1;
+            }
+
+            flags[((size_t)y * width) + x] = tile == '#' ? SolidFlag : 0;
+
+            for (int cellY = 0; cellY < CellsPerTile; cellY++)
+            {
+                for (int cellX = 0; cellX < CellsPerTile; cellX++)
+                {
+                    // 4 bits per pixel, left pixel in high nibble
+                    std::array<uint8_t, 32> cell;
+                    cell.fill(0);
+
+                    for (int pixel = 0; pixel < 64; pixel++)
+                    {
+                        const int sourceX = ((index % tilesetColumns) * TilePixels) + (cellX * 8) + (pixel & 7);
+                        const int sourceY = ((index / tilesetColumns) * TilePixels) + (cellY * 8) + (pixel >> 3);
+                        const uint16_t color = tileset.Pixels[((size_t)sourceY * tileset.Width) + sourceX];
+                        auto found = colors.find(color);
+
+                        if (found == colors.end())
+                        {
+                            if (colors.size() >= 16)
+                            {
+                                fprintf(stderr, "Tile set has more than 15 colors\n");
+                                return 1;
+                            }
+
+                            palette[colors.size()] = color;
+                            found = colors.emplace(color, (uint8_t)colors.size()).first;
+                        }
+
+                        cell[pixel >> 1] |= (pixel & 1) == 0 ? found->second << 4 : found->second;
+                    }
+
+                    auto existing = cellIndex.find(cell);
+                    uint16_t character;
+
+                    if (existing != cellIndex.end())
+                    {
+                        character = existing->second;
+                    }
+                    else
+                    {
+                        character = (uint16_t)cells.size();
+                        cellIndex[cell] = character;
+                        cells.push_back(cell);
+                    }
+
+                    patterns[((size_t)((y * CellsPerTile) + cellY) * columns) + (x * CellsPerTile) + cellX] = character;
+                }
+            }
+        }
+    }
+
+    if (cells.size() > MaxCells)
+    {
+        fprintf(stderr, "Floor needs %zu cells, at most %zu are supported\n", cells.size(), MaxCells);
+        return 1;
+    }
+
+    Writer writer;
+    writer.Long(streamed ? StreamedMagic : Magic);
+    writer.Word(width);
+    writer.Word(height);
+    writer.Long((uint32_t)(int32_t)(tileSize * 65536.0));
+    writer.Word((uint16_t)cells.size());
+    writer.Word((uint16_t)colors.size());
+
+    for (uint16_t color : palette)
+    {
+        writer.Word(color);
+    }
+
+    if (streamed)
+    {
+        // Chunks start at sector boundary right after the cells
+        const int chunkTiles = 1 << ChunkShift;
+        const int chunkCells = chunkTiles * CellsPerTile;
+        const int chunkColumns = (width + chunkTiles - 1) / chunkTiles;
+        const int chunkRows = (height + chunkTiles - 1) / chunkTiles;
+        const size_t chunkSize = (chunkTiles * chunkTiles) + (chunkCells * chunkCells * 2);
+        const size_t headerSize = 64;
+        const size_t chunkOffset = ((headerSize + (cells.size() * 32)) + SectorSize - 1) & ~(SectorSize - 1);
+
+        writer.Word(ChunkShift);
+        writer.Word(chunkColumns);
+        writer.Word(chunkRows);
+        writer.Word(0);
+        writer.Long((uint32_t)chunkOffset);
+        writer.Long((uint32_t)chunkSize);
+
+        for (const std::array<uint8_t, 32> & cell : cells)
+        {
+            for (uint8_t value : cell)
+            {
+                writer.Byte(value);
+            }
+        }
+
+        writer.Align(SectorSize);
+
+        // Tiles outside of the level are solid and have empty floor
+        for (int chunkY = 0; chunkY < chunkRows; chunkY++)
+        {
+            for (int chunkX = 0; chunkX < chunkColumns; chunkX++)
+            {
+                for (int y = chunkY * chunkTiles; y < (chunkY + 1) * chunkTiles; y++)
+                {
+                    for (int x = chunkX * chunkTiles; x < (chunkX + 1) * chunkTiles; x++)
+                    {
+                        writer.Byte(x < width && y < height ? flags[((size_t)y * width) + x] : SolidFlag);
+                    }
+                }
+
+                for (int y = chunkY * chunkCells; y < (chunkY + 1) * chunkCells; y++)
+                {
+                    for (int x = chunkX * chunkCells; x < (chunkX + 1) * chunkCells; x++)
+                    {
+                        writer.Word(x < columns && y < height * CellsPerTile ? patterns[((size_t)y * columns) + x] : 0);
+                    }
+                }
+            }
+        }
+
+        if (!writer.Save(argv[3]))
+        {
+            fprintf(stderr, "Cannot write %s\n", argv[3]);
+            return 1;
+        }
+
+        printf("%s: %dx%d tiles in %dx%d chunks, %zu cells, %zu colors\n", argv[3], width, height, chunkColumns, chunkRows, cells.size(), colors.size() - 1);
+        return 0;
+    }
+
+    for (uint8_t flag : flags)
+    {
+        writer.Byte(flag);
+    }
+
+    writer.Align();
+
+    for (const std::array<uint8_t, 32> & cell : cells)
+    {
+        for (uint8_t value : cell)
+        {
+            writer.Byte(value);
+        }
+    }
+
+    writer.Align();
+
+    for (uint16_t pattern : patterns)
+    {
+        writer.Word(pattern);
+    }
+
+    if (!writer.Save(argv[3]))
+    {
+        fprintf(stderr, "Cannot write %s\n", argv[3]);
+        return 1;
+    }
+
+    printf("%s: %dx%d tiles, %zu cells, %zu colors\n", argv[3], width, height, cells.size(), colors.size() - 1);
+    return 0;
+}
@@ -0,0 +1,211 @@
+/** @brief Measures Skathi::Vdp1::OrderingTable against std::sort for depth ordering 500 to 4000 polygons
+ * @details Build: g++ -std=c++20 -O2 -I../Host -o OrderingTableBenchmark OrderingTableBenchmark.cpp
+ * Usage: OrderingTableBenchmark [number of frames]
+ *
+ * Every frame polygons get random depths over the depth range of the frame ordering table. Ordering table clears its buckets,
+ * inserts every polygon and links them far to near, baseline sorts polygon indices by depth with std::sort and links them the
+ * same way. Both chains are walked from the head command through jump links, every polygon has to be visited exactly once,
+ * the chain has to end in the tail command and depth must not grow along it (for the ordering table only between buckets,
+ * polygons in the same bucket are drawn in any order). Report shows microseconds per frame and number of neighbouring polygons
+ * drawn in wrong order because they share a bucket. Depths far outside of the range have to land in the first or last bucket.
+ * Exits with non-zero code when any chain is broken or any depth lands in a wrong bucket.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <yaul.h>
+#include "../../src/constants.hpp"
+#include "../../Dependencies/Skathi/VDP1/OrderingTable.hpp"
+
+/** @brief Largest tested number of polygons
+ */
+static constexpr uint16_t MaxPolygons = 4000;
+
+/** @brief Command list size, head command, polygons and tail command
+ */
+static constexpr uint16_t Capacity = MaxPolygons + 2;
+
+/** @brief Ordering table with the same buckets the frame pipeline uses
+ */
+using Table = Skathi::Vdp1::OrderingTable<FRAME_ORDER_BUCKETS, Capacity>;
+
+/** @brief Microseconds elapsed since a time point
+ * @param start Start time
+ * @return Elapsed time
+ */
+static double Elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** @brief Sort polygons by depth with std::sort and chain them far to near
+ * @param depths Depth of each command (polygons are commands 1 to count)
+ * @param count Number of polygons
+ * @param order Scratch buffer for polygon indices
+ * @param commands Command list
+ */
+static void SortAndLink(const std::vector<fix16_t> & depths, uint16_t count, std::vector<uint16_t> & order, vdp1_cmdt_t * commands)
+{
+    for (uint16_t polygon = 0; polygon < count; polygon++)
+    {
+        order[polygon] = polygon + 1;
+    }
+
+    std::sort(order.begin(), order.begin() + count, [&depths](uint16_t first, uint16_t second)
+    {
+        return depths[first] > depths[second];
+    });
+
+    vdp1_cmdt_t * previous = &commands[0];
+
+    for (uint16_t polygon = 0; polygon < count; polygon++)
+    {
+        vdp1_cmdt_link_type_set(previous, VDP1_CMDT_LINK_TYPE_JUMP_ASSIGN);
+        vdp1_cmdt_link_set(previous, order[polygon]);
+        previous = &commands[order[polygon]];
+    }
+
+    vdp1_cmdt_link_type_set(previous, VDP1_CMDT_LINK_TYPE_JUMP_ASSIGN);
+    vdp1_cmdt_link_set(previous, count + 1);
+}
+
+/** @brief Walk command chain from the head command and check it
+ * @param commands Command list
+ * @param count Number of polygons
+ * @param key Sort key of each command, must not grow along the chain
+ * @param visited Scratch buffer of visited flags
+ * @return true Chain visits every polygon once in order and ends in the tail command
+ * @return false Chain is broken
+ */
+static bool CheckChain(const vdp1_cmdt_t * commands, uint16_t count, const std::vector<int32_t> & key, std::vector<uint8_t> & visited)
+{
+    std::fill(visited.begin(), visited.begin() + count + 2, 0);
+    uint16_t command = 0;
+
+    for (uint16_t step = 0; step < count; step++)
+    {
+        if ((commands[command].cmd_ctrl & 0x7000) != VDP1_CMDT_LINK_TYPE_JUMP_ASSIGN)
+        {
+            return false;
+        }
+
+        const uint16_t next = commands[command].cmd_link >> 2;
+
+        if (next == 0 || next > count || visited[next] != 0 || (command != 0 && key[next] > key[command]))
+        {
+            return false;
+        }
+
+        visited[next] = 1;
+        command = next;
+    }
+
+    return (commands[command].cmd_ctrl & 0x7000) == VDP1_CMDT_LINK_TYPE_JUMP_ASSIGN && (commands[command].cmd_link >> 2) == count + 1;
+}
+
+/** @brief Count neighbouring polygons of the chain where nearer polygon is drawn first
+ * @param commands Command list
+ * @param count Number of polygons
+ * @param depths Depth of each command
+ * @return Number of swapped neighbours
+ */
+static uint32_t CountSwapped(const vdp1_cmdt_t * commands, uint16_t count, const std::vector<fix16_t> & depths)
+{
+    uint32_t swapped = 0;
+    uint16_t command = commands[0].cmd_link >> 2;
+
+    for (uint16_t step = 1; step < count; step++)
+    {
+        const uint16_t next = commands[command].cmd_link >> 2;
+        swapped += depths[next] > depths[command] ? 1 : 0;
+        command = next;
+    }
+
+    return swapped;
+}
+
+int main(int argc, char ** argv)
+{
+    const uint32_t frames = argc > 1 ? (uint32_t)atoi(argv[1]) : 2000;
+
+    if (frames == 0)
+    {
+        fprintf(stderr, "Usage: %s [number of frames]\n", argv[0]);
+        return 1;
+    }
+
+    static Table table(FRAME_ORDER_NEAR, FRAME_ORDER_FAR);
+    std::vector<vdp1_cmdt_t> tableCommands(Capacity);
+    std::vector<vdp1_cmdt_t> sortCommands(Capacity);
+    std::vector<fix16_t> depths(Capacity);
+    std::vector<int32_t> buckets(Capacity);
+    std::vector<int32_t> exact(Capacity);
+    std::vector<uint16_t> order(Capacity);
+    std::vector<uint8_t> visited(Capacity);
+    std::mt19937 random(1);
+    uint32_t broken = 0;
+
+    // Depths past the range must not overflow into another bucket
+    const fix16_t farDepths[] = { FRAME_ORDER_FAR, FRAME_ORDER_FAR + FIX16(1000.0f), FIX16(30000.0f), INT32_MAX };
+    const fix16_t nearDepths[] = { FRAME_ORDER_NEAR, FRAME_ORDER_NEAR - FIX16(1000.0f), FIX16(-30000.0f), INT32_MIN };
+    uint32_t wrongBuckets = 0;
+
+    for (uint8_t depth = 0; depth < 4; depth++)
+    {
+        wrongBuckets += table.GetBucket(farDepths[depth]) == FRAME_ORDER_BUCKETS - 1 ? 0 : 1;
+        wrongBuckets += table.GetBucket(nearDepths[depth]) == 0 ? 0 : 1;
+    }
+
+    printf("%u buckets, %u frames per row\n", FRAME_ORDER_BUCKETS, frames);
+    printf("%10s %12s %12s %10s %10s\n", "polygons", "table us", "sort us", "speedup", "swapped");
+
+    for (const uint16_t count : { 500, 1000, 2000, 4000 })
+    {
+        double tableTime = 0.0;
+        double sortTime = 0.0;
+        uint64_t swapped = 0;
+
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            for (uint16_t polygon = 1; polygon <= count; polygon++)
+            {
+                depths[polygon] = FRAME_ORDER_NEAR + (fix16_t)(random() % (uint32_t)(FRAME_ORDER_FAR - FRAME_ORDER_NEAR));
+                buckets[polygon] = table.GetBucket(depths[polygon]);
+                exact[polygon] = depths[polygon];
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            table.Clear();
+
+            for (uint16_t polygon = 1; polygon <= count; polygon++)
+            {
+                table.Insert(polygon, depths[polygon]);
+            }
+
+            table.Link(tableCommands.data(), 0, count + 1, 0);
+            tableTime += Elapsed(start);
+
+            start = std::chrono::steady_clock::now();
+            SortAndLink(depths, count, order, sortCommands.data());
+            sortTime += Elapsed(start);
+
+            broken += CheckChain(tableCommands.data(), count, buckets, visited) ? 0 : 1;
+            broken += CheckChain(sortCommands.data(), count, exact, visited) ? 0 : 1;
+            swapped += CountSwapped(tableCommands.data(), count, depths);
+        }
+
+        printf("%10u %12.2f %12.2f %10.2f %10.1f\n",
+            count,
+            tableTime / frames,
+            sortTime / frames,
+            sortTime / tableTime,
+            (double)swapped / frames);
+    }
+
+    printf("%u broken chains, %u out of range depths in wrong bucket\n", broken, wrongBuckets);
+    return broken == 0 && wrongBuckets == 0 ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+/** @brief Measures Utenyaa::Effects::Particles update and draw cost for 256 to 4096 live particles
+ * @details Build: g++ -std=c++20 -O2 -I../Host -o ParticleBenchmark ParticleBenchmark.cpp
+ * Usage: ParticleBenchmark [number of frames]
+ *
+ * Pool capacity is raised to 4096 for the benchmark. Bursts of explosions, flashes and smoke are emitted over an arena larger
+ * than the viewport and topped up every frame, so the number of live particles stays at the tested count. Each frame Update
+ * is timed, then Draw adds sprites of particles inside of a single full screen viewport into a batch with the game draw budget.
+ * When more particles are inside of the viewport than the budget, every Nth of them is drawn, N is picked from the particles
+ * inside of the viewport, so the number of drawn sprites has to match the count expected from visible particles.
+ * Exits with non-zero code when it does not or when the budget is exceeded.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <yaul.h>
+#include "../../src/constants.hpp"
+
+#undef PARTICLE_CAPACITY
+#define PARTICLE_CAPACITY (4096)
+
+#include "../../src/Effects/Particles.hpp"
+
+/** @brief Half size of the area bursts are emitted in
+ */
+static constexpr fix16_t ArenaHalfSize = FIX16(48.0f);
+
+/** @brief Microseconds elapsed since a time point
+ * @param start Start time
+ * @return Elapsed time
+ */
+static double Elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** @brief Emit bursts until the pool has the requested number of particles
+ * @param target Requested number of live particles
+ * @param random Random generator
+ */
+static void TopUp(uint16_t target, std::mt19937 & random)
+{
+    while (Utenyaa::Effects::Particles::GetCount() < target)
+    {
+        const fix16_vec3_t location = {
+            (fix16_t)(random() % (2 * (uint32_t)ArenaHalfSize)) - ArenaHalfSize,
+            (fix16_t)(random() % (2 * (uint32_t)ArenaHalfSize)) - ArenaHalfSize,
+            FIX16_ZERO
+        };
+
+        const Utenyaa::Effects::Particles::Kind kind = (Utenyaa::Effects::Particles::Kind)(random() % Utenyaa::Effects::Particles::Kind::KindCount);
+        const uint16_t amount = std::min<uint16_t>(PARTICLE_EXPLOSION_AMOUNT, target - Utenyaa::Effects::Particles::GetCount());
+        Utenyaa::Effects::Particles::Emit(kind, &location, amount);
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const uint32_t frames = argc > 1 ? (uint32_t)atoi(argv[1]) : 2000;
+
+    if (frames == 0)
+    {
+        fprintf(stderr, "Usage: %s [number of frames]\n", argv[0]);
+        return 1;
+    }
+
+    const fix16_vec3_t center = { FIX16_ZERO, FIX16_ZERO, FIX16_ZERO };
+    Utenyaa::Rendering::Viewports::Initialize(1);
+    Utenyaa::Rendering::Viewports::SetFocus(0, &center);
+    const Utenyaa::Rendering::Viewports::Viewport * viewport = Utenyaa::Rendering::Viewports::Get(0);
+
+    const texture_t texture = { vram_index : 0, size : TEXTURE_SIZE(PARTICLE_TEXTURE_SIZE, PARTICLE_TEXTURE_SIZE) };
+
+    for (uint8_t kind = 0; kind < Utenyaa::Effects::Particles::Kind::KindCount; kind++)
+    {
+        Utenyaa::Effects::Particles::SetSprite((Utenyaa::Effects::Particles::Kind)kind, &texture, 0, 0);
+    }
+
+    Skathi::Vdp1::Sprite batch(PARTICLE_DRAW_BUDGET);
+    Skathi::Vdp1::Sprite all(Utenyaa::Effects::Particles::Capacity);
+    std::mt19937 random(1);
+    uint32_t mismatches = 0;
+
+    printf("Draw budget %u sprites, %u frames per row\n", PARTICLE_DRAW_BUDGET, frames);
+    printf("%10s %10s %10s %12s %12s %12s\n", "particles", "visible", "drawn", "update us", "draw us", "ns/particle");
+
+    for (uint16_t target = 256; target <= 4096; target <<= 1)
+    {
+        Utenyaa::Effects::Particles::Initialize(false);
+        TopUp(target, random);
+
+        double updateTime = 0.0;
+        double drawTime = 0.0;
+        uint64_t visible = 0;
+        uint64_t drawn = 0;
+        uint64_t updated = 0;
+
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            updated += Utenyaa::Effects::Particles::GetCount();
+
+            auto start = std::chrono::steady_clock::now();
+            Utenyaa::Effects::Particles::Update();
+            updateTime += Elapsed(start);
+
+            TopUp(target, random);
+
+            start = std::chrono::steady_clock::now();
+            batch.Clear();
+            Utenyaa::Effects::Particles::Draw(&batch, viewport, PARTICLE_DRAW_BUDGET);
+            drawTime += Elapsed(start);
+
+            // Budget as large as the pool draws every particle inside of the viewport, budgeted draw has to take every Nth of them
+            all.Clear();
+            Utenyaa::Effects::Particles::Draw(&all, viewport, Utenyaa::Effects::Particles::Capacity);
+            const uint32_t inside = all.GetCount();
+            const uint32_t stride = inside == 0 ? 1 : (inside + PARTICLE_DRAW_BUDGET - 1) / PARTICLE_DRAW_BUDGET;
+            const uint32_t expected = (inside + stride - 1) / stride;
+            mismatches += batch.GetCount() == expected && batch.GetCount() <= PARTICLE_DRAW_BUDGET ? 0 : 1;
+            visible += inside;
+            drawn += batch.GetCount();
+        }
+
+        printf("%10u %10.1f %10.1f %12.2f %12.2f %12.2f\n",
+            target,
+            (double)visible / frames,
+            (double)drawn / frames,
+            updateTime / frames,
+            drawTime / frames,
+            (updateTime * 1000.0) / updated);
+    }
+
+    printf("%u frames drew a wrong number of sprites\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
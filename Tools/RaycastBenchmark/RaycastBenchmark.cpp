@@ -0,0 +1,208 @@
+/** @brief Measures Utenyaa::Level::Raycast in rays per millisecond and checks its hits against a reference
+ * @details Build: g++ -std=c++20 -O2 -I../Host -o RaycastBenchmark RaycastBenchmark.cpp
+ * Usage: RaycastBenchmark [number of rays] [map size in tiles] [solid tiles in percent]
+ *
+ * Random map with a solid border is filled with solid tiles, then random rays from empty tiles are cast with Cast, CastBatch and
+ * IsVisible. Reference intersects the segment with every solid tile in its bounding box in double precision and takes the
+ * nearest one. Fixed point rays passing within a fraction of a tile from a corner can go around either side of it, so reference
+ * is run with tile squares grown and shrunk by Margin and hit fraction (1 for no hit) should lie between the two results.
+ * Segment fraction has 16 bits and grows by rounded steps, so long rays can end up slightly outside of that range, report shows
+ * the worst distance in tiles. Exits with non-zero code when Cast, CastBatch and IsVisible disagree or a hit is further than
+ * Tolerance from the reference range.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <yaul.h>
+#include "../../src/Level/Raycast.hpp"
+
+/** @brief Size of a tile in world units
+ */
+static constexpr fix16_t TileSize = FIX16(2.0f);
+
+/** @brief Distance in tiles tile squares are grown and shrunk by for the reference
+ */
+static constexpr double Margin = 1.0 / 256.0;
+
+/** @brief Largest distance in tiles a hit can be outside of the reference range
+ */
+static constexpr double Tolerance = 1.0 / 64.0;
+
+/** @brief Milliseconds elapsed since a time point
+ * @param start Start time
+ * @return Elapsed time
+ */
+static double Elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** @brief Reference ray cast intersecting the segment with tile squares
+ * @param map Tile map
+ * @param ray Ray segment
+ * @param margin Distance in tiles tile squares are grown by (negative to shrink them)
+ * @return Segment fraction at which the nearest solid tile is entered (1 if nothing is hit)
+ */
+static double Reference(const Utenyaa::Level::TileMap * map, const Utenyaa::Level::Raycast::Ray * ray, double margin)
+{
+    const fix16_vec2_t * origin = map->GetOrigin();
+    const double from[2] = { (ray->From.x - origin->x) / (double)TileSize, (ray->From.y - origin->y) / (double)TileSize };
+    const double to[2] = { (ray->To.x - origin->x) / (double)TileSize, (ray->To.y - origin->y) / (double)TileSize };
+    const int32_t left = (int32_t)std::floor(std::min(from[0], to[0]) - margin);
+    const int32_t right = (int32_t)std::floor(std::max(from[0], to[0]) + margin);
+    const int32_t top = (int32_t)std::floor(std::min(from[1], to[1]) - margin);
+    const int32_t bottom = (int32_t)std::floor(std::max(from[1], to[1]) + margin);
+    double fraction = 1.0;
+
+    for (int32_t y = top; y <= bottom; y++)
+    {
+        for (int32_t x = left; x <= right; x++)
+        {
+            if (!map->IsSolid(x, y))
+            {
+                continue;
+            }
+
+            // Slab test, segment enters the square at the latest entry of both axes
+            const double low[2] = { x - margin, y - margin };
+            const double high[2] = { x + 1.0 + margin, y + 1.0 + margin };
+            double enter = 0.0;
+            double leave = 1.0;
+
+            for (int axis = 0; axis < 2; axis++)
+            {
+                const double delta = to[axis] - from[axis];
+
+                if (std::abs(delta) < 1e-12)
+                {
+                    leave = from[axis] < low[axis] || from[axis] >= high[axis] ? -1.0 : leave;
+                    continue;
+                }
+
+                double first = (low[axis] - from[axis]) / delta;
+                double second = (high[axis] - from[axis]) / delta;
+                enter = std::max(enter, std::min(first, second));
+                leave = std::min(leave, std::max(first, second));
+            }
+
+            if (enter <= leave && enter < fraction)
+            {
+                fraction = enter;
+            }
+        }
+    }
+
+    return fraction;
+}
+
+int main(int argc, char ** argv)
+{
+    const uint32_t count = argc > 1 ? (uint32_t)atoi(argv[1]) : 50000;
+    const uint16_t size = argc > 2 ? (uint16_t)atoi(argv[2]) : 64;
+    const uint32_t density = argc > 3 ? (uint32_t)atoi(argv[3]) : 15;
+
+    if (count == 0 || count > UINT16_MAX || size < 4)
+    {
+        fprintf(stderr, "Usage: %s [number of rays (1-65535)] [map size in tiles (4+)] [solid tiles in percent]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937 random(1);
+    Utenyaa::Level::TileMap map(size, size, TileSize);
+    map.AddBorder();
+
+    for (uint16_t y = 1; y < size - 1; y++)
+    {
+        for (uint16_t x = 1; x < size - 1; x++)
+        {
+            if (random() % 100 < density)
+            {
+                map.Set(x, y, Utenyaa::Level::TileFlags::Solid);
+            }
+        }
+    }
+
+    // Rays start in empty tiles and are up to a quarter of the map long
+    std::vector<Utenyaa::Level::Raycast::Ray> rays;
+    const fix16_vec2_t * origin = map.GetOrigin();
+
+    while (rays.size() < count)
+    {
+        const fix16_t fromX = (fix16_t)(random() % ((size - 2) * TileSize)) + TileSize;
+        const fix16_t fromY = (fix16_t)(random() % ((size - 2) * TileSize)) + TileSize;
+
+        if (map.IsSolid(fromX / TileSize, fromY / TileSize))
+        {
+            continue;
+        }
+
+        const int32_t reach = (size * TileSize) >> 2;
+        const fix16_t toX = fromX + (fix16_t)(random() % (2 * reach)) - reach;
+        const fix16_t toY = fromY + (fix16_t)(random() % (2 * reach)) - reach;
+        rays.push_back({ { origin->x + fromX, origin->y + fromY }, { origin->x + toX, origin->y + toY } });
+    }
+
+    std::vector<Utenyaa::Level::Raycast::Hit> hits(count);
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t castHits = 0;
+
+    for (uint32_t ray = 0; ray < count; ray++)
+    {
+        castHits += Utenyaa::Level::Raycast::Cast(&map, &rays[ray], &hits[ray]) ? 1 : 0;
+    }
+
+    const double castTime = Elapsed(start);
+
+    start = std::chrono::steady_clock::now();
+    const uint32_t batchHits = Utenyaa::Level::Raycast::CastBatch(&map, rays.data(), hits.data(), (uint16_t)count);
+    const double batchTime = Elapsed(start);
+
+    start = std::chrono::steady_clock::now();
+    uint32_t blocked = 0;
+
+    for (uint32_t ray = 0; ray < count; ray++)
+    {
+        blocked += Utenyaa::Level::Raycast::IsVisible(&map, &rays[ray].From, &rays[ray].To) ? 0 : 1;
+    }
+
+    const double visibleTime = Elapsed(start);
+
+    start = std::chrono::steady_clock::now();
+    uint32_t mismatches = 0;
+    double worst = 0.0;
+
+    for (uint32_t ray = 0; ray < count; ray++)
+    {
+        const double fraction = hits[ray].IsHit ? hits[ray].Fraction / 65536.0 : 1.0;
+        const double earliest = Reference(&map, &rays[ray], Margin);
+        const double latest = Reference(&map, &rays[ray], -Margin);
+        const double length = std::hypot((rays[ray].To.x - rays[ray].From.x) / (double)TileSize, (rays[ray].To.y - rays[ray].From.y) / (double)TileSize);
+        const double distance = (fraction < earliest ? earliest - fraction : fraction > latest ? fraction - latest : 0.0) * length;
+        worst = std::max(worst, distance);
+        mismatches += distance > Tolerance ? 1 : 0;
+    }
+
+    const double referenceTime = Elapsed(start);
+
+    printf("%u rays on %ux%u tiles with %u%% solid, %u hit\n", count, size, size, density, batchHits);
+    printf("%-12s %12.0f rays/ms\n", "Cast", count / castTime);
+    printf("%-12s %12.0f rays/ms\n", "CastBatch", count / batchTime);
+    printf("%-12s %12.0f rays/ms\n", "IsVisible", count / visibleTime);
+    printf("%-12s %12.0f rays/ms\n", "Reference", count / referenceTime);
+    printf("Worst distance from reference: %.4f tiles, %u rays further than %.4f tiles\n", worst, mismatches, Tolerance);
+
+    const bool consistent = castHits == batchHits && blocked == batchHits;
+
+    if (!consistent)
+    {
+        fprintf(stderr, "Cast, CastBatch and IsVisible disagree\n");
+    }
+
+    return consistent && mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+/** @brief Measures Skathi::Vdp1::Sprite batch writes in command tables per millisecond and checks written commands
+ * @details Build: g++ -std=c++20 -O2 -I../Host -o SpriteBenchmark SpriteBenchmark.cpp
+ * Usage: SpriteBenchmark [number of frames]
+ *
+ * Every frame a batch is filled with random normal, scaled and distorted sprites over 4 layers, 8 textures and 4 color banks,
+ * then sorted and written into a command buffer filled with garbage. Baseline writes the same sprites in the order they were
+ * added. Written commands have to be in layer order, keep order of sprites with the same key (as a stable sort by layer, texture
+ * and palette would), have only the command type set in the control word (no end, zoom point, flip or link bits) and match
+ * the sprites field by field. Report shows command tables per millisecond and number of texture or palette changes between
+ * neighbouring commands, which is what the sort saves. Exits with non-zero code when any command is wrong.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <yaul.h>
+#include "../../Dependencies/Skathi/VDP1/Vdp1.hpp"
+
+/** @brief Milliseconds elapsed since a time point
+ * @param start Start time
+ * @return Elapsed time
+ */
+static double Elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** @brief Make random sprite
+ * @param random Random generator
+ * @return Sprite
+ */
+static Skathi::Vdp1::Sprite::Instance RandomSprite(std::mt19937 & random)
+{
+    Skathi::Vdp1::Sprite::Instance sprite;
+    sprite.Kind = (Skathi::Vdp1::Sprite::Type)(random() % 3);
+    sprite.Layer = (uint8_t)(random() % 4);
+    sprite.DrawMode = (uint16_t)(random() & 0x00ff);
+    sprite.Color = (uint16_t)(64 + ((random() % 4) * 64));
+    sprite.Character = (uint16_t)(0x100 + ((random() % 8) * 0x80));
+    sprite.Size = (uint16_t)(0x0210);
+
+    for (uint8_t vertex = 0; vertex < 4; vertex++)
+    {
+        sprite.Vertices[vertex].x = (int16_t)(random() % 320) - 160;
+        sprite.Vertices[vertex].y = (int16_t)(random() % 224) - 112;
+    }
+
+    return sprite;
+}
+
+/** @brief Check command was written from the sprite
+ * @param sprite Sprite
+ * @param command Written command
+ * @return true Command matches the sprite
+ * @return false Command is wrong
+ */
+static bool Matches(const Skathi::Vdp1::Sprite::Instance * sprite, const vdp1_cmdt_t * command)
+{
+    bool matches = command->cmd_ctrl == (uint16_t)sprite->Kind &&
+        command->cmd_link == 0 &&
+        command->cmd_pmod == sprite->DrawMode &&
+        command->cmd_colr == sprite->Color &&
+        command->cmd_srca == sprite->Character &&
+        command->cmd_size == sprite->Size &&
+        command->cmd_xa == sprite->Vertices[0].x &&
+        command->cmd_ya == sprite->Vertices[0].y;
+
+    if (sprite->Kind == Skathi::Vdp1::Sprite::Type::Scaled)
+    {
+        matches = matches && command->cmd_xc == sprite->Vertices[1].x && command->cmd_yc == sprite->Vertices[1].y;
+    }
+    else if (sprite->Kind == Skathi::Vdp1::Sprite::Type::Distorted)
+    {
+        matches = matches &&
+            command->cmd_xb == sprite->Vertices[1].x && command->cmd_yb == sprite->Vertices[1].y &&
+            command->cmd_xc == sprite->Vertices[2].x && command->cmd_yc == sprite->Vertices[2].y &&
+            command->cmd_xd == sprite->Vertices[3].x && command->cmd_yd == sprite->Vertices[3].y;
+    }
+
+    return matches;
+}
+
+/** @brief Count texture or palette changes between neighbouring commands
+ * @param commands Commands
+ * @param count Number of commands
+ * @return Number of changes
+ */
+static uint32_t CountChanges(const vdp1_cmdt_t * commands, uint16_t count)
+{
+    uint32_t changes = 0;
+
+    for (uint16_t command = 1; command < count; command++)
+    {
+        changes += commands[command].cmd_srca != commands[command - 1].cmd_srca || commands[command].cmd_colr != commands[command - 1].cmd_colr ? 1 : 0;
+    }
+
+    return changes;
+}
+
+int main(int argc, char ** argv)
+{
+    const uint32_t frames = argc > 1 ? (uint32_t)atoi(argv[1]) : 2000;
+
+    if (frames == 0)
+    {
+        fprintf(stderr, "Usage: %s [number of frames]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%u frames per row\n", frames);
+    printf("%8s %14s %14s %10s %10s\n", "sprites", "batch cmd/ms", "direct cmd/ms", "changes", "unsorted");
+    std::mt19937 random(1);
+    uint32_t mismatches = 0;
+
+    for (uint16_t size = 64; size <= 1024; size <<= 1)
+    {
+        Skathi::Vdp1::Sprite batch(size);
+        std::vector<Skathi::Vdp1::Sprite::Instance> sprites(size);
+        std::vector<vdp1_cmdt_t> commands(size);
+        std::vector<vdp1_cmdt_t> direct(size);
+        std::vector<uint16_t> expected(size);
+        double batchTime = 0.0;
+        double directTime = 0.0;
+        uint64_t changes = 0;
+        uint64_t unsortedChanges = 0;
+
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            for (Skathi::Vdp1::Sprite::Instance & sprite : sprites)
+            {
+                sprite = RandomSprite(random);
+            }
+
+            // Leftovers of an older frame must not leak into the control word
+            memset(commands.data(), 0xff, size * sizeof(vdp1_cmdt_t));
+
+            auto start = std::chrono::steady_clock::now();
+            batch.Clear();
+            batch.Add(sprites.data(), size);
+            const uint16_t written = batch.Write(commands.data(), size);
+            batchTime += Elapsed(start);
+
+            start = std::chrono::steady_clock::now();
+
+            for (uint16_t sprite = 0; sprite < size; sprite++)
+            {
+                Skathi::Vdp1::Sprite::WriteCommand(&sprites[sprite], &direct[sprite]);
+            }
+
+            directTime += Elapsed(start);
+            changes += CountChanges(commands.data(), written);
+            unsortedChanges += CountChanges(direct.data(), size);
+
+            // Stable sort by layer, then texture, then palette
+            for (uint16_t sprite = 0; sprite < size; sprite++)
+            {
+                expected[sprite] = sprite;
+            }
+
+            std::stable_sort(expected.begin(), expected.end(), [&sprites](uint16_t first, uint16_t second)
+            {
+                const Skathi::Vdp1::Sprite::Instance & a = sprites[first];
+                const Skathi::Vdp1::Sprite::Instance & b = sprites[second];
+
+                if (a.Layer != b.Layer)
+                {
+                    return a.Layer < b.Layer;
+                }
+
+                // Palette part of the key is the color bank folded into a byte
+                const uint8_t paletteA = (a.Color & 0xff) ^ (a.Color >> 8);
+                const uint8_t paletteB = (b.Color & 0xff) ^ (b.Color >> 8);
+                return a.Character != b.Character ? a.Character < b.Character : paletteA < paletteB;
+            });
+
+            mismatches += written == size ? 0 : 1;
+
+            for (uint16_t command = 0; command < written; command++)
+            {
+                mismatches += Matches(&sprites[expected[command]], &commands[command]) ? 0 : 1;
+            }
+        }
+
+        printf("%8u %14.0f %14.0f %10.1f %10.1f\n",
+            size,
+            ((double)size * frames) / batchTime,
+            ((double)size * frames) / directTime,
+            (double)changes / frames,
+            (double)unsortedChanges / frames);
+    }
+
+    printf("%u wrong commands\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,727 @@
+/** @brief Converts true color TGA textures into color mapped TGA textures with a shared palette
+ * @details Build: g++ -std=c++17 -O2 -o TextureQuantizer TextureQuantizer.cpp
+ * Usage: TextureQuantizer [-c 16|256] [-d] [-r <first> <count>] <output directory> <input.tga> [input.tga ...]
+ *
+ *   -c 16                16 color palette, textures are loaded as 4bpp color bank textures by Skathi::Vdp1::TextureUtils
+ *   -c 256               256 color palette, textures are loaded as 8bpp color bank textures
+ *   -d                   Floyd-Steinberg dithering (used only when colors have to be reduced)
+ *   -r <first> <count>   Team ramp, gray pixels are reduced to count shades pinned to palette entries first to first + count - 1
+ *                        (brightest first), other colors never use these entries (see Rendering::TeamColors)
+ *
+ * Without -c the smallest palette that holds all colors is picked, 256 colors are used when colors have to be reduced.
+ * All inputs share one palette (median cut over colors of all images), color 0 is reserved for transparent pixels.
+ * Outputs are uncompressed 8bpp color mapped TGA files with the same name as the inputs.
+ */
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+/** @brief Decoded image
+ */
+struct Image
+{
+    /** @brief Image width
+     */
+    int Width = 0;
+
+    /** @brief Image height
+     */
+    int Height = 0;
+
+    /** @brief Pixels as RGB555 with bit 15 set for opaque pixels (row major, top to bottom)
+     */
+    std::vector<uint16_t> Pixels;
+};
+
+/** @brief Convert 8 bit per channel color to RGB555
+ * @param r Red
+ * @param g Green
+ * @param b Blue
+ * @param a Alpha
+ * @return Saturn color with bit 15 set when opaque
+ */
+static uint16_t ToRgb555(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+    if (a < 0x80)
+    {
+        return 0;
+    }
+
+    return 0x8000 | ((b >> 3) << 10) | ((g >> 3) << 5) | (r >> 3);
+}
+
+/** @brief Decode single TGA color value
+ * @param data Color data
+ * @param bits Bits per color
+ * @return Saturn color
+ */
+static uint16_t DecodeColor(const uint8_t * data, int bits)
+{
+    switch (bits)
+    {
+    case 15:
+    case 16:
+    {
+        // Attribute bit is often left clear by paint programs, so 16 bit colors are always opaque
+        const uint16_t value = data[0] | (data[1] << 8);
+        return ToRgb555(((value >> 10) & 0x1f) << 3, ((value >> 5) & 0x1f) << 3, (value & 0x1f) << 3, 0xff);
+    }
+
+    case 24:
+        return ToRgb555(data[2], data[1], data[0], 0xff);
+
+    case 32:
+        return ToRgb555(data[2], data[1], data[0], data[3]);
+
+    default:
+        return 0;
+    }
+}
+
+/** @brief Load TGA image
+ * @param path File path
+ * @param image Decoded image
+ * @return true Image was loaded
+ * @return false File is missing or in unsupported format
+ */
+static bool LoadTga(const std::string & path, Image & image)
+{
+    std::ifstream stream(path, std::ios::binary);
+
+    if (!stream)
+    {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    if (file.size() < 18)
+    {
+        fprintf(stderr, "%s is not a TGA file\n", path.c_str());
+        return false;
+    }
+
+    const uint8_t idLength = file[0];
+    const uint8_t type = file[2];
+    const int mapFirst = file[3] | (file[4] << 8);
+    const int mapLength = file[5] | (file[6] << 8);
+    const int mapBits = file[7];
+    const int bits = file[16];
+    const bool topDown = (file[17] & 0x20) != 0;
+    image.Width = file[12] | (file[13] << 8);
+    image.Height = file[14] | (file[15] << 8);
+
+    const bool mapped = type == 1 || type == 9;
+    const bool rle = type == 9 || type == 10;
+
+    if ((!mapped && type != 2 && type != 10) || (mapped && bits != 8) || (!mapped && bits != 16 && bits != 24 && bits != 32))
+    {
+        fprintf(stderr, "%s: unsupported TGA type %d with %d bits per pixel\n", path.c_str(), type, bits);
+        return false;
+    }
+
+    size_t offset = 18 + idLength;
+    std::vector<uint16_t> palette;
+
+    if (file[1] != 0)
+    {
+        const int mapBytes = (mapBits + 7) / 8;
+        palette.resize(mapFirst + mapLength, 0);
+
+        if (offset + ((size_t)mapLength * mapBytes) > file.size())
+        {
+            fprintf(stderr, "%s: unexpected end of file\n", path.c_str());
+            return false;
+        }
+
+        for (int entry = 0; entry < mapLength; entry++, offset += mapBytes)
+        {
+            palette[mapFirst + entry] = DecodeColor(&file[offset], mapBits);
+        }
+    }
+
+    const int pixelBytes = bits / 8;
+    const size_t count = (size_t)image.Width * image.Height;
+    std::vector<uint16_t> pixels;
+    pixels.reserve(count);
+
+    auto decode = [&](size_t at) -> uint16_t
+    {
+        if (mapped)
+        {
+            return file[at] < palette.size() ? palette[file[at]] : 0;
+        }
+
+        return DecodeColor(&file[at], bits);
+    };
+
+    while (pixels.size() < count)
+    {
+        if (offset >= file.size())
+        {
+            fprintf(stderr, "%s: unexpected end of file\n", path.c_str());
+            return false;
+        }
+
+        if (!rle)
+        {
+            if (offset + pixelBytes > file.size())
+            {
+                fprintf(stderr, "%s: unexpected end of file\n", path.c_str());
+                return false;
+            }
+
+            pixels.push_back(decode(offset));
+            offset += pixelBytes;
+            continue;
+        }
+
+        const uint8_t packet = file[offset++];
+        const size_t length = (packet & 0x7f) + 1;
+
+        if (offset + (pixelBytes * ((packet & 0x80) != 0 ? 1 : length)) > file.size())
+        {
+            fprintf(stderr, "%s: unexpected end of file\n", path.c_str());
+            return false;
+        }
+
+        if ((packet & 0x80) != 0)
+        {
+            const uint16_t color = decode(offset);
+            offset += pixelBytes;
+            pixels.insert(pixels.end(), length, color);
+        }
+        else
+        {
+            for (size_t pixel = 0; pixel < length; pixel++, offset += pixelBytes)
+            {
+                pixels.push_back(decode(offset));
+            }
+        }
+    }
+
+    pixels.resize(count);
+    image.Pixels.resize(count);
+
+    for (int y = 0; y < image.Height; y++)
+    {
+        const int source = topDown ? y : image.Height - 1 - y;
+        std::copy(pixels.begin() + ((size_t)source * image.Width), pixels.begin() + ((size_t)(source + 1) * image.Width), image.Pixels.begin() + ((size_t)y * image.Width));
+    }
+
+    return true;
+}
+
+/** @brief Largest difference between channels of a color that still counts as gray
+ */
+static constexpr int GrayTolerance = 2;
+
+/** @brief Color with its number of occurrences
+ */
+struct Sample
+{
+    /** @brief Color channels (red, green, blue, 5 bits each)
+     */
+    std::array<int, 3> Channels;
+
+    /** @brief Number of pixels of this color
+     */
+    size_t Count;
+};
+
+/** @brief Split channels of RGB555 color
+ * @param color Saturn color
+ * @return Red, green and blue channels
+ */
+static std::array<int, 3> GetChannels(uint16_t color)
+{
+    return { color & 0x1f, (color >> 5) & 0x1f, (color >> 10) & 0x1f };
+}
+
+/** @brief Join channels into opaque RGB555 color
+ * @param channels Red, green and blue channels
+ * @return Saturn color
+ */
+static uint16_t FromChannels(const std::array<int, 3> & channels)
+{
+    return 0x8000 | (channels[2] << 10) | (channels[1] << 5) | channels[0];
+}
+
+/** @brief Check whether color is a shade of gray
+ * @param color Saturn color
+ * @return true Channels are (almost) equal
+ * @return false Color is tinted
+ */
+static bool IsGray(uint16_t color)
+{
+    const std::array<int, 3> channels = GetChannels(color);
+    return *std::max_element(channels.begin(), channels.end()) - *std::min_element(channels.begin(), channels.end()) <= GrayTolerance;
+}
+
+/** @brief Get brightness of a color
+ * @param color Saturn color
+ * @return Sum of channels
+ */
+static int GetBrightness(uint16_t color)
+{
+    const std::array<int, 3> channels = GetChannels(color);
+    return channels[0] + channels[1] + channels[2];
+}
+
+/** @brief Reduce colors with median cut
+ * @param samples Distinct colors of all images
+ * @param colors Number of palette colors to create
+ * @return Opaque palette colors
+ */
+static std::vector<uint16_t> MedianCut(std::vector<Sample> samples, size_t colors)
+{
+    // Each box is a range of samples
+    std::vector<std::pair<size_t, size_t>> boxes = { { 0, samples.size() } };
+
+    while (boxes.size() < colors)
+    {
+        // Split box with the largest channel range weighted by its pixel count
+        size_t best = boxes.size();
+        int bestChannel = 0;
+        double bestScore = 0.0;
+
+        for (size_t box = 0; box < boxes.size(); box++)
+        {
+            if (boxes[box].second - boxes[box].first < 2)
+            {
+                continue;
+            }
+
+            std::array<int, 3> low = { 31, 31, 31 };
+            std::array<int, 3> high = { 0, 0, 0 };
+            size_t count = 0;
+
+            for (size_t sample = boxes[box].first; sample < boxes[box].second; sample++)
+            {
+                for (int channel = 0; channel < 3; channel++)
+                {
+                    low[channel] = std::min(low[channel], samples[sample].Channels[channel]);
+                    high[channel] = std::max(high[channel], samples[sample].Channels[channel]);
+                }
+
+                count += samples[sample].Count;
+            }
+
+            for (int channel = 0; channel < 3; channel++)
+            {
+                const double score = (double)(high[channel] - low[channel]) * count;
+
+                if (high[channel] > low[channel] && score > bestScore)
+                {
+                    best = box;
+                    bestChannel = channel;
+                    bestScore = score;
+                }
+            }
+        }
+
+        if (best == boxes.size())
+        {
+            break;
+        }
+
+        // Split at weighted median of the widest channel
+        const size_t first = boxes[best].first;
+        const size_t last = boxes[best].second;
+        std::sort(samples.begin() + first, samples.begin() + last, [bestChannel](const Sample & a, const Sample & b)
+        {
+            return a.Channels[bestChannel] < b.Channels[bestChannel];
+        });
+
+        size_t total = 0;
+
+        for (size_t sample = first; sample < last; sample++)
+        {
+            total += samples[sample].Count;
+        }
+
+        size_t split = first + 1;
+
+        for (size_t sum = samples[first].Count; split < last - 1 && sum * 2 < total; split++)
+        {
+            sum += samples[split].Count;
+        }
+
+        boxes[best].second = split;
+        boxes.push_back({ split, last });
+    }
+
+    std::vector<uint16_t> palette;
+
+    for (const std::pair<size_t, size_t> & box : boxes)
+    {
+        std::array<double, 3> sum = { 0.0, 0.0, 0.0 };
+        size_t count = 0;
+
+        for (size_t sample = box.first; sample < box.second; sample++)
+        {
+            for (int channel = 0; channel < 3; channel++)
+            {
+                sum[channel] += (double)samples[sample].Channels[channel] * samples[sample].Count;
+            }
+
+            count += samples[sample].Count;
+        }
+
+        std::array<int, 3> average;
+
+        for (int channel = 0; channel < 3; channel++)
+        {
+            average[channel] = std::clamp((int)((sum[channel] / count) + 0.5), 0, 31);
+        }
+
+        palette.push_back(FromChannels(average));
+    }
+
+    return palette;
+}
+
+/** @brief Pick palette colors for a set of colors
+ * @param histogram Colors with their number of occurrences
+ * @param colors Maximum number of palette colors
+ * @param exact Set to false when colors had to be reduced
+ * @return Opaque palette colors
+ */
+static std::vector<uint16_t> PickColors(const std::map<uint16_t, size_t> & histogram, size_t colors, bool & exact)
+{
+    std::vector<uint16_t> picked;
+
+    if (colors == 0)
+    {
+        exact = histogram.empty();
+        return picked;
+    }
+
+    if (histogram.size() <= colors)
+    {
+        for (const std::pair<const uint16_t, size_t> & entry : histogram)
+        {
+            picked.push_back(entry.first);
+        }
+
+        return picked;
+    }
+
+    std::vector<Sample> samples;
+
+    for (const std::pair<const uint16_t, size_t> & entry : histogram)
+    {
+        samples.push_back({ GetChannels(entry.first), entry.second });
+    }
+
+    exact = false;
+    return MedianCut(samples, colors);
+}
+
+/** @brief Find nearest palette color
+ * @param palette Palette
+ * @param entries Palette entries the color can be mapped to
+ * @param channels Color channels
+ * @return Palette index
+ */
+static uint8_t FindNearest(const std::vector<uint16_t> & palette, const std::vector<uint8_t> & entries, const std::array<int, 3> & channels)
+{
+    uint8_t nearest = entries.front();
+    int nearestDistance = 1 << 30;
+
+    for (const uint8_t index : entries)
+    {
+        const std::array<int, 3> entry = GetChannels(palette[index]);
+        const int r = entry[0] - channels[0];
+        const int g = entry[1] - channels[1];
+        const int b = entry[2] - channels[2];
+        const int distance = (r * r) + (g * g) + (b * b);
+
+        if (distance < nearestDistance)
+        {
+            nearest = index;
+            nearestDistance = distance;
+        }
+    }
+
+    return nearest;
+}
+
+/** @brief Map image pixels to palette indices
+ * @param image Source image
+ * @param palette Palette (entry 0 is transparent)
+ * @param ramp Palette entries of the team ramp gray pixels are mapped to (empty without team ramp)
+ * @param other Palette entries all other pixels are mapped to
+ * @param dither Diffuse quantization error to neighbouring pixels
+ * @return Palette index of each pixel (row major, top to bottom)
+ */
+static std::vector<uint8_t> MapPixels(const Image & image, const std::vector<uint16_t> & palette, const std::vector<uint8_t> & ramp, const std::vector<uint8_t> & other, bool dither)
+{
+    std::vector<uint8_t> indices(image.Pixels.size(), 0);
+    std::map<uint16_t, uint8_t> cache;
+
+    // Error of current and next row in 1/16 of a channel step
+    std::vector<std::array<int, 3>> error[2];
+    error[0].assign(image.Width + 2, { 0, 0, 0 });
+    error[1].assign(image.Width + 2, { 0, 0, 0 });
+
+    for (int y = 0; y < image.Height; y++)
+    {
+        std::vector<std::array<int, 3>> & current = error[y & 1];
+        std::vector<std::array<int, 3>> & next = error[(y + 1) & 1];
+        std::fill(next.begin(), next.end(), std::array<int, 3> { 0, 0, 0 });
+
+        for (int x = 0; x < image.Width; x++)
+        {
+            const size_t pixel = ((size_t)y * image.Width) + x;
+            const uint16_t color = image.Pixels[pixel];
+
+            // Transparent pixels do not take or pass any error
+            if ((color & 0x8000) == 0)
+            {
+                continue;
+            }
+
+            // Gray pixels stay on the team ramp, tinted pixels stay off it
+            const std::vector<uint8_t> & entries = !ramp.empty() && (IsGray(color) || other.empty()) ? ramp : other;
+
+            if (!dither)
+            {
+                auto found = cache.find(color);
+
+                if (found == cache.end())
+                {
+                    found = cache.emplace(color, FindNearest(palette, entries, GetChannels(color))).first;
+                }
+
+                indices[pixel] = found->second;
+                continue;
+            }
+
+            std::array<int, 3> wanted = GetChannels(color);
+
+            for (int channel = 0; channel < 3; channel++)
+            {
+                wanted[channel] = std::clamp(wanted[channel] + ((current[x + 1][channel] + 8) >> 4), 0, 31);
+            }
+
+            const uint8_t index = FindNearest(palette, entries, wanted);
+            const std::array<int, 3> got = GetChannels(palette[index]);
+            indices[pixel] = index;
+
+            for (int channel = 0; channel < 3; channel++)
+            {
+                const int difference = (wanted[channel] - got[channel]) * 16;
+                current[x + 2][channel] += (difference * 7) / 16;
+                next[x][channel] += (difference * 3) / 16;
+                next[x + 1][channel] += (difference * 5) / 16;
+                next[x + 2][channel] += difference / 16;
+            }
+        }
+    }
+
+    return indices;
+}
+
+/** @brief Save color mapped TGA (uncompressed, 24 bit palette, bottom to top)
+ * @param path File path
+ * @param image Source image
+ * @param palette Palette
+ * @param indices Palette index of each pixel
+ * @return true File was written
+ * @return false File could not be written
+ */
+static bool SaveTga(const std::string & path, const Image & image, const std::vector<uint16_t> & palette, const std::vector<uint8_t> & indices)
+{
+    std::vector<uint8_t> file(18, 0);
+    file[1] = 1;
+    file[2] = 1;
+    file[5] = palette.size() & 0xff;
+    file[6] = palette.size() >> 8;
+    file[7] = 24;
+    file[12] = image.Width & 0xff;
+    file[13] = image.Width >> 8;
+    file[14] = image.Height & 0xff;
+    file[15] = image.Height >> 8;
+    file[16] = 8;
+
+    for (uint16_t color : palette)
+    {
+        const std::array<int, 3> channels = GetChannels(color);
+        file.push_back((uint8_t)(channels[2] << 3));
+        file.push_back((uint8_t)(channels[1] << 3));
+        file.push_back((uint8_t)(channels[0] << 3));
+    }
+
+    for (int y = image.Height - 1; y >= 0; y--)
+    {
+        file.insert(file.end(), indices.begin() + ((size_t)y * image.Width), indices.begin() + ((size_t)(y + 1) * image.Width));
+    }
+
+    std::ofstream stream(path, std::ios::binary);
+    stream.write((const char*)file.data(), file.size());
+    return (bool)stream;
+}
+
+int main(int argc, char ** argv)
+{
+    size_t colors = 0;
+    bool dither = false;
+    size_t rampFirst = 0;
+    size_t rampCount = 0;
+    int argument = 1;
+
+    for (; argument < argc && argv[argument][0] == '-'; argument++)
+    {
+        if (strcmp(argv[argument], "-d") == 0)
+        {
+            dither = true;
+        }
+        else if (strcmp(argv[argument], "-c") == 0 && argument + 1 < argc)
+        {
+            colors = (size_t)atoi(argv[++argument]);
+        }
+        else if (strcmp(argv[argument], "-r") == 0 && argument + 2 < argc)
+        {
+            rampFirst = (size_t)atoi(argv[++argument]);
+            rampCount = (size_t)atoi(argv[++argument]);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argc - argument < 2 || (colors != 0 && colors != 16 && colors != 256) || (rampFirst == 0) != (rampCount == 0))
+    {
+        fprintf(stderr, "Usage: %s [-c 16|256] [-d] [-r <first> <count>] <output directory> <input.tga> [input.tga ...]\n", argv[0]);
+        return 1;
+    }
+
+    const std::string output = argv[argument++];
+    std::vector<std::string> paths(argv + argument, argv + argc);
+    std::vector<Image> images(paths.size());
+    std::map<uint16_t, size_t> histogram;
+
+    for (size_t image = 0; image < paths.size(); image++)
+    {
+        if (!LoadTga(paths[image], images[image]))
+        {
+            return 1;
+        }
+
+        if (images[image].Width % 8 != 0)
+        {
+            fprintf(stderr, "%s: VDP1 texture width has to be a multiple of 8\n", paths[image].c_str());
+            return 1;
+        }
+
+        for (uint16_t color : images[image].Pixels)
+        {
+            if ((color & 0x8000) != 0)
+            {
+                histogram[color]++;
+            }
+        }
+    }
+
+    // Team ramp takes gray colors, the rest of the palette takes the others
+    std::map<uint16_t, size_t> grays;
+    std::map<uint16_t, size_t> others;
+
+    for (const std::pair<const uint16_t, size_t> & entry : histogram)
+    {
+        (rampCount != 0 && IsGray(entry.first) ? grays : others)[entry.first] = entry.second;
+    }
+
+    // Pick smallest palette that keeps all colors, color 0 is transparent
+    if (colors == 0)
+    {
+        const size_t needed = rampCount != 0 ? std::max(rampFirst + rampCount, 1 + rampCount + others.size()) : 1 + histogram.size();
+        colors = needed <= 16 ? 16 : 256;
+    }
+
+    if (rampFirst + rampCount > colors)
+    {
+        fprintf(stderr, "Team ramp does not fit into %zu color palette\n", colors);
+        return 1;
+    }
+
+    bool exact = true;
+    std::vector<uint16_t> palette = { 0 };
+    std::vector<uint8_t> rampEntries;
+    std::vector<uint8_t> otherEntries;
+    std::vector<uint16_t> other = PickColors(others, colors - 1 - rampCount, exact);
+
+    if (rampCount != 0)
+    {
+        // Ramp goes from the brightest shade, missing shades repeat the darkest one
+        std::vector<uint16_t> ramp = PickColors(grays, rampCount, exact);
+        std::sort(ramp.begin(), ramp.end(), [](uint16_t a, uint16_t b)
+        {
+            return GetBrightness(a) > GetBrightness(b);
+        });
+
+        ramp.resize(rampCount, ramp.empty() ? 0x8000 : ramp.back());
+
+        // Entries in front of the ramp are filled with other colors first, unused ones stay black
+        const size_t before = std::min(other.size(), rampFirst - 1);
+        palette.insert(palette.end(), other.begin(), other.begin() + before);
+        palette.resize(rampFirst, 0x8000);
+        palette.insert(palette.end(), ramp.begin(), ramp.end());
+        palette.insert(palette.end(), other.begin() + before, other.end());
+
+        for (size_t entry = 1; entry < palette.size(); entry++)
+        {
+            const bool inRamp = entry >= rampFirst && entry < rampFirst + rampCount;
+
+            if (inRamp || entry <= before || entry >= rampFirst + rampCount)
+            {
+                (inRamp ? rampEntries : otherEntries).push_back((uint8_t)entry);
+            }
+        }
+    }
+    else
+    {
+        palette.insert(palette.end(), other.begin(), other.end());
+
+        for (size_t entry = 1; entry < palette.size(); entry++)
+        {
+            otherEntries.push_back((uint8_t)entry);
+        }
+    }
+
+    for (size_t image = 0; image < images.size(); image++)
+    {
+        const std::vector<uint8_t> indices = MapPixels(images[image], palette, rampEntries, otherEntries, dither && !exact);
+        const size_t slash = paths[image].find_last_of("/\\");
+        const std::string path = output + "/" + (slash == std::string::npos ? paths[image] : paths[image].substr(slash + 1));
+
+        if (!SaveTga(path, images[image], palette, indices))
+        {
+            fprintf(stderr, "Cannot write %s\n", path.c_str());
+            return 1;
+        }
+
+        const size_t pixels = images[image].Pixels.size();
+        printf("%s: %dx%d, %zu -> %zu bytes of VDP1 memory\n", path.c_str(), images[image].Width, images[image].Height, pixels * 2, colors == 16 ? pixels / 2 : pixels);
+    }
+
+    printf("%zu colors in %zu palette entries%s\n", histogram.size(), palette.size() - 1, exact ? "" : (dither ? " (reduced, dithered)" : " (reduced)"));
+
+    if (rampCount != 0)
+    {
+        printf("%zu gray colors in team ramp entries %zu to %zu\n", grays.size(), rampFirst, rampFirst + rampCount - 1);
+    }
+
+    return 0;
+}
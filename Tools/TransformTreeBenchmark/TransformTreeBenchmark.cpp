@@ -0,0 +1,152 @@
+/** @brief Measures Utenyaa::Simulation::TransformTree update cost against the number of changed nodes
+ * @details Build: g++ -std=c++20 -O2 -I../Host -o TransformTreeBenchmark TransformTreeBenchmark.cpp
+ * Usage: TransformTreeBenchmark [number of frames]
+ *
+ * Node capacity is raised to 4096 for the benchmark, the game tree holds only a few tanks, so cost of tracking changed nodes shows
+ * only at larger sizes. Tree is filled with tanks of four nodes (hull with turret and barrel, and a track node on the hull) up to the capacity.
+ * Each frame random nodes get new local transforms, then Update is timed. World matrices are checked after every update against
+ * a full recompute of all nodes from their local transforms, which is also timed as the baseline. Update should only touch
+ * the changed nodes and their children, so its cost grows with the number of changed nodes instead of the tree size.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <yaul.h>
+#include "../../src/constants.hpp"
+
+#undef TRANSFORM_NODE_CAPACITY
+#define TRANSFORM_NODE_CAPACITY (4096)
+
+#include "../../src/Simulation/TransformTree.hpp"
+
+/** @brief Number of nodes of a tank
+ */
+static constexpr uint16_t NodesPerTank = 4;
+
+/** @brief Nanoseconds elapsed since a time point
+ * @param start Start time
+ * @return Elapsed time
+ */
+static double Elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** @brief Make random local transform (rotation part within one unit, translation within eight units)
+ * @param random Random generator
+ * @return Transform
+ */
+static fix16_mat43_t RandomTransform(std::mt19937 & random)
+{
+    fix16_mat43_t transform;
+
+    for (int row = 0; row < 3; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            const fix16_t range = column == 3 ? FIX16(8.0f) : FIX16_ONE;
+            transform.frow[row][column] = (fix16_t)(random() % (2 * (uint32_t)range)) - range;
+        }
+    }
+
+    return transform;
+}
+
+int main(int argc, char ** argv)
+{
+    const uint32_t frames = argc > 1 ? (uint32_t)atoi(argv[1]) : 2000;
+
+    if (frames == 0)
+    {
+        fprintf(stderr, "Usage: %s [number of frames]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937 random(1);
+    Utenyaa::Simulation::TransformTree::Initialize();
+
+    // Parents are added before children, so handle order is also a valid order for the full recompute
+    std::vector<uint16_t> handles;
+    std::vector<uint16_t> parents;
+
+    for (uint16_t tank = 0; tank < TRANSFORM_NODE_CAPACITY / NodesPerTank; tank++)
+    {
+        const fix16_mat43_t hullTransform = RandomTransform(random);
+        const uint16_t hull = Utenyaa::Simulation::TransformTree::Add(Utenyaa::Simulation::TransformTree::None, &hullTransform);
+        const fix16_mat43_t turretTransform = RandomTransform(random);
+        const uint16_t turret = Utenyaa::Simulation::TransformTree::Add(hull, &turretTransform);
+        const fix16_mat43_t barrelTransform = RandomTransform(random);
+        const uint16_t barrel = Utenyaa::Simulation::TransformTree::Add(turret, &barrelTransform);
+        const fix16_mat43_t trackTransform = RandomTransform(random);
+        const uint16_t track = Utenyaa::Simulation::TransformTree::Add(hull, &trackTransform);
+
+        handles.insert(handles.end(), { hull, turret, barrel, track });
+        parents.insert(parents.end(), { Utenyaa::Simulation::TransformTree::None, hull, turret, hull });
+    }
+
+    const uint16_t nodes = (uint16_t)handles.size();
+    std::vector<fix16_mat43_t> reference(TRANSFORM_NODE_CAPACITY);
+    Utenyaa::Simulation::TransformTree::Update();
+
+    printf("%u nodes, %u frames per row\n", nodes, frames);
+    printf("%8s %10s %12s %14s %8s\n", "changed", "computed", "update ns", "full ns", "ratio");
+    bool matches = true;
+
+    for (uint16_t changed = 0; changed <= nodes; changed = changed == 0 ? 1 : changed << 1)
+    {
+        double updateTime = 0.0;
+        double fullTime = 0.0;
+        uint64_t computed = 0;
+
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            for (uint16_t change = 0; change < changed; change++)
+            {
+                const fix16_mat43_t transform = RandomTransform(random);
+                Utenyaa::Simulation::TransformTree::SetLocal(handles[random() % nodes], &transform);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            Utenyaa::Simulation::TransformTree::Update();
+            updateTime += Elapsed(start);
+            computed += Utenyaa::Simulation::TransformTree::GetComputed();
+
+            // Baseline recomputes every node whether it changed or not
+            start = std::chrono::steady_clock::now();
+
+            for (uint16_t node = 0; node < nodes; node++)
+            {
+                const fix16_mat43_t * local = Utenyaa::Simulation::TransformTree::GetLocal(handles[node]);
+
+                if (parents[node] == Utenyaa::Simulation::TransformTree::None)
+                {
+                    reference[handles[node]] = *local;
+                }
+                else
+                {
+                    fix16_mat43_mul(&reference[parents[node]], local, &reference[handles[node]]);
+                }
+            }
+
+            fullTime += Elapsed(start);
+
+            for (uint16_t node = 0; node < nodes; node++)
+            {
+                matches = matches && memcmp(Utenyaa::Simulation::TransformTree::GetWorld(handles[node]), &reference[handles[node]], sizeof(fix16_mat43_t)) == 0;
+            }
+        }
+
+        printf("%8u %10.1f %12.1f %14.1f %8.2f\n",
+            changed,
+            (double)computed / frames,
+            updateTime / frames,
+            fullTime / frames,
+            fullTime > 0.0 ? updateTime / fullTime : 0.0);
+    }
+
+    printf("World matrices %s full recompute\n", matches ? "match" : "DO NOT match");
+    return matches ? 0 : 1;
+}
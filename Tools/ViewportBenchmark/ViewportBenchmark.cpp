@@ -0,0 +1,279 @@
+/** @brief Measures frame cost of Utenyaa::Rendering::Viewports split-screen for 1 to 4 viewports
+ * @details Build: g++ -std=c++20 -O2 -I../Host -o ViewportBenchmark ViewportBenchmark.cpp
+ * Usage: ViewportBenchmark [number of frames] [number of entities]
+ *
+ * Entities are spread over the arena, first four of them are players wandering around with a viewport camera above each one.
+ * Every frame cameras are moved, all entities are put into a visibility grid once (as TankRenderSystem does), then each
+ * viewport writes its clipping and local coordinate commands and a sprite command for every entity in grid cells it covers.
+ * Baseline tests all entities against each viewport. Camera math is not measured, host mic3d does not compute view matrices.
+ * Report shows bounds tests per frame and cost of N viewports compared to N times the cost of a single viewport with culling
+ * of all entities. Both paths have to write the same commands for each viewport (order of sprites inside of a viewport
+ * follows grid cells, so commands are compared sorted). Exits with non-zero code when they do not.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <yaul.h>
+#include "../../src/Rendering/Viewports.hpp"
+#include "../../src/Rendering/VisibilityGrid.hpp"
+
+/** @brief Half size of the arena in world units
+ */
+static constexpr fix16_t ArenaHalfSize = FIX16(64.0f);
+
+/** @brief Number of players
+ */
+static constexpr uint8_t Players = 4;
+
+/** @brief Largest number of entities
+ */
+static constexpr uint16_t MaxEntities = 8192;
+
+/** @brief Visibility grid of entity indices
+ */
+using Grid = Utenyaa::Rendering::VisibilityGrid<uint16_t, MaxEntities>;
+
+/** @brief Microseconds elapsed since a time point
+ * @param start Start time
+ * @return Elapsed time
+ */
+static double Elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** @brief Screen projection of a viewport
+ */
+struct Projection
+{
+    /** @brief Visible ground center X
+     */
+    fix16_t CenterX;
+
+    /** @brief Visible ground center Y
+     */
+    fix16_t CenterY;
+
+    /** @brief Pixels per world unit along X axis
+     */
+    fix16_t ScaleX;
+
+    /** @brief Pixels per world unit along Y axis
+     */
+    fix16_t ScaleY;
+};
+
+/** @brief Get screen projection of a viewport
+ * @param viewport Viewport
+ * @return Projection
+ */
+static Projection GetProjection(const Utenyaa::Rendering::Viewports::Viewport * viewport)
+{
+    return {
+        CenterX : (viewport->Bounds[0] + viewport->Bounds[2]) >> 1,
+        CenterY : (viewport->Bounds[1] + viewport->Bounds[3]) >> 1,
+        ScaleX : fix16_div(fix16_int32_from(viewport->Right - viewport->Left + 1), viewport->HalfWidth << 1),
+        ScaleY : fix16_div(fix16_int32_from(viewport->Bottom - viewport->Top + 1), viewport->HalfHeight << 1)
+    };
+}
+
+/** @brief Write scaled sprite command of an entity
+ * @param projection Viewport projection
+ * @param position Entity position
+ * @param command Written command
+ */
+static void Draw(const Projection * projection, const fix16_vec3_t * position, vdp1_cmdt_t * command)
+{
+    const int16_t x = fix16_int32_to(fix16_mul(position->x - projection->CenterX, projection->ScaleX));
+    const int16_t y = fix16_int32_to(fix16_mul(position->y - projection->CenterY, projection->ScaleY));
+    command->cmd_ctrl = 0x0001;
+    command->cmd_link = 0;
+    command->cmd_xa = x - 8;
+    command->cmd_ya = y - 8;
+    command->cmd_xc = x + 8;
+    command->cmd_yc = y + 8;
+}
+
+/** @brief Move players and viewport cameras above them
+ * @param positions Entity positions, players come first
+ * @param random Random generator
+ */
+static void MovePlayers(std::vector<fix16_vec3_t> & positions, std::mt19937 & random)
+{
+    for (uint8_t player = 0; player < Players; player++)
+    {
+        fix16_vec3_t * position = &positions[player];
+        position->x = std::clamp(position->x + (fix16_t)(random() % FIX16(1.0f)) - FIX16(0.5f), -ArenaHalfSize, ArenaHalfSize);
+        position->y = std::clamp(position->y + (fix16_t)(random() % FIX16(1.0f)) - FIX16(0.5f), -ArenaHalfSize, ArenaHalfSize);
+
+        if (player < Utenyaa::Rendering::Viewports::GetCount())
+        {
+            Utenyaa::Rendering::Viewports::SetFocus(player, position);
+        }
+    }
+}
+
+/** @brief Render all viewports after entities are put into the visibility grid once
+ * @param positions Entity positions
+ * @param grid Visibility grid
+ * @param commands Command list
+ * @param ends End of commands of each viewport
+ * @param tested Number of bounds tests
+ * @return Number of written commands
+ */
+static uint32_t RenderShared(const std::vector<fix16_vec3_t> & positions, Grid * grid, vdp1_cmdt_t * commands, uint32_t * ends, uint64_t * tested)
+{
+    const uint32_t entities = (uint32_t)positions.size();
+    uint32_t count = 0;
+    grid->Clear();
+
+    for (uint32_t entity = 0; entity < entities; entity++)
+    {
+        grid->Insert(&positions[entity], (uint16_t)entity);
+    }
+
+    for (uint8_t viewport = 0; viewport < Utenyaa::Rendering::Viewports::GetCount(); viewport++)
+    {
+        const Utenyaa::Rendering::Viewports::Viewport * view = Utenyaa::Rendering::Viewports::Get(viewport);
+        Utenyaa::Rendering::Viewports::Begin(viewport, &commands[count]);
+        const Projection projection = GetProjection(view);
+        count += 2;
+
+        *tested += grid->Query(view->Bounds, VIEWPORT_CULL_RADIUS, [&](const uint16_t * entity)
+        {
+            Draw(&projection, &positions[*entity], &commands[count++]);
+        });
+
+        ends[viewport] = count;
+    }
+
+    return count;
+}
+
+/** @brief Render all viewports, each one tests all entities on its own
+ * @param positions Entity positions
+ * @param commands Command list
+ * @return Number of written commands
+ */
+static uint32_t RenderSeparate(const std::vector<fix16_vec3_t> & positions, vdp1_cmdt_t * commands)
+{
+    const uint32_t entities = (uint32_t)positions.size();
+    uint32_t count = 0;
+
+    for (uint8_t viewport = 0; viewport < Utenyaa::Rendering::Viewports::GetCount(); viewport++)
+    {
+        Utenyaa::Rendering::Viewports::Begin(viewport, &commands[count]);
+        const Utenyaa::Rendering::Viewports::Viewport * view = Utenyaa::Rendering::Viewports::Get(viewport);
+        const Projection projection = GetProjection(view);
+        count += 2;
+
+        for (uint32_t entity = 0; entity < entities; entity++)
+        {
+            const fix16_vec3_t * position = &positions[entity];
+
+            if (position->x + VIEWPORT_CULL_RADIUS >= view->Bounds[0] &&
+                position->y + VIEWPORT_CULL_RADIUS >= view->Bounds[1] &&
+                position->x - VIEWPORT_CULL_RADIUS <= view->Bounds[2] &&
+                position->y - VIEWPORT_CULL_RADIUS <= view->Bounds[3])
+            {
+                Draw(&projection, position, &commands[count++]);
+            }
+        }
+    }
+
+    return count;
+}
+
+/** @brief Sort sprite commands of each viewport, so lists written in different order can be compared
+ * @param commands Command list
+ * @param ends End of commands of each viewport
+ * @param viewports Number of viewports
+ */
+static void SortViewports(vdp1_cmdt_t * commands, const uint32_t * ends, uint8_t viewports)
+{
+    uint32_t start = 0;
+
+    for (uint8_t viewport = 0; viewport < viewports; viewport++)
+    {
+        std::sort(commands + start + 2, commands + ends[viewport], [](const vdp1_cmdt_t & first, const vdp1_cmdt_t & second)
+        {
+            return memcmp(&first, &second, sizeof(vdp1_cmdt_t)) < 0;
+        });
+
+        start = ends[viewport];
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const uint32_t frames = argc > 1 ? (uint32_t)atoi(argv[1]) : 2000;
+    const uint32_t entities = argc > 2 ? (uint32_t)atoi(argv[2]) : 1024;
+
+    if (frames == 0 || entities < Players || entities > MaxEntities)
+    {
+        fprintf(stderr, "Usage: %s [number of frames] [number of entities (%u to %u)]\n", argv[0], Players, MaxEntities);
+        return 1;
+    }
+
+    static Grid grid;
+    std::vector<vdp1_cmdt_t> shared((entities + 2) * Utenyaa::Rendering::Viewports::MaxCount);
+    std::vector<vdp1_cmdt_t> separate(shared.size());
+    uint32_t ends[Utenyaa::Rendering::Viewports::MaxCount];
+    double single = 0.0;
+    bool matches = true;
+
+    printf("%u entities, %u frames per row\n", entities, frames);
+    printf("%10s %10s %10s %12s %12s %12s\n", "viewports", "drawn", "tested", "grid us", "separate us", "vs N x 1");
+
+    for (uint8_t count = 1; count <= Utenyaa::Rendering::Viewports::MaxCount; count++)
+    {
+        // Same entities and player paths for every viewport count
+        std::mt19937 random(1);
+        std::vector<fix16_vec3_t> positions(entities);
+
+        for (fix16_vec3_t & position : positions)
+        {
+            position = { (fix16_t)(random() % (2 * (uint32_t)ArenaHalfSize)) - ArenaHalfSize, (fix16_t)(random() % (2 * (uint32_t)ArenaHalfSize)) - ArenaHalfSize, FIX16_ZERO };
+        }
+
+        Utenyaa::Rendering::Viewports::Initialize(count);
+        double sharedTime = 0.0;
+        double separateTime = 0.0;
+        uint64_t drawn = 0;
+        uint64_t tested = 0;
+
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            MovePlayers(positions, random);
+
+            auto start = std::chrono::steady_clock::now();
+            const uint32_t written = RenderShared(positions, &grid, shared.data(), ends, &tested);
+            sharedTime += Elapsed(start);
+
+            start = std::chrono::steady_clock::now();
+            const uint32_t separateWritten = RenderSeparate(positions, separate.data());
+            separateTime += Elapsed(start);
+
+            drawn += written - (2 * count);
+            SortViewports(shared.data(), ends, count);
+            SortViewports(separate.data(), ends, count);
+            matches = matches && written == separateWritten && memcmp(shared.data(), separate.data(), written * sizeof(vdp1_cmdt_t)) == 0;
+        }
+
+        single = count == 1 ? sharedTime : single;
+        printf("%10u %10.1f %10.1f %12.2f %12.2f %12.2f\n",
+            count,
+            (double)drawn / frames,
+            (double)tested / frames,
+            sharedTime / frames,
+            separateTime / frames,
+            sharedTime / (single * count));
+    }
+
+    printf("Grid and separate culling %s\n", matches ? "write the same commands" : "write DIFFERENT commands");
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+/** @brief Measures rollback of Utenyaa::Simulation::World, restore of a state 8 frames old and re-simulation of those 8 frames
+ * @details Build: g++ -std=c++20 -O2 -I../Host -o WorldBenchmark WorldBenchmark.cpp (needs HyperionEngine submodule checked out)
+ * Usage: WorldBenchmark [number of frames] [largest entity count]
+ *
+ * Entities with a moving body and a weapon cooldown are simulated with fixed point math. Every frame is captured into WorldHistory,
+ * then the world is rolled back 8 frames and those frames are simulated again, like rollback netcode does when late input arrives.
+ * Re-simulated state has to match the state before the rollback byte for byte. Entity count is doubled from 16 up to the limit,
+ * report shows snapshot time, rollback with re-simulation time and size of delta compressed frames.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <yaul.h>
+#include "../../src/Simulation/World.hpp"
+
+/** @brief Number of frames rolled back
+ */
+static constexpr uint32_t RollbackFrames = 8;
+
+/** @brief Number of kept frames (one more than rolled back, so the state before the rollback is kept too)
+ */
+static constexpr uint8_t HistoryFrames = RollbackFrames + 1;
+
+/** @brief Half size of the arena in world units
+ */
+static constexpr fix16_t ArenaHalfSize = FIX16(64.0f);
+
+/** @brief Moving body
+ */
+struct Body
+{
+    /** @brief World location
+     */
+    fix16_vec3_t Location;
+
+    /** @brief Movement per frame
+     */
+    fix16_vec3_t Velocity;
+
+    /** @brief Input seed of the entity
+     */
+    uint32_t Seed;
+};
+
+/** @brief Weapon state
+ */
+struct Weapon
+{
+    /** @brief Frames until next shot
+     */
+    uint16_t Cooldown;
+
+    /** @brief Number of shots
+     */
+    uint16_t Shots;
+};
+
+/** @brief Simulated world
+ */
+typedef Utenyaa::Simulation::World<Body, Weapon> BenchmarkWorld;
+
+/** @brief Milliseconds elapsed since a time point
+ * @param start Start time
+ * @return Elapsed time
+ */
+static double Elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** @brief Simulate single frame, input of each entity is derived from its seed and the frame number
+ * @param frame Frame number
+ */
+static void Simulate(uint32_t frame)
+{
+    Entity::ForEach(
+        [frame](Body & body, Weapon & weapon)
+        {
+            const uint32_t input = (body.Seed ^ frame) * 2654435761u;
+            body.Velocity.x += ((fix16_t)(input & 0xff) - 0x80) << 4;
+            body.Velocity.y += ((fix16_t)((input >> 8) & 0xff) - 0x80) << 4;
+            body.Velocity.x = fix16_mul(body.Velocity.x, FIX16(0.95f));
+            body.Velocity.y = fix16_mul(body.Velocity.y, FIX16(0.95f));
+            body.Location.x += body.Velocity.x;
+            body.Location.y += body.Velocity.y;
+
+            // Arena walls bounce the body back
+            if (body.Location.x < -ArenaHalfSize || body.Location.x > ArenaHalfSize)
+            {
+                body.Velocity.x = -body.Velocity.x;
+                body.Location.x = std::clamp(body.Location.x, -ArenaHalfSize, ArenaHalfSize);
+            }
+
+            if (body.Location.y < -ArenaHalfSize || body.Location.y > ArenaHalfSize)
+            {
+                body.Velocity.y = -body.Velocity.y;
+                body.Location.y = std::clamp(body.Location.y, -ArenaHalfSize, ArenaHalfSize);
+            }
+
+            if (weapon.Cooldown > 0)
+            {
+                weapon.Cooldown--;
+            }
+            else if ((input >> 16) % 7 == 0)
+            {
+                weapon.Cooldown = 30;
+                weapon.Shots++;
+            }
+        });
+}
+
+/** @brief Run frames with a rollback every frame
+ * @param entities Number of entities
+ * @param frames Number of frames
+ * @return true Re-simulated states matched
+ * @return false Re-simulation gave different state
+ */
+static bool Run(uint32_t entities, uint32_t frames)
+{
+    const uint32_t capacity = entities * (sizeof(Body) + sizeof(Weapon)) + 4;
+    Utenyaa::Simulation::WorldHistory<BenchmarkWorld, HistoryFrames> history(capacity);
+    Utenyaa::Simulation::WorldState expected;
+    Utenyaa::Simulation::WorldState previous;
+    BenchmarkWorld::Allocate(&expected, capacity);
+    BenchmarkWorld::Allocate(&previous, capacity);
+    std::vector<uint8_t> delta(capacity + 4);
+
+    double snapshotTime = 0.0;
+    double rollbackTime = 0.0;
+    double worstRollback = 0.0;
+    uint64_t deltaSize = 0;
+    uint32_t rollbacks = 0;
+    bool matches = true;
+
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        Simulate(frame);
+
+        auto start = std::chrono::steady_clock::now();
+        history.Push(frame);
+        snapshotTime += Elapsed(start);
+
+        BenchmarkWorld::Snapshot(&expected, frame);
+
+        if (frame > 0)
+        {
+            deltaSize += BenchmarkWorld::Compress(&previous, &expected, delta.data());
+        }
+
+        BenchmarkWorld::Copy(&expected, &previous);
+
+        if (frame < RollbackFrames)
+        {
+            continue;
+        }
+
+        // Go back to the state at the end of an older frame and simulate the frames after it again
+        start = std::chrono::steady_clock::now();
+        const uint32_t from = frame - RollbackFrames;
+
+        if (!history.Rollback(from))
+        {
+            fprintf(stderr, "Frame %u is not in history\n", from);
+            return false;
+        }
+
+        for (uint32_t replay = from + 1; replay <= frame; replay++)
+        {
+            Simulate(replay);
+            history.Push(replay);
+        }
+
+        const double time = Elapsed(start);
+        rollbackTime += time;
+        worstRollback = std::max(worstRollback, time);
+        rollbacks++;
+
+        Utenyaa::Simulation::WorldState replayed;
+        BenchmarkWorld::Allocate(&replayed, capacity);
+        BenchmarkWorld::Snapshot(&replayed, frame);
+        matches = matches && replayed.Size == expected.Size && memcmp(replayed.Data, expected.Data, expected.Size) == 0;
+        free(replayed.Data);
+    }
+
+    printf("%8u %10u %12.2f %14.2f %12.2f %10llu %10.2f\n",
+        entities,
+        expected.Size,
+        (snapshotTime * 1000.0) / frames,
+        (rollbackTime * 1000.0) / rollbacks,
+        worstRollback * 1000.0,
+        (unsigned long long)(deltaSize / (frames - 1)),
+        (rollbackTime * 1000.0) / ((double)rollbacks * RollbackFrames));
+
+    free(expected.Data);
+    free(previous.Data);
+    return matches;
+}
+
+int main(int argc, char ** argv)
+{
+    const uint32_t frames = argc > 1 ? (uint32_t)atoi(argv[1]) : 600;
+    const uint32_t limit = argc > 2 ? (uint32_t)atoi(argv[2]) : 512;
+
+    if (frames <= RollbackFrames || limit < 16)
+    {
+        fprintf(stderr, "Usage: %s [number of frames (%u+)] [largest entity count (16+)]\n", argv[0], RollbackFrames + 1);
+        return 1;
+    }
+
+    printf("%8s %10s %12s %14s %12s %10s %10s\n", "entities", "bytes", "snapshot us", "rollback us", "worst us", "delta", "us/frame");
+    uint32_t created = 0;
+    bool matches = true;
+
+    for (uint32_t entities = 16; entities <= limit; entities <<= 1)
+    {
+        // Entities are only ever added, every run continues with the world left by the previous one
+        for (; created < entities; created++)
+        {
+            const fix16_t spread = (fix16_t)(created * 2654435761u) % ArenaHalfSize;
+            Entity::Create(
+                Body { Location : { spread, -spread, 0 }, Velocity : { 0, 0, 0 }, Seed : created * 40503u },
+                Weapon { Cooldown : (uint16_t)(created % 30), Shots : 0 });
+        }
+
+        matches = Run(entities, frames) && matches;
+    }
+
+    printf("Rollback of %u frames %s\n", RollbackFrames, matches ? "re-simulated the same state" : "gave DIFFERENT state");
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <yaul.h>
+
+namespace Utenyaa::Components
+{
+    /** @brief AI controller component
+     */
+    struct AI
+    {
+        /** @brief Navigation goal the tank drives toward
+         */
+        uint8_t Goal;
+
+        /** @brief Steering output of the last decision, replayed into input until the next decision
+         */
+        uint8_t Steering;
+
+        /** @brief Player targeted by the last decision (0xff if there is none)
+         */
+        uint8_t Target;
+    };
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <yaul.h>
+
+namespace Utenyaa::Components
+{
+    /** @brief Analog input component
+     * @details Stick steering and throttle are written to the input component, so movement does not depend on this component
+     */
+    struct AnalogInput
+    {
+        /** @brief Left trigger (0 released, 1 fully pressed)
+         */
+        fix16_t TriggerL;
+
+        /** @brief Right trigger (0 released, 1 fully pressed)
+         */
+        fix16_t TriggerR;
+
+        /** @brief Index of response curve used by the player
+         */
+        uint8_t Curve;
+
+        /** @brief Analog values are valid, otherwise digital input should be used
+         */
+        bool Active;
+    };
+}
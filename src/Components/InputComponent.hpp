@@ -124,5 +124,13 @@ namespace Utenyaa::Components::InputComponent
          */
         unsigned int Lt:1;
 
+        /** @brief Analog steering (-1 full left, 1 full right), zero when there is no analog input
+         */
+        fix16_t Steer;
+
+        /** @brief Analog throttle (-1 full reverse, 1 full forward), zero when there is no analog input
+         */
+        fix16_t Throttle;
+
     } __aligned(2) struct_name;
 }
\ No newline at end of file
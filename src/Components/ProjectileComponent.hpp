@@ -0,0 +1,18 @@
+#pragma once
+#include <yaul.h>
+
+namespace Utenyaa::Components
+{
+    /** @brief Projectile component
+     */
+    struct Projectile
+    {
+        /** @brief Movement per frame on the ground plane
+         */
+        fix16_vec2_t Velocity;
+
+        /** @brief Number of frames left before the projectile expires (0 if projectile is inactive)
+         */
+        uint16_t Lifetime;
+    };
+}
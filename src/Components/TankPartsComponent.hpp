@@ -0,0 +1,22 @@
+#pragma once
+#include <yaul.h>
+
+namespace Utenyaa::Components
+{
+    /** @brief Tank parts component, handles of tank nodes in Simulation::TransformTree
+     */
+    struct TankParts
+    {
+        /** @brief Hull node, follows entity transform
+         */
+        uint16_t Hull;
+
+        /** @brief Turret node, child of the hull that can rotate on its own
+         */
+        uint16_t Turret;
+
+        /** @brief Barrel node, child of the turret
+         */
+        uint16_t Barrel;
+    };
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <yaul.h>
+
+namespace Utenyaa::Components
+{
+    /** @brief Team component
+     */
+    struct Team
+    {
+        /** @brief Team index, selects color bank of the shared tank texture
+         */
+        uint8_t Index;
+    };
+}
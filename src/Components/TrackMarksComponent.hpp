@@ -0,0 +1,14 @@
+#pragma once
+#include <yaul.h>
+
+namespace Utenyaa::Components
+{
+    /** @brief Track marks component
+     */
+    struct TrackMarks
+    {
+        /** @brief Location of the last stamped track marks on the ground plane
+         */
+        fix16_vec2_t LastStamp;
+    };
+}
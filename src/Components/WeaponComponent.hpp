@@ -0,0 +1,14 @@
+#pragma once
+#include <yaul.h>
+
+namespace Utenyaa::Components
+{
+    /** @brief Weapon component, main gun fired from the end of the barrel
+     */
+    struct Weapon
+    {
+        /** @brief Number of frames left before the gun can fire again
+         */
+        uint8_t Cooldown;
+    };
+}
@@ -0,0 +1,337 @@
+#pragma once
+#include <yaul.h>
+
+namespace Utenyaa::Debug
+{
+    /** @brief Retained debug text overlay on top of the VDP2 debug text layer
+     * @details Values are written into fixed text slots of a shadow screen, and only the characters
+     * that differ from what is already shown are sent to dbgio on flush.
+     */
+    class Overlay
+    {
+    public:
+        /** @brief Number of text columns
+         */
+        static constexpr uint8_t Columns = 40;
+
+        /** @brief Number of text rows
+         */
+        static constexpr uint8_t Rows = 28;
+
+        /** @brief Maximum number of text slots
+         */
+        static constexpr uint8_t MaxSlots = 64;
+
+        /** @brief Width of a single fix16 value slot
+         */
+        static constexpr uint8_t Fix16Width = 10;
+
+    private:
+        /** @brief Text slot
+         */
+        struct Slot
+        {
+            /** @brief Screen row
+             */
+            uint8_t Row;
+
+            /** @brief First screen column
+             */
+            uint8_t Column;
+
+            /** @brief Number of characters
+             */
+            uint8_t Width;
+        };
+
+        /** @brief Unchanged characters shorter than this between two changed runs are sent along instead of a new cursor move
+         */
+        static constexpr uint8_t MergeGap = 6;
+
+        /** @brief Characters currently on screen
+         */
+        inline static char shown[Rows][Columns];
+
+        /** @brief Characters to be shown after next flush
+         */
+        inline static char pending[Rows][Columns];
+
+        /** @brief Rows that have pending changes
+         */
+        inline static uint32_t dirtyRows;
+
+        /** @brief Allocated slots
+         */
+        inline static Slot slots[MaxSlots];
+
+        /** @brief Number of allocated slots
+         */
+        inline static uint8_t slotCount;
+
+        /** @brief Write text into pending screen
+         * @param row Screen row
+         * @param column Screen column
+         * @param text Text to write
+         * @param length Number of characters to write
+         */
+        static void Write(uint8_t row, uint8_t column, const char * text, uint8_t length)
+        {
+            assert(row < Overlay::Rows);
+            assert(column + length <= Overlay::Columns);
+
+            char * target = &Overlay::pending[row][column];
+
+            for (uint8_t character = 0; character < length; character++)
+            {
+                if (target[character] != text[character])
+                {
+                    target[character] = text[character];
+                    Overlay::dirtyRows |= 1 << row;
+                }
+            }
+        }
+
+        /** @brief Append unsigned number to a buffer
+         * @param buffer Target buffer
+         * @param value Number to append
+         * @return Pointer past last written character
+         */
+        static char * AppendNumber(char * buffer, uint32_t value)
+        {
+            char digits[10];
+            uint8_t count = 0;
+
+            do
+            {
+                digits[count++] = '0' + (value % 10);
+                value /= 10;
+            } while (value != 0);
+
+            while (count > 0)
+            {
+                *buffer++ = digits[--count];
+            }
+
+            return buffer;
+        }
+
+        /** @brief Send part of a row to dbgio
+         * @param row Screen row
+         * @param column First column
+         * @param length Number of characters
+         */
+        static void Send(uint8_t row, uint8_t column, uint8_t length)
+        {
+            // Cursor position escape sequence is 1 based
+            char buffer[Overlay::Columns + 12];
+            char * cursor = buffer;
+            *cursor++ = '\x1b';
+            *cursor++ = '[';
+            cursor = Overlay::AppendNumber(cursor, row + 1);
+            *cursor++ = ';';
+            cursor = Overlay::AppendNumber(cursor, column + 1);
+            *cursor++ = 'H';
+
+            memcpy(cursor, &Overlay::pending[row][column], length);
+            memcpy(&Overlay::shown[row][column], &Overlay::pending[row][column], length);
+            cursor[length] = '\0';
+
+            dbgio_puts(buffer);
+        }
+
+    public:
+        /** @brief Clear screen and all slots
+         */
+        static void Initialize()
+        {
+            memset(Overlay::shown, ' ', sizeof(Overlay::shown));
+            memset(Overlay::pending, ' ', sizeof(Overlay::pending));
+            Overlay::dirtyRows = 0;
+            Overlay::slotCount = 0;
+
+            dbgio_puts("\x1b[H\x1b[2J");
+        }
+
+        /** @brief Add new text slot
+         * @param row Screen row
+         * @param column First screen column
+         * @param width Number of characters
+         * @param label Static text shown in front of the slot (can be NULL)
+         * @return Slot index
+         */
+        static uint8_t AddSlot(uint8_t row, uint8_t column, uint8_t width, const char * label)
+        {
+            assert(Overlay::slotCount < Overlay::MaxSlots);
+
+            if (label != NULL)
+            {
+                uint8_t length = strlen(label);
+                assert(column >= length);
+                Overlay::Write(row, column - length, label, length);
+            }
+
+            Overlay::slots[Overlay::slotCount] = { Row : row, Column : column, Width : width };
+            return Overlay::slotCount++;
+        }
+
+        /** @brief Add three fix16 slots on a single row
+         * @param row Screen row
+         * @param label Row label
+         * @return Index of the first slot (X), Y and Z slots follow
+         */
+        static uint8_t AddVector(uint8_t row, const char * label)
+        {
+            uint8_t column = Overlay::Columns - (Overlay::Fix16Width * 3);
+            uint8_t first = Overlay::AddSlot(row, column, Overlay::Fix16Width, label);
+            Overlay::AddSlot(row, column + Overlay::Fix16Width, Overlay::Fix16Width, NULL);
+            Overlay::AddSlot(row, column + (Overlay::Fix16Width * 2), Overlay::Fix16Width, NULL);
+            return first;
+        }
+
+        /** @brief Format fix16 value as right aligned decimal with 3 fractional digits
+         * @param buffer Target buffer
+         * @param width Buffer width (text is clipped from the left if it does not fit)
+         * @param value Value to format
+         */
+        static void FormatFix16(char * buffer, uint8_t width, fix16_t value)
+        {
+            uint32_t magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+            uint32_t fraction = (((magnitude & 0xffff) * 1000) + 0x8000) >> 16;
+            uint32_t integer = magnitude >> 16;
+
+            // Rounding of the fraction can carry over to integer part
+            if (fraction >= 1000)
+            {
+                fraction -= 1000;
+                integer++;
+            }
+
+            int32_t position = width;
+
+            for (uint8_t digit = 0; digit < 3 && position > 0; digit++)
+            {
+                buffer[--position] = '0' + (fraction % 10);
+                fraction /= 10;
+            }
+
+            if (position > 0)
+            {
+                buffer[--position] = '.';
+            }
+
+            do
+            {
+                if (position > 0)
+                {
+                    buffer[--position] = '0' + (integer % 10);
+                }
+
+                integer /= 10;
+            } while (integer != 0);
+
+            if (value < 0 && position > 0)
+            {
+                buffer[--position] = '-';
+            }
+
+            while (position > 0)
+            {
+                buffer[--position] = ' ';
+            }
+        }
+
+        /** @brief Set slot text
+         * @param slot Slot index
+         * @param text Text to show (padded with spaces or clipped to slot width)
+         */
+        static void SetText(uint8_t slot, const char * text)
+        {
+            assert(slot < Overlay::slotCount);
+            const Slot * target = &Overlay::slots[slot];
+            char buffer[Overlay::Columns];
+            uint8_t length = strnlen(text, target->Width);
+
+            memcpy(buffer, text, length);
+            memset(&buffer[length], ' ', target->Width - length);
+            Overlay::Write(target->Row, target->Column, buffer, target->Width);
+        }
+
+        /** @brief Set slot to fix16 value
+         * @param slot Slot index
+         * @param value Value to show
+         */
+        static void SetFix16(uint8_t slot, fix16_t value)
+        {
+            assert(slot < Overlay::slotCount);
+            const Slot * target = &Overlay::slots[slot];
+            char buffer[Overlay::Columns];
+
+            Overlay::FormatFix16(buffer, target->Width, value);
+            Overlay::Write(target->Row, target->Column, buffer, target->Width);
+        }
+
+        /** @brief Set slot to unsigned number
+         * @param slot Slot index
+         * @param value Value to show
+         */
+        static void SetNumber(uint8_t slot, uint32_t value)
+        {
+            char buffer[Overlay::Columns + 10];
+            char * end = Overlay::AppendNumber(buffer, value);
+            *end = '\0';
+
+            Overlay::SetText(slot, buffer);
+        }
+
+        /** @brief Set three consecutive slots to vector components
+         * @param slot Index of the first slot
+         * @param vector Vector to show
+         */
+        static void SetVector(uint8_t slot, const fix16_vec3_t * vector)
+        {
+            Overlay::SetFix16(slot, vector->x);
+            Overlay::SetFix16(slot + 1, vector->y);
+            Overlay::SetFix16(slot + 2, vector->z);
+        }
+
+        /** @brief Send changed characters to dbgio (dbgio_flush still has to be called)
+         */
+        static void Flush()
+        {
+            while (Overlay::dirtyRows != 0)
+            {
+                uint8_t row = __builtin_ctz(Overlay::dirtyRows);
+                Overlay::dirtyRows &= ~(1 << row);
+
+                const char * current = Overlay::shown[row];
+                const char * next = Overlay::pending[row];
+                int32_t runStart = -1;
+                int32_t runEnd = 0;
+
+                for (uint8_t column = 0; column < Overlay::Columns; column++)
+                {
+                    if (current[column] != next[column])
+                    {
+                        if (runStart >= 0 && column - runEnd > Overlay::MergeGap)
+                        {
+                            Overlay::Send(row, runStart, runEnd - runStart);
+                            runStart = -1;
+                        }
+
+                        if (runStart < 0)
+                        {
+                            runStart = column;
+                        }
+
+                        runEnd = column + 1;
+                    }
+                }
+
+                if (runStart >= 0)
+                {
+                    Overlay::Send(row, runStart, runEnd - runStart);
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <yaul.h>
+#include "../../Dependencies/Skathi/Timer.hpp"
+
+namespace Utenyaa::Debug
+{
+    /** @brief Per-frame timing of named code sections
+     */
+    class Profiler
+    {
+    public:
+        /** @brief Maximum number of sections
+         */
+        static constexpr uint8_t MaxSections = 8;
+
+        /** @brief Section timing
+         */
+        struct Section
+        {
+            /** @brief Section name
+             */
+            const char * Name;
+
+            /** @brief Ticks spent in section during current frame
+             */
+            uint32_t Current;
+
+            /** @brief Ticks spent in section during last frame
+             */
+            uint32_t Last;
+
+            /** @brief Most ticks spent in section during a single frame
+             */
+            uint32_t Worst;
+
+            /** @brief Timer value at the start of running section
+             */
+            uint16_t Start;
+        };
+
+    private:
+        /** @brief Registered sections
+         */
+        inline static Section sections[MaxSections];
+
+        /** @brief Number of registered sections
+         */
+        inline static uint8_t count;
+
+    public:
+        /** @brief Register new section
+         * @param name Section name
+         * @return Section index
+         */
+        static uint8_t Register(const char * name)
+        {
+            assert(Profiler::count < Profiler::MaxSections);
+            Profiler::sections[Profiler::count] = { Name : name, Current : 0, Last : 0, Worst : 0, Start : 0 };
+            return Profiler::count++;
+        }
+
+        /** @brief Start measuring section
+         * @param section Section index
+         */
+        static void Begin(uint8_t section)
+        {
+            assert(section < Profiler::count);
+            Profiler::sections[section].Start = Skathi::Timer::GetTicks();
+        }
+
+        /** @brief Stop measuring section (section can be measured multiple times per frame)
+         * @param section Section index
+         */
+        static void End(uint8_t section)
+        {
+            assert(section < Profiler::count);
+            Profiler::sections[section].Current += Skathi::Timer::GetElapsed(Profiler::sections[section].Start);
+        }
+
+        /** @brief Finish frame (should be called once at the end of each game loop)
+         */
+        static void EndFrame()
+        {
+            for (uint8_t section = 0; section < Profiler::count; section++)
+            {
+                Section * target = &Profiler::sections[section];
+                target->Last = target->Current;
+                target->Worst = target->Current > target->Worst ? target->Current : target->Worst;
+                target->Current = 0;
+            }
+        }
+
+        /** @brief Get section timing
+         * @param section Section index
+         * @return Section timing
+         */
+        static const Section * Get(uint8_t section)
+        {
+            assert(section < Profiler::count);
+            return &Profiler::sections[section];
+        }
+
+        /** @brief Get time spent in section during last frame
+         * @param section Section index
+         * @return Time in microseconds
+         */
+        static uint32_t GetLastMicroseconds(uint8_t section)
+        {
+            return Skathi::Timer::ToMicroseconds(Profiler::Get(section)->Last);
+        }
+
+        /** @brief Get most time spent in section during a single frame
+         * @param section Section index
+         * @return Time in microseconds
+         */
+        static uint32_t GetWorstMicroseconds(uint8_t section)
+        {
+            return Skathi::Timer::ToMicroseconds(Profiler::Get(section)->Worst);
+        }
+    };
+}
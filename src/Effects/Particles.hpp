@@ -0,0 +1,374 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+#include "../Rendering/Viewports.hpp"
+#include "../../Dependencies/Skathi/Slave.hpp"
+#include "../../Dependencies/Skathi/VDP1/Vdp1.hpp"
+
+namespace Utenyaa::Effects
+{
+    /** @brief Fixed capacity particle pool for explosions, muzzle flashes and smoke
+     * @details Particle data is kept in separate arrays (structure of arrays), dead particles are replaced by the last one.
+     * Update can run on the slave CPU, particles must not be emitted or drawn between StartUpdate and WaitUpdate.
+     */
+    class Particles
+    {
+    public:
+        /** @brief Maximum number of live particles
+         */
+        static constexpr uint16_t Capacity = PARTICLE_CAPACITY;
+
+        /** @brief Number of live particles above which new effects are emitted with half of the particles
+         */
+        static constexpr uint16_t SoftLimit = (Capacity * 3) >> 2;
+
+        /** @brief Particle kind
+         */
+        enum Kind : uint8_t
+        {
+            /** @brief Fast, short lived explosion debris
+             */
+            Explosion = 0,
+
+            /** @brief Very short flash in front of the gun
+             */
+            MuzzleFlash = 1,
+
+            /** @brief Slow, long lived smoke
+             */
+            Smoke = 2,
+
+            /** @brief Number of particle kinds
+             */
+            KindCount = 3
+        };
+
+    private:
+        /** @brief Kind parameters
+         */
+        struct KindInfo
+        {
+            /** @brief Lifetime in frames
+             */
+            uint16_t Lifetime;
+
+            /** @brief Initial speed in world units per frame
+             */
+            fix16_t Speed;
+
+            /** @brief Velocity loses 1/(2^Drag) of itself each frame
+             */
+            uint8_t Drag;
+
+            /** @brief Sprite size in pixels at the start of life
+             */
+            uint8_t Size;
+
+            /** @brief Sprite color
+             */
+            uint16_t Color;
+        };
+
+        /** @brief Parameters of each kind
+         */
+        static constexpr KindInfo Kinds[KindCount] = {
+            { Lifetime : 24, Speed : FIX16(0.4f), Drag : 3, Size : 8, Color : RGB1555(1, 31, 14, 3) },
+            { Lifetime : 4, Speed : FIX16(0.1f), Drag : 1, Size : 12, Color : RGB1555(1, 31, 29, 18) },
+            { Lifetime : 60, Speed : FIX16(0.05f), Drag : 5, Size : 16, Color : RGB1555(1, 12, 12, 11) }
+        };
+
+        /** @brief Location X
+         */
+        inline static fix16_t positionX[Capacity];
+
+        /** @brief Location Y
+         */
+        inline static fix16_t positionY[Capacity];
+
+        /** @brief Velocity X
+         */
+        inline static fix16_t velocityX[Capacity];
+
+        /** @brief Velocity Y
+         */
+        inline static fix16_t velocityY[Capacity];
+
+        /** @brief Frames left to live
+         */
+        inline static uint16_t lifetime[Capacity];
+
+        /** @brief Particle kind
+         */
+        inline static uint8_t kind[Capacity];
+
+        /** @brief Number of live particles
+         */
+        inline static uint16_t count = 0;
+
+        /** @brief Number of particles that were not emitted because of the limits
+         */
+        inline static uint32_t dropped = 0;
+
+        /** @brief Random generator state
+         */
+        inline static uint32_t seed = 0x2545f491;
+
+        /** @brief Sprite of each kind
+         */
+        inline static Skathi::Vdp1::Sprite::Instance sprites[KindCount];
+
+        /** @brief Generated texture of each kind
+         */
+        inline static texture_t textures[KindCount];
+
+        /** @brief Particles inside of the viewport being drawn
+         */
+        inline static uint16_t visible[Capacity];
+
+        /** @brief Update runs on the slave CPU
+         */
+        inline static bool useSlave = false;
+
+        /** @brief Get next pseudo random number
+         * @return Random number in range of -1 to 1 (fix16)
+         */
+        static fix16_t Random()
+        {
+            Particles::seed = (Particles::seed * 1664525) + 1013904223;
+            return ((int32_t)Particles::seed) >> 15;
+        }
+
+        /** @brief Slave CPU job
+         * @param work Not used
+         */
+        static void SlaveUpdate(void * work __unused)
+        {
+            Particles::Update();
+        }
+
+    public:
+        /** @brief Initialize particle pool
+         * @param slave Run update on the slave CPU
+         */
+        static void Initialize(bool slave)
+        {
+            Particles::count = 0;
+            Particles::dropped = 0;
+            Particles::useSlave = slave;
+
+            if (slave)
+            {
+                Skathi::Slave::Initialize();
+            }
+        }
+
+        /** @brief Set sprite used by a particle kind
+         * @param particleKind Particle kind
+         * @param texture Sprite texture
+         * @param color Color bank or lookup table address
+         * @param drawMode Sprite draw mode
+         */
+        static void SetSprite(Kind particleKind, const texture_t * texture, uint16_t color, uint16_t drawMode)
+        {
+            assert(particleKind < Kind::KindCount);
+            Skathi::Vdp1::Sprite::Instance * sprite = &Particles::sprites[particleKind];
+            sprite->Kind = Skathi::Vdp1::Sprite::Type::Scaled;
+            sprite->Layer = PARTICLE_SPRITE_LAYER;
+            sprite->Color = color;
+            sprite->DrawMode = drawMode;
+            Skathi::Vdp1::Sprite::SetTexture(sprite, texture);
+        }
+
+        /** @brief Make round sprite texture of each particle kind and load it into VRAM
+         * @param textureBase Where to load textures to in VRAM
+         * @return Size of loaded textures
+         */
+        static size_t LoadSprites(vdp1_vram_t textureBase)
+        {
+            // RGB texture with transparent corners, end codes are not checked and sprites are clipped to the viewport (user clipping)
+            const uint16_t drawMode = (VDP1_CMDT_CM_RGB_32768 << 3) | (1 << 7) | (1 << 10);
+            size_t size = 0;
+
+            for (uint8_t particleKind = 0; particleKind < Kind::KindCount; particleKind++)
+            {
+                Skathi::Bitmap::Image image(PARTICLE_TEXTURE_SIZE, PARTICLE_TEXTURE_SIZE, Skathi::Bitmap::ImageFormat::RGB);
+                const uint16_t color = Particles::Kinds[particleKind].Color;
+                const int32_t quarter = PARTICLE_TEXTURE_SIZE >> 2;
+                image.FillRect(0, 0, PARTICLE_TEXTURE_SIZE, PARTICLE_TEXTURE_SIZE, 0);
+                image.FillRect(quarter, 0, PARTICLE_TEXTURE_SIZE - (quarter << 1), PARTICLE_TEXTURE_SIZE, color);
+                image.FillRect(0, quarter, PARTICLE_TEXTURE_SIZE, PARTICLE_TEXTURE_SIZE - (quarter << 1), color);
+                image.FillRect(quarter >> 1, quarter >> 1, PARTICLE_TEXTURE_SIZE - quarter, PARTICLE_TEXTURE_SIZE - quarter, color);
+
+                size += Skathi::Vdp1::TextureUtils::LoadTexture(&image, textureBase + size, &Particles::textures[particleKind]);
+                Particles::SetSprite((Kind)particleKind, &Particles::textures[particleKind], 0, drawMode);
+            }
+
+            return size;
+        }
+
+        /** @brief Emit burst of particles
+         * @details Over the soft limit bursts are halved, over the capacity the rest is dropped.
+         * @param particleKind Particle kind
+         * @param location Burst center
+         * @param amount Requested number of particles
+         * @return Number of emitted particles
+         */
+        static uint16_t Emit(Kind particleKind, const fix16_vec3_t * location, uint16_t amount)
+        {
+            assert(particleKind < Kind::KindCount);
+            const KindInfo * info = &Particles::Kinds[particleKind];
+            uint16_t emitted = Particles::count >= Particles::SoftLimit ? (amount + 1) >> 1 : amount;
+
+            if (emitted > Particles::Capacity - Particles::count)
+            {
+                emitted = Particles::Capacity - Particles::count;
+            }
+
+            Particles::dropped += amount - emitted;
+
+            for (uint16_t particle = Particles::count; particle < Particles::count + emitted; particle++)
+            {
+                Particles::positionX[particle] = location->x;
+                Particles::positionY[particle] = location->y;
+                Particles::velocityX[particle] = fix16_mul(Particles::Random(), info->Speed);
+                Particles::velocityY[particle] = fix16_mul(Particles::Random(), info->Speed);
+                Particles::lifetime[particle] = info->Lifetime;
+                Particles::kind[particle] = particleKind;
+            }
+
+            Particles::count += emitted;
+            return emitted;
+        }
+
+        /** @brief Move particles and remove dead ones
+         */
+        static void Update()
+        {
+            uint16_t particle = 0;
+            uint16_t live = Particles::count;
+
+            while (particle < live)
+            {
+                if (--Particles::lifetime[particle] == 0)
+                {
+                    // Last particle takes place of the dead one and is aged and moved in this slot
+                    live--;
+                    Particles::positionX[particle] = Particles::positionX[live];
+                    Particles::positionY[particle] = Particles::positionY[live];
+                    Particles::velocityX[particle] = Particles::velocityX[live];
+                    Particles::velocityY[particle] = Particles::velocityY[live];
+                    Particles::lifetime[particle] = Particles::lifetime[live];
+                    Particles::kind[particle] = Particles::kind[live];
+                    continue;
+                }
+
+                const uint8_t drag = Particles::Kinds[Particles::kind[particle]].Drag;
+                Particles::positionX[particle] += Particles::velocityX[particle];
+                Particles::positionY[particle] += Particles::velocityY[particle];
+                Particles::velocityX[particle] -= Particles::velocityX[particle] >> drag;
+                Particles::velocityY[particle] -= Particles::velocityY[particle] >> drag;
+                particle++;
+            }
+
+            Particles::count = live;
+        }
+
+        /** @brief Start particle update, on slave CPU if enabled
+         */
+        static void StartUpdate()
+        {
+            if (Particles::useSlave)
+            {
+                Skathi::Slave::Start(Particles::SlaveUpdate, NULL);
+            }
+            else
+            {
+                Particles::Update();
+            }
+        }
+
+        /** @brief Wait until particle update is done
+         */
+        static void WaitUpdate()
+        {
+            if (Particles::useSlave)
+            {
+                Skathi::Slave::Wait();
+            }
+        }
+
+        /** @brief Add particles visible in the viewport into sprite batch
+         * @details When there are more particles inside of the viewport than the budget, only every Nth of them is drawn.
+         * @param batch Sprite batch
+         * @param viewport Viewport being rendered
+         * @param budget Largest number of sprites to add
+         */
+        static void Draw(Skathi::Vdp1::Sprite * batch, const Utenyaa::Rendering::Viewports::Viewport * viewport, uint16_t budget)
+        {
+            if (Particles::count == 0 || budget == 0)
+            {
+                return;
+            }
+
+            // Stride is picked from particles of this viewport, particles elsewhere in the arena do not thin it out
+            uint16_t inside = 0;
+
+            for (uint16_t particle = 0; particle < Particles::count; particle++)
+            {
+                const fix16_t x = Particles::positionX[particle];
+                const fix16_t y = Particles::positionY[particle];
+
+                if (x >= viewport->Bounds[0] && y >= viewport->Bounds[1] && x <= viewport->Bounds[2] && y <= viewport->Bounds[3])
+                {
+                    Particles::visible[inside++] = particle;
+                }
+            }
+
+            const uint16_t stride = (inside + budget - 1) / budget;
+            const fix16_t centerX = (viewport->Bounds[0] + viewport->Bounds[2]) >> 1;
+            const fix16_t centerY = (viewport->Bounds[1] + viewport->Bounds[3]) >> 1;
+
+            // Pixels per world unit, coordinates are relative to the viewport center (local coordinates)
+            const fix16_t scaleX = fix16_div(fix16_int32_from(viewport->Right - viewport->Left + 1), viewport->HalfWidth << 1);
+            const fix16_t scaleY = fix16_div(fix16_int32_from(viewport->Bottom - viewport->Top + 1), viewport->HalfHeight << 1);
+
+            for (uint16_t index = 0; index < inside; index += stride)
+            {
+                const uint16_t particle = Particles::visible[index];
+
+                // Sprite shrinks as the particle dies
+                const KindInfo * info = &Particles::Kinds[Particles::kind[particle]];
+                const int16_t half = ((info->Size * Particles::lifetime[particle]) / info->Lifetime) >> 1;
+                const int16_t screenX = fix16_int32_to(fix16_mul(Particles::positionX[particle] - centerX, scaleX));
+                const int16_t screenY = fix16_int32_to(fix16_mul(Particles::positionY[particle] - centerY, scaleY));
+
+                Skathi::Vdp1::Sprite::Instance sprite = Particles::sprites[Particles::kind[particle]];
+                sprite.Vertices[0].x = screenX - half;
+                sprite.Vertices[0].y = screenY - half;
+                sprite.Vertices[1].x = screenX + half;
+                sprite.Vertices[1].y = screenY + half;
+
+                if (!batch->Add(&sprite))
+                {
+                    return;
+                }
+            }
+        }
+
+        /** @brief Get number of live particles
+         * @return Particle count
+         */
+        static uint16_t GetCount()
+        {
+            return Particles::count;
+        }
+
+        /** @brief Get number of particles that were not emitted because of the limits
+         * @return Dropped particle count
+         */
+        static uint32_t GetDropped()
+        {
+            return Particles::dropped;
+        }
+    };
+}
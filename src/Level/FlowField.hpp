@@ -0,0 +1,212 @@
+#pragma once
+#include <yaul.h>
+#include "../../Dependencies/Skathi/Timer.hpp"
+#include "TileMap.hpp"
+
+namespace Utenyaa::Level
+{
+    /** @brief Flow field toward a single goal tile, built incrementally by breadth first search
+     * @details Field is double buffered, lookups are served from the last complete field while the next one is being built.
+     */
+    class FlowField
+    {
+    public:
+        /** @brief Tile is not reachable from the goal
+         */
+        static constexpr uint8_t None = 0xff;
+
+        /** @brief Tile is the goal
+         */
+        static constexpr uint8_t Goal = 0xfe;
+
+        /** @brief Number of expanded tiles between two timer checks
+         */
+        static constexpr uint16_t TimerCheckInterval = 16;
+
+        /** @brief Tile offsets of the 8 directions (east, south-east, south, ... north-east)
+         */
+        static constexpr int8_t Offsets[8][2] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+
+    private:
+        /** @brief Tile map the field is built over
+         */
+        const TileMap * map = NULL;
+
+        /** @brief Direction toward goal per tile, front and back buffer
+         */
+        uint8_t * directions[2] = { NULL, NULL };
+
+        /** @brief Index of the complete (front) buffer
+         */
+        uint8_t front = 0;
+
+        /** @brief Search queue of tile indexes
+         */
+        uint16_t * queue = NULL;
+
+        /** @brief Queue read position
+         */
+        uint16_t queueHead = 0;
+
+        /** @brief Queue write position
+         */
+        uint16_t queueTail = 0;
+
+        /** @brief Goal tile index
+         */
+        int32_t goal = -1;
+
+        /** @brief Field is being built
+         */
+        bool building = false;
+
+        /** @brief Front buffer contains a complete field
+         */
+        bool ready = false;
+
+        /** @brief Expand single tile of the search
+         * @param tile Tile index
+         */
+        void Expand(uint16_t tile)
+        {
+            uint8_t * back = this->directions[this->front ^ 1];
+            const int32_t width = this->map->GetWidth();
+            const int32_t x = tile % width;
+            const int32_t y = tile / width;
+
+            for (uint8_t direction = 0; direction < 8; direction++)
+            {
+                const int32_t nextX = x + FlowField::Offsets[direction][0];
+                const int32_t nextY = y + FlowField::Offsets[direction][1];
+
+                if (this->map->IsSolid(nextX, nextY))
+                {
+                    continue;
+                }
+
+                // Do not cut corners of solid tiles
+                if ((direction & 1) != 0 && (this->map->IsSolid(nextX, y) || this->map->IsSolid(x, nextY)))
+                {
+                    continue;
+                }
+
+                const uint16_t next = (nextY * width) + nextX;
+
+                if (back[next] == FlowField::None)
+                {
+                    // Neighbor flows back toward the tile it was reached from
+                    back[next] = (direction + 4) & 7;
+                    this->queue[this->queueTail++] = next;
+                }
+            }
+        }
+
+    public:
+        /** @brief Allocate field buffers for a tile map
+         * @param map Tile map to build field over
+         */
+        void Initialize(const TileMap * map)
+        {
+            assert(map != NULL);
+            const uint32_t count = map->GetWidth() * map->GetHeight();
+            assert(count <= 0xffff);
+
+            this->map = map;
+            this->directions[0] = (uint8_t*)malloc(count);
+            this->directions[1] = (uint8_t*)malloc(count);
+            this->queue = (uint16_t*)malloc(count * sizeof(uint16_t));
+            assert(this->directions[0] != NULL && this->directions[1] != NULL && this->queue != NULL);
+
+            this->front = 0;
+            this->goal = -1;
+            this->building = false;
+            this->ready = false;
+        }
+
+        /** @brief Start building field toward a new goal (previous complete field stays in use until the new one is done)
+         * @param x Goal tile column
+         * @param y Goal tile row
+         */
+        void SetGoal(uint16_t x, uint16_t y)
+        {
+            assert(this->map != NULL);
+            const int32_t tile = (y * this->map->GetWidth()) + x;
+
+            if (tile == this->goal && (this->building || this->ready))
+            {
+                return;
+            }
+
+            uint8_t * back = this->directions[this->front ^ 1];
+            memset(back, FlowField::None, this->map->GetWidth() * this->map->GetHeight());
+            back[tile] = FlowField::Goal;
+
+            this->goal = tile;
+            this->queue[0] = tile;
+            this->queueHead = 0;
+            this->queueTail = 1;
+            this->building = true;
+        }
+
+        /** @brief Continue building the field
+         * @param start Timer value the time budget is counted from
+         * @param budget Time budget in timer ticks
+         * @return true Field is complete (or there is nothing to build)
+         * @return false Time budget ran out
+         */
+        bool Step(uint16_t start, uint16_t budget)
+        {
+            uint16_t expanded = 0;
+
+            while (this->building)
+            {
+                if (this->queueHead == this->queueTail)
+                {
+                    // Search is done, swap buffers
+                    this->front ^= 1;
+                    this->building = false;
+                    this->ready = true;
+                    break;
+                }
+
+                this->Expand(this->queue[this->queueHead++]);
+
+                if (++expanded == FlowField::TimerCheckInterval)
+                {
+                    expanded = 0;
+
+                    if (Skathi::Timer::GetElapsed(start) >= budget)
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        /** @brief Check whether field is still being built
+         * @return true Build is in progress
+         * @return false Field is complete
+         */
+        bool IsBuilding() const
+        {
+            return this->building;
+        }
+
+        /** @brief Get direction toward goal
+         * @param x Tile column
+         * @param y Tile row
+         * @return Direction index into Offsets, Goal or None
+         */
+        uint8_t GetDirection(int32_t x, int32_t y) const
+        {
+            if (!this->ready || x < 0 || y < 0 || x >= this->map->GetWidth() || y >= this->map->GetHeight())
+            {
+                return FlowField::None;
+            }
+
+            return this->directions[this->front][(y * this->map->GetWidth()) + x];
+        }
+    };
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <yaul.h>
+#include "../../Dependencies/Skathi/Cd.hpp"
+#include "../../Dependencies/Skathi/Compression/Packed.hpp"
+#include "TileMap.hpp"
+
+namespace Utenyaa::Level
+{
+    /** @brief Level file loaded from disc (created by Tools/LevelConverter)
+     * @details File layout (big endian, every section starts at 4 byte boundary):
+     * header, tile flags (width * height bytes), floor cells (16 color, 32 bytes each)
+     * and floor pattern names (cell index for each of (width * 2) * (height * 2) cells, row major).
+     */
+    class LevelFile
+    {
+    public:
+        /** @brief File identifier
+         */
+        static constexpr uint32_t Magic = 0x554c564c;
+
+        /** @brief Number of floor cells along one side of a tile
+         */
+        static constexpr uint8_t CellsPerTile = 2;
+
+        /** @brief Size of a single 16 color floor cell in bytes
+         */
+        static constexpr uint8_t CellSize = 32;
+
+        /** @brief File header
+         */
+        struct Header
+        {
+            /** @brief File identifier ("ULVL")
+             */
+            uint32_t Magic;
+
+            /** @brief Number of tile columns
+             */
+            uint16_t Width;
+
+            /** @brief Number of tile rows
+             */
+            uint16_t Height;
+
+            /** @brief Size of a single tile in world units
+             */
+            fix16_t TileSize;
+
+            /** @brief Number of floor cells (cell 0 is always empty)
+             */
+            uint16_t CellCount;
+
+            /** @brief Number of used floor palette colors including transparent color 0
+             */
+            uint16_t ColorCount;
+
+            /** @brief Floor palette
+             */
+            uint16_t Palette[16];
+        };
+
+    private:
+        /** @brief Whole file data
+         */
+        uint8_t * data;
+
+        /** @brief Round size up to whole words
+         * @param size Size in bytes
+         * @return Aligned size
+         */
+        static uint32_t Align(uint32_t size)
+        {
+            return (size + 3) & ~3;
+        }
+
+    public:
+        /** @brief Load level file
+         * @param file File entry
+         */
+        LevelFile(const cdfs_filelist_entry_t * file)
+        {
+            // Level can be stored packed
+            uint32_t size;
+            this->data = Skathi::Compression::Packed::ReadFile(file, &size);
+            assert(this->data != NULL);
+            assert(size >= sizeof(Header) && this->GetHeader()->Magic == LevelFile::Magic);
+        }
+
+        /** @brief Free level data
+         */
+        ~LevelFile()
+        {
+            free(this->data);
+        }
+
+        /** @brief Get file header
+         * @return Level header
+         */
+        const Header * GetHeader() const
+        {
+            return (const Header*)this->data;
+        }
+
+        /** @brief Get tile flags (row major)
+         * @return Tile flags
+         */
+        const uint8_t * GetTiles() const
+        {
+            return this->data + sizeof(Header);
+        }
+
+        /** @brief Get floor cell data
+         * @return 16 color cells
+         */
+        const uint8_t * GetCells() const
+        {
+            const Header * header = this->GetHeader();
+            return this->GetTiles() + LevelFile::Align(header->Width * header->Height);
+        }
+
+        /** @brief Get floor pattern names
+         * @return Cell index of each floor cell (row major)
+         */
+        const uint16_t * GetPatterns() const
+        {
+            return (const uint16_t*)(this->GetCells() + LevelFile::Align(this->GetHeader()->CellCount * LevelFile::CellSize));
+        }
+
+        /** @brief Copy tile flags into tile map
+         * @param map Tile map of the same size as the level
+         */
+        void LoadTiles(TileMap * map) const
+        {
+            const Header * header = this->GetHeader();
+            assert(map->GetWidth() == header->Width && map->GetHeight() == header->Height);
+            memcpy(map->GetTiles(), this->GetTiles(), header->Width * header->Height);
+        }
+    };
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+#include "../../Dependencies/Skathi/Timer.hpp"
+#include "TileMap.hpp"
+#include "FlowField.hpp"
+
+namespace Utenyaa::Level
+{
+    /** @brief Shared flow fields for AI navigation, any number of AI tanks can steer toward the same goal
+     */
+    class Navigation
+    {
+    public:
+        /** @brief Maximum number of goals
+         */
+        static constexpr uint8_t MaxGoals = NAVIGATION_MAX_GOALS;
+
+    private:
+        /** @brief Unit vectors of flow field directions
+         */
+        static constexpr fix16_vec2_t Directions[8] = {
+            { FIX16(1.0f), FIX16(0.0f) },
+            { FIX16(0.70710678f), FIX16(0.70710678f) },
+            { FIX16(0.0f), FIX16(1.0f) },
+            { FIX16(-0.70710678f), FIX16(0.70710678f) },
+            { FIX16(-1.0f), FIX16(0.0f) },
+            { FIX16(-0.70710678f), FIX16(-0.70710678f) },
+            { FIX16(0.0f), FIX16(-1.0f) },
+            { FIX16(0.70710678f), FIX16(-0.70710678f) }
+        };
+
+        /** @brief Tile map of current level
+         */
+        inline static const TileMap * map = NULL;
+
+        /** @brief Flow field per goal
+         */
+        inline static FlowField fields[MaxGoals];
+
+        /** @brief Goal that gets the time budget first next frame
+         */
+        inline static uint8_t next = 0;
+
+    public:
+        /** @brief Initialize navigation for a level
+         * @param map Level tile map
+         */
+        static void Initialize(const TileMap * map)
+        {
+            Navigation::map = map;
+            Navigation::next = 0;
+
+            for (uint8_t goal = 0; goal < Navigation::MaxGoals; goal++)
+            {
+                Navigation::fields[goal].Initialize(map);
+            }
+        }
+
+        /** @brief Set goal location
+         * @param goal Goal index
+         * @param location World location of the goal
+         */
+        static void SetGoal(uint8_t goal, const fix16_vec3_t * location)
+        {
+            assert(goal < Navigation::MaxGoals);
+            int32_t x;
+            int32_t y;
+            Navigation::map->WorldToTile(location, &x, &y);
+
+            if (x >= 0 && y >= 0 && x < Navigation::map->GetWidth() && y < Navigation::map->GetHeight())
+            {
+                Navigation::fields[goal].SetGoal(x, y);
+            }
+        }
+
+        /** @brief Continue building flow fields within the per-frame time budget (should be called once per frame)
+         */
+        static void Update()
+        {
+            const uint16_t start = Skathi::Timer::GetTicks();
+            const uint16_t budget = Skathi::Timer::FromMicroseconds(NAVIGATION_BUDGET_US);
+
+            // Fields take turns in getting the budget first, so one large build cannot starve the others
+            for (uint8_t goal = 0; goal < Navigation::MaxGoals; goal++)
+            {
+                FlowField * field = &Navigation::fields[(Navigation::next + goal) % Navigation::MaxGoals];
+
+                if (field->IsBuilding() && !field->Step(start, budget))
+                {
+                    break;
+                }
+            }
+
+            Navigation::next = (Navigation::next + 1) % Navigation::MaxGoals;
+        }
+
+        /** @brief Get direction toward goal
+         * @param goal Goal index
+         * @param location World location
+         * @param direction Unit direction on the ground plane
+         * @return true Direction is valid
+         * @return false Goal was reached, is unreachable or its field is not built yet
+         */
+        static bool GetDirection(uint8_t goal, const fix16_vec3_t * location, fix16_vec2_t * direction)
+        {
+            assert(goal < Navigation::MaxGoals);
+            int32_t x;
+            int32_t y;
+            Navigation::map->WorldToTile(location, &x, &y);
+
+            const uint8_t flow = Navigation::fields[goal].GetDirection(x, y);
+
+            if (flow >= 8)
+            {
+                return false;
+            }
+
+            *direction = Navigation::Directions[flow];
+            return true;
+        }
+    };
+}
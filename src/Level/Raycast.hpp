@@ -0,0 +1,240 @@
+#pragma once
+#include <yaul.h>
+#include "TileMap.hpp"
+
+namespace Utenyaa::Level
+{
+    /** @brief Fixed point grid traversal (Amanatides-Woo DDA) over level tiles
+     */
+    class Raycast
+    {
+    public:
+        /** @brief Ray segment on the ground plane
+         */
+        struct Ray
+        {
+            /** @brief Start location
+             */
+            fix16_vec2_t From;
+
+            /** @brief End location
+             */
+            fix16_vec2_t To;
+        };
+
+        /** @brief Ray cast result
+         */
+        struct Hit
+        {
+            /** @brief Fraction of the segment at which solid tile was entered (FIX16_ONE if nothing was hit)
+             */
+            fix16_t Fraction;
+
+            /** @brief World location of the hit
+             */
+            fix16_vec2_t Location;
+
+            /** @brief Hit tile column
+             */
+            int16_t TileX;
+
+            /** @brief Hit tile row
+             */
+            int16_t TileY;
+
+            /** @brief Surface normal of the hit tile side (zero if the ray started inside solid tile)
+             */
+            int8_t NormalX;
+
+            /** @brief Surface normal of the hit tile side (zero if the ray started inside solid tile)
+             */
+            int8_t NormalY;
+
+            /** @brief Solid tile was hit
+             */
+            bool IsHit;
+        };
+
+    private:
+        /** @brief Segment fraction used for axes the ray does not move along
+         */
+        static constexpr fix16_t Never = 0x7fffffff;
+
+        /** @brief Smallest movement along an axis in tiles that is not treated as zero
+         */
+        static constexpr fix16_t MinimalDelta = 16;
+
+        /** @brief Axis traversal state
+         */
+        struct Axis
+        {
+            /** @brief Current tile
+             */
+            int32_t Tile;
+
+            /** @brief Tile step direction
+             */
+            int32_t Step;
+
+            /** @brief Segment fraction at which next tile boundary is crossed
+             */
+            fix16_t Next;
+
+            /** @brief Segment fraction needed to cross a whole tile
+             */
+            fix16_t Delta;
+        };
+
+        /** @brief Setup traversal along single axis
+         * @param from Start in tile units
+         * @param to End in tile units
+         * @param axis Traversal state
+         */
+        static void SetupAxis(fix16_t from, fix16_t to, Axis * axis)
+        {
+            const fix16_t delta = to - from;
+            const fix16_t fraction = from & 0xffff;
+            axis->Tile = fix16_int32_to(from);
+
+            if (delta > Raycast::MinimalDelta)
+            {
+                axis->Step = 1;
+                axis->Delta = fix16_div(FIX16_ONE, delta);
+                axis->Next = fix16_mul(FIX16_ONE - fraction, axis->Delta);
+            }
+            else if (delta < -Raycast::MinimalDelta)
+            {
+                axis->Step = -1;
+                axis->Delta = fix16_div(FIX16_ONE, -delta);
+                axis->Next = fix16_mul(fraction, axis->Delta);
+            }
+            else
+            {
+                axis->Step = 0;
+                axis->Delta = Raycast::Never;
+                axis->Next = Raycast::Never;
+            }
+        }
+
+        /** @brief Walk tiles along the segment until a solid tile is entered
+         * @param map Level tile map
+         * @param inverseTileSize Reciprocal of the tile size
+         * @param ray Ray segment
+         * @param hit Hit result (can be NULL for visibility test only)
+         * @return true Solid tile was hit
+         * @return false Segment is clear
+         */
+        static bool Traverse(const TileMap * map, fix16_t inverseTileSize, const Ray * ray, Hit * hit)
+        {
+            const fix16_vec2_t * origin = map->GetOrigin();
+            Axis x;
+            Axis y;
+            Raycast::SetupAxis(fix16_mul(ray->From.x - origin->x, inverseTileSize), fix16_mul(ray->To.x - origin->x, inverseTileSize), &x);
+            Raycast::SetupAxis(fix16_mul(ray->From.y - origin->y, inverseTileSize), fix16_mul(ray->To.y - origin->y, inverseTileSize), &y);
+
+            fix16_t fraction = FIX16_ZERO;
+            int8_t normalX = 0;
+            int8_t normalY = 0;
+
+            while (!map->IsSolid(x.Tile, y.Tile))
+            {
+                fraction = x.Next < y.Next ? x.Next : y.Next;
+
+                // Segment ends before next tile boundary
+                if (fraction > FIX16_ONE)
+                {
+                    if (hit != NULL)
+                    {
+                        hit->IsHit = false;
+                        hit->Fraction = FIX16_ONE;
+                        hit->Location = ray->To;
+                    }
+
+                    return false;
+                }
+
+                if (x.Next < y.Next)
+                {
+                    x.Tile += x.Step;
+                    x.Next += x.Delta;
+                    normalX = -x.Step;
+                    normalY = 0;
+                }
+                else
+                {
+                    y.Tile += y.Step;
+                    y.Next += y.Delta;
+                    normalX = 0;
+                    normalY = -y.Step;
+                }
+            }
+
+            if (hit != NULL)
+            {
+                hit->IsHit = true;
+                hit->Fraction = fraction;
+                hit->Location.x = ray->From.x + fix16_mul(ray->To.x - ray->From.x, fraction);
+                hit->Location.y = ray->From.y + fix16_mul(ray->To.y - ray->From.y, fraction);
+                hit->TileX = x.Tile;
+                hit->TileY = y.Tile;
+                hit->NormalX = normalX;
+                hit->NormalY = normalY;
+            }
+
+            return true;
+        }
+
+    public:
+        /** @brief Cast single ray
+         * @param map Level tile map
+         * @param ray Ray segment
+         * @param hit Hit result
+         * @return true Solid tile was hit
+         * @return false Segment is clear
+         */
+        static bool Cast(const TileMap * map, const Ray * ray, Hit * hit)
+        {
+            assert(map != NULL);
+            assert(ray != NULL);
+            assert(hit != NULL);
+            return Raycast::Traverse(map, fix16_div(FIX16_ONE, map->GetTileSize()), ray, hit);
+        }
+
+        /** @brief Cast many rays
+         * @param map Level tile map
+         * @param rays Ray segments
+         * @param hits Hit result for each ray
+         * @param count Number of rays
+         * @return Number of rays that hit a solid tile
+         */
+        static uint16_t CastBatch(const TileMap * map, const Ray * rays, Hit * hits, uint16_t count)
+        {
+            assert(map != NULL);
+            assert(rays != NULL);
+            assert(hits != NULL);
+            const fix16_t inverseTileSize = fix16_div(FIX16_ONE, map->GetTileSize());
+            uint16_t hitCount = 0;
+
+            for (uint16_t ray = 0; ray < count; ray++)
+            {
+                hitCount += Raycast::Traverse(map, inverseTileSize, &rays[ray], &hits[ray]) ? 1 : 0;
+            }
+
+            return hitCount;
+        }
+
+        /** @brief Check line of sight, stops at first solid tile without computing hit details
+         * @param map Level tile map
+         * @param from Start location
+         * @param to End location
+         * @return true Nothing blocks the line
+         * @return false Line is blocked
+         */
+        static bool IsVisible(const TileMap * map, const fix16_vec2_t * from, const fix16_vec2_t * to)
+        {
+            assert(map != NULL);
+            const Ray ray = { From : *from, To : *to };
+            return !Raycast::Traverse(map, fix16_div(FIX16_ONE, map->GetTileSize()), &ray, NULL);
+        }
+    };
+}
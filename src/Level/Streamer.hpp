@@ -0,0 +1,583 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+#include "../../Dependencies/Skathi/Cd.hpp"
+#include "../Rendering/Floor.hpp"
+#include "LevelFile.hpp"
+#include "TileMap.hpp"
+
+namespace Utenyaa::Level
+{
+    /** @brief Streams square chunks of a large level around players (level file created by Tools/LevelConverter -s)
+     * @details File layout (big endian): header, floor cells (16 color, 32 bytes each) and chunks starting at sector boundary.
+     * Each chunk has tile flags (chunk tiles * chunk tiles bytes) followed by floor pattern names (cell index of each chunk cell, row major).
+     * Chunks are kept in a fixed number of slots, chunks nobody needs are evicted when a new one has to be loaded.
+     * Missing chunks are queued on CdScheduler without waiting, up to LEVEL_CHUNK_READS at once, and are moved into a slot by a later
+     * Update once their read finished, so the game never waits for a whole chunk.
+     * Drive backend still reads with blocking cd_block_sectors_read, so the frame that serves a chunk read waits for its sectors
+     * and a seek to the chunk stalls that frame (50 to 400 ms, see CdScheduler::GetSeekCost). Reads are not yet started on the CD block
+     * and polled across frames.
+     */
+    class Streamer
+    {
+    public:
+        /** @brief File identifier ("ULVC")
+         */
+        static constexpr uint32_t Magic = 0x554c5643;
+
+        /** @brief Largest number of players the chunks are streamed around
+         */
+        static constexpr uint8_t MaxFocus = 4;
+
+        /** @brief File header
+         */
+        struct Header
+        {
+            /** @brief File identifier ("ULVC")
+             */
+            uint32_t Magic;
+
+            /** @brief Number of tile columns
+             */
+            uint16_t Width;
+
+            /** @brief Number of tile rows
+             */
+            uint16_t Height;
+
+            /** @brief Size of a single tile in world units
+             */
+            fix16_t TileSize;
+
+            /** @brief Number of floor cells (cell 0 is always empty)
+             */
+            uint16_t CellCount;
+
+            /** @brief Number of used floor palette colors including transparent color 0
+             */
+            uint16_t ColorCount;
+
+            /** @brief Floor palette
+             */
+            uint16_t Palette[16];
+
+            /** @brief Chunk size in tiles as power of two
+             */
+            uint16_t ChunkShift;
+
+            /** @brief Number of chunk columns
+             */
+            uint16_t ChunkColumns;
+
+            /** @brief Number of chunk rows
+             */
+            uint16_t ChunkRows;
+
+            /** @brief Not used
+             */
+            uint16_t Reserved;
+
+            /** @brief Offset of the first chunk from the start of the file
+             */
+            uint32_t ChunkOffset;
+
+            /** @brief Size of a single chunk
+             */
+            uint32_t ChunkSize;
+        };
+
+    private:
+        /** @brief Chunk read queued on the drive
+         */
+        struct PendingRead
+        {
+            /** @brief Chunk index (-1 when unused)
+             */
+            int32_t Chunk;
+
+            /** @brief Read status
+             */
+            Skathi::CdScheduler::Status Status;
+
+            /** @brief Chunk data in the buffer once read
+             */
+            const uint8_t * Data;
+
+            /** @brief Read buffer (one sector larger than a chunk, reads start at sector boundary)
+             */
+            uint8_t * Buffer;
+        };
+
+        /** @brief Level file
+         */
+        inline static const cdfs_filelist_entry_t * file = NULL;
+
+        /** @brief Level header
+         */
+        inline static Header header;
+
+        /** @brief Streamed tile map
+         */
+        inline static TileMap * map = NULL;
+
+        /** @brief Chunk data of all slots
+         */
+        inline static uint8_t * slots = NULL;
+
+        /** @brief Chunk reads in flight
+         */
+        inline static PendingRead reads[LEVEL_CHUNK_READS];
+
+        /** @brief Chunk index held by each slot (-1 for empty slot)
+         */
+        inline static int32_t slotChunks[LEVEL_CHUNK_BUDGET];
+
+        /** @brief Frame in which each slot was last needed
+         */
+        inline static uint32_t slotUsed[LEVEL_CHUNK_BUDGET];
+
+        /** @brief Current frame
+         */
+        inline static uint32_t frame = 0;
+
+        /** @brief Locations chunks are streamed around this frame
+         */
+        inline static fix16_vec3_t focus[Streamer::MaxFocus];
+
+        /** @brief Number of locations chunks are streamed around this frame
+         */
+        inline static uint8_t focusCount = 0;
+
+        /** @brief Number of chunks that were needed but could not be loaded yet
+         */
+        inline static uint16_t missing = 0;
+
+        /** @brief Chunk picked by last Update to be written into the floor window (-1 when there is none)
+         */
+        inline static int32_t floorChunk = -1;
+
+        /** @brief Slot holding the chunk to be written into the floor window
+         */
+        inline static int8_t floorSlot = -1;
+
+        /** @brief Chunk column of the chunk to be written into the floor window
+         */
+        inline static int32_t floorX = 0;
+
+        /** @brief Chunk row of the chunk to be written into the floor window
+         */
+        inline static int32_t floorY = 0;
+
+        /** @brief Chunk the first focus was in when the ring around it was prefetched (-1 before first prefetch)
+         */
+        inline static int32_t prefetchCenter = -1;
+
+        /** @brief Find slot holding a chunk
+         * @param chunk Chunk index
+         * @return Slot index or -1 if chunk is not loaded
+         */
+        static int8_t FindSlot(int32_t chunk)
+        {
+            for (uint8_t slot = 0; slot < LEVEL_CHUNK_BUDGET; slot++)
+            {
+                if (Streamer::slotChunks[slot] == chunk)
+                {
+                    return slot;
+                }
+            }
+
+            return -1;
+        }
+
+        /** @brief Get chunk data of a slot
+         * @param slot Slot index
+         * @return Tile flags followed by floor pattern names
+         */
+        static uint8_t * GetSlotData(uint8_t slot)
+        {
+            return Streamer::slots + (slot * Streamer::header.ChunkSize);
+        }
+
+        /** @brief Get floor pattern names of a chunk
+         * @param slot Slot index
+         * @return Pattern names
+         */
+        static const uint16_t * GetSlotPatterns(uint8_t slot)
+        {
+            return (const uint16_t*)(Streamer::GetSlotData(slot) + (1 << (Streamer::header.ChunkShift << 1)));
+        }
+
+        /** @brief Visit chunks in rings around each focus, ring 0 is the chunk the focus is in
+         * @tparam Visitor Visitor type
+         * @param visit Called with focus index, chunk index, chunk column and chunk row
+         */
+        template<typename Visitor>
+        static void ForEachWanted(Visitor visit)
+        {
+            const int32_t shift = Streamer::header.ChunkShift;
+
+            for (int32_t ring = 0; ring <= LEVEL_CHUNK_RADIUS; ring++)
+            {
+                for (uint8_t location = 0; location < Streamer::focusCount; location++)
+                {
+                    int32_t tileX;
+                    int32_t tileY;
+                    Streamer::map->WorldToTile(&Streamer::focus[location], &tileX, &tileY);
+                    const int32_t centerX = tileX >> shift;
+                    const int32_t centerY = tileY >> shift;
+
+                    for (int32_t y = centerY - ring; y <= centerY + ring; y++)
+                    {
+                        for (int32_t x = centerX - ring; x <= centerX + ring; x++)
+                        {
+                            const bool edge = y == centerY - ring || y == centerY + ring || x == centerX - ring || x == centerX + ring;
+
+                            if (edge && x >= 0 && y >= 0 && x < Streamer::header.ChunkColumns && y < Streamer::header.ChunkRows)
+                            {
+                                visit(location, (y * Streamer::header.ChunkColumns) + x, x, y);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        /** @brief Prefetch chunks of the ring just past the streamed radius around the first focus into the DRAM cartridge
+         * @details Done only when the first focus enters another chunk, later loads of those chunks then do not touch the drive.
+         */
+        static void PrefetchRing()
+        {
+            int32_t tileX;
+            int32_t tileY;
+            Streamer::map->WorldToTile(&Streamer::focus[0], &tileX, &tileY);
+            const int32_t centerX = tileX >> Streamer::header.ChunkShift;
+            const int32_t centerY = tileY >> Streamer::header.ChunkShift;
+            const int32_t center = (centerY * Streamer::header.ChunkColumns) + centerX;
+
+            if (center == Streamer::prefetchCenter)
+            {
+                return;
+            }
+
+            Streamer::prefetchCenter = center;
+            const int32_t ring = LEVEL_CHUNK_RADIUS + 1;
+
+            for (int32_t y = centerY - ring; y <= centerY + ring; y++)
+            {
+                for (int32_t x = centerX - ring; x <= centerX + ring; x++)
+                {
+                    const bool edge = y == centerY - ring || y == centerY + ring || x == centerX - ring || x == centerX + ring;
+
+                    if (edge && x >= 0 && y >= 0 && x < Streamer::header.ChunkColumns && y < Streamer::header.ChunkRows)
+                    {
+                        const int32_t chunk = (y * Streamer::header.ChunkColumns) + x;
+                        Skathi::Cd::Prefetch(Streamer::file, Streamer::header.ChunkOffset + (chunk * Streamer::header.ChunkSize), Streamer::header.ChunkSize);
+                    }
+                }
+            }
+        }
+
+        /** @brief Find chunk read in flight
+         * @param chunk Chunk index
+         * @return Read index or -1 if chunk is not being read
+         */
+        static int8_t FindRead(int32_t chunk)
+        {
+            for (uint8_t read = 0; read < LEVEL_CHUNK_READS; read++)
+            {
+                if (Streamer::reads[read].Chunk == chunk)
+                {
+                    return read;
+                }
+            }
+
+            return -1;
+        }
+
+        /** @brief Check whether any chunk read is still waiting for the drive
+         * @return true Some read is queued
+         * @return false All reads are finished or unused
+         */
+        static bool IsReading()
+        {
+            for (uint8_t read = 0; read < LEVEL_CHUNK_READS; read++)
+            {
+                if (Streamer::reads[read].Chunk >= 0 && Streamer::reads[read].Status == Skathi::CdScheduler::Status::Queued)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        /** @brief Queue chunk read without waiting for it
+         * @param chunk Chunk index
+         * @return true Read was queued
+         * @return false All reads are in flight or drive queue is full
+         */
+        static bool Queue(int32_t chunk)
+        {
+            const int8_t read = Streamer::FindRead(-1);
+
+            if (read < 0)
+            {
+                return false;
+            }
+
+            PendingRead * pending = &Streamer::reads[read];
+            pending->Data = Skathi::Cd::QueueFileRange(
+                Streamer::file,
+                Streamer::header.ChunkOffset + (chunk * Streamer::header.ChunkSize),
+                Streamer::header.ChunkSize,
+                pending->Buffer,
+                &pending->Status);
+
+            if (pending->Data == NULL)
+            {
+                return false;
+            }
+
+            pending->Chunk = chunk;
+            return true;
+        }
+
+        /** @brief Copy chunk into the least recently needed slot that is not needed this frame
+         * @param chunk Chunk index
+         * @param data Chunk data
+         * @return true Chunk was loaded
+         * @return false No slot is free
+         */
+        static bool Install(int32_t chunk, const uint8_t * data)
+        {
+            int8_t oldest = -1;
+
+            for (uint8_t slot = 0; slot < LEVEL_CHUNK_BUDGET; slot++)
+            {
+                if (Streamer::slotUsed[slot] != Streamer::frame && (oldest < 0 || Streamer::slotUsed[slot] < Streamer::slotUsed[oldest]))
+                {
+                    oldest = slot;
+                }
+            }
+
+            if (oldest < 0)
+            {
+                return false;
+            }
+
+            if (Streamer::slotChunks[oldest] >= 0)
+            {
+                Streamer::map->SetChunk(Streamer::slotChunks[oldest], NULL);
+            }
+
+            memcpy(Streamer::GetSlotData(oldest), data, Streamer::header.ChunkSize);
+            Streamer::slotChunks[oldest] = chunk;
+            Streamer::slotUsed[oldest] = Streamer::frame;
+            Streamer::map->SetChunk(chunk, Streamer::GetSlotData(oldest));
+            return true;
+        }
+
+        /** @brief Move finished chunk reads into slots, read that finds no free slot waits for a later frame
+         */
+        static void FinishReads()
+        {
+            for (uint8_t read = 0; read < LEVEL_CHUNK_READS; read++)
+            {
+                PendingRead * pending = &Streamer::reads[read];
+
+                if (pending->Chunk < 0 || pending->Status == Skathi::CdScheduler::Status::Queued)
+                {
+                    continue;
+                }
+
+                if (pending->Status == Skathi::CdScheduler::Status::Failed || Streamer::Install(pending->Chunk, pending->Data))
+                {
+                    pending->Chunk = -1;
+                }
+            }
+        }
+
+    public:
+        /** @brief Open streamed level, no chunks are loaded until first Update
+         * @param entry Level file
+         * @return Streamed tile map
+         */
+        static TileMap * Initialize(const cdfs_filelist_entry_t * entry)
+        {
+            assert(entry != NULL);
+            Streamer::file = entry;
+
+            // Header and floor cells are read once and stay in VDP2 memory
+            uint8_t * start = (uint8_t*)malloc(Skathi::Cd::SectorSize);
+            assert(start != NULL);
+            const bool loaded = Skathi::Cd::ReadFileRange(entry, 0, sizeof(Header), start) != NULL;
+            assert(loaded);
+            memcpy(&Streamer::header, start, sizeof(Header));
+            free(start);
+
+            const Header * info = &Streamer::header;
+            assert(info->Magic == Streamer::Magic);
+
+            const uint32_t cellsSize = info->CellCount * LevelFile::CellSize;
+            uint8_t * cells = (uint8_t*)malloc(sizeof(Header) + cellsSize);
+            assert(cells != NULL);
+            const bool cellsLoaded = Skathi::Cd::ReadFileRange(entry, 0, sizeof(Header) + cellsSize, cells) != NULL;
+            assert(cellsLoaded);
+            Utenyaa::Rendering::Floor::InitializeStreamed(cells + sizeof(Header), info->CellCount, info->Palette, info->Width, info->Height, info->TileSize, 1 << info->ChunkShift);
+            free(cells);
+
+            // Chunks around the first focus have to fit into the floor window
+            assert((LEVEL_CHUNK_RADIUS * 2) + 1 <= Utenyaa::Rendering::Floor::GetWindowSize());
+
+            // All chunk memory is allocated up front
+            Streamer::slots = (uint8_t*)malloc(LEVEL_CHUNK_BUDGET * info->ChunkSize);
+            assert(Streamer::slots != NULL);
+
+            for (uint8_t read = 0; read < LEVEL_CHUNK_READS; read++)
+            {
+                Streamer::reads[read].Chunk = -1;
+                Streamer::reads[read].Buffer = (uint8_t*)malloc(info->ChunkSize + Skathi::Cd::SectorSize);
+                assert(Streamer::reads[read].Buffer != NULL);
+            }
+
+            for (uint8_t slot = 0; slot < LEVEL_CHUNK_BUDGET; slot++)
+            {
+                Streamer::slotChunks[slot] = -1;
+                Streamer::slotUsed[slot] = 0;
+            }
+
+            Streamer::frame = 0;
+            Streamer::focusCount = 0;
+            Streamer::prefetchCenter = -1;
+            Streamer::floorChunk = -1;
+            Streamer::map = new TileMap(info->Width, info->Height, info->TileSize, info->ChunkShift);
+            return Streamer::map;
+        }
+
+        /** @brief Check whether level is streamed
+         * @return true Streamer was initialized
+         * @return false Level is loaded whole or there is no level file
+         */
+        static bool IsActive()
+        {
+            return Streamer::map != NULL;
+        }
+
+        /** @brief Add location chunks are streamed around this frame, first location is followed by the floor
+         * @param location World location
+         */
+        static void AddFocus(const fix16_vec3_t * location)
+        {
+            if (Streamer::focusCount < Streamer::MaxFocus)
+            {
+                Streamer::focus[Streamer::focusCount++] = *location;
+            }
+        }
+
+        /** @brief Install chunks read since last update and queue reads of missing chunks near focus locations, nearest chunks first
+         * @details VDP2 is not touched, chunk missing from the floor window is only picked here and written by WriteFloor.
+         */
+        static void Update()
+        {
+            if (Streamer::map == NULL)
+            {
+                return;
+            }
+
+            Streamer::frame++;
+            Streamer::missing = 0;
+            Streamer::floorChunk = -1;
+            bool queueFull = false;
+
+            // Loaded chunks needed this frame must not be evicted by chunks loaded below
+            Streamer::ForEachWanted([](uint8_t location __unused, int32_t chunk, int32_t x __unused, int32_t y __unused)
+            {
+                const int8_t slot = Streamer::FindSlot(chunk);
+
+                if (slot >= 0)
+                {
+                    Streamer::slotUsed[slot] = Streamer::frame;
+                }
+            });
+
+            // Slots needed this frame are marked, so finished reads evict only chunks nobody needs
+            Streamer::FinishReads();
+
+            Streamer::ForEachWanted([&queueFull](uint8_t location, int32_t chunk, int32_t x, int32_t y)
+            {
+                const int8_t slot = Streamer::FindSlot(chunk);
+
+                if (slot < 0)
+                {
+                    if (!queueFull && Streamer::FindRead(chunk) < 0)
+                    {
+                        queueFull = !Streamer::Queue(chunk);
+                    }
+
+                    Streamer::missing++;
+                    return;
+                }
+
+                // Floor window follows the first focus, one chunk is written per frame by WriteFloor
+                if (location == 0 && Streamer::floorChunk < 0 && !Utenyaa::Rendering::Floor::HasChunk(chunk, x, y))
+                {
+                    Streamer::floorChunk = chunk;
+                    Streamer::floorSlot = slot;
+                    Streamer::floorX = x;
+                    Streamer::floorY = y;
+                }
+            });
+
+            if (Streamer::focusCount > 0)
+            {
+                Streamer::PrefetchRing();
+            }
+
+            Streamer::focusCount = 0;
+        }
+
+        /** @brief Write chunk picked by last Update into the floor window (VDP2 is written, has to be called between FramePipeline::Wait and Submit)
+         */
+        static void WriteFloor()
+        {
+            if (Streamer::floorChunk >= 0)
+            {
+                Utenyaa::Rendering::Floor::LoadChunk(Streamer::floorChunk, Streamer::floorX, Streamer::floorY, Streamer::GetSlotPatterns(Streamer::floorSlot));
+                Streamer::floorChunk = -1;
+            }
+        }
+
+        /** @brief Load chunks around focus locations added since last update and wait for them (used while loading)
+         */
+        static void Preload()
+        {
+            fix16_vec3_t locations[Streamer::MaxFocus];
+            const uint8_t count = Streamer::focusCount;
+            memcpy(locations, Streamer::focus, count * sizeof(fix16_vec3_t));
+
+            while (true)
+            {
+                memcpy(Streamer::focus, locations, count * sizeof(fix16_vec3_t));
+                Streamer::focusCount = count;
+                Streamer::Update();
+                Streamer::WriteFloor();
+
+                // Chunks that do not fit into slots or cannot be read are left missing
+                if (Streamer::missing == 0 || !Streamer::IsReading())
+                {
+                    break;
+                }
+
+                Skathi::CdScheduler::Update(Skathi::CdScheduler::DiscSectors, 0);
+            }
+        }
+
+        /** @brief Get number of chunks that were needed in last update but are not loaded
+         * @return Missing chunk count
+         */
+        static uint16_t GetMissing()
+        {
+            return Streamer::missing;
+        }
+    };
+}
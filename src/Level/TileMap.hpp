@@ -0,0 +1,254 @@
+#pragma once
+#include <yaul.h>
+
+namespace Utenyaa::Level
+{
+    /** @brief Tile flags
+     */
+    enum TileFlags : uint8_t
+    {
+        /** @brief Tile can be driven over
+         */
+        Empty = 0,
+
+        /** @brief Tile blocks movement and projectiles
+         */
+        Solid = 1 << 0,
+    };
+
+    /** @brief Level tile grid, world origin is at the center of the grid
+     * @details Streamed map keeps only loaded square chunks of tiles (see Level::Streamer), tiles of chunks that are not loaded are solid.
+     */
+    class TileMap
+    {
+    private:
+        /** @brief Tile flags (NULL for streamed map)
+         */
+        uint8_t * tiles;
+
+        /** @brief Tile flags of each chunk (NULL for chunks that are not loaded, whole table is NULL for map that is not streamed)
+         */
+        const uint8_t ** chunks;
+
+        /** @brief Chunk size in tiles as power of two
+         */
+        uint8_t chunkShift;
+
+        /** @brief Number of chunk columns
+         */
+        uint16_t chunkColumns;
+
+        /** @brief Number of tile columns
+         */
+        uint16_t width;
+
+        /** @brief Number of tile rows
+         */
+        uint16_t height;
+
+        /** @brief Size of a single tile in world units
+         */
+        fix16_t tileSize;
+
+        /** @brief World location of the top left corner of the grid
+         */
+        fix16_vec2_t origin;
+
+    public:
+        /** @brief Construct a new empty tile map
+         * @param width Number of tile columns
+         * @param height Number of tile rows
+         * @param tileSize Size of a single tile in world units
+         */
+        TileMap(uint16_t width, uint16_t height, fix16_t tileSize)
+        {
+            assert(width > 0 && height > 0);
+            this->width = width;
+            this->height = height;
+            this->tileSize = tileSize;
+            this->origin.x = -(tileSize * width) >> 1;
+            this->origin.y = -(tileSize * height) >> 1;
+            this->tiles = (uint8_t*)malloc(width * height);
+            assert(this->tiles != NULL);
+            memset(this->tiles, TileFlags::Empty, width * height);
+            this->chunks = NULL;
+            this->chunkShift = 0;
+            this->chunkColumns = 0;
+        }
+
+        /** @brief Construct a new streamed tile map with no chunks loaded
+         * @param width Number of tile columns
+         * @param height Number of tile rows
+         * @param tileSize Size of a single tile in world units
+         * @param chunkShift Chunk size in tiles as power of two
+         */
+        TileMap(uint16_t width, uint16_t height, fix16_t tileSize, uint8_t chunkShift)
+        {
+            assert(width > 0 && height > 0);
+            this->width = width;
+            this->height = height;
+            this->tileSize = tileSize;
+            this->origin.x = -(tileSize * width) >> 1;
+            this->origin.y = -(tileSize * height) >> 1;
+            this->tiles = NULL;
+            this->chunkShift = chunkShift;
+            this->chunkColumns = (width + (1 << chunkShift) - 1) >> chunkShift;
+
+            const uint32_t count = this->chunkColumns * ((height + (1 << chunkShift) - 1) >> chunkShift);
+            this->chunks = (const uint8_t**)malloc(count * sizeof(uint8_t*));
+            assert(this->chunks != NULL);
+            memset(this->chunks, 0, count * sizeof(uint8_t*));
+        }
+
+        /** @brief Destroy the tile map
+         */
+        ~TileMap()
+        {
+            free(this->tiles);
+            free(this->chunks);
+        }
+
+        /** @brief Get number of tile columns
+         * @return Tile column count
+         */
+        uint16_t GetWidth() const
+        {
+            return this->width;
+        }
+
+        /** @brief Get number of tile rows
+         * @return Tile row count
+         */
+        uint16_t GetHeight() const
+        {
+            return this->height;
+        }
+
+        /** @brief Get size of a single tile in world units
+         * @return Tile size
+         */
+        fix16_t GetTileSize() const
+        {
+            return this->tileSize;
+        }
+
+        /** @brief Get world location of the top left corner of the grid
+         * @return Grid origin
+         */
+        const fix16_vec2_t * GetOrigin() const
+        {
+            return &this->origin;
+        }
+
+        /** @brief Get raw tile data (row major)
+         * @return Tile flags (NULL for streamed map)
+         */
+        uint8_t * GetTiles()
+        {
+            return this->tiles;
+        }
+
+        /** @brief Check whether map is made of streamed chunks
+         * @return true Map is streamed
+         * @return false Whole map is in memory
+         */
+        bool IsStreamed() const
+        {
+            return this->chunks != NULL;
+        }
+
+        /** @brief Set tile flags of a chunk of streamed map
+         * @param chunk Chunk index (row major)
+         * @param chunkTiles Tile flags of the chunk (row major) or NULL when chunk was unloaded
+         */
+        void SetChunk(uint32_t chunk, const uint8_t * chunkTiles)
+        {
+            assert(this->chunks != NULL);
+            this->chunks[chunk] = chunkTiles;
+        }
+
+        /** @brief Get flags of a tile
+         * @param x Tile column
+         * @param y Tile row
+         * @return Tile flags (tiles outside of the grid are solid)
+         */
+        uint8_t Get(int32_t x, int32_t y) const
+        {
+            if (x < 0 || y < 0 || x >= this->width || y >= this->height)
+            {
+                return TileFlags::Solid;
+            }
+            else if (this->chunks != NULL)
+            {
+                const uint8_t * chunk = this->chunks[((y >> this->chunkShift) * this->chunkColumns) + (x >> this->chunkShift)];
+                const int32_t mask = (1 << this->chunkShift) - 1;
+                return chunk != NULL ? chunk[((y & mask) << this->chunkShift) + (x & mask)] : (uint8_t)TileFlags::Solid;
+            }
+
+            return this->tiles[(y * this->width) + x];
+        }
+
+        /** @brief Set flags of a tile
+         * @param x Tile column
+         * @param y Tile row
+         * @param flags Tile flags
+         */
+        void Set(uint16_t x, uint16_t y, uint8_t flags)
+        {
+            assert(x < this->width && y < this->height);
+            assert(this->tiles != NULL);
+            this->tiles[(y * this->width) + x] = flags;
+        }
+
+        /** @brief Check whether tile blocks movement
+         * @param x Tile column
+         * @param y Tile row
+         * @return true Tile is solid or outside of the grid
+         * @return false Tile can be driven over
+         */
+        bool IsSolid(int32_t x, int32_t y) const
+        {
+            return (this->Get(x, y) & TileFlags::Solid) != 0;
+        }
+
+        /** @brief Make border of the grid solid
+         */
+        void AddBorder()
+        {
+            for (uint16_t x = 0; x < this->width; x++)
+            {
+                this->Set(x, 0, TileFlags::Solid);
+                this->Set(x, this->height - 1, TileFlags::Solid);
+            }
+
+            for (uint16_t y = 0; y < this->height; y++)
+            {
+                this->Set(0, y, TileFlags::Solid);
+                this->Set(this->width - 1, y, TileFlags::Solid);
+            }
+        }
+
+        /** @brief Convert world location to tile coordinates
+         * @param location World location
+         * @param x Tile column (can be outside of the grid)
+         * @param y Tile row (can be outside of the grid)
+         */
+        void WorldToTile(const fix16_vec3_t * location, int32_t * x, int32_t * y) const
+        {
+            *x = fix16_int32_to(fix16_div(location->x - this->origin.x, this->tileSize));
+            *y = fix16_int32_to(fix16_div(location->y - this->origin.y, this->tileSize));
+        }
+
+        /** @brief Get world location of a tile center
+         * @param x Tile column
+         * @param y Tile row
+         * @param location Tile center
+         */
+        void TileToWorld(int32_t x, int32_t y, fix16_vec3_t * location) const
+        {
+            location->x = this->origin.x + (this->tileSize * x) + (this->tileSize >> 1);
+            location->y = this->origin.y + (this->tileSize * y) + (this->tileSize >> 1);
+            location->z = FIX16_ZERO;
+        }
+    };
+}
@@ -0,0 +1,265 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+#include "../Level/TileMap.hpp"
+#include "Floor.hpp"
+#include "Viewports.hpp"
+
+namespace Utenyaa::Rendering
+{
+    /** @brief Persistent ground decals (track marks) drawn into NBG1 bitmap above the floor
+     * @details Decals are stamped into a copy of the bitmap in work RAM. Changed 8x8 blocks are queued in a ring
+     * and only a fixed number of them is uploaded each frame, so cost does not grow with number of decals.
+     */
+    class Decals
+    {
+    public:
+        /** @brief Bitmap width and height in pixels
+         */
+        static constexpr uint16_t Size = 512;
+
+        /** @brief Number of 8x8 blocks along one side of the bitmap
+         */
+        static constexpr uint16_t Blocks = Size / 8;
+
+        /** @brief Bitmap color of worn ground
+         */
+        static constexpr uint8_t Worn = 1;
+
+        /** @brief Bitmap color of tread imprint
+         */
+        static constexpr uint8_t Imprint = 2;
+
+    private:
+        /** @brief Bitmap data (bank A1, 16 colors)
+         */
+        static constexpr vdp2_vram_t BitmapBase = VDP2_VRAM_ADDR(1, 0x00000);
+
+        /** @brief Bytes per bitmap line
+         */
+        static constexpr uint16_t Stride = Size >> 1;
+
+        /** @brief Decal palette number (16 color palettes)
+         */
+        static constexpr uint16_t Palette = DECAL_PALETTE;
+
+        /** @brief Bitmap copy in work RAM
+         */
+        inline static uint8_t * bitmap = NULL;
+
+        /** @brief Queued blocks (bit N is set for block N)
+         */
+        inline static uint8_t queued[(Blocks * Blocks) >> 3];
+
+        /** @brief Ring of blocks waiting for upload, each block is in the ring at most once so it can never overflow
+         */
+        inline static uint16_t ring[Blocks * Blocks];
+
+        /** @brief Oldest queued block
+         */
+        inline static uint16_t head;
+
+        /** @brief Number of queued blocks
+         */
+        inline static uint16_t pending;
+
+        /** @brief World location of the bitmap top left corner
+         */
+        inline static fix16_vec2_t origin;
+
+        /** @brief Bitmap pixels per world unit
+         */
+        inline static fix16_t pixelsPerUnit;
+
+        /** @brief Queue block for upload
+         * @param x Pixel column
+         * @param y Pixel row
+         */
+        static void MarkDirty(int32_t x, int32_t y)
+        {
+            const uint16_t block = ((y >> 3) * Decals::Blocks) + (x >> 3);
+
+            if ((Decals::queued[block >> 3] & (1 << (block & 7))) == 0)
+            {
+                Decals::queued[block >> 3] |= 1 << (block & 7);
+                Decals::ring[(Decals::head + Decals::pending) % (Decals::Blocks * Decals::Blocks)] = block;
+                Decals::pending++;
+            }
+        }
+
+        /** @brief Set bitmap pixel
+         * @param x World X coordinate
+         * @param y World Y coordinate
+         * @param color Color index
+         */
+        static void Plot(fix16_t x, fix16_t y, uint8_t color)
+        {
+            const int32_t column = fix16_int32_to(fix16_mul(x - Decals::origin.x, Decals::pixelsPerUnit));
+            const int32_t row = fix16_int32_to(fix16_mul(y - Decals::origin.y, Decals::pixelsPerUnit));
+
+            if (column < 0 || row < 0 || column >= Decals::Size || row >= Decals::Size)
+            {
+                return;
+            }
+
+            // Left pixel is in the high nibble, imprint is never overwritten by lighter wear
+            uint8_t * pixels = &Decals::bitmap[(row * Decals::Stride) + (column >> 1)];
+            const uint8_t shift = (column & 1) == 0 ? 4 : 0;
+            const uint8_t current = (*pixels >> shift) & 0x0f;
+
+            if (current < color)
+            {
+                *pixels = (*pixels & ~(0x0f << shift)) | (color << shift);
+                Decals::MarkDirty(column, row);
+            }
+        }
+
+    public:
+        /** @brief Allocate decal bitmap and enable NBG1
+         * @param map Level tile map, bitmap is stretched over the whole level
+         */
+        static void Initialize(const Utenyaa::Level::TileMap * map)
+        {
+            if (Decals::bitmap == NULL)
+            {
+                Decals::bitmap = (uint8_t*)malloc(Decals::Stride * Decals::Size);
+                assert(Decals::bitmap != NULL);
+            }
+
+            // Keep floor resolution when the level fits, otherwise cover the whole level at lower resolution
+            const uint16_t tiles = map->GetWidth() > map->GetHeight() ? map->GetWidth() : map->GetHeight();
+            const fix16_t levelSize = map->GetTileSize() * tiles;
+            const fix16_t floorPixels = fix16_div(fix16_int32_from(Utenyaa::Level::LevelFile::CellsPerTile * 8), map->GetTileSize());
+            const fix16_t fitPixels = fix16_div(fix16_int32_from(Decals::Size), levelSize);
+            Decals::pixelsPerUnit = floorPixels < fitPixels ? floorPixels : fitPixels;
+            Decals::origin = *map->GetOrigin();
+
+            // Color RAM has to be written by words
+            volatile uint16_t * palette = (volatile uint16_t*)VDP2_CRAM_ADDR(Decals::Palette << 4);
+            palette[0] = 0;
+            palette[Decals::Worn] = DECAL_WORN_COLOR;
+            palette[Decals::Imprint] = DECAL_IMPRINT_COLOR;
+
+            const vdp2_scrn_bitmap_format_t format = {
+                scroll_screen : VDP2_SCRN_NBG1,
+                ccc : VDP2_SCRN_CCC_PALETTE_16,
+                bitmap_size : VDP2_SCRN_BITMAP_SIZE_512X512,
+                palette_base : VDP2_CRAM_ADDR(Decals::Palette << 4),
+                bitmap_base : Decals::BitmapBase
+            };
+
+            vdp2_scrn_bitmap_format_set(&format);
+
+            // Bitmap reads take half of the bank, rest is left for block uploads
+            const vdp2_vram_cycp_bank_t bitmapBank = {
+                t0 : VDP2_VRAM_CYCP_CHPNDR_NBG1,
+                t1 : VDP2_VRAM_CYCP_CHPNDR_NBG1,
+                t2 : VDP2_VRAM_CYCP_CHPNDR_NBG1,
+                t3 : VDP2_VRAM_CYCP_CHPNDR_NBG1,
+                t4 : VDP2_VRAM_CYCP_CPU_RW,
+                t5 : VDP2_VRAM_CYCP_CPU_RW,
+                t6 : VDP2_VRAM_CYCP_CPU_RW,
+                t7 : VDP2_VRAM_CYCP_CPU_RW
+            };
+
+            vdp2_vram_cycp_bank_set(1, &bitmapBank);
+            Decals::Clear();
+
+            vdp2_scrn_priority_set(VDP2_SCRN_NBG1, DECAL_PRIORITY);
+            vdp2_scrn_display_set(VDP2_SCRN_DISPTP_NBG1);
+        }
+
+        /** @brief Remove all decals (uploads whole bitmap at once, not meant to be called during a match)
+         */
+        static void Clear()
+        {
+            assert(Decals::bitmap != NULL);
+            memset(Decals::bitmap, 0, Decals::Stride * Decals::Size);
+            memset(Decals::queued, 0, sizeof(Decals::queued));
+            Decals::head = 0;
+            Decals::pending = 0;
+
+            scu_dma_transfer(0, (void*)Decals::BitmapBase, Decals::bitmap, Decals::Stride * Decals::Size);
+            scu_dma_transfer_wait(0);
+        }
+
+        /** @brief Stamp pair of track marks under a tank
+         * @param location Tank location
+         * @param forward Tank forward direction (unit vector)
+         */
+        static void StampTracks(const fix16_vec3_t * location, const fix16_vec3_t * forward)
+        {
+            // Rotated patch is walked in half pixel steps, so it has no holes
+            const fix16_t step = fix16_div(FIX16_ONE, Decals::pixelsPerUnit) >> 1;
+
+            // Right vector on the ground plane
+            const fix16_t rightX = -forward->y;
+            const fix16_t rightY = forward->x;
+
+            for (int8_t side = -1; side <= 1; side += 2)
+            {
+                const fix16_t centerX = location->x + (fix16_mul(rightX, DECAL_TRACK_OFFSET) * side);
+                const fix16_t centerY = location->y + (fix16_mul(rightY, DECAL_TRACK_OFFSET) * side);
+
+                // Every other pixel row across the tread gets the imprint
+                uint8_t row = 0;
+
+                for (fix16_t along = -(DECAL_TRACK_LENGTH >> 1); along <= (DECAL_TRACK_LENGTH >> 1); along += step, row++)
+                {
+                    const uint8_t color = (row & 2) != 0 ? Decals::Imprint : Decals::Worn;
+
+                    for (fix16_t across = -(DECAL_TRACK_WIDTH >> 1); across <= (DECAL_TRACK_WIDTH >> 1); across += step)
+                    {
+                        Decals::Plot(
+                            centerX + fix16_mul(forward->x, along) + fix16_mul(rightX, across),
+                            centerY + fix16_mul(forward->y, along) + fix16_mul(rightY, across),
+                            color);
+                    }
+                }
+            }
+        }
+
+        /** @brief Upload queued blocks
+         * @param budget Largest number of blocks to upload
+         */
+        static void Flush(uint16_t budget)
+        {
+            while (Decals::pending > 0 && budget-- > 0)
+            {
+                const uint16_t block = Decals::ring[Decals::head];
+                Decals::head = (Decals::head + 1) % (Decals::Blocks * Decals::Blocks);
+                Decals::pending--;
+                Decals::queued[block >> 3] &= ~(1 << (block & 7));
+
+                // 8 pixels of a block line are a single long word
+                const uint32_t offset = ((block / Decals::Blocks) * 8 * Decals::Stride) + ((block % Decals::Blocks) << 2);
+                const uint32_t * source = (const uint32_t*)(Decals::bitmap + offset);
+                volatile uint32_t * target = (volatile uint32_t*)(Decals::BitmapBase + offset);
+
+                for (uint8_t line = 0; line < 8; line++)
+                {
+                    target[line * (Decals::Stride >> 2)] = source[line * (Decals::Stride >> 2)];
+                }
+            }
+        }
+
+        /** @brief Get number of blocks waiting for upload
+         * @return Block count
+         */
+        static uint16_t GetPending()
+        {
+            return Decals::pending;
+        }
+
+        /** @brief Keep decal layer in sync with viewport camera (should be called after cameras are updated)
+         * @param viewport Viewport to follow
+         */
+        static void Update(const Viewports::Viewport * viewport)
+        {
+            if (Decals::bitmap != NULL)
+            {
+                Floor::Follow(VDP2_SCRN_NBG1, viewport, &Decals::origin, Decals::pixelsPerUnit);
+            }
+        }
+    };
+}
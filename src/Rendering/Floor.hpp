@@ -0,0 +1,323 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+#include "../Level/LevelFile.hpp"
+#include "Viewports.hpp"
+
+namespace Utenyaa::Rendering
+{
+    /** @brief Arena floor drawn by VDP2 as a scaled NBG0 tilemap, so VDP1 does not have to fill the largest area of the screen
+     * @details Camera looks straight down, so the floor stays parallel to the screen and only needs scroll and reduction.
+     * Map is made of 2x2 planes of 64x64 cells, so levels can be at most 64x64 tiles large.
+     * Streamed levels use the map as a window that wraps around, chunks around the first player are written into it as they load.
+     */
+    class Floor
+    {
+    public:
+        /** @brief Number of cells along one side of a plane
+         */
+        static constexpr uint16_t PlaneCells = 64;
+
+        /** @brief Largest level size in tiles
+         */
+        static constexpr uint16_t MaxTiles = (PlaneCells * 2) / Utenyaa::Level::LevelFile::CellsPerTile;
+
+        /** @brief Largest number of floor cells (10 bit character number)
+         */
+        static constexpr uint16_t MaxCells = 1024;
+
+        /** @brief Largest number of streamed chunks in the window
+         */
+        static constexpr uint8_t MaxWindowChunks = 16;
+
+    private:
+        /** @brief Character pattern data (bank A0)
+         */
+        static constexpr vdp2_vram_t CellBase = VDP2_VRAM_ADDR(0, 0x00000);
+
+        /** @brief Pattern name data of planes A, B, C and D (bank B0)
+         */
+        static constexpr vdp2_vram_t PlaneBase = VDP2_VRAM_ADDR(2, 0x00000);
+
+        /** @brief Size of a single plane of 1 word pattern names
+         */
+        static constexpr uint32_t PlaneSize = PlaneCells * PlaneCells * sizeof(uint16_t);
+
+        /** @brief Floor palette number (16 color palettes)
+         */
+        static constexpr uint16_t Palette = FLOOR_PALETTE;
+
+        /** @brief Floor was loaded
+         */
+        inline static bool loaded = false;
+
+        /** @brief World location of the top left corner of the floor
+         */
+        inline static fix16_vec2_t origin;
+
+        /** @brief Floor pixels per world unit
+         */
+        inline static fix16_t pixelsPerUnit;
+
+        /** @brief Chunk size of streamed floor in cells
+         */
+        inline static uint16_t chunkCells = 0;
+
+        /** @brief Chunk shown in each place of the window (-1 for none)
+         */
+        inline static int32_t windowChunks[Floor::MaxWindowChunks];
+
+        /** @brief Set pattern name of a map cell
+         * @param x Map cell column
+         * @param y Map cell row
+         * @param cell Character number
+         */
+        static void SetName(uint16_t x, uint16_t y, uint16_t cell)
+        {
+            const uint8_t plane = ((y / Floor::PlaneCells) << 1) + (x / Floor::PlaneCells);
+            volatile uint16_t * names = (volatile uint16_t*)(Floor::PlaneBase + (plane * Floor::PlaneSize));
+
+            // 1 word pattern name: palette number in top 4 bits, character number in bottom 10 bits
+            names[((y % Floor::PlaneCells) * Floor::PlaneCells) + (x % Floor::PlaneCells)] = (Floor::Palette << 12) | cell;
+        }
+
+        /** @brief Upload cells and palette and enable NBG0
+         * @param cells 16 color cells
+         * @param cellCount Number of cells
+         * @param colors Floor palette
+         * @param width Level width in tiles
+         * @param height Level height in tiles
+         * @param tileSize Size of a single tile in world units
+         */
+        static void Setup(const uint8_t * cells, uint16_t cellCount, const uint16_t * colors, uint16_t width, uint16_t height, fix16_t tileSize)
+        {
+            assert(cellCount <= Floor::MaxCells);
+
+            // Same placement as Level::TileMap, world origin is at the center of the grid
+            Floor::origin.x = -(tileSize * width) >> 1;
+            Floor::origin.y = -(tileSize * height) >> 1;
+            Floor::pixelsPerUnit = fix16_div(fix16_int32_from(Utenyaa::Level::LevelFile::CellsPerTile * 8), tileSize);
+
+            // Character pattern data can go in one go
+            scu_dma_transfer(0, (void*)Floor::CellBase, cells, cellCount * Utenyaa::Level::LevelFile::CellSize);
+            scu_dma_transfer_wait(0);
+
+            // Color RAM has to be written by words
+            volatile uint16_t * palette = (volatile uint16_t*)VDP2_CRAM_ADDR(Floor::Palette << 4);
+
+            for (uint8_t color = 0; color < 16; color++)
+            {
+                palette[color] = colors[color];
+            }
+
+            const vdp2_scrn_cell_format_t format = {
+                scroll_screen : VDP2_SCRN_NBG0,
+                ccc : VDP2_SCRN_CCC_PALETTE_16,
+                char_size : VDP2_SCRN_CHAR_SIZE_1X1,
+                pnd_size : 1,
+                aux_mode : VDP2_SCRN_AUX_MODE_0,
+                plane_size : VDP2_SCRN_PLANE_SIZE_1X1,
+                cpd_base : Floor::CellBase,
+                palette_base : VDP2_CRAM_ADDR(Floor::Palette << 4)
+            };
+
+            const vdp2_scrn_normal_map_t map = {
+                plane_a : Floor::PlaneBase,
+                plane_b : Floor::PlaneBase + Floor::PlaneSize,
+                plane_c : Floor::PlaneBase + (Floor::PlaneSize * 2),
+                plane_d : Floor::PlaneBase + (Floor::PlaneSize * 3)
+            };
+
+            vdp2_scrn_cell_format_set(&format, &map);
+
+            // Reduced NBG0 needs up to 4 pattern name and character pattern reads per cycle, banks A0 and B0 are reserved for the floor
+            const vdp2_vram_cycp_bank_t cellBank = {
+                t0 : VDP2_VRAM_CYCP_CHPNDR_NBG0,
+                t1 : VDP2_VRAM_CYCP_CHPNDR_NBG0,
+                t2 : VDP2_VRAM_CYCP_CHPNDR_NBG0,
+                t3 : VDP2_VRAM_CYCP_CHPNDR_NBG0,
+                t4 : VDP2_VRAM_CYCP_NO_ACCESS,
+                t5 : VDP2_VRAM_CYCP_NO_ACCESS,
+                t6 : VDP2_VRAM_CYCP_NO_ACCESS,
+                t7 : VDP2_VRAM_CYCP_NO_ACCESS
+            };
+
+            const vdp2_vram_cycp_bank_t nameBank = {
+                t0 : VDP2_VRAM_CYCP_PNDR_NBG0,
+                t1 : VDP2_VRAM_CYCP_PNDR_NBG0,
+                t2 : VDP2_VRAM_CYCP_PNDR_NBG0,
+                t3 : VDP2_VRAM_CYCP_PNDR_NBG0,
+                t4 : VDP2_VRAM_CYCP_NO_ACCESS,
+                t5 : VDP2_VRAM_CYCP_NO_ACCESS,
+                t6 : VDP2_VRAM_CYCP_NO_ACCESS,
+                t7 : VDP2_VRAM_CYCP_NO_ACCESS
+            };
+
+            vdp2_vram_cycp_bank_set(0, &cellBank);
+            vdp2_vram_cycp_bank_set(2, &nameBank);
+
+            // Floor is always behind sprites
+            vdp2_scrn_priority_set(VDP2_SCRN_NBG0, FLOOR_PRIORITY);
+            vdp2_scrn_display_set(VDP2_SCRN_DISPTP_NBG0);
+            Floor::loaded = true;
+        }
+
+        /** @brief Select reduction mode for coordinate increment
+         * @param increment Plane pixels per screen pixel
+         * @return Reduction mode
+         */
+        static vdp2_scrn_reduction_t GetReduction(fix16_t increment)
+        {
+            if (increment <= FIX16_ONE)
+            {
+                return VDP2_SCRN_REDUCTION_NONE;
+            }
+            else if (increment <= FIX16(2.0f))
+            {
+                return VDP2_SCRN_REDUCTION_HALF;
+            }
+
+            return VDP2_SCRN_REDUCTION_QUARTER;
+        }
+
+    public:
+        /** @brief Upload level floor into VDP2 memory and enable NBG0
+         * @param level Loaded level
+         */
+        static void Initialize(const Utenyaa::Level::LevelFile * level)
+        {
+            const Utenyaa::Level::LevelFile::Header * header = level->GetHeader();
+            assert(header->Width <= Floor::MaxTiles && header->Height <= Floor::MaxTiles);
+            Floor::chunkCells = 0;
+
+            // Spread level cells over the planes, cells outside of the level use empty cell 0
+            const uint16_t * patterns = level->GetPatterns();
+            const uint16_t columns = header->Width * Utenyaa::Level::LevelFile::CellsPerTile;
+            const uint16_t rows = header->Height * Utenyaa::Level::LevelFile::CellsPerTile;
+
+            for (uint16_t y = 0; y < Floor::PlaneCells * 2; y++)
+            {
+                for (uint16_t x = 0; x < Floor::PlaneCells * 2; x++)
+                {
+                    Floor::SetName(x, y, (x < columns && y < rows) ? patterns[(y * columns) + x] : 0);
+                }
+            }
+
+            Floor::Setup(level->GetCells(), header->CellCount, header->Palette, header->Width, header->Height, header->TileSize);
+        }
+
+        /** @brief Upload cells of a streamed level and enable NBG0 with empty map
+         * @param cells 16 color cells
+         * @param cellCount Number of cells
+         * @param colors Floor palette
+         * @param width Level width in tiles
+         * @param height Level height in tiles
+         * @param tileSize Size of a single tile in world units
+         * @param chunkTiles Chunk size in tiles
+         */
+        static void InitializeStreamed(const uint8_t * cells, uint16_t cellCount, const uint16_t * colors, uint16_t width, uint16_t height, fix16_t tileSize, uint16_t chunkTiles)
+        {
+            Floor::chunkCells = chunkTiles * Utenyaa::Level::LevelFile::CellsPerTile;
+            assert(((Floor::PlaneCells * 2) % Floor::chunkCells) == 0);
+            assert(Floor::GetWindowSize() * Floor::GetWindowSize() <= Floor::MaxWindowChunks);
+
+            for (uint8_t chunk = 0; chunk < Floor::MaxWindowChunks; chunk++)
+            {
+                Floor::windowChunks[chunk] = -1;
+            }
+
+            for (uint16_t y = 0; y < Floor::PlaneCells * 2; y++)
+            {
+                for (uint16_t x = 0; x < Floor::PlaneCells * 2; x++)
+                {
+                    Floor::SetName(x, y, 0);
+                }
+            }
+
+            Floor::Setup(cells, cellCount, colors, width, height, tileSize);
+        }
+
+        /** @brief Get number of chunks along one side of the window
+         * @return Window size in chunks
+         */
+        static uint16_t GetWindowSize()
+        {
+            return (Floor::PlaneCells * 2) / Floor::chunkCells;
+        }
+
+        /** @brief Check whether chunk is shown in the window
+         * @param chunk Chunk index
+         * @param chunkX Chunk column
+         * @param chunkY Chunk row
+         * @return true Chunk is in its place in the window
+         * @return false Window place is empty or shows other chunk
+         */
+        static bool HasChunk(int32_t chunk, uint16_t chunkX, uint16_t chunkY)
+        {
+            const uint16_t size = Floor::GetWindowSize();
+            return Floor::windowChunks[((chunkY % size) * size) + (chunkX % size)] == chunk;
+        }
+
+        /** @brief Write chunk of a streamed level into its place in the window
+         * @param chunk Chunk index
+         * @param chunkX Chunk column
+         * @param chunkY Chunk row
+         * @param patterns Cell index of each chunk cell (row major)
+         */
+        static void LoadChunk(int32_t chunk, uint16_t chunkX, uint16_t chunkY, const uint16_t * patterns)
+        {
+            const uint16_t size = Floor::GetWindowSize();
+            const uint16_t left = (chunkX % size) * Floor::chunkCells;
+            const uint16_t top = (chunkY % size) * Floor::chunkCells;
+
+            for (uint16_t y = 0; y < Floor::chunkCells; y++)
+            {
+                for (uint16_t x = 0; x < Floor::chunkCells; x++)
+                {
+                    Floor::SetName(left + x, top + y, patterns[(y * Floor::chunkCells) + x]);
+                }
+            }
+
+            Floor::windowChunks[((chunkY % size) * size) + (chunkX % size)] = chunk;
+        }
+
+        /** @brief Scroll and scale a scroll screen so its plane lies under the viewport camera
+         * @param screen Scroll screen (NBG0 or NBG1)
+         * @param viewport Viewport to follow
+         * @param origin World location of the plane top left corner
+         * @param pixelsPerUnit Plane pixels per world unit
+         */
+        static void Follow(vdp2_scrn_t screen, const Viewports::Viewport * viewport, const fix16_vec2_t * origin, fix16_t pixelsPerUnit)
+        {
+            const int32_t width = viewport->Right - viewport->Left + 1;
+            const int32_t height = viewport->Bottom - viewport->Top + 1;
+
+            // Plane pixels per screen pixel, visible ground area has to cover the whole viewport
+            const fix16_t incrementX = fix16_mul(viewport->HalfWidth << 1, pixelsPerUnit) / width;
+            const fix16_t incrementY = fix16_mul(viewport->HalfHeight << 1, pixelsPerUnit) / height;
+
+            // Top left corner of the viewport in plane pixels
+            const fix16_t scrollX = fix16_mul(viewport->Bounds[0] - origin->x, pixelsPerUnit) - (incrementX * viewport->Left);
+            const fix16_t scrollY = fix16_mul(viewport->Bounds[1] - origin->y, pixelsPerUnit) - (incrementY * viewport->Top);
+
+            const fix16_t increment = incrementX > incrementY ? incrementX : incrementY;
+            vdp2_scrn_reduction_set(screen, Floor::GetReduction(increment));
+            vdp2_scrn_reduction_x_set(screen, (q0_3_8_t)(incrementX >> 8));
+            vdp2_scrn_reduction_y_set(screen, (q0_3_8_t)(incrementY >> 8));
+            vdp2_scrn_scroll_x_set(screen, scrollX);
+            vdp2_scrn_scroll_y_set(screen, scrollY);
+        }
+
+        /** @brief Keep floor in sync with viewport camera (should be called after cameras are updated)
+         * @details Single scroll screen can follow only one camera, in split-screen it follows the first viewport.
+         * @param viewport Viewport to follow
+         */
+        static void Update(const Viewports::Viewport * viewport)
+        {
+            if (Floor::loaded)
+            {
+                Floor::Follow(VDP2_SCRN_NBG0, viewport, &Floor::origin, Floor::pixelsPerUnit);
+            }
+        }
+    };
+}
@@ -0,0 +1,239 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+#include "../Simulation/TransformTree.hpp"
+#include "../../Dependencies/Skathi/Timer.hpp"
+#include "../../Dependencies/Skathi/VDP1/OrderingTable.hpp"
+#include "../../Dependencies/Skathi/VDP1/Vdp1.hpp"
+
+namespace Utenyaa::Rendering
+{
+    /** @brief Two frames in flight, CPU simulates and builds next frame while VDP1 draws the current one
+     * @details Each frame has its own command list and snapshot of world transforms taken when the frame is started, so render
+     * code never reads simulation state that already moved on, and the list VDP1 is being fed from is never written.
+     * Only handing the next list to VDP1 waits for the previous frame, so frame time gets close to the longer of CPU and VDP1 time
+     * instead of their sum. Anything writing VDP1 VRAM or VDP2 state has to be done between Wait and Submit.
+     * Commands added with AddSorted are drawn far to near by an ordering table, each run of them is linked in place once
+     * any other command is added or the frame is submitted.
+     */
+    class FramePipeline
+    {
+    public:
+        /** @brief Single frame
+         */
+        struct Frame
+        {
+            /** @brief Command list (FRAME_COMMAND_CAPACITY entries)
+             */
+            vdp1_cmdt_t * Commands;
+
+            /** @brief Number of used commands
+             */
+            uint16_t Count;
+
+            /** @brief World transforms indexed by transform tree node handle
+             */
+            fix16_mat43_t Worlds[TRANSFORM_NODE_CAPACITY];
+
+            /** @brief Vertical blank input used by the frame was latched at
+             */
+            uint32_t Latched;
+        };
+
+    private:
+        /** @brief Commands at the start of every list (system clipping and local coordinates)
+         */
+        static constexpr uint16_t SystemCommands = 2;
+
+        /** @brief Frames, one is built while the other one is drawn
+         */
+        inline static Frame frames[2];
+
+        /** @brief Index of the frame being built
+         */
+        inline static uint8_t building = 0;
+
+        /** @brief Other frame was handed to VDP1 and was not waited for yet
+         */
+        inline static bool drawing = false;
+
+        /** @brief Ticks spent waiting for the previous frame
+         */
+        inline static uint16_t waitTicks = 0;
+
+        /** @brief Depth order of the current run of sorted commands
+         */
+        inline static Skathi::Vdp1::OrderingTable<FRAME_ORDER_BUCKETS, FRAME_COMMAND_CAPACITY> order { FRAME_ORDER_NEAR, FRAME_ORDER_FAR };
+
+        /** @brief Command that jumps to the farthest command of the current run of sorted commands
+         */
+        inline static uint16_t orderHead = 0;
+
+        /** @brief Link current run of sorted commands far to near, last one jumps to the next command in the list
+         */
+        static void Sort()
+        {
+            if (FramePipeline::order.GetCount() == 0)
+            {
+                return;
+            }
+
+            // Command list is put at the start of VDP1 command tables, so list index is also VRAM index
+            Frame * frame = &FramePipeline::frames[FramePipeline::building];
+            FramePipeline::order.Link(frame->Commands, FramePipeline::orderHead, frame->Count, 0);
+            FramePipeline::order.Clear();
+        }
+
+    public:
+        /** @brief Allocate command lists
+         */
+        static void Initialize()
+        {
+            for (uint8_t frame = 0; frame < 2; frame++)
+            {
+                FramePipeline::frames[frame].Commands = (vdp1_cmdt_t*)malloc(sizeof(vdp1_cmdt_t) * FRAME_COMMAND_CAPACITY);
+                assert(FramePipeline::frames[frame].Commands != NULL);
+                FramePipeline::frames[frame].Count = 0;
+            }
+
+            FramePipeline::building = 0;
+            FramePipeline::drawing = false;
+        }
+
+        /** @brief Start building next frame, takes snapshot of world transforms (should be called once simulation of the frame is done)
+         * @param latched Vertical blank input used by the frame was latched at
+         * @return Frame being built
+         */
+        static Frame * Begin(uint32_t latched)
+        {
+            Frame * frame = &FramePipeline::frames[FramePipeline::building];
+            Utenyaa::Simulation::TransformTree::CopyWorld(frame->Worlds);
+            frame->Latched = latched;
+
+            // Whole screen, projected vertices are centered on it until a viewport sets its own origin
+            vdp1_cmdt_system_clip_coord_set(&frame->Commands[0]);
+            frame->Commands[0].cmd_xc = VIEWPORT_SCREEN_WIDTH - 1;
+            frame->Commands[0].cmd_yc = VIEWPORT_SCREEN_HEIGHT - 1;
+
+            vdp1_cmdt_local_coord_set(&frame->Commands[1]);
+            frame->Commands[1].cmd_xa = VIEWPORT_SCREEN_WIDTH >> 1;
+            frame->Commands[1].cmd_ya = VIEWPORT_SCREEN_HEIGHT >> 1;
+
+            frame->Count = FramePipeline::SystemCommands;
+            FramePipeline::order.Clear();
+            return frame;
+        }
+
+        /** @brief Reserve commands at the end of the list of the frame being built
+         * @param count Number of commands
+         * @return First reserved command
+         */
+        static vdp1_cmdt_t * Add(uint16_t count)
+        {
+            FramePipeline::Sort();
+            Frame * frame = &FramePipeline::frames[FramePipeline::building];
+
+            // Last entry is kept for the end command
+            assert(frame->Count + count < FRAME_COMMAND_CAPACITY);
+            vdp1_cmdt_t * commands = &frame->Commands[frame->Count];
+            frame->Count += count;
+            return commands;
+        }
+
+        /** @brief Reserve command drawn in depth order with other sorted commands added right before or after it
+         * @details Command has to be written with a jump next link type, its link is rewritten when the run is sorted.
+         * @param depth Distance from the camera, farther commands are drawn first
+         * @return Reserved command
+         */
+        static vdp1_cmdt_t * AddSorted(fix16_t depth)
+        {
+            Frame * frame = &FramePipeline::frames[FramePipeline::building];
+
+            // Last entry is kept for the end command, run starts after the last unsorted command
+            assert(frame->Count + 1 < FRAME_COMMAND_CAPACITY);
+            FramePipeline::orderHead = FramePipeline::order.GetCount() == 0 ? frame->Count - 1 : FramePipeline::orderHead;
+            FramePipeline::order.Insert(frame->Count, depth);
+            return &frame->Commands[frame->Count++];
+        }
+
+        /** @brief Write sprite batch at the end of the list of the frame being built
+         * @details Sprites that do not fit into the list are dropped.
+         * @param batch Sprite batch
+         * @return Number of written sprites
+         */
+        static uint16_t AddSprites(Skathi::Vdp1::Sprite * batch)
+        {
+            FramePipeline::Sort();
+            Frame * frame = &FramePipeline::frames[FramePipeline::building];
+
+            // Last entry is kept for the end command
+            const uint16_t written = batch->Write(&frame->Commands[frame->Count], FRAME_COMMAND_CAPACITY - 1 - frame->Count);
+            frame->Count += written;
+            return written;
+        }
+
+        /** @brief Get world transform from the snapshot of the frame being built
+         * @param node Transform tree node handle
+         * @return World transform
+         */
+        static const fix16_mat43_t * GetWorld(uint16_t node)
+        {
+            assert(node < TRANSFORM_NODE_CAPACITY);
+            return &FramePipeline::frames[FramePipeline::building].Worlds[node];
+        }
+
+        /** @brief Wait until the previous frame is drawn and displayed, its command list in VRAM can be replaced after this
+         * @return true Previous frame was displayed
+         * @return false There was no frame in flight
+         */
+        static bool Wait()
+        {
+            if (!FramePipeline::drawing)
+            {
+                FramePipeline::waitTicks = 0;
+                return false;
+            }
+
+            const uint16_t start = Skathi::Timer::GetTicks();
+            vdp1_sync_wait();
+            vdp2_sync_wait();
+            FramePipeline::waitTicks = Skathi::Timer::GetElapsed(start);
+            FramePipeline::drawing = false;
+            return true;
+        }
+
+        /** @brief Hand frame being built to VDP1 without waiting for it to be drawn, next frame is built into the other list
+         */
+        static void Submit()
+        {
+            assert(!FramePipeline::drawing);
+            FramePipeline::Sort();
+            Frame * frame = &FramePipeline::frames[FramePipeline::building];
+            vdp1_cmdt_end_set(&frame->Commands[frame->Count]);
+
+            vdp1_sync_cmdt_put(frame->Commands, frame->Count + 1, 0);
+            vdp1_sync_render();
+            vdp1_sync();
+            vdp2_sync();
+
+            FramePipeline::drawing = true;
+            FramePipeline::building ^= 1;
+        }
+
+        /** @brief Get frame that was handed to VDP1 last
+         * @return Displayed frame once Wait returned true
+         */
+        static const Frame * GetDisplayed()
+        {
+            return &FramePipeline::frames[FramePipeline::building ^ 1];
+        }
+
+        /** @brief Get time last wait for the previous frame took (zero means CPU is the bottleneck)
+         * @return Time in microseconds
+         */
+        static uint32_t GetWaitMicroseconds()
+        {
+            return Skathi::Timer::ToMicroseconds(FramePipeline::waitTicks);
+        }
+    };
+}
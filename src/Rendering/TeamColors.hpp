@@ -0,0 +1,208 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+#include "../../Dependencies/Skathi/VDP1/Vdp1.hpp"
+
+namespace Utenyaa::Rendering
+{
+    /** @brief Team colors made by palette swapping a single indexed texture
+     * @details Texture is loaded into VDP1 memory once, every team gets its own 64 color bank in color RAM.
+     * Palette entries of the team ramp are tinted by the team color, all other entries are shared by every team.
+     * Top half of the texture is the hull, bottom half is the turret.
+     */
+    class TeamColors
+    {
+    public:
+        /** @brief Tank part drawn with its own region of the texture
+         */
+        enum class Part : uint8_t
+        {
+            /** @brief Hull (top half of the texture)
+             */
+            Hull = 0,
+
+            /** @brief Turret and barrel (bottom half of the texture)
+             */
+            Turret = 1
+        };
+
+        /** @brief Number of tank parts
+         */
+        static constexpr uint8_t PartCount = 2;
+
+        /** @brief Number of colors in a single team color bank
+         */
+        static constexpr uint16_t BankSize = 64;
+
+        /** @brief Maximum number of teams
+         */
+        static constexpr uint8_t MaxTeams = TEAM_COUNT;
+
+    private:
+        /** @brief First color RAM entry of team 0
+         */
+        static constexpr uint16_t BankBase = TEAM_COLOR_BANK * BankSize;
+
+        /** @brief Default team tints
+         */
+        static constexpr uint16_t Tints[TEAM_COUNT] = {
+            RGB1555(1, 31, 6, 4),
+            RGB1555(1, 6, 12, 31),
+            RGB1555(1, 8, 28, 8),
+            RGB1555(1, 31, 28, 6)
+        };
+
+        /** @brief Palette of the loaded texture
+         */
+        inline static uint16_t basePalette[BankSize];
+
+        /** @brief Number of used colors in the base palette
+         */
+        inline static uint16_t baseSize = 0;
+
+        /** @brief Texture regions of tank parts shared by all teams
+         */
+        inline static texture_t textures[PartCount];
+
+        /** @brief VDP1 color mode of the texture
+         */
+        inline static uint16_t colorMode = VDP1_CMDT_CM_CB_64;
+
+        /** @brief Tint single color channel
+         * @param channel Base channel value
+         * @param tint Tint channel value
+         * @return Tinted channel
+         */
+        static uint16_t TintChannel(uint16_t channel, uint16_t tint)
+        {
+            return (channel * tint) / 31;
+        }
+
+        /** @brief Get number of palette entries pixels of the image use
+         * @details Palettes are often saved padded to 256 entries, only the highest used index matters for the bank size.
+         * @param image Indexed image
+         * @return Highest used palette index plus one
+         */
+        static uint16_t GetUsedColors(Skathi::Bitmap::Image * image)
+        {
+            Skathi::Bitmap::ImageInfo_t info;
+            image->GetInfo(&info);
+            const uint8_t * data = image->GetImageData();
+            const uint32_t pixels = info.Size.Width * info.Size.Height;
+            uint8_t highest = 0;
+
+            for (uint32_t pixel = 0; pixel < pixels; pixel++)
+            {
+                highest = data[pixel] > highest ? data[pixel] : highest;
+            }
+
+            return highest + 1;
+        }
+
+    public:
+        /** @brief Load shared texture and write default team palettes into color RAM
+         * @param image Indexed image with pixels using at most 64 colors (at most 16 palette entries for 4bpp texture)
+         * @param textureBase Where to load texture to in VRAM
+         * @return Size of loaded image data
+         */
+        static size_t Initialize(Skathi::Bitmap::Image * image, vdp1_vram_t textureBase)
+        {
+            Skathi::Bitmap::ImageInfo_t info;
+            image->GetInfo(&info);
+            assert(info.Format == Skathi::Bitmap::ImageFormat::Indexed);
+
+            // Pixels have to stay inside of the team bank, unused padding of the palette does not matter
+            const uint16_t used = TeamColors::GetUsedColors(image);
+            assert(used <= TeamColors::BankSize && used <= info.PaletteSize);
+
+            // Palette goes to color RAM per team, texture data only once
+            texture_t texture;
+            const size_t size = Skathi::Vdp1::TextureUtils::LoadTexture(image, textureBase, &texture);
+            const Skathi::Bitmap::Color_t * palette = image->GetPalette();
+            TeamColors::baseSize = used;
+
+            // Textures with up to 16 colors are loaded as 4bpp
+            TeamColors::colorMode = Skathi::Vdp1::TextureUtils::GetColorMode(image) == VDP1_CMDT_CM_CB_16 ? VDP1_CMDT_CM_CB_16 : VDP1_CMDT_CM_CB_64;
+
+            // Every part is a band of rows, so it is not squashed into another part's sprite
+            const uint16_t partRows = info.Size.Height / TeamColors::PartCount;
+
+            for (uint8_t part = 0; part < TeamColors::PartCount; part++)
+            {
+                Skathi::Vdp1::TextureUtils::GetRows(&texture, TeamColors::colorMode, part * partRows, partRows, &TeamColors::textures[part]);
+            }
+
+            for (uint16_t color = 0; color < TeamColors::BankSize; color++)
+            {
+                TeamColors::basePalette[color] = color < used ? palette[color].Data : 0;
+            }
+
+            for (uint8_t team = 0; team < TeamColors::MaxTeams; team++)
+            {
+                TeamColors::SetTint(team, TeamColors::Tints[team]);
+            }
+
+            return size;
+        }
+
+        /** @brief Change team color
+         * @param team Team index
+         * @param tint Team color, team ramp of the base palette is multiplied by it
+         */
+        static void SetTint(uint8_t team, uint16_t tint)
+        {
+            assert(team < TeamColors::MaxTeams);
+
+            // Color RAM has to be written by words
+            volatile uint16_t * bank = (volatile uint16_t*)VDP2_CRAM_ADDR(TeamColors::BankBase + (team * TeamColors::BankSize));
+            const Skathi::Bitmap::Color_t color = Skathi::Bitmap::Color_t(tint);
+
+            for (uint16_t entry = 0; entry < TeamColors::baseSize; entry++)
+            {
+                Skathi::Bitmap::Color_t base = Skathi::Bitmap::Color_t(TeamColors::basePalette[entry]);
+
+                if (entry >= TEAM_RAMP_FIRST && entry < TEAM_RAMP_FIRST + TEAM_RAMP_COUNT)
+                {
+                    base.Components.R = TeamColors::TintChannel(base.Components.R, color.Components.R);
+                    base.Components.G = TeamColors::TintChannel(base.Components.G, color.Components.G);
+                    base.Components.B = TeamColors::TintChannel(base.Components.B, color.Components.B);
+                }
+
+                bank[entry] = base.Data;
+            }
+        }
+
+        /** @brief Get texture region of a tank part shared by all teams
+         * @param part Tank part
+         * @return Team texture of the part
+         */
+        static const texture_t * GetTexture(Part part)
+        {
+            return &TeamColors::textures[(uint8_t)part];
+        }
+
+        /** @brief Get color bank of a team (command table cmd_colr)
+         * @param team Team index
+         * @return Color bank
+         */
+        static uint16_t GetColorBank(uint8_t team)
+        {
+            assert(team < TeamColors::MaxTeams);
+            return TeamColors::BankBase + (team * TeamColors::BankSize);
+        }
+
+        /** @brief Make sprite use team texture of a tank part and team colors
+         * @param sprite Sprite to change
+         * @param team Team index
+         * @param part Tank part
+         */
+        static void Apply(Skathi::Vdp1::Sprite::Instance * sprite, uint8_t team, Part part)
+        {
+            Skathi::Vdp1::Sprite::SetTexture(sprite, TeamColors::GetTexture(part));
+            sprite->Color = TeamColors::GetColorBank(team);
+
+            // Color mode is in bits 3 to 5 of the draw mode
+            sprite->DrawMode = (sprite->DrawMode & ~(0x7 << 3)) | (TeamColors::colorMode << 3);
+        }
+    };
+}
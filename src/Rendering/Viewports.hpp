@@ -0,0 +1,205 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+
+extern "C"
+{
+#include <mic3d.h>
+};
+
+namespace Utenyaa::Rendering
+{
+    /** @brief Split-screen viewports
+     */
+    class Viewports
+    {
+    public:
+        /** @brief Maximum number of viewports
+         */
+        static constexpr uint8_t MaxCount = 4;
+
+        /** @brief Single viewport
+         */
+        struct Viewport
+        {
+            /** @brief Screen rectangle left edge
+             */
+            int16_t Left;
+
+            /** @brief Screen rectangle top edge
+             */
+            int16_t Top;
+
+            /** @brief Screen rectangle right edge (inclusive)
+             */
+            int16_t Right;
+
+            /** @brief Screen rectangle bottom edge (inclusive)
+             */
+            int16_t Bottom;
+
+            /** @brief Half size of the visible ground area along X axis
+             */
+            fix16_t HalfWidth;
+
+            /** @brief Half size of the visible ground area along Y axis
+             */
+            fix16_t HalfHeight;
+
+            /** @brief Visible ground area (min X, min Y, max X, max Y), updated by SetFocus
+             */
+            fix16_t Bounds[4];
+
+            /** @brief Viewport camera
+             */
+            camera_t Camera;
+        };
+
+    private:
+        /** @brief Viewports
+         */
+        inline static Viewport viewports[MaxCount];
+
+        /** @brief Number of active viewports
+         */
+        inline static uint8_t count;
+
+        /** @brief Viewport currently being rendered
+         */
+        inline static uint8_t active;
+
+        /** @brief Set viewport screen rectangle
+         * @param index Viewport index
+         * @param left Left edge
+         * @param top Top edge
+         * @param width Rectangle width
+         * @param height Rectangle height
+         */
+        static void SetRectangle(uint8_t index, int16_t left, int16_t top, int16_t width, int16_t height)
+        {
+            Viewport * viewport = &Viewports::viewports[index];
+            viewport->Left = left;
+            viewport->Top = top;
+            viewport->Right = left + width - 1;
+            viewport->Bottom = top + height - 1;
+
+            // Visible ground area shrinks together with the viewport, since focal length stays the same
+            viewport->HalfWidth = fix16_mul(VIEWPORT_VIEW_HALF_WIDTH, fix16_div(fix16_int32_from(width), fix16_int32_from(VIEWPORT_SCREEN_WIDTH)));
+            viewport->HalfHeight = fix16_mul(VIEWPORT_VIEW_HALF_HEIGHT, fix16_div(fix16_int32_from(height), fix16_int32_from(VIEWPORT_SCREEN_HEIGHT)));
+
+            viewport->Camera.up.x = FIX16_ZERO;
+            viewport->Camera.up.y = -FIX16_ONE;
+            viewport->Camera.up.z = FIX16_ZERO;
+        }
+
+    public:
+        /** @brief Set number of split-screen viewports
+         * @param viewportCount Number of viewports (1, 2, 3 or 4; 3 uses 4 way split with empty last quarter)
+         */
+        static void Initialize(uint8_t viewportCount)
+        {
+            assert(viewportCount > 0 && viewportCount <= Viewports::MaxCount);
+
+            const int16_t width = VIEWPORT_SCREEN_WIDTH;
+            const int16_t height = VIEWPORT_SCREEN_HEIGHT;
+            Viewports::count = viewportCount;
+            Viewports::active = 0;
+
+            if (viewportCount == 1)
+            {
+                Viewports::SetRectangle(0, 0, 0, width, height);
+            }
+            else if (viewportCount == 2)
+            {
+                Viewports::SetRectangle(0, 0, 0, width, height >> 1);
+                Viewports::SetRectangle(1, 0, height >> 1, width, height >> 1);
+            }
+            else
+            {
+                for (uint8_t index = 0; index < viewportCount; index++)
+                {
+                    Viewports::SetRectangle(index, (index & 1) * (width >> 1), (index >> 1) * (height >> 1), width >> 1, height >> 1);
+                }
+            }
+
+            const fix16_vec3_t origin = { FIX16_ZERO, FIX16_ZERO, FIX16_ZERO };
+
+            for (uint8_t index = 0; index < viewportCount; index++)
+            {
+                Viewports::SetFocus(index, &origin);
+            }
+        }
+
+        /** @brief Get number of viewports
+         * @return Viewport count
+         */
+        static uint8_t GetCount()
+        {
+            return Viewports::count;
+        }
+
+        /** @brief Get viewport
+         * @param index Viewport index
+         * @return Viewport data
+         */
+        static const Viewport * Get(uint8_t index)
+        {
+            assert(index < Viewports::count);
+            return &Viewports::viewports[index];
+        }
+
+        /** @brief Get viewport currently being rendered
+         * @return Viewport index
+         */
+        static uint8_t GetActive()
+        {
+            return Viewports::active;
+        }
+
+        /** @brief Move viewport camera above a point on the ground
+         * @param index Viewport index
+         * @param target Point the camera looks at
+         */
+        static void SetFocus(uint8_t index, const fix16_vec3_t * target)
+        {
+            assert(index < Viewports::count);
+            Viewport * viewport = &Viewports::viewports[index];
+
+            viewport->Camera.target = *target;
+            viewport->Camera.position.x = target->x;
+            viewport->Camera.position.y = target->y;
+            viewport->Camera.position.z = target->z - VIEWPORT_CAMERA_HEIGHT;
+
+            viewport->Bounds[0] = target->x - viewport->HalfWidth;
+            viewport->Bounds[1] = target->y - viewport->HalfHeight;
+            viewport->Bounds[2] = target->x + viewport->HalfWidth;
+            viewport->Bounds[3] = target->y + viewport->HalfHeight;
+        }
+
+        /** @brief Start rendering of a viewport
+         * @param index Viewport index
+         * @param commands Two command tables that receive user clipping rectangle and local coordinates of the viewport
+         */
+        static void Begin(uint8_t index, vdp1_cmdt_t * commands)
+        {
+            assert(index < Viewports::count);
+            assert(commands != NULL);
+            Viewport * viewport = &Viewports::viewports[index];
+            Viewports::active = index;
+
+            // Clip everything outside of the viewport (commands have to enable user clipping in their draw mode)
+            vdp1_cmdt_user_clip_coord_set(&commands[0]);
+            commands[0].cmd_xa = viewport->Left;
+            commands[0].cmd_ya = viewport->Top;
+            commands[0].cmd_xc = viewport->Right;
+            commands[0].cmd_yc = viewport->Bottom;
+
+            // Projected vertices are centered on the viewport
+            vdp1_cmdt_local_coord_set(&commands[1]);
+            commands[1].cmd_xa = (viewport->Left + viewport->Right + 1) >> 1;
+            commands[1].cmd_ya = (viewport->Top + viewport->Bottom + 1) >> 1;
+
+            camera_lookat(&viewport->Camera);
+        }
+    };
+}
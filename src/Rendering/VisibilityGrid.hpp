@@ -0,0 +1,154 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+
+namespace Utenyaa::Rendering
+{
+    /** @brief Coarse grid of drawable items filled once per frame and shared by all viewports
+     * @details Items are put into square cells by their ground position, cells wrap around every Wrap cells along each axis,
+     * so the grid does not depend on the level size. Viewport query visits only buckets of the cells its visible area covers,
+     * items of far cells that share a bucket are rejected by the exact bounds test.
+     * @tparam Item Item type
+     * @tparam Capacity Maximum number of items per frame
+     */
+    template<typename Item, uint16_t Capacity>
+    class VisibilityGrid
+    {
+    public:
+        /** @brief Number of cells along each axis before the grid repeats
+         */
+        static constexpr int32_t Wrap = VIEWPORT_GRID_WRAP;
+
+    private:
+        /** @brief Marks empty bucket or end of bucket chain
+         */
+        static constexpr uint16_t Empty = 0xffff;
+
+        /** @brief Bits of a fix16 coordinate below the cell index
+         */
+        static constexpr uint8_t CellShift = 16 + VIEWPORT_GRID_CELL_SHIFT;
+
+        /** @brief First item in each bucket
+         */
+        uint16_t heads[Wrap * Wrap];
+
+        /** @brief Next item in the same bucket
+         */
+        uint16_t next[Capacity];
+
+        /** @brief Item position along X axis
+         */
+        fix16_t positionX[Capacity];
+
+        /** @brief Item position along Y axis
+         */
+        fix16_t positionY[Capacity];
+
+        /** @brief Inserted items
+         */
+        Item items[Capacity];
+
+        /** @brief Number of inserted items
+         */
+        uint16_t count;
+
+        /** @brief Get bucket of a cell
+         * @param cellX Cell index along X axis
+         * @param cellY Cell index along Y axis
+         * @return Bucket index
+         */
+        static uint16_t GetBucket(int32_t cellX, int32_t cellY)
+        {
+            return (uint16_t)(((cellY & (Wrap - 1)) * Wrap) + (cellX & (Wrap - 1)));
+        }
+
+    public:
+        static_assert((Wrap & (Wrap - 1)) == 0, "Grid wrap has to be a power of two");
+
+        /** @brief Construct a new empty grid
+         */
+        VisibilityGrid()
+        {
+            this->Clear();
+        }
+
+        /** @brief Remove all items (should be called before the grid is filled for the frame)
+         */
+        void Clear()
+        {
+            memset(this->heads, 0xff, sizeof(this->heads));
+            this->count = 0;
+        }
+
+        /** @brief Get number of inserted items
+         * @return Item count
+         */
+        uint16_t GetCount() const
+        {
+            return this->count;
+        }
+
+        /** @brief Insert item
+         * @param position Item position on the ground
+         * @param item Item
+         * @return true Item was inserted
+         * @return false Grid is full
+         */
+        bool Insert(const fix16_vec3_t * position, const Item & item)
+        {
+            if (this->count >= Capacity)
+            {
+                return false;
+            }
+
+            // Arithmetic shift rounds negative coordinates down, so cells do not change size around zero
+            const uint16_t bucket = VisibilityGrid::GetBucket(position->x >> VisibilityGrid::CellShift, position->y >> VisibilityGrid::CellShift);
+            const uint16_t entry = this->count++;
+            this->positionX[entry] = position->x;
+            this->positionY[entry] = position->y;
+            this->items[entry] = item;
+            this->next[entry] = this->heads[bucket];
+            this->heads[bucket] = entry;
+            return true;
+        }
+
+        /** @brief Visit items whose bounding radius overlaps visible area
+         * @param bounds Visible area (min X, min Y, max X, max Y), has to span less than Wrap cells along each axis
+         * @param radius Bounding radius around item positions
+         * @param visitor Called with pointer to each overlapping item
+         * @return Number of items that were tested
+         */
+        template<typename Visitor>
+        uint16_t Query(const fix16_t * bounds, fix16_t radius, Visitor visitor)
+        {
+            const int32_t firstX = (bounds[0] - radius) >> VisibilityGrid::CellShift;
+            const int32_t firstY = (bounds[1] - radius) >> VisibilityGrid::CellShift;
+            const int32_t lastX = (bounds[2] + radius) >> VisibilityGrid::CellShift;
+            const int32_t lastY = (bounds[3] + radius) >> VisibilityGrid::CellShift;
+
+            // Wider area would visit some buckets twice
+            assert(lastX - firstX < Wrap && lastY - firstY < Wrap);
+            uint16_t tested = 0;
+
+            for (int32_t cellY = firstY; cellY <= lastY; cellY++)
+            {
+                for (int32_t cellX = firstX; cellX <= lastX; cellX++)
+                {
+                    for (uint16_t entry = this->heads[VisibilityGrid::GetBucket(cellX, cellY)]; entry != VisibilityGrid::Empty; entry = this->next[entry])
+                    {
+                        const fix16_t x = this->positionX[entry];
+                        const fix16_t y = this->positionY[entry];
+                        tested++;
+
+                        if (x + radius >= bounds[0] && y + radius >= bounds[1] && x - radius <= bounds[2] && y - radius <= bounds[3])
+                        {
+                            visitor(&this->items[entry]);
+                        }
+                    }
+                }
+            }
+
+            return tested;
+        }
+    };
+}
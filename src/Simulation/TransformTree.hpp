@@ -0,0 +1,344 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+
+namespace Utenyaa::Simulation
+{
+    /** @brief Parent/child transforms with cached world matrices
+     * @details Nodes are stored in depth first order, so every subtree is one continuous range that starts with its root
+     * and parents always come before their children. Changing local transform only marks the node, Update then recomputes
+     * world matrices of marked subtrees in one pass over their ranges. Unchanged nodes are not touched at all.
+     * Node handles stay the same when other nodes are added or removed.
+     */
+    class TransformTree
+    {
+    public:
+        /** @brief Handle of a missing node
+         */
+        static constexpr uint16_t None = 0xffff;
+
+    private:
+        /** @brief Changed node count times this ratio above node count makes update walk all nodes instead of sorting the changes
+         */
+        static constexpr uint16_t ScanRatio = 16;
+
+        /** @brief Local transform of each node relative to its parent (depth first order)
+         */
+        inline static fix16_mat43_t local[TRANSFORM_NODE_CAPACITY];
+
+        /** @brief World transform of each node
+         */
+        inline static fix16_mat43_t world[TRANSFORM_NODE_CAPACITY];
+
+        /** @brief Index of the parent of each node (None for roots)
+         */
+        inline static uint16_t parents[TRANSFORM_NODE_CAPACITY];
+
+        /** @brief Number of nodes in the subtree of each node including the node itself
+         */
+        inline static uint16_t spans[TRANSFORM_NODE_CAPACITY];
+
+        /** @brief Handle of each node
+         */
+        inline static uint16_t handles[TRANSFORM_NODE_CAPACITY];
+
+        /** @brief Index of each handle (None for free handle)
+         */
+        inline static uint16_t indexes[TRANSFORM_NODE_CAPACITY];
+
+        /** @brief Node is marked as changed
+         */
+        inline static bool dirty[TRANSFORM_NODE_CAPACITY];
+
+        /** @brief Indexes of changed nodes
+         */
+        inline static uint16_t changed[TRANSFORM_NODE_CAPACITY];
+
+        /** @brief Number of changed nodes
+         */
+        inline static uint16_t changedCount = 0;
+
+        /** @brief Number of nodes
+         */
+        inline static uint16_t count = 0;
+
+        /** @brief Number of world matrices computed by last update
+         */
+        inline static uint16_t computed = 0;
+
+        /** @brief Move nodes within the arrays
+         * @param to Target index
+         * @param from Source index
+         * @param amount Number of nodes
+         */
+        static void MoveNodes(uint16_t to, uint16_t from, uint16_t amount)
+        {
+            memmove(&TransformTree::local[to], &TransformTree::local[from], amount * sizeof(fix16_mat43_t));
+            memmove(&TransformTree::world[to], &TransformTree::world[from], amount * sizeof(fix16_mat43_t));
+            memmove(&TransformTree::parents[to], &TransformTree::parents[from], amount * sizeof(uint16_t));
+            memmove(&TransformTree::spans[to], &TransformTree::spans[from], amount * sizeof(uint16_t));
+            memmove(&TransformTree::handles[to], &TransformTree::handles[from], amount * sizeof(uint16_t));
+            memmove(&TransformTree::dirty[to], &TransformTree::dirty[from], amount * sizeof(bool));
+        }
+
+        /** @brief Fix indexes after nodes at or after index moved
+         * @param start First moved index
+         * @param offset Distance nodes moved by
+         */
+        static void Shift(uint16_t start, int16_t offset)
+        {
+            for (uint16_t index = 0; index < TransformTree::count; index++)
+            {
+                if (TransformTree::parents[index] != TransformTree::None && TransformTree::parents[index] >= start)
+                {
+                    TransformTree::parents[index] += offset;
+                }
+
+                TransformTree::indexes[TransformTree::handles[index]] = index;
+            }
+
+            for (uint16_t entry = 0; entry < TransformTree::changedCount; entry++)
+            {
+                if (TransformTree::changed[entry] >= start)
+                {
+                    TransformTree::changed[entry] += offset;
+                }
+            }
+        }
+
+        /** @brief Mark node as changed
+         * @param index Node index
+         */
+        static void MarkDirty(uint16_t index)
+        {
+            if (!TransformTree::dirty[index])
+            {
+                TransformTree::dirty[index] = true;
+                TransformTree::changed[TransformTree::changedCount++] = index;
+            }
+        }
+
+        /** @brief Recompute world matrices of a subtree
+         * @param root Index of the subtree root
+         * @return Index after the subtree
+         */
+        static uint16_t ComputeSubtree(uint16_t root)
+        {
+            const uint16_t end = root + TransformTree::spans[root];
+
+            // Parents come first, so their world matrix is always up to date when a child needs it
+            for (uint16_t index = root; index < end; index++)
+            {
+                const uint16_t parent = TransformTree::parents[index];
+                TransformTree::dirty[index] = false;
+
+                if (parent == TransformTree::None)
+                {
+                    TransformTree::world[index] = TransformTree::local[index];
+                }
+                else
+                {
+                    fix16_mat43_mul(&TransformTree::world[parent], &TransformTree::local[index], &TransformTree::world[index]);
+                }
+            }
+
+            TransformTree::computed += end - root;
+            return end;
+        }
+
+    public:
+        /** @brief Remove all nodes
+         */
+        static void Initialize()
+        {
+            TransformTree::count = 0;
+            TransformTree::changedCount = 0;
+
+            for (uint16_t handle = 0; handle < TRANSFORM_NODE_CAPACITY; handle++)
+            {
+                TransformTree::indexes[handle] = TransformTree::None;
+            }
+        }
+
+        /** @brief Add node as the last child of its parent
+         * @param parent Parent node handle (None for root node)
+         * @param transform Local transform
+         * @return Node handle
+         */
+        static uint16_t Add(uint16_t parent, const fix16_mat43_t * transform)
+        {
+            assert(TransformTree::count < TRANSFORM_NODE_CAPACITY);
+            assert(parent == TransformTree::None || TransformTree::indexes[parent] != TransformTree::None);
+
+            uint16_t handle = 0;
+
+            while (TransformTree::indexes[handle] != TransformTree::None)
+            {
+                handle++;
+            }
+
+            // New node goes right after the subtree of its parent, roots go to the end
+            const uint16_t parentIndex = parent != TransformTree::None ? TransformTree::indexes[parent] : TransformTree::None;
+            const uint16_t index = parentIndex != TransformTree::None ? parentIndex + TransformTree::spans[parentIndex] : TransformTree::count;
+
+            TransformTree::MoveNodes(index + 1, index, TransformTree::count - index);
+            TransformTree::count++;
+            TransformTree::handles[index] = handle;
+            TransformTree::Shift(index, 1);
+
+            TransformTree::local[index] = *transform;
+            TransformTree::parents[index] = parentIndex;
+            TransformTree::spans[index] = 1;
+            TransformTree::dirty[index] = false;
+
+            for (uint16_t ancestor = parentIndex; ancestor != TransformTree::None; ancestor = TransformTree::parents[ancestor])
+            {
+                TransformTree::spans[ancestor]++;
+            }
+
+            TransformTree::MarkDirty(index);
+            return handle;
+        }
+
+        /** @brief Remove node and all its children
+         * @param node Node handle
+         */
+        static void Remove(uint16_t node)
+        {
+            const uint16_t index = TransformTree::indexes[node];
+            assert(index != TransformTree::None);
+            const uint16_t span = TransformTree::spans[index];
+
+            for (uint16_t ancestor = TransformTree::parents[index]; ancestor != TransformTree::None; ancestor = TransformTree::parents[ancestor])
+            {
+                TransformTree::spans[ancestor] -= span;
+            }
+
+            // Removed nodes cannot stay in the changed list
+            for (uint16_t entry = 0; entry < TransformTree::changedCount;)
+            {
+                if (TransformTree::changed[entry] >= index && TransformTree::changed[entry] < index + span)
+                {
+                    TransformTree::changed[entry] = TransformTree::changed[--TransformTree::changedCount];
+                }
+                else
+                {
+                    entry++;
+                }
+            }
+
+            for (uint16_t removed = index; removed < index + span; removed++)
+            {
+                TransformTree::indexes[TransformTree::handles[removed]] = TransformTree::None;
+            }
+
+            TransformTree::MoveNodes(index, index + span, TransformTree::count - index - span);
+            TransformTree::count -= span;
+            TransformTree::Shift(index + span, -(int16_t)span);
+        }
+
+        /** @brief Set local transform, world matrices of the node and its children are recomputed on next update
+         * @param node Node handle
+         * @param transform Local transform relative to parent
+         */
+        static void SetLocal(uint16_t node, const fix16_mat43_t * transform)
+        {
+            const uint16_t index = TransformTree::indexes[node];
+            assert(index != TransformTree::None);
+            TransformTree::local[index] = *transform;
+            TransformTree::MarkDirty(index);
+        }
+
+        /** @brief Get local transform
+         * @param node Node handle
+         * @return Local transform relative to parent
+         */
+        static const fix16_mat43_t * GetLocal(uint16_t node)
+        {
+            assert(TransformTree::indexes[node] != TransformTree::None);
+            return &TransformTree::local[TransformTree::indexes[node]];
+        }
+
+        /** @brief Get world transform as of last update
+         * @param node Node handle
+         * @return World transform
+         */
+        static const fix16_mat43_t * GetWorld(uint16_t node)
+        {
+            assert(TransformTree::indexes[node] != TransformTree::None);
+            return &TransformTree::world[TransformTree::indexes[node]];
+        }
+
+        /** @brief Recompute world matrices of changed subtrees
+         */
+        static void Update()
+        {
+            TransformTree::computed = 0;
+            uint16_t * changes = TransformTree::changed;
+            const uint16_t amount = TransformTree::changedCount;
+            TransformTree::changedCount = 0;
+
+            // When large part of the tree changed, walking all flags is cheaper than sorting the changes
+            if (amount * TransformTree::ScanRatio > TransformTree::count)
+            {
+                for (uint16_t index = 0; index < TransformTree::count;)
+                {
+                    index = TransformTree::dirty[index] ? TransformTree::ComputeSubtree(index) : index + 1;
+                }
+
+                return;
+            }
+
+            // Changed nodes are visited in depth first order, nodes inside an already computed subtree are skipped
+            for (uint16_t entry = 1; entry < amount; entry++)
+            {
+                const uint16_t value = changes[entry];
+                uint16_t position = entry;
+
+                for (; position > 0 && changes[position - 1] > value; position--)
+                {
+                    changes[position] = changes[position - 1];
+                }
+
+                changes[position] = value;
+            }
+
+            uint16_t computedEnd = 0;
+
+            for (uint16_t entry = 0; entry < amount; entry++)
+            {
+                if (changes[entry] >= computedEnd)
+                {
+                    computedEnd = TransformTree::ComputeSubtree(changes[entry]);
+                }
+            }
+        }
+
+        /** @brief Copy world matrices as of last update
+         * @param worlds Target matrices indexed by node handle (TRANSFORM_NODE_CAPACITY entries, slots of free handles are not written)
+         */
+        static void CopyWorld(fix16_mat43_t * worlds)
+        {
+            for (uint16_t index = 0; index < TransformTree::count; index++)
+            {
+                worlds[TransformTree::handles[index]] = TransformTree::world[index];
+            }
+        }
+
+        /** @brief Get number of nodes
+         * @return Node count
+         */
+        static uint16_t GetCount()
+        {
+            return TransformTree::count;
+        }
+
+        /** @brief Get number of world matrices computed by last update
+         * @return Computed node count
+         */
+        static uint16_t GetComputed()
+        {
+            return TransformTree::computed;
+        }
+    };
+}
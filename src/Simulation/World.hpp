@@ -0,0 +1,275 @@
+#pragma once
+#include <yaul.h>
+#include "../../Dependencies/HyperionEngine/ECS/Entity.hpp"
+
+namespace Utenyaa::Simulation
+{
+    /** @brief Captured world state
+     */
+    struct WorldState
+    {
+        /** @brief Component data, component types are stored one after another in ForEach order
+         */
+        uint8_t * Data;
+
+        /** @brief Size of the data buffer
+         */
+        uint32_t Capacity;
+
+        /** @brief Number of used bytes (always multiple of 4)
+         */
+        uint32_t Size;
+
+        /** @brief Frame the state was captured at
+         */
+        uint32_t Frame;
+    };
+
+    /** @brief Snapshot and restore of component data, used for rollback and replay seeking
+     * @details Entities must not be created or destroyed between snapshot and restore.
+     * @tparam ComponentTypes Component types that are part of the simulation state
+     */
+    template<class... ComponentTypes>
+    class World
+    {
+    private:
+        /** @brief Current read/write position
+         */
+        inline static uint8_t * cursor;
+
+        /** @brief End of the buffer
+         */
+        inline static const uint8_t * end;
+
+        /** @brief Copy all components of one type into buffer
+         * @tparam Type Component type
+         */
+        template<class Type>
+        static void Write()
+        {
+            Entity::ForEach(
+                [](Type &component)
+                {
+                    assert(World::cursor + sizeof(Type) <= World::end);
+                    memcpy(World::cursor, &component, sizeof(Type));
+                    World::cursor += sizeof(Type);
+                });
+        }
+
+        /** @brief Copy all components of one type from buffer
+         * @tparam Type Component type
+         */
+        template<class Type>
+        static void Read()
+        {
+            Entity::ForEach(
+                [](Type &component)
+                {
+                    assert(World::cursor + sizeof(Type) <= World::end);
+                    memcpy(&component, World::cursor, sizeof(Type));
+                    World::cursor += sizeof(Type);
+                });
+        }
+
+    public:
+        /** @brief Allocate state buffer
+         * @param state State to initialize
+         * @param capacity Buffer size in bytes
+         */
+        static void Allocate(WorldState * state, uint32_t capacity)
+        {
+            assert(state != NULL);
+            state->Capacity = (capacity + 3) & ~3;
+            state->Data = (uint8_t*)malloc(state->Capacity);
+            state->Size = 0;
+            state->Frame = 0;
+            assert(state->Data != NULL);
+        }
+
+        /** @brief Capture current component data
+         * @param state Target state
+         * @param frame Current frame number
+         */
+        static void Snapshot(WorldState * state, uint32_t frame)
+        {
+            assert(state != NULL && state->Data != NULL);
+            World::cursor = state->Data;
+            World::end = state->Data + state->Capacity;
+
+            (World::Write<ComponentTypes>(), ...);
+
+            // Pad to whole words for delta compression
+            while (((uintptr_t)World::cursor & 3) != 0)
+            {
+                *World::cursor++ = 0;
+            }
+
+            state->Size = World::cursor - state->Data;
+            state->Frame = frame;
+        }
+
+        /** @brief Write captured component data back to the entities
+         * @param state Source state
+         */
+        static void Restore(const WorldState * state)
+        {
+            assert(state != NULL && state->Data != NULL);
+            World::cursor = state->Data;
+            World::end = state->Data + state->Size;
+
+            (World::Read<ComponentTypes>(), ...);
+        }
+
+        /** @brief Copy state (whole buffer at once)
+         * @param source Source state
+         * @param target Target state
+         */
+        static void Copy(const WorldState * source, WorldState * target)
+        {
+            assert(target->Capacity >= source->Size);
+            memcpy(target->Data, source->Data, source->Size);
+            target->Size = source->Size;
+            target->Frame = source->Frame;
+        }
+
+        /** @brief Delta compress state against earlier state
+         * @details Output is a list of runs, each run is 16bit count of unchanged words, 16bit count of changed words
+         * and changed words XORed with the base. Output buffer has to hold at least (state size + 4) bytes.
+         * @param base Earlier state
+         * @param state State to compress
+         * @param delta Output buffer
+         * @return Size of compressed data in bytes
+         */
+        static uint32_t Compress(const WorldState * base, const WorldState * state, uint8_t * delta)
+        {
+            assert(base->Size == state->Size);
+            const uint32_t * previous = (const uint32_t*)base->Data;
+            const uint32_t * current = (const uint32_t*)state->Data;
+            const uint32_t words = state->Size >> 2;
+            uint16_t * output = (uint16_t*)delta;
+            uint32_t word = 0;
+
+            while (word < words)
+            {
+                uint16_t same = 0;
+
+                while (word < words && same < 0xffff && previous[word] == current[word])
+                {
+                    same++;
+                    word++;
+                }
+
+                uint16_t changed = 0;
+
+                while (word + changed < words && changed < 0xffff && previous[word + changed] != current[word + changed])
+                {
+                    changed++;
+                }
+
+                *output++ = same;
+                *output++ = changed;
+
+                uint32_t * changes = (uint32_t*)output;
+
+                for (uint16_t index = 0; index < changed; index++, word++)
+                {
+                    changes[index] = previous[word] ^ current[word];
+                }
+
+                output = (uint16_t*)(changes + changed);
+            }
+
+            return (uint8_t*)output - delta;
+        }
+
+        /** @brief Rebuild state from earlier state and delta
+         * @param base Earlier state
+         * @param delta Compressed delta
+         * @param size Size of compressed delta in bytes
+         * @param state Target state (can be the same as base)
+         * @param frame Frame number of the rebuilt state
+         */
+        static void Decompress(const WorldState * base, const uint8_t * delta, uint32_t size, WorldState * state, uint32_t frame)
+        {
+            assert(state->Capacity >= base->Size);
+
+            if (state != base)
+            {
+                World::Copy(base, state);
+            }
+
+            uint32_t * current = (uint32_t*)state->Data;
+            const uint16_t * input = (const uint16_t*)delta;
+            const uint16_t * inputEnd = (const uint16_t*)(delta + size);
+            uint32_t word = 0;
+
+            while (input < inputEnd)
+            {
+                word += *input++;
+                const uint16_t changed = *input++;
+                const uint32_t * changes = (const uint32_t*)input;
+
+                for (uint16_t index = 0; index < changed; index++, word++)
+                {
+                    current[word] ^= changes[index];
+                }
+
+                input = (const uint16_t*)(changes + changed);
+            }
+
+            state->Frame = frame;
+        }
+    };
+
+    /** @brief Ring of recent world states for rollback
+     * @tparam WorldType World type the states are captured from
+     * @tparam Frames Number of kept frames
+     */
+    template<class WorldType, uint8_t Frames>
+    class WorldHistory
+    {
+    private:
+        /** @brief Captured states
+         */
+        WorldState states[Frames];
+
+    public:
+        /** @brief Allocate history buffers
+         * @param capacity Size of a single state buffer in bytes
+         */
+        WorldHistory(uint32_t capacity)
+        {
+            for (uint8_t frame = 0; frame < Frames; frame++)
+            {
+                WorldType::Allocate(&this->states[frame], capacity);
+                this->states[frame].Frame = 0xffffffff;
+            }
+        }
+
+        /** @brief Capture state of current frame
+         * @param frame Current frame number
+         */
+        void Push(uint32_t frame)
+        {
+            WorldType::Snapshot(&this->states[frame % Frames], frame);
+        }
+
+        /** @brief Restore state of earlier frame, simulation can then be re-run from that frame
+         * @param frame Frame number to restore
+         * @return true State was restored
+         * @return false Frame is too old and is not in history
+         */
+        bool Rollback(uint32_t frame)
+        {
+            const WorldState * state = &this->states[frame % Frames];
+
+            if (state->Frame != frame)
+            {
+                return false;
+            }
+
+            WorldType::Restore(state);
+            return true;
+        }
+    };
+}
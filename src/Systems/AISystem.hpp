@@ -0,0 +1,277 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+#include "BaseSystem.hpp"
+#include "../Components/AIComponent.hpp"
+#include "../Components/InputComponent.hpp"
+#include "../Components/TransformComponent.hpp"
+#include "../Debug/Profiler.hpp"
+#include "../Level/Navigation.hpp"
+#include "../Level/Raycast.hpp"
+#include "../Level/TileMap.hpp"
+#include "../../Dependencies/Skathi/Timer.hpp"
+
+namespace Utenyaa::Systems
+{
+    /** @brief AI controller system, writes input of AI controlled entities
+     * @details Decisions are time sliced, each frame AI entities take turns in making a decision until
+     * the time budget runs out, the rest only replays the steering of their last decision.
+     */
+    class AISystem : public BaseSystem<
+        AISystem,
+        Utenyaa::Components::InputComponent::Input,
+        Utenyaa::Components::AI,
+        Utenyaa::Components::Transform>
+    {
+    public:
+        /** @brief Steering output bits
+         */
+        enum Steering : uint8_t
+        {
+            /** @brief Turn left
+             */
+            TurnLeft = 1 << 0,
+
+            /** @brief Turn right
+             */
+            TurnRight = 1 << 1,
+
+            /** @brief Drive forward
+             */
+            Forward = 1 << 2,
+
+            /** @brief Fire main gun
+             */
+            Fire = 1 << 3,
+        };
+
+        /** @brief Marks that AI has no target
+         */
+        static constexpr uint8_t NoTarget = 0xff;
+
+    private:
+        /** @brief Locations of human players, gathered once per frame
+         */
+        inline static fix16_vec2_t players[Utenyaa::Components::InputComponent::InputSource::P12 + 1];
+
+        /** @brief Number of human players
+         */
+        inline static uint8_t playerCount;
+
+        /** @brief Index of AI entity that makes the next decision
+         */
+        inline static uint16_t cursor;
+
+        /** @brief Index of currently processed AI entity
+         */
+        inline static uint16_t index;
+
+        /** @brief Number of decisions made this frame
+         */
+        inline static uint16_t decisions;
+
+        /** @brief Timer value at start of the frame
+         */
+        inline static uint16_t start;
+
+        /** @brief Decision time budget in timer ticks
+         */
+        inline static uint16_t budget;
+
+        /** @brief Profiler section
+         */
+        inline static uint8_t profilerSection;
+
+        /** @brief Level tile map
+         */
+        inline static const Utenyaa::Level::TileMap * map;
+
+        /** @brief Choose steering toward direction
+         * @param transform Entity transform
+         * @param direction Desired unit direction on the ground plane
+         * @return Steering bits
+         */
+        static uint8_t Steer(const Utenyaa::Components::Transform * transform, const fix16_vec2_t * direction)
+        {
+            const fix16_t forwardX = transform->Matrix.frow[0][0];
+            const fix16_t forwardY = transform->Matrix.frow[0][1];
+
+            // Sign of the cross product tells which side the direction is on, dot product how well we are aligned
+            const fix16_t cross = fix16_mul(forwardX, direction->y) - fix16_mul(forwardY, direction->x);
+            const fix16_t dot = fix16_mul(forwardX, direction->x) + fix16_mul(forwardY, direction->y);
+            uint8_t steering = 0;
+
+            if (cross > AI_STEER_DEADZONE)
+            {
+                steering |= Steering::TurnLeft;
+            }
+            else if (cross < -AI_STEER_DEADZONE)
+            {
+                steering |= Steering::TurnRight;
+            }
+
+            if (dot > AI_STEER_ALIGNED)
+            {
+                steering |= Steering::Forward;
+            }
+
+            return steering;
+        }
+
+        /** @brief Make a decision (target selection, navigation and firing solution)
+         * @param ai AI component data
+         * @param transform Entity transform
+         */
+        static void Decide(Utenyaa::Components::AI * ai, const Utenyaa::Components::Transform * transform)
+        {
+            const fix16_vec3 location = { transform->Matrix.frow[0][3], transform->Matrix.frow[1][3], transform->Matrix.frow[2][3] };
+            const fix16_t forwardX = transform->Matrix.frow[0][0];
+            const fix16_t forwardY = transform->Matrix.frow[0][1];
+
+            // Target selection, closest player in range
+            fix16_t targetDistance = fix16_mul(AI_FIRE_RANGE, AI_FIRE_RANGE);
+            fix16_vec2_t toTarget = { FIX16_ZERO, FIX16_ZERO };
+            ai->Target = AISystem::NoTarget;
+
+            for (uint8_t player = 0; player < AISystem::playerCount; player++)
+            {
+                const fix16_t x = AISystem::players[player].x - location.x;
+                const fix16_t y = AISystem::players[player].y - location.y;
+
+                // Skip players that are clearly out of range, so the squared distance cannot overflow
+                if (x > AI_FIRE_RANGE || x < -AI_FIRE_RANGE || y > AI_FIRE_RANGE || y < -AI_FIRE_RANGE)
+                {
+                    continue;
+                }
+
+                const fix16_t distance = fix16_mul(x, x) + fix16_mul(y, y);
+
+                if (distance < targetDistance)
+                {
+                    targetDistance = distance;
+                    toTarget = { x, y };
+                    ai->Target = player;
+                }
+            }
+
+            // Navigation
+            fix16_vec2_t direction;
+            ai->Steering = 0;
+
+            if (Utenyaa::Level::Navigation::GetDirection(ai->Goal, &location, &direction))
+            {
+                ai->Steering = AISystem::Steer(transform, &direction);
+            }
+
+            // Firing solution, target has to be in front of the barrel within a narrow cone and not behind a wall
+            if (ai->Target != AISystem::NoTarget)
+            {
+                const fix16_t dot = fix16_mul(forwardX, toTarget.x) + fix16_mul(forwardY, toTarget.y);
+                const fix16_t cross = fix16_mul(forwardX, toTarget.y) - fix16_mul(forwardY, toTarget.x);
+                const fix16_vec2_t from = { location.x, location.y };
+
+                if (dot > 0 &&
+                    (cross < 0 ? -cross : cross) < fix16_mul(dot, AI_FIRE_CONE) &&
+                    Utenyaa::Level::Raycast::IsVisible(AISystem::map, &from, &AISystem::players[ai->Target]))
+                {
+                    ai->Steering |= Steering::Fire;
+                }
+            }
+        }
+
+    public:
+        /** @brief Initialize AI scheduler
+         * @param map Level tile map
+         * @param budgetMicroseconds Decision time budget per frame
+         */
+        static void Initialize(const Utenyaa::Level::TileMap * map, uint32_t budgetMicroseconds)
+        {
+            AISystem::map = map;
+            AISystem::cursor = 0;
+            AISystem::profilerSection = Utenyaa::Debug::Profiler::Register("AI");
+            AISystem::SetBudget(budgetMicroseconds);
+        }
+
+        /** @brief Set decision time budget
+         * @param budgetMicroseconds Decision time budget per frame
+         */
+        static void SetBudget(uint32_t budgetMicroseconds)
+        {
+            AISystem::budget = Skathi::Timer::FromMicroseconds(budgetMicroseconds);
+        }
+
+        /** @brief Get profiler section of the AI
+         * @return Profiler section index
+         */
+        static uint8_t GetProfilerSection()
+        {
+            return AISystem::profilerSection;
+        }
+
+        /** @brief Process system call
+         */
+        static void Process()
+        {
+            Utenyaa::Debug::Profiler::Begin(AISystem::profilerSection);
+
+            // Gather human players once, so decisions do not have to walk all entities
+            AISystem::playerCount = 0;
+            Entity::ForEach(
+                [](Utenyaa::Components::InputComponent::Input &input, Utenyaa::Components::Transform &transform)
+                {
+                    if (input.Source <= Utenyaa::Components::InputComponent::InputSource::P12)
+                    {
+                        AISystem::players[AISystem::playerCount++] = { transform.Matrix.frow[0][3], transform.Matrix.frow[1][3] };
+                    }
+                });
+
+            AISystem::index = 0;
+            AISystem::decisions = 0;
+            AISystem::start = Skathi::Timer::GetTicks();
+
+            BaseSystem::Process();
+
+            // Every AI entity had its turn, start over
+            if (AISystem::cursor >= AISystem::index)
+            {
+                AISystem::cursor = 0;
+            }
+
+            Utenyaa::Debug::Profiler::End(AISystem::profilerSection);
+        }
+
+        /** @brief Process single AI entity
+         * @param input Input component data
+         * @param ai AI component data
+         * @param transform Entity transform
+         */
+        static void ProcessEntity(
+            Utenyaa::Components::InputComponent::Input * input,
+            Utenyaa::Components::AI * ai,
+            Utenyaa::Components::Transform * transform)
+        {
+            if (input->Source != Utenyaa::Components::InputComponent::InputSource::AI)
+            {
+                return;
+            }
+
+            // At least one decision is made each frame, so AI does not stall when budget is too small
+            if (AISystem::index >= AISystem::cursor &&
+                (AISystem::decisions == 0 || Skathi::Timer::GetElapsed(AISystem::start) < AISystem::budget))
+            {
+                AISystem::Decide(ai, transform);
+                AISystem::cursor = AISystem::index + 1;
+                AISystem::decisions++;
+            }
+
+            // Replay last decision
+            input->Left = (ai->Steering & Steering::TurnLeft) != 0;
+            input->Right = (ai->Steering & Steering::TurnRight) != 0;
+            input->Up = (ai->Steering & Steering::Forward) != 0;
+            input->Down = 0;
+            input->A = (ai->Steering & Steering::Fire) != 0;
+
+            AISystem::index++;
+        }
+    };
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "../constants.hpp"
+#include "BaseSystem.hpp"
+#include "../Components/AnalogInputComponent.hpp"
+#include "../Components/InputComponent.hpp"
+#include "../../Dependencies/Skathi/Skathi.hpp"
+
+namespace Utenyaa::Systems
+{
+    /** @brief Analog input update system, reads stick steering and throttle while the pad is in analog mode
+     * @details Stick position is written to the input component, PhysicsSystem turns and drives proportionally to it.
+     * Pressed D-Pad direction takes precedence over the stick.
+     */
+    class AnalogInputSystem : public BaseSystem<
+        AnalogInputSystem,
+        Utenyaa::Components::InputComponent::Input,
+        Utenyaa::Components::AnalogInput>
+    {
+    public:
+        /** @brief Number of response curves players can choose from
+         */
+        static constexpr uint8_t CurveCount = 3;
+
+    private:
+        /** @brief Response curves
+         */
+        inline static Skathi::Input::ResponseCurve curves[CurveCount];
+
+        /** @brief Ports with connected analog pad (bit N is set for port N)
+         */
+        inline static uint16_t analogPads = 0;
+
+    public:
+        /** @brief Build response curves (linear, quadratic and cubic)
+         */
+        static void Initialize()
+        {
+            AnalogInputSystem::curves[0].Build(ANALOG_DEADZONE, Skathi::Input::ResponseCurve::Shape::Linear);
+            AnalogInputSystem::curves[1].Build(ANALOG_DEADZONE, Skathi::Input::ResponseCurve::Shape::Quadratic);
+            AnalogInputSystem::curves[2].Build(ANALOG_DEADZONE, Skathi::Input::ResponseCurve::Shape::Cubic);
+        }
+
+        /** @brief Process system call
+         */
+        static void Process()
+        {
+            for (uint8_t event = 0; event < Skathi::Input::Peripherals::GetEventCount(); event++)
+            {
+                const Skathi::Input::Peripherals::Event * change = Skathi::Input::Peripherals::GetEvent(event);
+
+                if (change->Peripheral == Skathi::Input::Peripherals::PeripheralType::Analog3dPad)
+                {
+                    AnalogInputSystem::analogPads |= 1 << change->Port;
+                }
+                else
+                {
+                    AnalogInputSystem::analogPads &= ~(1 << change->Port);
+                }
+            }
+
+            BaseSystem::Process();
+        }
+
+        /** @brief Process single analog input component
+         * @param input Input component data
+         * @param analog Analog input component data
+         */
+        static void ProcessEntity(
+            Utenyaa::Components::InputComponent::Input * input,
+            Utenyaa::Components::AnalogInput * analog)
+        {
+            if (input->Source > Utenyaa::Components::InputComponent::InputSource::P12 ||
+                (AnalogInputSystem::analogPads & (1 << input->Source)) == 0)
+            {
+                input->Steer = FIX16_ZERO;
+                input->Throttle = FIX16_ZERO;
+                analog->Active = false;
+                return;
+            }
+
+            assert(analog->Curve < AnalogInputSystem::CurveCount);
+            const Skathi::Input::ResponseCurve * curve = &AnalogInputSystem::curves[analog->Curve];
+            const smpc_peripheral_t * peripheral = Skathi::Input::Peripherals::GetPeripheral((uint8_t)input->Source);
+
+            // Stick Y axis is 0 when pushed up
+            input->Steer = curve->GetStick(Skathi::Input::Controllers::NightsPad::GetAxis(peripheral, Skathi::Input::Controllers::NightsPad::Axis::X));
+            input->Throttle = -curve->GetStick(Skathi::Input::Controllers::NightsPad::GetAxis(peripheral, Skathi::Input::Controllers::NightsPad::Axis::Y));
+            analog->TriggerL = curve->GetTrigger(Skathi::Input::Controllers::NightsPad::GetAxis(peripheral, Skathi::Input::Controllers::NightsPad::Axis::L));
+            analog->TriggerR = curve->GetTrigger(Skathi::Input::Controllers::NightsPad::GetAxis(peripheral, Skathi::Input::Controllers::NightsPad::Axis::R));
+            analog->Active = true;
+        }
+    };
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <yaul.h>
+#include "BaseSystem.hpp"
+#include "InputSystem.hpp"
+#include "../Components/InputComponent.hpp"
+#include "../Components/TransformComponent.hpp"
+#include "../Rendering/Viewports.hpp"
+
+namespace Utenyaa::Systems
+{
+    /** @brief Keeps viewport camera of each local player above its entity
+     * @details Connected players get viewports in order of their entities, so the player slot does not depend on the port
+     * (multitap ports start at a fixed base). Number of viewports follows number of connected players.
+     */
+    class CameraSystem : public BaseSystem<
+        CameraSystem,
+        Utenyaa::Components::InputComponent::Input,
+        Utenyaa::Components::Transform>
+    {
+    private:
+        /** @brief Number of connected players
+         */
+        inline static uint8_t players = 0;
+
+        /** @brief Viewport of the next connected player
+         */
+        inline static uint8_t slot = 0;
+
+        /** @brief Check whether entity is controlled by a connected local player
+         * @param input Input component data
+         * @return true Entity has a viewport
+         * @return false Entity is controlled by AI or its pad is disconnected
+         */
+        static bool IsPlayer(const Utenyaa::Components::InputComponent::Input * input)
+        {
+            return Utenyaa::Systems::InputSystem::IsConnected(input->Source);
+        }
+
+    public:
+        /** @brief Process system call
+         */
+        static void Process()
+        {
+            CameraSystem::players = 0;
+
+            Entity::ForEach(
+                [](Utenyaa::Components::InputComponent::Input & input)
+                {
+                    CameraSystem::players += CameraSystem::IsPlayer(&input) ? 1 : 0;
+                });
+
+            // Single view is kept when nobody is connected
+            const uint8_t count = CameraSystem::players == 0 ? 1 :
+                (CameraSystem::players < Utenyaa::Rendering::Viewports::MaxCount ? CameraSystem::players : Utenyaa::Rendering::Viewports::MaxCount);
+
+            if (count != Utenyaa::Rendering::Viewports::GetCount())
+            {
+                Utenyaa::Rendering::Viewports::Initialize(count);
+            }
+
+            CameraSystem::slot = 0;
+            BaseSystem::Process();
+        }
+
+        /** @brief Process single entity
+         * @param input Input component data
+         * @param transform Entity transform
+         */
+        static void ProcessEntity(
+            Utenyaa::Components::InputComponent::Input * input,
+            Utenyaa::Components::Transform * transform)
+        {
+            if (!CameraSystem::IsPlayer(input))
+            {
+                return;
+            }
+
+            // N-th connected player is shown in viewport N
+            if (CameraSystem::slot < Utenyaa::Rendering::Viewports::GetCount())
+            {
+                fix16_vec3 location = { transform->Matrix.frow[0][3], transform->Matrix.frow[1][3], transform->Matrix.frow[2][3] };
+                Utenyaa::Rendering::Viewports::SetFocus(CameraSystem::slot, &location);
+            }
+
+            CameraSystem::slot++;
+        }
+    };
+}
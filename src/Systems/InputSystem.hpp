@@ -11,37 +11,83 @@ namespace Utenyaa::Systems
         InputSystem, 
         Utenyaa::Components::InputComponent::Input>
     {
+    private:
+        /** @brief Ports with connected digital or 3D pad (bit N is set for port N)
+         */
+        inline static uint16_t gamepads = 0;
+
     public:
+        /** @brief Check whether digital or 3D pad is connected to the port of an input source
+         * @param source Input source
+         * @return true Pad is connected
+         * @return false Nothing usable is connected or source is not a controller port
+         */
+        static bool IsConnected(Utenyaa::Components::InputComponent::InputSource source)
+        {
+            return source <= Utenyaa::Components::InputComponent::InputSource::P12 && (InputSystem::gamepads & (1 << source)) != 0;
+        }
+
+        /** @brief Process system call
+         */
+        static void Process()
+        {
+            // Track connected pads from peripheral change events instead of polling every port
+            for (uint8_t event = 0; event < Skathi::Input::Peripherals::GetEventCount(); event++)
+            {
+                const Skathi::Input::Peripherals::Event * change = Skathi::Input::Peripherals::GetEvent(event);
+
+                if (change->Peripheral == Skathi::Input::Peripherals::PeripheralType::Gamepad ||
+                    change->Peripheral == Skathi::Input::Peripherals::PeripheralType::Analog3dPad)
+                {
+                    InputSystem::gamepads |= 1 << change->Port;
+                }
+                else
+                {
+                    InputSystem::gamepads &= ~(1 << change->Port);
+                }
+            }
+
+            BaseSystem::Process();
+        }
+
         /** @brief Process single input component
          * @param input Input component data
          */
         static void ProcessEntity(Utenyaa::Components::InputComponent::Input * input)
         {
-            if (input->Source != Utenyaa::Components::InputComponent::InputSource::AI &&
-                input->Source != Utenyaa::Components::InputComponent::InputSource::NotPresent &&
-                Skathi::Input::Controllers::Gamepad::IsConnected((uint8_t)input->Source))
+            if (input->Source > Utenyaa::Components::InputComponent::InputSource::P12)
+            {
+                // Input of AI controlled entities is written by AISystem
+                return;
+            }
+
+            if ((InputSystem::gamepads & (1 << input->Source)) == 0)
+            {
+                // Release everything, so tank of disconnected player does not keep driving
+                const Utenyaa::Components::InputComponent::InputSource source = input->Source;
+                *input = Utenyaa::Components::InputComponent::Input();
+                input->Source = source;
+            }
+            else
             {
-                input->Right = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::Right);
-                input->Left = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::Left);
-                input->Up = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::Up);
-                input->Down = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::Down);
+                // 3D pad reports buttons the same way as digital pad in both of its modes
+                input->Right = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::Right);
+                input->Left = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::Left);
+                input->Up = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::Up);
+                input->Down = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::Down);
 
-                input->Rt = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::R);
-                input->Lt = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::L);
+                input->Rt = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::R);
+                input->Lt = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::L);
 
-                input->A = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::A);
-                input->B = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::B);
-                input->C = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::C);
+                input->A = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::A);
+                input->B = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::B);
+                input->C = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::C);
 
-                input->X = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::X);
-                input->Y = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::Y);
-                input->Z = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::Z);
+                input->X = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::X);
+                input->Y = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::Y);
+                input->Z = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::Z);
 
-                input->Start = (unsigned int)Skathi::Input::Controllers::Gamepad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::Gamepad::Button::START);
-            }
-            else if (input->Source == Utenyaa::Components::InputComponent::InputSource::AI)
-            {
-                // TODO: imploement AI controller
+                input->Start = (unsigned int)Skathi::Input::Controllers::NightsPad::IsHeld((uint8_t)input->Source, Skathi::Input::Controllers::NightsPad::Button::START);
             }
         }
     };
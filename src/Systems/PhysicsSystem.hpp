@@ -29,18 +29,19 @@ namespace Utenyaa::Systems
             // 1 | aYx aYy aYz Oy
             // 2 | aZx aZy aZz Oz
 
+            // D-Pad direction is full deflection of the stick
+            const fix16_t steer = input->Left ? -FIX16_ONE : (input->Right ? FIX16_ONE : input->Steer);
+            const fix16_t throttle = input->Down ? -FIX16_ONE : (input->Up ? FIX16_ONE : input->Throttle);
+
             // Rotate matrix around Z axis
-            if (input->Left)
-            {
-                fix16_mat43_z_rotate(&transform->Matrix, &transform->Matrix, PLAYER_TURN_SPEED);
-            }
-            else if (input->Right)
+            if (steer != FIX16_ZERO)
             {
-                fix16_mat43_z_rotate(&transform->Matrix, &transform->Matrix, -PLAYER_TURN_SPEED);
+                angle_t turn = (angle_t)((PLAYER_TURN_SPEED * steer) >> 16);
+                fix16_mat43_z_rotate(&transform->Matrix, &transform->Matrix, -turn);
             }
 
             // We want to change players position
-            if (input->Down || input->Up)
+            if (throttle != FIX16_ZERO)
             {
                 // Save current player origin
                 fix16_vec3 lastLocation = { transform->Matrix.frow[0][3], transform->Matrix.frow[1][3], transform->Matrix.frow[2][3] };
@@ -49,14 +50,7 @@ namespace Utenyaa::Systems
                 fix16_vec3 forward = { transform->Matrix.frow[0][0], transform->Matrix.frow[0][1], transform->Matrix.frow[0][2] };
 
                 // Scale movement vector depending on where we want to move
-                if (input->Down)
-                {
-                    fix16_vec3_scale(-PLAYER_BACKWARD_SPEED, &forward);
-                }
-                else if (input->Up)
-                {
-                    fix16_vec3_scale(PLAYER_FORWARD_SPEED, &forward);
-                }
+                fix16_vec3_scale(fix16_mul(throttle, throttle > 0 ? PLAYER_FORWARD_SPEED : PLAYER_BACKWARD_SPEED), &forward);
 
                 // Test for collisions and move player back
                 // !! TODO !!
@@ -0,0 +1,138 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+#include "BaseSystem.hpp"
+#include "../Components/ProjectileComponent.hpp"
+#include "../Components/TransformComponent.hpp"
+#include "../Effects/Particles.hpp"
+#include "../Level/Raycast.hpp"
+#include "../Level/TileMap.hpp"
+
+namespace Utenyaa::Systems
+{
+    /** @brief Projectile movement system
+     * @details Each frame the whole path of the projectile is swept with a ray, so fast shells cannot tunnel through thin walls.
+     * Projectile entities are created once and reused, fired shells wait in a queue until the next update picks an inactive one.
+     */
+    class ProjectileSystem : public BaseSystem<
+        ProjectileSystem,
+        Utenyaa::Components::Projectile,
+        Utenyaa::Components::Transform>
+    {
+    private:
+        /** @brief Level tile map
+         */
+        inline static const Utenyaa::Level::TileMap * map = NULL;
+
+        /** @brief Shell waiting for an inactive projectile
+         */
+        struct Shot
+        {
+            /** @brief Muzzle location
+             */
+            fix16_vec3_t From;
+
+            /** @brief Movement per frame on the ground plane
+             */
+            fix16_vec2_t Velocity;
+        };
+
+        /** @brief Fired shells
+         */
+        inline static Shot queued[PROJECTILE_CAPACITY];
+
+        /** @brief Number of fired shells
+         */
+        inline static uint8_t queuedCount = 0;
+
+    public:
+        /** @brief Initialize projectile system for a level
+         * @param map Level tile map
+         */
+        static void Initialize(const Utenyaa::Level::TileMap * map)
+        {
+            ProjectileSystem::map = map;
+            ProjectileSystem::queuedCount = 0;
+        }
+
+        /** @brief Fire a shell, it starts moving on the next update
+         * @param from Muzzle location
+         * @param direction Unit direction on the ground plane
+         * @return true Shell was fired
+         * @return false Too many shells were fired this frame
+         */
+        static bool Fire(const fix16_vec3_t * from, const fix16_vec2_t * direction)
+        {
+            if (ProjectileSystem::queuedCount >= PROJECTILE_CAPACITY)
+            {
+                return false;
+            }
+
+            Shot * shot = &ProjectileSystem::queued[ProjectileSystem::queuedCount++];
+            shot->From = *from;
+            shot->Velocity = { fix16_mul(direction->x, PROJECTILE_SPEED), fix16_mul(direction->y, PROJECTILE_SPEED) };
+            Utenyaa::Effects::Particles::Emit(Utenyaa::Effects::Particles::Kind::MuzzleFlash, from, PARTICLE_SMOKE_AMOUNT);
+            return true;
+        }
+
+        /** @brief Process system call
+         */
+        static void Process()
+        {
+            BaseSystem::Process();
+
+            // Shells that did not find an inactive projectile are dropped
+            ProjectileSystem::queuedCount = 0;
+        }
+
+        /** @brief Process single projectile
+         * @param projectile Projectile component data
+         * @param transform Entity transform
+         */
+        static void ProcessEntity(
+            Utenyaa::Components::Projectile * projectile,
+            Utenyaa::Components::Transform * transform)
+        {
+            if (projectile->Lifetime == 0)
+            {
+                if (ProjectileSystem::queuedCount == 0)
+                {
+                    return;
+                }
+
+                const Shot * shot = &ProjectileSystem::queued[--ProjectileSystem::queuedCount];
+                transform->Matrix.frow[0][3] = shot->From.x;
+                transform->Matrix.frow[1][3] = shot->From.y;
+                transform->Matrix.frow[2][3] = shot->From.z;
+                projectile->Velocity = shot->Velocity;
+                projectile->Lifetime = PROJECTILE_LIFETIME;
+            }
+
+            Utenyaa::Level::Raycast::Ray path;
+            path.From = { transform->Matrix.frow[0][3], transform->Matrix.frow[1][3] };
+            path.To = { path.From.x + projectile->Velocity.x, path.From.y + projectile->Velocity.y };
+
+            Utenyaa::Level::Raycast::Hit hit;
+
+            if (Utenyaa::Level::Raycast::Cast(ProjectileSystem::map, &path, &hit))
+            {
+                // Stop at the wall
+                projectile->Lifetime = 0;
+
+                const fix16_vec3_t location = { hit.Location.x, hit.Location.y, transform->Matrix.frow[2][3] };
+                Utenyaa::Effects::Particles::Emit(Utenyaa::Effects::Particles::Kind::Explosion, &location, PARTICLE_EXPLOSION_AMOUNT);
+                Utenyaa::Effects::Particles::Emit(Utenyaa::Effects::Particles::Kind::Smoke, &location, PARTICLE_SMOKE_AMOUNT);
+            }
+            else
+            {
+                // Smoke trail shows where the shell flies
+                const fix16_vec3_t location = { hit.Location.x, hit.Location.y, transform->Matrix.frow[2][3] };
+                Utenyaa::Effects::Particles::Emit(Utenyaa::Effects::Particles::Kind::Smoke, &location, 1);
+                projectile->Lifetime--;
+            }
+
+            transform->Matrix.frow[0][3] = hit.Location.x;
+            transform->Matrix.frow[1][3] = hit.Location.y;
+        }
+    };
+}
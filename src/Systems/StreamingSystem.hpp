@@ -0,0 +1,36 @@
+#pragma once
+#include <yaul.h>
+#include "BaseSystem.hpp"
+#include "../Components/InputComponent.hpp"
+#include "../Components/TransformComponent.hpp"
+#include "../Level/Streamer.hpp"
+
+namespace Utenyaa::Systems
+{
+    /** @brief Tells level streamer where the players are
+     * @details AI tanks are not streamed around, only the chunks around players have to be loaded.
+     */
+    class StreamingSystem : public BaseSystem<
+        StreamingSystem,
+        Utenyaa::Components::InputComponent::Input,
+        Utenyaa::Components::Transform>
+    {
+    public:
+        /** @brief Process single entity
+         * @param input Input component data
+         * @param transform Entity transform
+         */
+        static void ProcessEntity(
+            Utenyaa::Components::InputComponent::Input * input,
+            Utenyaa::Components::Transform * transform)
+        {
+            if (input->Source > Utenyaa::Components::InputComponent::InputSource::P12)
+            {
+                return;
+            }
+
+            const fix16_vec3_t location = { transform->Matrix.frow[0][3], transform->Matrix.frow[1][3], transform->Matrix.frow[2][3] };
+            Utenyaa::Level::Streamer::AddFocus(&location);
+        }
+    };
+}
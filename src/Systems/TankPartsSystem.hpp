@@ -0,0 +1,56 @@
+#pragma once
+#include <yaul.h>
+#include "BaseSystem.hpp"
+#include "../Components/TankPartsComponent.hpp"
+#include "../Components/TransformComponent.hpp"
+#include "../Simulation/TransformTree.hpp"
+
+namespace Utenyaa::Systems
+{
+    /** @brief Moves tank hull nodes to entity transforms, turret and barrel follow on next transform tree update
+     */
+    class TankPartsSystem : public BaseSystem<
+        TankPartsSystem,
+        Utenyaa::Components::TankParts,
+        Utenyaa::Components::Transform>
+    {
+    public:
+        /** @brief Create tank nodes
+         * @param transform Hull transform
+         * @return Tank parts
+         */
+        static Utenyaa::Components::TankParts Create(const fix16_mat43_t * transform)
+        {
+            fix16_mat43_t turret;
+            fix16_mat43_t barrel;
+            // Cameras look down along Z axis, so up is negative Z
+            const fix16_vec3_t turretOffset = { FIX16_ZERO, FIX16_ZERO, -TANK_TURRET_HEIGHT };
+            const fix16_vec3_t barrelOffset = { TANK_BARREL_LENGTH, FIX16_ZERO, FIX16_ZERO };
+            fix16_mat43_identity(&turret);
+            fix16_mat43_identity(&barrel);
+            fix16_mat43_translate(&turret, &turret, &turretOffset);
+            fix16_mat43_translate(&barrel, &barrel, &barrelOffset);
+
+            Utenyaa::Components::TankParts parts;
+            parts.Hull = Utenyaa::Simulation::TransformTree::Add(Utenyaa::Simulation::TransformTree::None, transform);
+            parts.Turret = Utenyaa::Simulation::TransformTree::Add(parts.Hull, &turret);
+            parts.Barrel = Utenyaa::Simulation::TransformTree::Add(parts.Turret, &barrel);
+            return parts;
+        }
+
+        /** @brief Process single entity
+         * @param parts Tank parts
+         * @param transform Entity transform
+         */
+        static void ProcessEntity(
+            Utenyaa::Components::TankParts * parts,
+            Utenyaa::Components::Transform * transform)
+        {
+            // Tanks standing still do not mark their subtree as changed
+            if (memcmp(Utenyaa::Simulation::TransformTree::GetLocal(parts->Hull), &transform->Matrix, sizeof(fix16_mat43_t)) != 0)
+            {
+                Utenyaa::Simulation::TransformTree::SetLocal(parts->Hull, &transform->Matrix);
+            }
+        }
+    };
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+#include "BaseSystem.hpp"
+#include "../Components/TankPartsComponent.hpp"
+#include "../Components/TeamComponent.hpp"
+#include "../Rendering/FramePipeline.hpp"
+#include "../Rendering/TeamColors.hpp"
+#include "../Rendering/Viewports.hpp"
+#include "../Rendering/VisibilityGrid.hpp"
+#include "../../Dependencies/Skathi/VDP1/Vdp1.hpp"
+
+namespace Utenyaa::Systems
+{
+    /** @brief Draws tanks visible in the active viewport with the shared tank texture in their team colors
+     * @details Hull and turret are distorted sprites rotated by their world transforms from the frame snapshot,
+     * each with its own region of the tank texture, turret sprite reaches from the turret to the end of the barrel.
+     * Treads use their own texture and palette and are drawn over both edges of the hull. Parts are drawn far to near by the frame ordering table,
+     * so turrets stay on top of hulls of other tanks. Tanks are put into a visibility grid once per frame, every viewport
+     * then visits only tanks in grid cells its visible area covers.
+     */
+    class TankRenderSystem : public BaseSystem<
+        TankRenderSystem,
+        Utenyaa::Components::TankParts,
+        Utenyaa::Components::Team>
+    {
+    private:
+        /** @brief Tank in the visibility grid
+         */
+        struct Tank
+        {
+            /** @brief Tank nodes
+             */
+            Utenyaa::Components::TankParts Parts;
+
+            /** @brief Team index
+             */
+            uint8_t Team;
+        };
+
+        /** @brief Tanks of the frame by their position on the ground
+         */
+        inline static Utenyaa::Rendering::VisibilityGrid<Tank, TANK_RENDER_CAPACITY> grid;
+
+        /** @brief Visible ground center X of the viewport
+         */
+        inline static fix16_t centerX = FIX16_ZERO;
+
+        /** @brief Visible ground center Y of the viewport
+         */
+        inline static fix16_t centerY = FIX16_ZERO;
+
+        /** @brief Pixels per world unit along X axis
+         */
+        inline static fix16_t scaleX = FIX16_ONE;
+
+        /** @brief Pixels per world unit along Y axis
+         */
+        inline static fix16_t scaleY = FIX16_ONE;
+
+        /** @brief Height of the viewport camera (Z axis points away from it)
+         */
+        inline static fix16_t cameraZ = FIX16_ZERO;
+
+        /** @brief Tread texture, not tinted by team
+         */
+        inline static texture_t treads;
+
+        /** @brief Add sprite of a single tank part
+         * @param sprite Sprite with texture, color and draw mode of the part
+         * @param world Part world transform, gives orientation of the sprite
+         * @param x Sprite center X in world units
+         * @param y Sprite center Y in world units
+         * @param depth Sprite depth, world Z of the part
+         * @param halfLength Half of the sprite length along forward axis
+         * @param halfWidth Half of the sprite width along side axis
+         * @param sideways Texture rows run along the side axis instead of the forward axis
+         */
+        static void AddPart(
+            Skathi::Vdp1::Sprite::Instance * sprite,
+            const fix16_mat43_t * world,
+            fix16_t x,
+            fix16_t y,
+            fix16_t depth,
+            fix16_t halfLength,
+            fix16_t halfWidth,
+            bool sideways)
+        {
+            const fix16_t forwardX = fix16_mul(world->frow[0][0], halfLength);
+            const fix16_t forwardY = fix16_mul(world->frow[0][1], halfLength);
+            const fix16_t sideX = fix16_mul(world->frow[1][0], halfWidth);
+            const fix16_t sideY = fix16_mul(world->frow[1][1], halfWidth);
+
+            // Front left, front right, back right and back left corner, top of the texture is the front of the tank
+            const fix16_t cornersX[4] = { forwardX - sideX, forwardX + sideX, sideX - forwardX, -forwardX - sideX };
+            const fix16_t cornersY[4] = { forwardY - sideY, forwardY + sideY, sideY - forwardY, -forwardY - sideY };
+
+            // Sideways texture starts at the back left corner, so its top edge runs along the left side to the front
+            const uint8_t first = sideways ? 3 : 0;
+
+            for (uint8_t vertex = 0; vertex < 4; vertex++)
+            {
+                const uint8_t corner = (vertex + first) & 3;
+                sprite->Vertices[vertex].x = fix16_int32_to(fix16_mul(x + cornersX[corner] - TankRenderSystem::centerX, TankRenderSystem::scaleX));
+                sprite->Vertices[vertex].y = fix16_int32_to(fix16_mul(y + cornersY[corner] - TankRenderSystem::centerY, TankRenderSystem::scaleY));
+            }
+
+            Skathi::Vdp1::Sprite::WriteCommand(sprite, Utenyaa::Rendering::FramePipeline::AddSorted(depth - TankRenderSystem::cameraZ));
+        }
+
+        /** @brief Add sprites of a single tank
+         * @param tank Tank
+         */
+        static void AddTank(const Tank * tank)
+        {
+            const fix16_mat43_t * hull = Utenyaa::Rendering::FramePipeline::GetWorld(tank->Parts.Hull);
+            const fix16_mat43_t * turret = Utenyaa::Rendering::FramePipeline::GetWorld(tank->Parts.Turret);
+            const fix16_mat43_t * barrel = Utenyaa::Rendering::FramePipeline::GetWorld(tank->Parts.Barrel);
+
+            // Transparent pixels are skipped, end codes are not checked and sprites are clipped to the viewport (user clipping)
+            Skathi::Vdp1::Sprite::Instance sprite;
+            sprite.Kind = Skathi::Vdp1::Sprite::Type::Distorted;
+            sprite.DrawMode = (1 << 7) | (1 << 10);
+            Utenyaa::Rendering::TeamColors::Apply(&sprite, tank->Team, Utenyaa::Rendering::TeamColors::Part::Hull);
+            TankRenderSystem::AddPart(&sprite, hull, hull->frow[0][3], hull->frow[1][3], hull->frow[2][3], TANK_HULL_HALF_LENGTH, TANK_HULL_HALF_WIDTH, false);
+
+            // Turret sprite is centered between the turret and the end of the barrel
+            Utenyaa::Rendering::TeamColors::Apply(&sprite, tank->Team, Utenyaa::Rendering::TeamColors::Part::Turret);
+            TankRenderSystem::AddPart(
+                &sprite,
+                turret,
+                (turret->frow[0][3] + barrel->frow[0][3]) >> 1,
+                (turret->frow[1][3] + barrel->frow[1][3]) >> 1,
+                turret->frow[2][3],
+                (TANK_BARREL_LENGTH >> 1) + TANK_TURRET_HALF_WIDTH,
+                TANK_TURRET_HALF_WIDTH,
+                false);
+
+            // Tread texture was not found on the disc
+            if (TankRenderSystem::treads.size == 0)
+            {
+                return;
+            }
+
+            // Treads cover both edges of the hull and are drawn over it
+            const fix16_t offset = TANK_HULL_HALF_WIDTH - TANK_TREAD_HALF_WIDTH;
+            const fix16_t sideX = fix16_mul(hull->frow[1][0], offset);
+            const fix16_t sideY = fix16_mul(hull->frow[1][1], offset);
+            Skathi::Vdp1::Sprite::SetTexture(&sprite, &TankRenderSystem::treads);
+            sprite.Color = TANK_TREAD_PALETTE << 4;
+            sprite.DrawMode = (VDP1_CMDT_CM_CB_16 << 3) | (1 << 7) | (1 << 10);
+            TankRenderSystem::AddPart(&sprite, hull, hull->frow[0][3] - sideX, hull->frow[1][3] - sideY, hull->frow[2][3] - TANK_TREAD_DEPTH_BIAS, TANK_HULL_HALF_LENGTH, TANK_TREAD_HALF_WIDTH, true);
+            TankRenderSystem::AddPart(&sprite, hull, hull->frow[0][3] + sideX, hull->frow[1][3] + sideY, hull->frow[2][3] - TANK_TREAD_DEPTH_BIAS, TANK_HULL_HALF_LENGTH, TANK_TREAD_HALF_WIDTH, true);
+        }
+
+    public:
+        /** @brief Load tread texture and its palette
+         * @param image Indexed tread image with at most 16 palette entries, long side is the length of the tread
+         * @param textureBase Where to load texture to in VRAM
+         * @return Size of loaded image data
+         */
+        static size_t LoadTreads(Skathi::Bitmap::Image * image, vdp1_vram_t textureBase)
+        {
+            assert(Skathi::Vdp1::TextureUtils::GetColorMode(image) == VDP1_CMDT_CM_CB_16);
+            return Skathi::Vdp1::TextureUtils::LoadTexture(image, TANK_TREAD_PALETTE << 4, textureBase, &TankRenderSystem::treads);
+        }
+
+        /** @brief Put all tanks into the visibility grid (should be called once per frame after FramePipeline::Begin)
+         */
+        static void Process()
+        {
+            TankRenderSystem::grid.Clear();
+            BaseSystem::Process();
+        }
+
+        /** @brief Add depth sorted commands of all tanks visible in the viewport being rendered
+         * @param viewport Viewport being rendered
+         */
+        static void Draw(const Utenyaa::Rendering::Viewports::Viewport * viewport)
+        {
+            // Tank texture was not found on the disc
+            if (Utenyaa::Rendering::TeamColors::GetTexture(Utenyaa::Rendering::TeamColors::Part::Hull)->size == 0)
+            {
+                return;
+            }
+
+            // Coordinates are relative to the viewport center (local coordinates)
+            TankRenderSystem::centerX = (viewport->Bounds[0] + viewport->Bounds[2]) >> 1;
+            TankRenderSystem::centerY = (viewport->Bounds[1] + viewport->Bounds[3]) >> 1;
+            TankRenderSystem::scaleX = fix16_div(fix16_int32_from(viewport->Right - viewport->Left + 1), viewport->HalfWidth << 1);
+            TankRenderSystem::scaleY = fix16_div(fix16_int32_from(viewport->Bottom - viewport->Top + 1), viewport->HalfHeight << 1);
+            TankRenderSystem::cameraZ = viewport->Camera.position.z;
+            TankRenderSystem::grid.Query(viewport->Bounds, VIEWPORT_CULL_RADIUS, [](const Tank * tank)
+            {
+                TankRenderSystem::AddTank(tank);
+            });
+        }
+
+        /** @brief Process single entity
+         * @param parts Tank parts
+         * @param team Tank team
+         */
+        static void ProcessEntity(
+            Utenyaa::Components::TankParts * parts,
+            Utenyaa::Components::Team * team)
+        {
+            // Position comes from the frame snapshot, the same transforms the tank is drawn with
+            const fix16_mat43_t * hull = Utenyaa::Rendering::FramePipeline::GetWorld(parts->Hull);
+            const fix16_vec3_t position = { hull->frow[0][3], hull->frow[1][3], hull->frow[2][3] };
+            TankRenderSystem::grid.Insert(&position, Tank { Parts : *parts, Team : team->Index });
+        }
+    };
+}
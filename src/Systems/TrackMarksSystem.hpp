@@ -0,0 +1,41 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+#include "BaseSystem.hpp"
+#include "../Components/TrackMarksComponent.hpp"
+#include "../Components/TransformComponent.hpp"
+#include "../Rendering/Decals.hpp"
+
+namespace Utenyaa::Systems
+{
+    /** @brief Leaves track marks behind moving tanks
+     */
+    class TrackMarksSystem : public BaseSystem<
+        TrackMarksSystem,
+        Utenyaa::Components::TrackMarks,
+        Utenyaa::Components::Transform>
+    {
+    public:
+        /** @brief Process single entity
+         * @param marks Track marks component data
+         * @param transform Entity transform
+         */
+        static void ProcessEntity(
+            Utenyaa::Components::TrackMarks * marks,
+            Utenyaa::Components::Transform * transform)
+        {
+            const fix16_t deltaX = transform->Matrix.frow[0][3] - marks->LastStamp.x;
+            const fix16_t deltaY = transform->Matrix.frow[1][3] - marks->LastStamp.y;
+
+            // Manhattan distance is good enough for spacing and cannot overflow
+            if ((deltaX < 0 ? -deltaX : deltaX) + (deltaY < 0 ? -deltaY : deltaY) >= DECAL_TRACK_SPACING)
+            {
+                fix16_vec3 location = { transform->Matrix.frow[0][3], transform->Matrix.frow[1][3], transform->Matrix.frow[2][3] };
+                fix16_vec3 forward = { transform->Matrix.frow[0][0], transform->Matrix.frow[0][1], transform->Matrix.frow[0][2] };
+                Utenyaa::Rendering::Decals::StampTracks(&location, &forward);
+                marks->LastStamp.x = location.x;
+                marks->LastStamp.y = location.y;
+            }
+        }
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <yaul.h>
+#include "../constants.hpp"
+#include "BaseSystem.hpp"
+#include "ProjectileSystem.hpp"
+#include "../Components/InputComponent.hpp"
+#include "../Components/TankPartsComponent.hpp"
+#include "../Components/WeaponComponent.hpp"
+#include "../Simulation/TransformTree.hpp"
+
+namespace Utenyaa::Systems
+{
+    /** @brief Fires shells from the barrel while fire input (A button, or AI fire decision) is held and the gun is reloaded
+     * @details Should run after transform tree update, so shells leave from where the barrel is this frame.
+     */
+    class WeaponSystem : public BaseSystem<
+        WeaponSystem,
+        Utenyaa::Components::InputComponent::Input,
+        Utenyaa::Components::Weapon,
+        Utenyaa::Components::TankParts>
+    {
+    public:
+        /** @brief Process single entity
+         * @param input Input component data
+         * @param weapon Weapon component data
+         * @param parts Tank parts
+         */
+        static void ProcessEntity(
+            Utenyaa::Components::InputComponent::Input * input,
+            Utenyaa::Components::Weapon * weapon,
+            Utenyaa::Components::TankParts * parts)
+        {
+            if (weapon->Cooldown > 0)
+            {
+                weapon->Cooldown--;
+                return;
+            }
+
+            if (!input->A)
+            {
+                return;
+            }
+
+            // Shell flies along the barrel
+            const fix16_mat43_t * barrel = Utenyaa::Simulation::TransformTree::GetWorld(parts->Barrel);
+            const fix16_vec3_t from = { barrel->frow[0][3], barrel->frow[1][3], barrel->frow[2][3] };
+            const fix16_vec2_t direction = { barrel->frow[0][0], barrel->frow[0][1] };
+
+            if (Utenyaa::Systems::ProjectileSystem::Fire(&from, &direction))
+            {
+                weapon->Cooldown = PROJECTILE_RELOAD_FRAMES;
+            }
+        }
+    };
+}
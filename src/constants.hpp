@@ -3,4 +3,103 @@
 /* Player constants */
 #define PLAYER_FORWARD_SPEED (FIX16_ONE)
 #define PLAYER_BACKWARD_SPEED (FIX16_ONE)
-#define PLAYER_TURN_SPEED   (DEG2ANGLE(8))
\ No newline at end of file
+#define PLAYER_TURN_SPEED   (DEG2ANGLE(8))
+
+/* Tank constants */
+#define TANK_TURRET_HEIGHT (FIX16(0.5f))
+#define TANK_BARREL_LENGTH (FIX16(0.75f))
+#define TANK_HULL_HALF_LENGTH (FIX16(1.0f))
+#define TANK_HULL_HALF_WIDTH (FIX16(0.75f))
+#define TANK_TURRET_HALF_WIDTH (FIX16(0.25f))
+#define TANK_TREAD_HALF_WIDTH (FIX16(0.25f))
+#define TANK_TREAD_DEPTH_BIAS (FIX16(0.25f))
+#define TANK_TREAD_PALETTE (3)
+#define TANK_TREAD_TEXTURE_NAME "THREADS.TGA"
+#define TANK_RENDER_CAPACITY (32)
+
+/* Transform constants */
+#define TRANSFORM_NODE_CAPACITY (64)
+
+/* Analog input constants */
+#define ANALOG_DEADZONE (12)
+
+/* Level constants */
+#define LEVEL_TILE_SIZE (FIX16(2.0f))
+#define LEVEL_ARENA_WIDTH (32)
+#define LEVEL_ARENA_HEIGHT (32)
+#define LEVEL_FILE_NAME "ARENA.LVL"
+#define LEVEL_STREAMED_FILE_NAME "ARENA.LVC"
+#define LEVEL_CHUNK_BUDGET (24)
+#define LEVEL_CHUNK_RADIUS (1)
+#define LEVEL_CHUNK_READS (4)
+
+/* Floor constants */
+#define FLOOR_PALETTE (1)
+#define FLOOR_PRIORITY (2)
+
+/* Decal constants */
+#define DECAL_PALETTE (2)
+#define DECAL_PRIORITY (3)
+#define DECAL_UPLOAD_BLOCKS (48)
+#define DECAL_WORN_COLOR (RGB1555(1, 10, 9, 7))
+#define DECAL_IMPRINT_COLOR (RGB1555(1, 6, 5, 4))
+#define DECAL_TRACK_OFFSET (FIX16(0.75f))
+#define DECAL_TRACK_WIDTH (FIX16(0.4f))
+#define DECAL_TRACK_LENGTH (FIX16(1.0f))
+#define DECAL_TRACK_SPACING (FIX16(1.0f))
+
+/* Team constants */
+#define TEAM_COUNT (4)
+#define TEAM_COLOR_BANK (1)
+#define TEAM_RAMP_FIRST (1)
+#define TEAM_RAMP_COUNT (8)
+#define TEAM_TEXTURE_NAME "TANK.TGA"
+
+/* AI constants */
+#define NAVIGATION_MAX_GOALS (4)
+#define NAVIGATION_BUDGET_US (500)
+#define AI_STEER_DEADZONE (FIX16(0.05f))
+#define AI_STEER_ALIGNED (FIX16(0.7f))
+#define AI_BUDGET_US (300)
+#define AI_FIRE_RANGE (FIX16(40.0f))
+#define AI_FIRE_CONE (FIX16(0.1f))
+#define AI_TANK_COUNT (3)
+#define AI_SPAWN_DISTANCE (FIX16(20.0f))
+
+/* Projectile constants */
+#define PROJECTILE_CAPACITY (16)
+#define PROJECTILE_SPEED (FIX16(1.5f))
+#define PROJECTILE_LIFETIME (60)
+#define PROJECTILE_RELOAD_FRAMES (45)
+
+/* Particle constants */
+#define PARTICLE_CAPACITY (1024)
+#define PARTICLE_DRAW_BUDGET (256)
+#define PARTICLE_SPRITE_LAYER (1)
+#define PARTICLE_TEXTURE_SIZE (8)
+#define PARTICLE_EXPLOSION_AMOUNT (24)
+#define PARTICLE_SMOKE_AMOUNT (8)
+
+/* Viewport constants */
+#define VIEWPORT_SCREEN_WIDTH (320)
+#define VIEWPORT_SCREEN_HEIGHT (224)
+#define VIEWPORT_CAMERA_HEIGHT (FIX16(30.0f))
+#define VIEWPORT_VIEW_HALF_WIDTH (FIX16(24.0f))
+#define VIEWPORT_VIEW_HALF_HEIGHT (FIX16(17.0f))
+#define VIEWPORT_CULL_RADIUS (FIX16(2.0f))
+#define VIEWPORT_GRID_CELL_SHIFT (3)
+#define VIEWPORT_GRID_WRAP (16)
+
+/* Frame constants */
+#define FRAME_COMMAND_CAPACITY (1024)
+#define FRAME_SPRITE_CAPACITY (320)
+#define FRAME_ORDER_BUCKETS (256)
+#define FRAME_ORDER_NEAR (FIX16(26.0f))
+#define FRAME_ORDER_FAR (FIX16(34.0f))
+
+/* CD constants */
+#define CD_READ_SECTORS (2)
+#define CD_PREFETCH_READS (1)
+
+/* Debug constants */
+#define DEBUG_TRACKED_ENTITIES (4)
\ No newline at end of file
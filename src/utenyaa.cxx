@@ -3,11 +3,41 @@
 #include <yaul.h>
 #include "..\Dependencies\HyperionEngine\ECS\Entity.hpp"
 #include "..\Dependencies\Skathi\Skathi.hpp"
+#include "constants.hpp"
+#include "Components/AIComponent.hpp"
+#include "Components/AnalogInputComponent.hpp"
 #include "Components/InputComponent.hpp"
+#include "Components/ProjectileComponent.hpp"
+#include "Components/TankPartsComponent.hpp"
+#include "Components/TeamComponent.hpp"
+#include "Components/TrackMarksComponent.hpp"
 #include "Components/TransformComponent.hpp"
+#include "Components/WeaponComponent.hpp"
+#include "Debug/Overlay.hpp"
+#include "Debug/Profiler.hpp"
+#include "Effects/Particles.hpp"
+#include "Level/LevelFile.hpp"
+#include "Level/Navigation.hpp"
+#include "Level/Streamer.hpp"
+#include "Level/TileMap.hpp"
+#include "Rendering/Decals.hpp"
+#include "Rendering/Floor.hpp"
+#include "Rendering/FramePipeline.hpp"
+#include "Rendering/TeamColors.hpp"
+#include "Rendering/Viewports.hpp"
+#include "Simulation/TransformTree.hpp"
+#include "Systems/AISystem.hpp"
+#include "Systems/AnalogInputSystem.hpp"
 #include "Systems/BaseSystem.hpp"
+#include "Systems/CameraSystem.hpp"
 #include "Systems/InputSystem.hpp"
 #include "Systems/PhysicsSystem.hpp"
+#include "Systems/ProjectileSystem.hpp"
+#include "Systems/StreamingSystem.hpp"
+#include "Systems/TankPartsSystem.hpp"
+#include "Systems/TankRenderSystem.hpp"
+#include "Systems/TrackMarksSystem.hpp"
+#include "Systems/WeaponSystem.hpp"
 
 extern "C"
 {
@@ -27,6 +57,14 @@ vblank_out_handler(void *work __unused)
     smpc_peripheral_intback_issue();
 }
 
+/** @brief VBlank-in handler
+ */
+static void
+vblank_in_handler(void *work __unused)
+{
+    Skathi::Input::Peripherals::Latch();
+}
+
 /** @brief Main program entry
  */
 void main(void)
@@ -34,23 +72,12 @@ void main(void)
     dbgio_init();
     dbgio_dev_default_init(DBGIO_DEV_VDP2_ASYNC);
     dbgio_dev_font_load();
+    Utenyaa::Debug::Overlay::Initialize();
 
-    /* NOT NEEDED IN THIS EARLY STAGE
-    // Initialize 3D
+    // Initialize 3D, every viewport sets its own camera
     mic3d_init();
 
-    // Initialize camera
-    camera_t camera __unused;
-    camera.position.x = FIX16(0.0f);
-    camera.position.y = FIX16(0.0f);
-    camera.position.z = FIX16(-30.0f);
-    camera.target.x = FIX16_ZERO;
-    camera.target.y = FIX16_ZERO;
-    camera.target.z = FIX16_ZERO;
-    camera.up.x = FIX16_ZERO;
-    camera.up.y = -FIX16_ONE;
-    camera_lookat(&camera);
-
+    /* NOT NEEDED IN THIS EARLY STAGE
     // Initialize shading
     vdp1_vram_partitions_t vdp1_vram_partitions;
     vdp1_vram_partitions_get(&vdp1_vram_partitions);
@@ -77,42 +104,247 @@ void main(void)
     Utenyaa::Components::Transform transform = Utenyaa::Components::Transform();
     fix16_mat43_identity(&transform.Matrix);
 
+    // Turret and barrel are children of the hull
+    Utenyaa::Simulation::TransformTree::Initialize();
+
     Entity::Create(Utenyaa::Components::InputComponent::Input { Source : Utenyaa::Components::InputComponent::P1 },
-                   transform);
+                   Utenyaa::Components::AnalogInput(),
+                   Utenyaa::Components::Team { Index : 0 },
+                   Utenyaa::Components::TrackMarks(),
+                   Utenyaa::Components::Weapon { Cooldown : 0 },
+                   transform,
+                   Utenyaa::Systems::TankPartsSystem::Create(&transform.Matrix));
+
+    // Single player view
+    Utenyaa::Rendering::Viewports::Initialize(1);
+
+    // Next frame is simulated while VDP1 draws the current one
+    Utenyaa::Rendering::FramePipeline::Initialize();
+
+    Skathi::Cd::Initialize();
+
+    // Slave CPU decompresses packed files while master reads the disc
+    Skathi::Slave::Initialize();
+
+    // Point batches are transformed by the SCU DSP
+    Skathi::Dsp::Transform::Initialize();
+
+    // Textures are loaded one after another, VDP1 texture addresses are multiples of 8 bytes
+    vdp1_vram_partitions_t vdp1_vram_partitions;
+    vdp1_vram_partitions_get(&vdp1_vram_partitions);
+    vdp1_vram_t textureBase = (vdp1_vram_t)vdp1_vram_partitions.texture_base;
+
+    // All tanks share one indexed texture, teams differ only by color bank
+    const cdfs_filelist_entry_t * teamEntry = Skathi::Cd::FindFileByName(TEAM_TEXTURE_NAME);
+
+    if (teamEntry != NULL)
+    {
+        Skathi::Bitmap::TGAImage teamImage(teamEntry);
+        textureBase += (Utenyaa::Rendering::TeamColors::Initialize(&teamImage, textureBase) + 7) & ~7;
+    }
+
+    // Treads are the same for every team and have their own palette
+    const cdfs_filelist_entry_t * treadEntry = Skathi::Cd::FindFileByName(TANK_TREAD_TEXTURE_NAME);
+
+    if (treadEntry != NULL)
+    {
+        Skathi::Bitmap::TGAImage treadImage(treadEntry);
+        textureBase += (Utenyaa::Systems::TankRenderSystem::LoadTreads(&treadImage, textureBase) + 7) & ~7;
+    }
+
+    // Particle sprites are generated, there are no particle textures on the disc
+    textureBase += (Utenyaa::Effects::Particles::LoadSprites(textureBase) + 7) & ~7;
+
+    // Level walls and floor come from disc, empty walled arena is used when the level file is missing
+    Utenyaa::Level::TileMap * arena;
+    const cdfs_filelist_entry_t * streamedEntry = Skathi::Cd::FindFileByName(LEVEL_STREAMED_FILE_NAME);
+    const cdfs_filelist_entry_t * levelEntry = Skathi::Cd::FindFileByName(LEVEL_FILE_NAME);
+
+    if (streamedEntry != NULL)
+    {
+        // Large levels are streamed in chunks, chunks around players are loaded before the match starts
+        arena = Utenyaa::Level::Streamer::Initialize(streamedEntry);
+        Utenyaa::Systems::StreamingSystem::Process();
+        Utenyaa::Level::Streamer::Preload();
+    }
+    else if (levelEntry != NULL)
+    {
+        // Level data is not needed once tiles are copied and floor is in VDP2 memory
+        Utenyaa::Level::LevelFile level(levelEntry);
+        const Utenyaa::Level::LevelFile::Header * header = level.GetHeader();
+        static Utenyaa::Level::TileMap levelMap(header->Width, header->Height, header->TileSize);
+        level.LoadTiles(&levelMap);
+        Utenyaa::Rendering::Floor::Initialize(&level);
+        arena = &levelMap;
+    }
+    else
+    {
+        static Utenyaa::Level::TileMap emptyMap(LEVEL_ARENA_WIDTH, LEVEL_ARENA_HEIGHT, LEVEL_TILE_SIZE);
+        emptyMap.AddBorder();
+        arena = &emptyMap;
+    }
 
-    //Skathi::Cd::Initialize();
+    // Track marks stay on the ground for the whole match
+    Utenyaa::Rendering::Decals::Initialize(arena);
+
+    const fix16_vec3_t arenaCenter = { FIX16_ZERO, FIX16_ZERO, FIX16_ZERO };
+    Utenyaa::Level::Navigation::Initialize(arena);
+    Utenyaa::Level::Navigation::SetGoal(0, &arenaCenter);
+
+    // AI tanks start in the corners and drive toward the goal along its flow field
+    for (uint8_t tank = 0; tank < AI_TANK_COUNT; tank++)
+    {
+        Utenyaa::Components::Transform aiTransform = Utenyaa::Components::Transform();
+        fix16_mat43_identity(&aiTransform.Matrix);
+        aiTransform.Matrix.frow[0][3] = (tank & 1) != 0 ? AI_SPAWN_DISTANCE : -AI_SPAWN_DISTANCE;
+        aiTransform.Matrix.frow[1][3] = (tank & 2) != 0 ? AI_SPAWN_DISTANCE : -AI_SPAWN_DISTANCE;
+
+        Entity::Create(Utenyaa::Components::InputComponent::Input { Source : Utenyaa::Components::InputComponent::AI },
+                       Utenyaa::Components::AI { Goal : 0, Steering : 0, Target : Utenyaa::Systems::AISystem::NoTarget },
+                       Utenyaa::Components::Team { Index : (uint8_t)((tank % (TEAM_COUNT - 1)) + 1) },
+                       Utenyaa::Components::TrackMarks(),
+                       Utenyaa::Components::Weapon { Cooldown : 0 },
+                       aiTransform,
+                       Utenyaa::Systems::TankPartsSystem::Create(&aiTransform.Matrix));
+    }
+
+    // Analog response curves
+    Utenyaa::Systems::AnalogInputSystem::Initialize();
+
+    // Particles are moved by the slave CPU while master runs AI
+    Utenyaa::Effects::Particles::Initialize(true);
+
+    // AI decisions are time sliced
+    Utenyaa::Systems::AISystem::Initialize(arena, AI_BUDGET_US);
+    Utenyaa::Systems::ProjectileSystem::Initialize(arena);
+
+    // Projectiles are reused, inactive ones wait for fired shells
+    for (uint8_t projectile = 0; projectile < PROJECTILE_CAPACITY; projectile++)
+    {
+        Utenyaa::Components::Transform shellTransform = Utenyaa::Components::Transform();
+        fix16_mat43_identity(&shellTransform.Matrix);
+        Entity::Create(Utenyaa::Components::Projectile { Velocity : { FIX16_ZERO, FIX16_ZERO }, Lifetime : 0 }, shellTransform);
+    }
+
+    // Sprites of a viewport are collected here and written into its command list in one go
+    Skathi::Vdp1::Sprite sprites(FRAME_SPRITE_CAPACITY);
+
+    // Debug overlay slots of tracked entities
+    static uint8_t debugSlots[DEBUG_TRACKED_ENTITIES][2];
+
+    for (uint8_t entity = 0; entity < DEBUG_TRACKED_ENTITIES; entity++)
+    {
+        debugSlots[entity][0] = Utenyaa::Debug::Overlay::AddVector(entity << 1, "Pos");
+        debugSlots[entity][1] = Utenyaa::Debug::Overlay::AddVector((entity << 1) + 1, "Dir");
+    }
+
+    // Debug overlay slots of profiled sections
+    const uint8_t aiCostSlot = Utenyaa::Debug::Overlay::AddSlot(DEBUG_TRACKED_ENTITIES << 1, 10, 6, "AI us");
+    const uint8_t aiWorstSlot = Utenyaa::Debug::Overlay::AddSlot(DEBUG_TRACKED_ENTITIES << 1, 24, 6, "worst");
+    const uint8_t latencySlot = Utenyaa::Debug::Overlay::AddSlot((DEBUG_TRACKED_ENTITIES << 1) + 1, 10, 2, "Lag");
+    const uint8_t latencyWorstSlot = Utenyaa::Debug::Overlay::AddSlot((DEBUG_TRACKED_ENTITIES << 1) + 1, 24, 2, "worst");
+    const uint8_t cartHitSlot = Utenyaa::Debug::Overlay::AddSlot((DEBUG_TRACKED_ENTITIES << 1) + 2, 10, 6, "Cart");
+    const uint8_t cartMissSlot = Utenyaa::Debug::Overlay::AddSlot((DEBUG_TRACKED_ENTITIES << 1) + 2, 24, 6, "miss");
+    const uint8_t frameWaitSlot = Utenyaa::Debug::Overlay::AddSlot((DEBUG_TRACKED_ENTITIES << 1) + 3, 10, 6, "Wait us");
 
     while (true)
     {
-        dbgio_puts("[H[2J");
-        
-        // Fetch input
-        Skathi::Input::Peripherals::FetchAll();
+        Utenyaa::Effects::Particles::StartUpdate();
+
+        // Spread flow field builds over frames
+        Utenyaa::Level::Navigation::Update();
+
+        // Process entity components that do not depend on player input, particles can be emitted only after their update
+        Utenyaa::Systems::AISystem::Process();
+        Utenyaa::Effects::Particles::WaitUpdate();
+        Utenyaa::Systems::ProjectileSystem::Process();
 
-        // Process entity components
+        // Fetch input as late as possible, so the newest latched sample makes it into this frame
+        Skathi::Input::Peripherals::FetchAll();
         Utenyaa::Systems::InputSystem::Process();
+        Utenyaa::Systems::AnalogInputSystem::Process();
         Utenyaa::Systems::PhysicsSystem::Process();
+        Utenyaa::Systems::TrackMarksSystem::Process();
+
+        // World matrices of moved tanks and their parts
+        Utenyaa::Systems::TankPartsSystem::Process();
+        Utenyaa::Simulation::TransformTree::Update();
+
+        // Shells leave the barrel where it is this frame and start moving on the next projectile update
+        Utenyaa::Systems::WeaponSystem::Process();
+
+        // Load level chunks around players
+        Utenyaa::Systems::StreamingSystem::Process();
+        Utenyaa::Level::Streamer::Update();
+
+        // Queued reads are read a few sectors per frame and stop the music once per batch, prefetches wait for idle drive
+        Skathi::CdScheduler::Update(CD_READ_SECTORS, CD_PREFETCH_READS);
+
+        // Viewport cameras follow connected players
+        Utenyaa::Systems::CameraSystem::Process();
 
         // Debug print entities
+        static uint8_t debugEntity;
+        debugEntity = 0;
+
         Entity::ForEach(
             [](Utenyaa::Components::Transform &v)
             {
-                fix16_vec3 lastLocation = { v.Matrix.frow[0][3], v.Matrix.frow[1][3], v.Matrix.frow[2][3] };
-                fix16_vec3 forward = { v.Matrix.frow[0][0], v.Matrix.frow[0][1], v.Matrix.frow[0][2] };
+                if (debugEntity < DEBUG_TRACKED_ENTITIES)
+                {
+                    fix16_vec3 lastLocation = { v.Matrix.frow[0][3], v.Matrix.frow[1][3], v.Matrix.frow[2][3] };
+                    fix16_vec3 forward = { v.Matrix.frow[0][0], v.Matrix.frow[0][1], v.Matrix.frow[0][2] };
+
+                    Utenyaa::Debug::Overlay::SetVector(debugSlots[debugEntity][0], &lastLocation);
+                    Utenyaa::Debug::Overlay::SetVector(debugSlots[debugEntity][1], &forward);
+                }
 
-                dbgio_printf("Position x:%f y:%f z:%f\n", lastLocation.x, lastLocation.y, lastLocation.z);
-                dbgio_printf("Dir x:%f y:%f z:%f\n", forward.x, forward.y, forward.z);
+                debugEntity++;
             });
 
-        // Start rendering to screen
-        //render();
+        // Render state of the frame is frozen here, its commands are built while VDP1 still draws the previous frame
+        Utenyaa::Rendering::FramePipeline::Begin(Skathi::Input::Peripherals::GetLatchedVblank());
+
+        // Shared culling for all viewports, tanks are put into the visibility grid once
+        Utenyaa::Systems::TankRenderSystem::Process();
+
+        // Start rendering to screen, each viewport gets its own clipping rectangle and camera and draws only entities from grid cells it covers
+        for (uint8_t viewport = 0; viewport < Utenyaa::Rendering::Viewports::GetCount(); viewport++)
+        {
+            Utenyaa::Rendering::Viewports::Begin(viewport, Utenyaa::Rendering::FramePipeline::Add(2));
 
-        //vdp1_sync_render();
-        //vdp1_sync();
-        //vdp1_sync_wait();
+            // Tanks in their team colors are depth sorted, effects are drawn over everything else
+            Utenyaa::Systems::TankRenderSystem::Draw(Utenyaa::Rendering::Viewports::Get(viewport));
+            sprites.Clear();
+            Utenyaa::Effects::Particles::Draw(&sprites, Utenyaa::Rendering::Viewports::Get(viewport), PARTICLE_DRAW_BUDGET);
+            Utenyaa::Rendering::FramePipeline::AddSprites(&sprites);
+        }
+
+        // Previous frame has to be displayed before its command list in VRAM and VDP2 state are replaced
+        if (Utenyaa::Rendering::FramePipeline::Wait())
+        {
+            Skathi::Input::Peripherals::FrameDisplayed(Utenyaa::Rendering::FramePipeline::GetDisplayed()->Latched);
+        }
+
+        // Floor window chunk picked by the streamer this frame, then floor and decal scroll screens follow the first viewport camera
+        Utenyaa::Level::Streamer::WriteFloor();
+        Utenyaa::Rendering::Floor::Update(Utenyaa::Rendering::Viewports::Get(0));
+        Utenyaa::Rendering::Decals::Update(Utenyaa::Rendering::Viewports::Get(0));
+        Utenyaa::Rendering::Decals::Flush(DECAL_UPLOAD_BLOCKS);
+
+        Utenyaa::Debug::Overlay::SetNumber(aiCostSlot, Utenyaa::Debug::Profiler::GetLastMicroseconds(Utenyaa::Systems::AISystem::GetProfilerSection()));
+        Utenyaa::Debug::Overlay::SetNumber(aiWorstSlot, Utenyaa::Debug::Profiler::GetWorstMicroseconds(Utenyaa::Systems::AISystem::GetProfilerSection()));
+        Utenyaa::Debug::Overlay::SetNumber(latencySlot, Skathi::Input::Peripherals::GetLatency());
+        Utenyaa::Debug::Overlay::SetNumber(latencyWorstSlot, Skathi::Input::Peripherals::GetWorstLatency());
+        Utenyaa::Debug::Overlay::SetNumber(cartHitSlot, Skathi::Cache::GetHits());
+        Utenyaa::Debug::Overlay::SetNumber(cartMissSlot, Skathi::Cache::GetMisses());
+        Utenyaa::Debug::Overlay::SetNumber(frameWaitSlot, Utenyaa::Rendering::FramePipeline::GetWaitMicroseconds());
+        Utenyaa::Debug::Overlay::Flush();
         dbgio_flush();
-        vdp2_sync();
-        vdp2_sync_wait();
+
+        // Hand the frame over without waiting, next frame is simulated while this one is drawn
+        Utenyaa::Rendering::FramePipeline::Submit();
+        Utenyaa::Debug::Profiler::EndFrame();
     }
 }
 
@@ -121,7 +353,9 @@ void main(void)
 void user_init(void)
 {
     smpc_peripheral_init();
+    Skathi::Timer::Initialize();
     vdp_sync_vblank_out_set(vblank_out_handler, NULL);
+    vdp_sync_vblank_in_set(vblank_in_handler, NULL);
 
     vdp2_tvmd_display_res_set(VDP2_TVMD_INTERLACE_NONE, VDP2_TVMD_HORZ_NORMAL_B, VDP2_TVMD_VERT_224);
 